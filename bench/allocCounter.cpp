@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * allocCounter.cpp: Counts heap allocations made through operator new
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "allocCounter.hpp"
+
+#include "allocProfiler.hpp"
+
+#ifdef MUTATEPLACEHOLDER_ALLOC_PROFILING
+
+// the library already replaced operator new and counts every allocation
+AllocationCounts currentAllocations() {
+    AllocationTally total = AllocProfiler::total();
+    AllocationCounts counts;
+    counts.allocations = total.allocations;
+    counts.bytes = total.bytes;
+    return counts;
+}
+
+#else
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::uint64_t> allocationCount{ 0 };
+static std::atomic<std::uint64_t> allocationBytes{ 0 };
+
+static void* countedAlloc( std::size_t size ) {
+    allocationCount.fetch_add( 1, std::memory_order_relaxed );
+    allocationBytes.fetch_add( size, std::memory_order_relaxed );
+    return std::malloc( size ? size : 1 );
+}
+
+AllocationCounts currentAllocations() {
+    AllocationCounts counts;
+    counts.allocations = allocationCount.load( std::memory_order_relaxed );
+    counts.bytes = allocationBytes.load( std::memory_order_relaxed );
+    return counts;
+}
+
+void* operator new( std::size_t size ) {
+    if ( void* ptr = countedAlloc( size ) ) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[]( std::size_t size ) { return operator new( size ); }
+
+void* operator new( std::size_t size, const std::nothrow_t& ) noexcept { return countedAlloc( size ); }
+
+void* operator new[]( std::size_t size, const std::nothrow_t& ) noexcept { return countedAlloc( size ); }
+
+void operator delete( void* ptr ) noexcept { std::free( ptr ); }
+
+void operator delete[]( void* ptr ) noexcept { std::free( ptr ); }
+
+void operator delete( void* ptr, std::size_t ) noexcept { std::free( ptr ); }
+
+void operator delete[]( void* ptr, std::size_t ) noexcept { std::free( ptr ); }
+
+#endif
@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * allocCounter.hpp: Counts heap allocations made through operator new
+ *
+ * - Linking allocCounter.cpp into a program replaces the global operator new/delete of that program, so only link
+ it into benchmarks
+ * - In allocation profiling builds it reads the counts of allocProfiler.hpp instead of replacing anything
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_ALLOCCOUNTER_HPP_
+#define _INCLUDED_ALLOCCOUNTER_HPP_
+
+#include <cstdint>
+
+struct AllocationCounts {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+};
+
+// Totals since the program started, subtract two snapshots to count what happened in between
+AllocationCounts currentAllocations();
+
+#endif  // _INCLUDED_ALLOCCOUNTER_HPP_
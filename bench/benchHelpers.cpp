@@ -0,0 +1,278 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * benchHelpers.cpp: Workload generation, timing and JSON reporting shared by the benchmarks
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "benchHelpers.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "chacharng/seedHelper.hpp"
+#include "common.hpp"
+#include "excepts.hpp"
+
+namespace {
+// Constants of one generated function, the TSV rows are written against them
+struct FunctionConstants {
+    size_t index;
+    std::uint32_t multiplier;
+    std::uint32_t offset;
+    std::uint32_t shift;
+    std::uint32_t threshold;
+    std::uint32_t decrement;
+    std::uint32_t mask;
+};
+}  // namespace
+
+State seededState( const std::string& seed ) {
+    SeedArray seedArray;
+    if ( seed.size() != RNG_SEED_LENGTH || !parseHexString( seed.c_str(), seedArray.data(), SEED_SIZE_BYTES ) ) {
+        throw InvalidSeedException( " Error : Invalid benchmark seed. Expected 64 hexadecimal digits" );
+    }
+    return State( seedArray.data() );
+}
+
+// Every function is 9 lines and every line holding a statement is unique to it, so plain rows match exactly once
+static void appendFunction( std::ostringstream& src, const FunctionConstants& fc ) {
+    std::string v = "v" + std::to_string( fc.index );
+    std::string a = "a" + std::to_string( fc.index );
+
+    src << "int fn" << fc.index << "( int " << a << " ) {\n";
+    src << "    int " << v << " = " << a << " * " << fc.multiplier << " + " << fc.offset << ";  // seed " << fc.index
+        << "\n";
+    src << "    /* scale " << fc.index << " */\n";
+    src << "    " << v << " = " << v << " << " << fc.shift << ";\n";
+    src << "    if ( " << v << " > " << fc.threshold << " ) {\n";
+    src << "        " << v << " -= " << fc.decrement << ";\n";
+    src << "    }\n";
+    src << "    return " << v << " ^ " << fc.mask << ";\n";
+    src << "}\n";
+}
+
+// Returns how many TSV rows were written
+static size_t appendRows( std::ostringstream& tsv, const FunctionConstants& fc, std::uint32_t kind ) {
+    std::string v = "v" + std::to_string( fc.index );
+    std::string a = "a" + std::to_string( fc.index );
+
+    if ( kind < 40 ) {  // plain
+        tsv << v << " = " << v << " << " << fc.shift << ";\t" << v << " = " << v << " << " << fc.shift + 1 << ";\t"
+            << v << " = " << v << " >> " << fc.shift << ";\n";
+        return 1;
+    }
+    if ( kind < 50 ) {  // optional
+        tsv << "?return " << v << " ^ " << fc.mask << ";\treturn " << v << ";\treturn " << v << " | " << fc.mask
+            << ";\n";
+        return 1;
+    }
+    if ( kind < 65 ) {  // regex, unanchored so that it can match anywhere in the source
+        tsv << "/" << v << " -= \\d+;/-A\t" << v << " -= 0;\t" << v << " += 1;\n";
+        return 1;
+    }
+    if ( kind < 80 ) {  // multiline
+        tsv << "\"if ( " << v << " > " << fc.threshold << " ) {\n        " << v << " -= " << fc.decrement << ";\"\t";
+        tsv << "\"if ( " << v << " >= " << fc.threshold << " ) {\n        " << v << " -= " << fc.decrement << ";\"\t";
+        tsv << "\"if ( " << v << " < " << fc.threshold << " ) {\n        " << v << " += " << fc.decrement << ";\"\n";
+        return 1;
+    }
+    // grouped, a leader followed by a nested, an index synced and an optional nested row
+    tsv << "int " << v << " = " << a << " * " << fc.multiplier << " + " << fc.offset << ";\tint " << v << " = " << a
+        << " * " << fc.multiplier << ";\tint " << v << " = " << a << " + " << fc.offset << ";\tint " << v << " = "
+        << fc.offset << ";\n";
+    tsv << "^" << v << " = " << v << " << " << fc.shift << ";\t" << v << " = " << v << " << " << fc.shift + 1 << ";\t"
+        << v << " = " << v << " >> " << fc.shift << ";\n";
+    tsv << "@return " << v << " ^ " << fc.mask << ";\treturn " << v << ";\treturn " << v << " & " << fc.mask
+        << ";\treturn ~" << v << ";\n";
+    tsv << "^?" << v << " -= " << fc.decrement << ";\t" << v << " += " << fc.decrement << ";\t" << v << " -= "
+        << fc.decrement + 1 << ";\n";
+    return 4;
+}
+
+SyntheticCorpus generateCorpus( size_t lines, size_t rows, State& rng ) {
+    SyntheticCorpus corpus;
+    std::vector<FunctionConstants> functions;
+    std::ostringstream src;
+
+    src << "/* synthetic source generated by the benchmarks */\n";
+    corpus.lines = 1;
+    while ( corpus.lines < lines || !functions.size() ) {
+        FunctionConstants fc;
+        fc.index = functions.size();
+        fc.multiplier = nextRNGBetween( 2, 1000, rng );
+        fc.offset = nextRNGBetween( 1, 1000, rng );
+        fc.shift = nextRNGBetween( 1, 16, rng );
+        fc.threshold = nextRNGBetween( 1, 100000, rng );
+        fc.decrement = nextRNGBetween( 1, 1000, rng );
+        fc.mask = nextRNGBetween( 1, 65536, rng );
+        appendFunction( src, fc );
+        functions.push_back( fc );
+        corpus.lines += 9;
+    }
+
+    std::ostringstream tsv;
+    tsv << "# synthetic mutations generated by the benchmarks\n";
+    for ( size_t next = 0; corpus.rows < rows || !corpus.rows; ++next ) {
+        // wraps around when there are more rows than functions, which then match more than once
+        corpus.rows += appendRows( tsv, functions[next % functions.size()], nextRNGBetween( 0, 100, rng ) );
+    }
+
+    corpus.src = src.str();
+    corpus.tsv = tsv.str();
+    return corpus;
+}
+
+SampleSummary summarize( std::vector<std::uint64_t> samples ) {
+    SampleSummary summary;
+    if ( !samples.size() ) {
+        return summary;
+    }
+    std::sort( samples.begin(), samples.end() );
+
+    auto percentile = [&]( double p ) {
+        size_t rank = static_cast<size_t>( std::ceil( p / 100.0 * samples.size() ) );
+        return samples[rank ? rank - 1 : 0];
+    };
+    summary.minNs = samples.front();
+    summary.p50Ns = percentile( 50 );
+    summary.p90Ns = percentile( 90 );
+    summary.p99Ns = percentile( 99 );
+    summary.maxNs = samples.back();
+
+    double total = 0;
+    for ( const auto& ns : samples ) {
+        total += static_cast<double>( ns );
+    }
+    summary.meanNs = total / samples.size();
+    return summary;
+}
+
+std::string jsonEscape( const std::string& str ) {
+    std::ostringstream os;
+    for ( const char& c : str ) {
+        switch ( c ) {
+            case '"':
+                os << "\\\"";
+                break;
+            case '\\':
+                os << "\\\\";
+                break;
+            case '\n':
+                os << "\\n";
+                break;
+            case '\t':
+                os << "\\t";
+                break;
+            default:
+                if ( static_cast<unsigned char>( c ) < 0x20 ) {
+                    os << "\\u" << std::hex << std::setw( 4 ) << std::setfill( '0' ) << static_cast<int>( c )
+                       << std::dec;
+                }
+                else {
+                    os << c;
+                }
+        }
+    }
+    return os.str();
+}
+
+void writeSummaryJson( std::ostream& os, const SampleSummary& summary, std::uint64_t bytes ) {
+    double bytesPerSecond = summary.p50Ns ? static_cast<double>( bytes ) * 1e9 / summary.p50Ns : 0;
+
+    os << "\"minNs\": " << summary.minNs << ", \"p50Ns\": " << summary.p50Ns << ", \"p90Ns\": " << summary.p90Ns
+       << ", \"p99Ns\": " << summary.p99Ns << ", \"maxNs\": " << summary.maxNs << ", \"meanNs\": " << std::fixed
+       << std::setprecision( 1 ) << summary.meanNs << ", \"bytes\": " << bytes
+       << ", \"bytesPerSecond\": " << std::setprecision( 0 ) << bytesPerSecond << std::defaultfloat;
+}
+
+size_t parseBenchCount( const char* value, const char* optionName, bool allowZero ) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long count = std::strtoull( value, &end, 10 );
+    if ( !*value || *end || errno || ( !count && !allowZero ) || *value == '-' ) {
+        std::ostringstream os;
+        os << "Option --" << optionName << " expects a " << ( allowZero ? "non-negative" : "positive" )
+           << " number, got \'" << value << "\'";
+        throw InvalidArgumentException( sanitizeOutputMessage( os.str() ) );
+    }
+    return static_cast<size_t>( count );
+}
+
+static double parseBudgetBound( const std::string& value, const std::string& path, size_t lineNumber ) {
+    if ( value == "-" ) {
+        return -1;
+    }
+    char* end = nullptr;
+    double bound = std::strtod( value.c_str(), &end );
+    if ( value.empty() || *end || bound < 0 ) {
+        std::ostringstream os;
+        os << "Allocation budget " << path << ':' << lineNumber << " expects a non-negative number or -, got \'"
+           << value << "\'";
+        throw InvalidArgumentException( sanitizeOutputMessage( os.str() ) );
+    }
+    return bound;
+}
+
+AllocationBudgets readAllocationBudgets( const std::string& path ) {
+    std::ifstream in( path );
+    if ( !in ) {
+        throw IOErrorException( sanitizeOutputMessage( "Unable to read allocation budget " + path ) );
+    }
+
+    AllocationBudgets budgets;
+    std::string line;
+    for ( size_t lineNumber = 1; std::getline( in, line ); ++lineNumber ) {
+        if ( line.empty() || line[0] == '#' ) {
+            continue;
+        }
+        std::istringstream cells( line );
+        std::string key, maxAllocations, maxBytes = "-";
+        std::getline( cells, key, '\t' );
+        std::getline( cells, maxAllocations, '\t' );
+        std::getline( cells, maxBytes, '\t' );
+
+        AllocationBudget& budget = budgets[key];
+        budget.maxAllocations = parseBudgetBound( maxAllocations, path, lineNumber );
+        budget.maxBytes = parseBudgetBound( maxBytes, path, lineNumber );
+    }
+    return budgets;
+}
+
+void checkAllocationBudget( const AllocationBudgets& budgets, const std::string& key, double allocations,
+                            double bytes, std::vector<std::string>& violations ) {
+    auto found = budgets.find( key );
+    if ( found == budgets.end() ) {
+        return;
+    }
+    const AllocationBudget& budget = found->second;
+    std::ostringstream os;
+    os << std::fixed << std::setprecision( 3 );
+    if ( budget.maxAllocations >= 0 && allocations > budget.maxAllocations ) {
+        os << key << ": " << allocations << " allocations, budget is " << budget.maxAllocations;
+        violations.push_back( os.str() );
+        os.str( "" );
+    }
+    if ( budget.maxBytes >= 0 && bytes > budget.maxBytes ) {
+        os << key << ": " << bytes << " allocated bytes, budget is " << budget.maxBytes;
+        violations.push_back( os.str() );
+    }
+}
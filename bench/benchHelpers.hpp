@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * benchHelpers.hpp: Workload generation, timing and JSON reporting shared by the benchmarks
+ *
+ * - Synthetic corpora are generated from a seed with the same ChaCha generator the mutate command uses, so a given
+ seed always yields byte for byte the same source and TSV on every machine
+ * - The TSVs mix plain, multiline, regex, grouped (`^`/`@`) and optional rows, all of them written against lines
+ that exist in the generated source
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_BENCHHELPERS_HPP_
+#define _INCLUDED_BENCHHELPERS_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "chacharng/chacharng.hpp"
+
+#define BENCH_DEFAULT_SEED "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6"
+
+struct SyntheticCorpus {
+    std::string src;
+    std::string tsv;
+    size_t lines = 0;  // actual counts, the generator rounds up to whole functions and whole groups
+    size_t rows = 0;
+};
+
+// Throws InvalidSeedException unless seed is 64 hexadecimal digits
+State seededState( const std::string& seed );
+
+SyntheticCorpus generateCorpus( size_t lines, size_t rows, State& rng );
+
+class Stopwatch {
+   private:
+    std::chrono::steady_clock::time_point start;
+
+   public:
+    Stopwatch() : start{ std::chrono::steady_clock::now() } {}
+
+    void reset() { start = std::chrono::steady_clock::now(); }
+
+    std::uint64_t elapsedNs() const {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count() );
+    }
+};
+
+struct SampleSummary {
+    std::uint64_t minNs = 0;
+    std::uint64_t p50Ns = 0;
+    std::uint64_t p90Ns = 0;
+    std::uint64_t p99Ns = 0;
+    std::uint64_t maxNs = 0;
+    double meanNs = 0;
+};
+
+// Nearest rank percentiles, samples does not need to be sorted
+SampleSummary summarize( std::vector<std::uint64_t> samples );
+
+std::string jsonEscape( const std::string& str );
+
+// Writes the summary as the members of a JSON object (no braces). Throughput is bytes over the median
+void writeSummaryJson( std::ostream& os, const SampleSummary& summary, std::uint64_t bytes );
+
+// Parses a positive (or zero if allowed) decimal command line value, throws InvalidArgumentException naming the option
+// otherwise
+size_t parseBenchCount( const char* value, const char* optionName, bool allowZero = false );
+
+// Upper bounds on the allocations of one benchmark entry, per repetition or per op. Negative means no bound
+struct AllocationBudget {
+    double maxAllocations = -1;
+    double maxBytes = -1;
+};
+
+using AllocationBudgets = std::map<std::string, AllocationBudget>;
+
+// Reads lines of "key<TAB>maxAllocations[<TAB>maxBytes]", where a bound may be - for none. Blank lines and lines
+// starting with # are skipped. Throws IOErrorException or InvalidArgumentException
+AllocationBudgets readAllocationBudgets( const std::string& path );
+
+// Adds a message to violations when key has a budget and the measured allocations or bytes go over it
+void checkAllocationBudget( const AllocationBudgets& budgets, const std::string& key, double allocations,
+                            double bytes, std::vector<std::string>& violations );
+
+#endif  // _INCLUDED_BENCHHELPERS_HPP_
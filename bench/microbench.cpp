@@ -0,0 +1,415 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * microbench.cpp: Isolated benchmarks of the hot kernels of the mutate pipeline
+ *
+ * - Regressions in a single kernel get lost in the noise of mutatebench, so every kernel is timed on its own here
+ over the same synthetic corpus mutatebench generates
+ * - Every kernel reports ns/op, bytes/s, heap allocations per op and, where perf_event_open() works, hardware
+ counters per op as JSON
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "allocCounter.hpp"
+#include "benchHelpers.hpp"
+#include "chacharng/chacharng.hpp"
+#include "commands/cli-options.hpp"
+#include "commands/mutate/mutateDataStructures.hpp"
+#include "commands/mutate/mutationsRetriever.hpp"
+#include "commands/mutate/mutationsSelector.hpp"
+#include "commands/mutate/regexCache.hpp"
+#include "commands/mutate/regexReplacer.hpp"
+#include "commands/tsvFileHelpers.hpp"
+#include "common.hpp"
+#include "excepts.hpp"
+#include "perfCounters.hpp"
+// same trick as the tests, the kernels below are private members
+#define class struct
+#define private public
+#define protected public
+#include "commands/mutate/mutator.hpp"
+#include "commands/mutate/textReplacer.hpp"
+#undef protected
+#undef private
+#undef class
+
+struct MicroOptions {
+    size_t minTimeMs = 200;  // per kernel, split across the samples
+    size_t samples = 5;
+    size_t lines = 10000;
+    std::string filter;
+    std::string seed = BENCH_DEFAULT_SEED;
+    std::string outputFileName;
+    AllocationBudgets budgets;
+};
+
+struct KernelResult {
+    std::string name;
+    std::uint64_t iterations = 0;  // per sample
+    double nsPerOp = 0;            // of the median sample
+    double bytesPerOp = 0;
+    double allocationsPerOp = 0;
+    double allocatedBytesPerOp = 0;
+    PerfSample counters;  // over all timed samples, divided by the ops when reported
+    std::uint64_t totalOps = 0;
+};
+
+// Keeps the compiler from optimizing away results that are otherwise unused
+template <typename T>
+static inline void doNotOptimize( const T& value ) {
+    asm volatile( "" : : "g"( &value ) : "memory" );
+}
+
+static void printUsage( std::ostream& os ) {
+    const char* indent = "  ";
+    os << "Usage: microbench [OPTIONS...]\n\n";
+    os << indent << "-f, --filter=TEXT        Only run kernels whose name contains TEXT\n";
+    os << indent << "-t, --min-time=MS        Minimum time spent timing each kernel. Defaults to 200\n";
+    os << indent << "-n, --samples=NUMBER     Timed samples per kernel, the median is reported. Defaults to 5\n";
+    os << indent << "-l, --lines=NUMBER       Source lines of the generated corpus. Defaults to 10000\n";
+    os << indent << "-s, --seed=HEXSTRING     Seed of the generated corpus\n";
+    os << indent << "-o, --output=FILE        Write the JSON report to this file. Defaults to stdout\n";
+    os << indent << "    --alloc-budget=FILE  Fail (exit status 2) when a kernel allocates more per op than the budget "
+                    "in FILE allows\n";
+    os << indent << "-h, --help               Show this help page\n";
+}
+
+// returns false when only the help page was asked for
+static bool parseMicroArgs( int argc, char** argv, MicroOptions& options ) {
+    enum MicroOpts : int { ALLOC_BUDGET = 256 };
+    static const struct option longOptions[] = { { "filter", required_argument, NULL, 'f' },
+                                                 { "min-time", required_argument, NULL, 't' },
+                                                 { "samples", required_argument, NULL, 'n' },
+                                                 { "lines", required_argument, NULL, 'l' },
+                                                 { "seed", required_argument, NULL, 's' },
+                                                 { "output", required_argument, NULL, 'o' },
+                                                 { "alloc-budget", required_argument, NULL, ALLOC_BUDGET },
+                                                 { "help", no_argument, NULL, 'h' },
+                                                 { NULL, 0, NULL, 0 } };
+    int opt;
+    while ( ( opt = getopt_long( argc, argv, "f:t:n:l:s:o:h", longOptions, NULL ) ) != -1 ) {
+        switch ( opt ) {
+            case 'f':
+                options.filter = optarg;
+                break;
+            case 't':
+                options.minTimeMs = parseBenchCount( optarg, "min-time" );
+                break;
+            case 'n':
+                options.samples = parseBenchCount( optarg, "samples" );
+                break;
+            case 'l':
+                options.lines = parseBenchCount( optarg, "lines" );
+                break;
+            case 's':
+                options.seed = optarg;
+                seededState( options.seed );  // validate early
+                break;
+            case 'o':
+                options.outputFileName = optarg;
+                break;
+            case ALLOC_BUDGET:
+                options.budgets = readAllocationBudgets( optarg );
+                break;
+            case 'h':
+                printUsage( std::cout );
+                return false;
+            default:
+                throw InvalidArgumentException( "Unrecognized option, see microbench --help" );
+        }
+    }
+    if ( optind < argc ) {
+        throw InvalidArgumentException( "microbench does not accept non-positional arguments" );
+    }
+    return true;
+}
+
+// Doubles the iteration count until one sample takes long enough, then times the samples
+template <typename Op>
+static KernelResult runKernel( const char* name, double bytesPerOp, const MicroOptions& options,
+                               const PerfCounters& perf, Op&& op ) {
+    KernelResult result;
+    result.name = name;
+    result.bytesPerOp = bytesPerOp;
+
+    std::uint64_t sampleTargetNs = options.minTimeMs * 1000000 / options.samples;
+    std::uint64_t iterations = 1;
+    op();  // warm up caches and lazily built state
+    for ( ;; ) {
+        Stopwatch watch;
+        for ( std::uint64_t i = 0; i < iterations; ++i ) {
+            op();
+        }
+        if ( watch.elapsedNs() >= sampleTargetNs || iterations >= ( std::uint64_t( 1 ) << 40 ) ) {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    std::vector<std::uint64_t> samples;
+    samples.reserve( options.samples );  // so that only the allocations of op are counted
+    AllocationCounts before = currentAllocations();
+    PerfSample countersBefore = perf.read();
+    for ( size_t sample = 0; sample < options.samples; ++sample ) {
+        Stopwatch watch;
+        for ( std::uint64_t i = 0; i < iterations; ++i ) {
+            op();
+        }
+        samples.push_back( watch.elapsedNs() );
+    }
+    PerfSample countersAfter = perf.read();
+    AllocationCounts after = currentAllocations();
+
+    double totalOps = static_cast<double>( iterations ) * options.samples;
+    result.iterations = iterations;
+    result.nsPerOp = static_cast<double>( summarize( samples ).p50Ns ) / iterations;
+    result.allocationsPerOp = ( after.allocations - before.allocations ) / totalOps;
+    result.allocatedBytesPerOp = ( after.bytes - before.bytes ) / totalOps;
+    result.counters = countersAfter - countersBefore;
+    result.totalOps = iterations * options.samples;
+    return result;
+}
+
+// Returns the line of text holding needle without its indentation or line break
+static std::string trimmedLineContaining( const std::string& text, const std::string& needle ) {
+    size_t pos = text.find( needle );
+    if ( pos == std::string::npos ) {
+        throw InvalidArgumentException( "Generated corpus is missing \'" + needle + "\'" );
+    }
+    size_t begin = text.rfind( '\n', pos ) + 1;
+    size_t end = text.find( '\n', pos );
+    std::string line = text.substr( begin, end - begin );
+    return line.substr( line.find_first_not_of( ' ' ) );
+}
+
+// Same length replacement so that swapping pattern and replacement after every op keeps the subject stable
+static std::string swapOperator( std::string str, const std::string& from, const std::string& to ) {
+    size_t pos = str.find( from );
+    return str.replace( pos, from.size(), to );
+}
+
+static std::vector<KernelResult> runKernels( const MicroOptions& options, const PerfCounters& perf ) {
+    State corpusRng = seededState( options.seed );
+    SyntheticCorpus corpus = generateCorpus( options.lines, options.lines / 10, corpusRng );
+    Mutator mutator;
+    std::string stripped = mutator.removeStrComments( corpus.src );
+    std::string middle = "v" + std::to_string( corpus.lines / 18 );  // a function around the middle of the source
+
+    std::vector<KernelResult> results;
+    auto selected = [&]( const char* name ) {
+        return !options.filter.size() || std::string( name ).find( options.filter ) != std::string::npos;
+    };
+
+    if ( selected( "chacha_block" ) ) {
+        std::uint32_t in[16], out[16];
+        State rng = seededState( options.seed );
+        for ( auto& word : in ) {
+            word = rng();
+        }
+        results.push_back( runKernel( "chacha_block", sizeof( out ), options, perf, [&]() {
+            chacha_block( out, in );
+            ++in[12];
+            doNotOptimize( out );
+        } ) );
+    }
+
+    if ( selected( "nextRNGBetween" ) ) {
+        State rng = seededState( options.seed );
+        std::uint32_t sink = 0;
+        results.push_back( runKernel( "nextRNGBetween", sizeof( std::uint32_t ), options, perf, [&]() {
+            sink += nextRNGBetween( 0, 1000, rng );
+            doNotOptimize( sink );
+        } ) );
+    }
+
+    if ( selected( "isWhiteSpace" ) ) {
+        std::string text = corpus.src.substr( 0, 4096 );
+        results.push_back( runKernel( "isWhiteSpace", text.size(), options, perf, [&]() {
+            unsigned int spaces = 0;
+            for ( auto it = text.begin(); it != text.end(); ++it ) {
+                spaces += isWhiteSpace( it, text.end() );
+            }
+            doNotOptimize( spaces );
+        } ) );
+    }
+
+    if ( selected( "lastNonWhiteSpace" ) ) {
+        std::string line = trimmedLineContaining( stripped, "int " + middle + " = " ) + "        ";
+        results.push_back( runKernel( "lastNonWhiteSpace", line.size(), options, perf, [&]() {
+            size_t pos = lastNonWhiteSpace( line.begin(), line.end() );
+            doNotOptimize( pos );
+        } ) );
+    }
+
+    if ( selected( "getPatternOrPermutation" ) ) {
+        std::string row = corpus.tsv.substr( corpus.tsv.find( '\n' ) + 1 );
+        row = row.substr( 0, row.find( '\n' ) );
+        results.push_back( runKernel( "getPatternOrPermutation", row.size(), options, perf, [&]() {
+            auto it = row.begin();
+            int lineNumber = 1;
+            while ( it != row.end() ) {
+                while ( *it == '\t' ) {
+                    ++it;
+                }
+                std::string cell = getPatternOrPermutation( it, row.end(), lineNumber, 1 );
+                doNotOptimize( cell );
+            }
+        } ) );
+    }
+
+    if ( selected( "singleLineReplace" ) ) {
+        std::string subject = stripped;
+        std::string pattern = trimmedLineContaining( subject, middle + " = " + middle + " << " );
+        std::string replacement = swapOperator( pattern, "<<", ">>" );
+        TextReplacer replacer;
+        replacer.isNewLined = false;
+        results.push_back( runKernel( "singleLineReplace", subject.size(), options, perf, [&]() {
+            replacer.patternStr = pattern;
+            int matches = replacer.singleLineReplace( subject, replacement );
+            doNotOptimize( matches );
+            std::swap( pattern, replacement );
+        } ) );
+    }
+
+    if ( selected( "multilineReplace" ) ) {
+        std::string subject = stripped;
+        std::string firstLine = trimmedLineContaining( subject, "if ( " + middle + " > " );
+        size_t secondLinePos = subject.find( '\n', subject.find( firstLine ) ) + 1;
+        std::string pattern =
+            firstLine + "\n" + subject.substr( secondLinePos, subject.find( '\n', secondLinePos ) - secondLinePos );
+        std::string replacement = swapOperator( pattern, " > ", " < " );
+        TextReplacer replacer;
+        replacer.isNewLined = false;
+        results.push_back( runKernel( "multilineReplace", subject.size(), options, perf, [&]() {
+            replacer.patternStr = pattern;
+            int matches = replacer.multilineReplace( subject, replacement );
+            doNotOptimize( matches );
+            std::swap( pattern, replacement );
+        } ) );
+    }
+
+    if ( selected( "removeStrComments" ) ) {
+        results.push_back( runKernel( "removeStrComments", corpus.src.size(), options, perf, [&]() {
+            std::string result = mutator.removeStrComments( corpus.src );
+            doNotOptimize( result );
+        } ) );
+    }
+
+    if ( selected( "regexReplace" ) ) {
+        std::string subject = stripped;
+        RegexCache regexCache;
+        const RegexEngine& regex = regexCache.get( middle + " -= \\d+;" );
+        std::string replacement = middle + " -= 7;";  // matches again, so every op replaces as many matches
+        RegexReplacer regexReplacer;
+        results.push_back( runKernel( "regexReplace", subject.size(), options, perf, [&]() {
+            int matches = regexReplacer( subject, regex, replacement, "Fgnm", false );
+            doNotOptimize( matches );
+        } ) );
+    }
+
+    return results;
+}
+
+static void writeReport( const MicroOptions& options, const PerfCounters& perf, const std::vector<KernelResult>& results,
+                         std::ostream& json ) {
+    json << "{\n";
+    json << "  \"benchmark\": \"microbench\", \"version\": \"" PROGRAM_VERSION "\", \"seed\": \""
+         << jsonEscape( options.seed ) << "\", \"lines\": " << options.lines << ", \"samples\": " << options.samples
+         << ", \"hardwareCounters\": " << ( perf.anyAvailable() ? "true" : "false" ) << ",\n";
+    json << "  \"kernels\": [\n";
+    for ( size_t i = 0; i < results.size(); ++i ) {
+        const KernelResult& r = results[i];
+        double bytesPerSecond = r.nsPerOp > 0 ? r.bytesPerOp * 1e9 / r.nsPerOp : 0;
+        json << "    { \"name\": \"" << jsonEscape( r.name ) << "\", \"iterations\": " << r.iterations << std::fixed
+             << std::setprecision( 3 ) << ", \"nsPerOp\": " << r.nsPerOp << std::setprecision( 0 )
+             << ", \"bytesPerOp\": " << r.bytesPerOp << ", \"bytesPerSecond\": " << bytesPerSecond
+             << std::setprecision( 3 ) << ", \"allocationsPerOp\": " << r.allocationsPerOp
+             << std::setprecision( 1 ) << ", \"allocatedBytesPerOp\": " << r.allocatedBytesPerOp
+             << std::setprecision( 3 );
+        for ( size_t e = 0; e < PERF_EVENT_COUNT; ++e ) {
+            json << ", \"" << PerfCounters::eventName( static_cast<PerfEvent>( e ) ) << "PerOp\": ";
+            if ( perf.isAvailable( static_cast<PerfEvent>( e ) ) && r.totalOps ) {
+                json << static_cast<double>( r.counters.values[e] ) / r.totalOps;
+            }
+            else {
+                json << "null";
+            }
+        }
+        json << std::defaultfloat << " }" << ( i + 1 < results.size() ? "," : "" ) << "\n";
+    }
+    json << "  ]\n}\n";
+}
+
+int main( int argc, char** argv ) {
+    try {
+        MicroOptions options;
+        if ( !parseMicroArgs( argc, argv, options ) ) {
+            return 0;
+        }
+        PerfCounters perf;
+        if ( !perf.anyAvailable() ) {
+            std::cerr << "microbench: hardware counters are unavailable, reporting times only: "
+                      << perf.getUnavailableReason() << std::endl;
+        }
+        std::vector<KernelResult> results = runKernels( options, perf );
+
+        std::ostringstream json;
+        writeReport( options, perf, results, json );
+        if ( options.outputFileName.size() ) {
+            std::ofstream out( options.outputFileName, std::ios::binary );
+            if ( !( out << json.str() ) ) {
+                throw IOErrorException( sanitizeOutputMessage( "Unable to write report to " + options.outputFileName ) );
+            }
+        }
+        else {
+            std::cout << json.str();
+        }
+
+        std::vector<std::string> violations;
+        for ( const auto& r : results ) {
+            checkAllocationBudget( options.budgets, "microbench/" + r.name, r.allocationsPerOp, r.allocatedBytesPerOp,
+                                   violations );
+        }
+        for ( const auto& violation : violations ) {
+            std::cerr << "microbench: allocation budget exceeded by " << violation << std::endl;
+        }
+        return violations.empty() ? 0 : 2;
+    } catch ( const InvalidSeedException& ex ) {
+        std::cerr << "microbench: Error processing seed\n" << ex.what() << std::endl;
+    } catch ( const InvalidArgumentException& ex ) {
+        std::cerr << "microbench: Error processing arguments\n" << ex.what() << std::endl;
+    } catch ( const IOErrorException& ex ) {
+        std::cerr << "microbench: I/O error\n" << ex.what() << std::endl;
+    } catch ( const std::exception& ex ) {
+        std::cerr << "microbench: Error " << ex.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,406 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutatebench.cpp: End to end benchmark of the mutate pipeline
+ *
+ * - Generates deterministic synthetic workloads from a seed and runs the same phases the mutate command runs (read,
+ strip comments, parse, categorize, select, replace, write) over many repetitions
+ * - Every repetition starts cold like a fresh mutate process would, nothing is cached between repetitions
+ * - Reports percentiles and throughput of every phase as JSON so that runs can be diffed for regressions
+ * - Adds the mean cycles, instructions, branch misses and cache misses of every phase where perf_event_open() works
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <getopt.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "allocCounter.hpp"
+#include "benchHelpers.hpp"
+#include "commands/cli-options.hpp"
+#include "commands/mutate/mutationsRetriever.hpp"
+#include "commands/mutate/mutationsSelector.hpp"
+#include "commands/mutate/mutator.hpp"
+#include "common.hpp"
+#include "excepts.hpp"
+#include "perfCounters.hpp"
+
+struct Workload {
+    std::string name;
+    size_t lines;
+    size_t rows;
+};
+
+struct BenchOptions {
+    std::vector<Workload> workloads;
+    size_t repetitions = 20;
+    size_t warmup = 2;
+    size_t count = 64;  // fixed so that the replace phase scales with the source and not with a random count
+    std::string seed = BENCH_DEFAULT_SEED;
+    std::string outputFileName;
+    AllocationBudgets budgets;
+};
+
+enum Phase : size_t { READ, STRIP, PARSE, CATEGORIZE, SELECT, REPLACE, WRITE, PHASE_COUNT };
+
+static const char* phaseNames[PHASE_COUNT] = { "read", "strip", "parse", "categorize", "select", "replace", "write" };
+
+static const std::vector<Workload> presetWorkloads = {
+    { "1k", 1000, 10 }, { "10k", 10000, 1000 }, { "100k", 100000, 10000 }, { "1m", 1000000, 100000 } };
+
+// Removes the generated corpus files however the benchmark exits
+class ScratchDir {
+   private:
+    std::filesystem::path path;
+
+   public:
+    ScratchDir() {
+        path = std::filesystem::temp_directory_path() / ( "mutatebench-" + std::to_string( getpid() ) );
+        std::filesystem::create_directories( path );
+    }
+
+    ~ScratchDir() {
+        std::error_code ignored;
+        std::filesystem::remove_all( path, ignored );
+    }
+
+    std::string file( const char* name ) const { return ( path / name ).string(); }
+};
+
+static void printUsage( std::ostream& os ) {
+    const char* indent = "  ";
+    os << "Usage: mutatebench [OPTIONS...]\n\n";
+    os << indent << "-w, --workload=NAMES     Comma separated presets out of 1k, 10k, 100k and 1m, or all. Defaults to "
+                    "1k,10k,100k\n";
+    os << indent << "-l, --lines=NUMBER       Run a custom workload with this many source lines instead of presets\n";
+    os << indent << "-t, --rows=NUMBER        Run a custom workload with this many TSV rows instead of presets\n";
+    os << indent << "-n, --repetitions=NUMBER Timed repetitions of every workload. Defaults to 20\n";
+    os << indent << "    --warmup=NUMBER      Untimed repetitions before those. Defaults to 2\n";
+    os << indent << "-c, --count=NUMBER       Mutations selected per repetition. Defaults to 64\n";
+    os << indent << "-s, --seed=HEXSTRING     Seed of the generated workloads and of the selection\n";
+    os << indent << "-o, --output=FILE        Write the JSON report to this file. Defaults to stdout\n";
+    os << indent << "    --alloc-budget=FILE  Fail (exit status 2) when a phase allocates more per repetition than the "
+                    "budget in FILE allows\n";
+    os << indent << "-h, --help               Show this help page\n";
+}
+
+static std::vector<Workload> parseWorkloads( const std::string& names ) {
+    if ( names == "all" ) {
+        return presetWorkloads;
+    }
+
+    std::vector<Workload> workloads;
+    std::istringstream is( names );
+    std::string name;
+    while ( std::getline( is, name, ',' ) ) {
+        bool found = false;
+        for ( const auto& preset : presetWorkloads ) {
+            if ( preset.name == name ) {
+                workloads.push_back( preset );
+                found = true;
+            }
+        }
+        if ( !found ) {
+            std::ostringstream os;
+            os << "Unknown workload \'" << name << "\', expected 1k, 10k, 100k, 1m or all";
+            throw InvalidArgumentException( sanitizeOutputMessage( os.str() ) );
+        }
+    }
+    return workloads;
+}
+
+// returns false when only the help page was asked for
+static bool parseBenchArgs( int argc, char** argv, BenchOptions& options ) {
+    enum BenchOpts : int { WARMUP = 256, ALLOC_BUDGET };
+    static const struct option longOptions[] = { { "workload", required_argument, NULL, 'w' },
+                                                 { "lines", required_argument, NULL, 'l' },
+                                                 { "rows", required_argument, NULL, 't' },
+                                                 { "repetitions", required_argument, NULL, 'n' },
+                                                 { "warmup", required_argument, NULL, WARMUP },
+                                                 { "count", required_argument, NULL, 'c' },
+                                                 { "seed", required_argument, NULL, 's' },
+                                                 { "output", required_argument, NULL, 'o' },
+                                                 { "alloc-budget", required_argument, NULL, ALLOC_BUDGET },
+                                                 { "help", no_argument, NULL, 'h' },
+                                                 { NULL, 0, NULL, 0 } };
+    size_t customLines = 0, customRows = 0;
+    std::string workloadNames = "1k,10k,100k";
+
+    int opt;
+    while ( ( opt = getopt_long( argc, argv, "w:l:t:n:c:s:o:h", longOptions, NULL ) ) != -1 ) {
+        switch ( opt ) {
+            case 'w':
+                workloadNames = optarg;
+                break;
+            case 'l':
+                customLines = parseBenchCount( optarg, "lines" );
+                break;
+            case 't':
+                customRows = parseBenchCount( optarg, "rows" );
+                break;
+            case 'n':
+                options.repetitions = parseBenchCount( optarg, "repetitions" );
+                break;
+            case WARMUP:
+                options.warmup = parseBenchCount( optarg, "warmup", true );
+                break;
+            case 'c':
+                options.count = parseBenchCount( optarg, "count" );
+                break;
+            case 's':
+                options.seed = optarg;
+                seededState( options.seed );  // validate early
+                break;
+            case 'o':
+                options.outputFileName = optarg;
+                break;
+            case ALLOC_BUDGET:
+                options.budgets = readAllocationBudgets( optarg );
+                break;
+            case 'h':
+                printUsage( std::cout );
+                return false;
+            default:
+                throw InvalidArgumentException( "Unrecognized option, see mutatebench --help" );
+        }
+    }
+    if ( optind < argc ) {
+        throw InvalidArgumentException( "mutatebench does not accept non-positional arguments" );
+    }
+
+    if ( customLines || customRows ) {
+        options.workloads = { { "custom", customLines ? customLines : 10000, customRows ? customRows : 1000 } };
+    }
+    else {
+        options.workloads = parseWorkloads( workloadNames );
+    }
+    return true;
+}
+
+static void writeFile( const std::string& path, const std::string& content ) {
+    std::ofstream out( path, std::ios::binary );
+    if ( !( out << content ) ) {
+        throw IOErrorException( sanitizeOutputMessage( "Unable to write benchmark corpus to " + path ) );
+    }
+}
+
+// Mean per repetition of every available counter, or null when none is
+static void writeCountersJson( std::ostream& json, const PerfCounters& perf, const PerfSample& total,
+                               size_t repetitions ) {
+    if ( !perf.anyAvailable() ) {
+        json << "null";
+        return;
+    }
+    json << "{ ";
+    for ( size_t e = 0; e < PERF_EVENT_COUNT; ++e ) {
+        json << ( e ? ", " : "" ) << "\"" << PerfCounters::eventName( static_cast<PerfEvent>( e ) ) << "\": ";
+        if ( perf.isAvailable( static_cast<PerfEvent>( e ) ) ) {
+            json << total.values[e] / repetitions;
+        }
+        else {
+            json << "null";
+        }
+    }
+    json << " }";
+}
+
+static void runWorkload( const Workload& workload, const BenchOptions& options, const ScratchDir& scratch,
+                         const PerfCounters& perf, std::ostream& json, std::vector<std::string>& violations ) {
+    State rng = seededState( options.seed );
+    SyntheticCorpus corpus = generateCorpus( workload.lines, workload.rows, rng );
+    std::string srcPath = scratch.file( "corpus.c" );
+    std::string tsvPath = scratch.file( "corpus.tsv" );
+    std::string outPath = scratch.file( "mutant.c" );
+    writeFile( srcPath, corpus.src );
+    writeFile( tsvPath, corpus.tsv );
+
+    std::cerr << "mutatebench: " << workload.name << " (" << corpus.lines << " lines, " << corpus.rows << " rows, "
+              << options.repetitions << " repetitions)" << std::endl;
+
+    std::array<std::vector<std::uint64_t>, PHASE_COUNT> samples;
+    std::array<PerfSample, PHASE_COUNT> counters;  // summed over the timed repetitions
+    std::array<AllocationCounts, PHASE_COUNT> allocations{};
+    std::vector<std::uint64_t> totals;
+    std::array<std::uint64_t, PHASE_COUNT> bytes{};
+    size_t selectedCount = 0;
+    std::string countString = std::to_string( options.count );
+
+    for ( size_t rep = 0; rep < options.warmup + options.repetitions; ++rep ) {
+        std::array<std::uint64_t, PHASE_COUNT> elapsed;
+        std::array<PerfSample, PHASE_COUNT> counted;
+        std::array<AllocationCounts, PHASE_COUNT> allocated;
+        auto measure = [&]( Phase phase, auto&& body ) {
+            AllocationCounts allocationsBefore = currentAllocations();
+            PerfSample before = perf.read();
+            Stopwatch watch;
+            body();
+            elapsed[phase] = watch.elapsedNs();
+            counted[phase] = perf.read() - before;
+            AllocationCounts allocationsAfter = currentAllocations();
+            allocated[phase].allocations = allocationsAfter.allocations - allocationsBefore.allocations;
+            allocated[phase].bytes = allocationsAfter.bytes - allocationsBefore.bytes;
+        };
+
+        CLIOptions opts;
+        opts.setSrcInput( srcPath.c_str() );
+        opts.setTsvInput( tsvPath.c_str() );
+        opts.setSeed( options.seed.c_str() );
+        opts.setMutCount( countString.c_str() );
+
+        std::string src, tsv;
+        measure( READ, [&]() {
+            src = opts.getSrcString();
+            tsv = opts.getTsvString();
+        } );
+
+        Mutator mutator;  // a new one every repetition so that regexes are compiled every time, as in the CLI
+        std::string stripped;
+        measure( STRIP, [&]() { stripped = mutator.removeStrComments( src ); } );
+
+        MutationsRetriever retriever( tsv );
+        measure( PARSE, [&]() { retriever.capturePossibleMutations(); } );
+
+        measure( CATEGORIZE, [&]() {
+            retriever.categorizeMutations();
+            retriever.checkNesting();
+        } );
+
+        SelectedMutVec selected;
+        measure( SELECT, [&]() {
+            MutationsSelector selector( &opts, retriever.getPossibleMutations() );
+            selected = selector.getSelectedMutations();
+        } );
+
+        size_t strippedSize = stripped.size();
+        measure( REPLACE, [&]() { mutator.applyMutations( stripped, selected, &opts ); } );
+
+        measure( WRITE, [&]() {
+            opts.setResOutput( outPath.c_str() );
+            opts.putResOutput( stripped );
+        } );
+
+        if ( rep < options.warmup ) {
+            continue;
+        }
+        std::uint64_t total = 0;
+        for ( size_t phase = 0; phase < PHASE_COUNT; ++phase ) {
+            samples[phase].push_back( elapsed[phase] );
+            counters[phase] += counted[phase];
+            allocations[phase].allocations += allocated[phase].allocations;
+            allocations[phase].bytes += allocated[phase].bytes;
+            total += elapsed[phase];
+        }
+        totals.push_back( total );
+
+        bytes[READ] = src.size() + tsv.size();
+        bytes[STRIP] = src.size();
+        bytes[PARSE] = bytes[CATEGORIZE] = bytes[SELECT] = tsv.size();
+        bytes[REPLACE] = strippedSize;
+        bytes[WRITE] = stripped.size();
+        selectedCount = selected.size();
+    }
+
+    json << "    {\n";
+    json << "      \"name\": \"" << jsonEscape( workload.name ) << "\", \"lines\": " << corpus.lines
+         << ", \"rows\": " << corpus.rows << ", \"srcBytes\": " << corpus.src.size()
+         << ", \"tsvBytes\": " << corpus.tsv.size() << ", \"selectedMutations\": " << selectedCount << ",\n";
+    json << "      \"phases\": {\n";
+    for ( size_t phase = 0; phase < PHASE_COUNT; ++phase ) {
+        json << "        \"" << phaseNames[phase] << "\": { ";
+        writeSummaryJson( json, summarize( samples[phase] ), bytes[phase] );
+        double meanAllocations = static_cast<double>( allocations[phase].allocations ) / options.repetitions;
+        double meanAllocatedBytes = static_cast<double>( allocations[phase].bytes ) / options.repetitions;
+        json << std::fixed << std::setprecision( 1 ) << ", \"allocations\": " << meanAllocations
+             << ", \"allocatedBytes\": " << meanAllocatedBytes << std::defaultfloat << ", \"counters\": ";
+        checkAllocationBudget( options.budgets, "mutatebench/" + workload.name + "/" + phaseNames[phase],
+                               meanAllocations, meanAllocatedBytes, violations );
+        writeCountersJson( json, perf, counters[phase], options.repetitions );
+        json << " }" << ( phase + 1 < PHASE_COUNT ? "," : "" ) << "\n";
+    }
+    json << "      },\n";
+    json << "      \"total\": { ";
+    writeSummaryJson( json, summarize( totals ), corpus.src.size() + corpus.tsv.size() );
+    json << " }\n";
+    json << "    }";
+}
+
+// returns false when an allocation budget was exceeded
+static bool runBenchmarks( const BenchOptions& options ) {
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"benchmark\": \"mutatebench\", \"version\": \"" PROGRAM_VERSION "\", \"seed\": \""
+         << jsonEscape( options.seed ) << "\",\n";
+    json << "  \"repetitions\": " << options.repetitions << ", \"warmup\": " << options.warmup
+         << ", \"count\": " << options.count << ",\n";
+    PerfCounters perf;
+    if ( !perf.anyAvailable() ) {
+        std::cerr << "mutatebench: hardware counters are unavailable, reporting times only: "
+                  << perf.getUnavailableReason() << std::endl;
+    }
+    json << "  \"hardwareCounters\": " << ( perf.anyAvailable() ? "true" : "false" ) << ",\n";
+    json << "  \"workloads\": [\n";
+
+    ScratchDir scratch;
+    std::vector<std::string> violations;
+    for ( size_t i = 0; i < options.workloads.size(); ++i ) {
+        runWorkload( options.workloads[i], options, scratch, perf, json, violations );
+        json << ( i + 1 < options.workloads.size() ? ",\n" : "\n" );
+    }
+    json << "  ]\n}\n";
+
+    if ( options.outputFileName.size() ) {
+        writeFile( options.outputFileName, json.str() );
+    }
+    else {
+        std::cout << json.str();
+    }
+
+    for ( const auto& violation : violations ) {
+        std::cerr << "mutatebench: allocation budget exceeded by " << violation << std::endl;
+    }
+    return violations.empty();
+}
+
+int main( int argc, char** argv ) {
+    try {
+        BenchOptions options;
+        if ( parseBenchArgs( argc, argv, options ) && !runBenchmarks( options ) ) {
+            return 2;
+        }
+        return 0;
+    } catch ( const TSVParsingException& ex ) {
+        std::cerr << "mutatebench: Error parsing generated TSV\n" << ex.what() << std::endl;
+    } catch ( const InvalidSeedException& ex ) {
+        std::cerr << "mutatebench: Error processing seed\n" << ex.what() << std::endl;
+    } catch ( const InvalidArgumentException& ex ) {
+        std::cerr << "mutatebench: Error processing arguments\n" << ex.what() << std::endl;
+    } catch ( const IOErrorException& ex ) {
+        std::cerr << "mutatebench: I/O error\n" << ex.what() << std::endl;
+    } catch ( const std::exception& ex ) {
+        std::cerr << "mutatebench: Error " << ex.what() << std::endl;
+    }
+    return 1;
+}
@@ -0,0 +1,66 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * allocProfiler.hpp: Heap allocations attributed to pipeline phases, in builds configured with
+ * -DMUTATEPLACEHOLDER_ALLOC_PROFILING=ON
+ *
+ * - Such builds replace the global operator new/delete with counting shims, every allocation is added to the phase
+ * (see ScopedPhase) its thread is in at the time, or to StatsPhase::COUNT outside of any phase
+ * - In normal builds nothing is replaced, AllocProfiler::enabled is false and every count reads as 0
+ * - Only allocations made through operator new are seen, not the ones PCRE2 makes with malloc()
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_ALLOCPROFILER_HPP
+#define _INCLUDED_ALLOCPROFILER_HPP
+
+#include <cstdint>
+
+enum class StatsPhase : unsigned char;  // pipelineStats.hpp
+
+struct AllocationTally {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0;
+
+    AllocationTally operator-(const AllocationTally& other) const {
+        return {allocations - other.allocations, bytes - other.bytes};
+    }
+    AllocationTally& operator+=(const AllocationTally& other) {
+        allocations += other.allocations;
+        bytes += other.bytes;
+        return *this;
+    }
+};
+
+class AllocProfiler {
+   public:
+#ifdef MUTATEPLACEHOLDER_ALLOC_PROFILING
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    // Attributes the following allocations of the calling thread to phase, returns the phase it replaces
+    static StatsPhase enterPhase(StatsPhase phase);
+
+    // Allocations the calling thread made in phase so far
+    static AllocationTally get(StatsPhase phase);
+
+    // Allocations of every thread so far
+    static AllocationTally total();
+};
+
+#endif  //_INCLUDED_ALLOCPROFILER_HPP
@@ -26,6 +26,9 @@
 
 constexpr std::size_t SEED_SIZE_BYTES = 8 * 4;
 
+// One ChaCha20 block function call, only exposed outside of State for the microbenchmarks
+void chacha_block(std::uint32_t out[16], std::uint32_t const in[16]);
+
 class State {
    private:
     std::uint32_t block[16];
@@ -43,16 +43,32 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <vector>
 
 #include "chacharng/chacharng.hpp"
 #include "chacharng/seedHelper.hpp"
+#include "commands/sourceLexer.hpp"
 #include "common.hpp"
+#include "pipelineStats.hpp"
 
 enum class Format : unsigned char { HTML, SRCTEXT, TSVTEXT };
 
+enum class MatchMode : unsigned char { TEXT, TOKENS };
+
+// Per-row resource limits of the regex pattern cells, 0 keeps the PCRE2 default
+struct RegexLimits {
+    std::uint32_t matchLimit = 0;
+    std::uint32_t depthLimit = 0;
+    std::uint32_t heapLimitKib = 0;
+
+    bool operator==(const RegexLimits& other) const {
+        return matchLimit == other.matchLimit && depthLimit == other.depthLimit && heapLimitKib == other.heapLimitKib;
+    }
+};
+
 class CLIOptions {
    private:
     FILE* srcInput;
@@ -60,31 +76,62 @@ class CLIOptions {
     FILE* resOutput;
     FILE* seedInput;
     FILE* seedOutput;
+    FILE* descriptorOutput;
 
    protected:
     std::optional<std::string> seedString;
+    std::optional<std::string> descriptor;
     std::optional<std::string> srcString;
     std::optional<std::string> tsvString;
     std::optional<std::string> outputFileName;
     std::optional<std::string> inputFileName;
+    std::optional<std::string> socketPath;
+    std::optional<std::string> traceFileName;
+    std::optional<std::string> treeRoot;
+    std::optional<std::string> fileListName;
+    std::optional<std::string> outputDirName;
+    std::optional<std::string> testCommand;
+    std::optional<std::string> killPattern;
+    std::optional<std::string> workDirName;
+    std::vector<std::string> globs;
     // std::optional<std::string> resString;
 
     std::optional<std::int32_t> mutCount;
     std::optional<std::int32_t> minMutCount;
     std::optional<std::int32_t> maxMutCount;
+    std::optional<std::int32_t> jobs;
+    std::optional<std::int32_t> timeLimitMs;
+
+    RegexLimits regexLimits;
 
     std::optional<Format> format;
 
+    const SourceLexer* language = nullptr;  // nullptr unless --language was given
+
+    std::optional<MatchMode> matchMode;
+
+    std::optional<StatsFormat> statsFormat;
+    PipelineStats stats;
+
     bool overwriteOutputFile = false;
+    bool hardwareCounters = false;
+    bool streaming = false;
+    bool schemata = false;
+    bool jobsFromStdin = false;
+    bool hardlinks = false;
+    bool verboseOutput = false;
 
     std::vector<std::string> warnings;
     std::vector<int> noMatchLines;
     std::vector<int> multipleMatchLines;
+    std::vector<int> regexLimitLines;
 
     void setSrcOrTsvInput(FILE** srcOrTsv, const char* path, const char* mode, int bufferMode, const char* which);
     void setSeedInputOrOutput(FILE** inOrOut, const char* path, const char* mode, int bufferMode, const char* which);
     void setMinOrMaxMutCount(std::optional<std::int32_t>* minOrMax, const char* count, const char* shortName,
                              const char* fullName);
+    void setRegexLimit(std::uint32_t* limit, const char* value, const char* fullName);
+    void readSrcTsvTogether();  // when both come from stdin, split from one read
 
    public:
     CLIOptions();
@@ -97,47 +144,137 @@ class CLIOptions {
     void setSeedInput(const char* path);
     void setSeedOutput(const char* path);
     void setSeed(const char* seed);
+    void setDescriptor(const char* text);
+    void setDescriptorOutput(const char* path);
     void setMutCount(const char* count);
     void setMinMutCount(const char* count);
     void setMinMutCount(std::int32_t count);
     void setMaxMutCount(const char* count);
     void setMaxMutCount(std::int32_t count);
     void forceOverwrite();
+    void setSocketPath(const char* path);
+    void setStats(const char* fmt);  // fmt is nullptr when --stats is given without a value
+    void setTraceFileName(const char* path);
+    void requestHardwareCounters();
+    void requestStreaming();
+    void requestSchemata();
+    void requestJobsFromStdin();
+    void setLanguage(const char* name);
+    void setMatchMode(const char* mode);
+    void setTreeRoot(const char* path);
+    void setFileListName(const char* path);  // "-" for stdin
+    void setOutputDirName(const char* path);
+    void addGlob(const char* glob);
+    void setJobs(const char* count);
+    void setRegexMatchLimit(const char* limit);
+    void setRegexDepthLimit(const char* limit);
+    void setRegexHeapLimit(const char* kib);
+    void setRegexLimits(const RegexLimits& limits);  // copies them all at once, for the per-file options of --tree
+    void setTimeLimit(const char* ms);
+    void setTestCommand(const char* command);
+    void setKillPattern(const char* pattern);
+    void setWorkDirName(const char* path);
+    void requestHardlinks();
+    void requestVerboseOutput();
 
     void setFormat(const char* fmt);
-    std::string getSrcString();
-    std::string getTsvString();
+    // Read on the first call, the references stay valid as long as the options
+    const std::string& getSrcString();
+    const std::string& getTsvString();
+    // Reads up to size bytes of the source without keeping them, for --stream. Returns 0 at the end of the input
+    std::size_t readSrcChunk(char* buffer, std::size_t size);
     void putResOutput(std::string result);
     void putSeedOutput(std::string result);
+    void putDescriptorOutput(std::string result);
 
     // check these before using a getter as getters will throw
     bool hasSeed();
+    bool hasDescriptor();  // --apply
     bool hasMutCount();
     bool hasMinMutCount();
     bool hasMaxMutCount();
     bool hasOutputFileName();
     bool hasInputFileName();
+    bool hasTsvFile();  // --mutations named a file rather than stdin
     bool hasSrcString();
+    bool hasSocketPath();
+    bool hasStats();
+    bool hasTraceFileName();
+    bool wantsHardwareCounters();
+    bool wantsStreaming();
+    bool wantsSchemata();
+    bool wantsJobsFromStdin();
+    bool hasLanguage();
+    bool hasMatchMode();
+    bool hasTreeRoot();
+    bool hasFileListName();
+    bool hasOutputDirName();
+    bool hasJobs();
+    bool hasRegexLimits();  // any of --regex-match-limit, --regex-depth-limit or --regex-heap-limit was given
+    bool hasTimeLimit();
+    bool hasTestCommand();
+    bool hasKillPattern();
+    bool hasWorkDirName();
+    bool wantsHardlinks();
+    bool wantsVerboseOutput();  // --verbose, for printing status of process messages
+
+    // --tree or --file-list was given, so a whole set of files is mutated instead of --input
+    bool isTreeMode();
+
+    // any of the options that only tree mode takes was given
+    bool hasTreeOptions();
+
+    // any of the options that only the run command takes was given
+    bool hasRunOptions();
 
     bool hasFormat();
 
     bool seedNeedsExporting();
+    bool descriptorNeedsExporting();
     bool okToOverwriteOutputFile();
 
     // These will throw a std::bad_optional_access error if no value was
     // defined/provided, so be sure to check the hasValue() methods first
     std::string getSeed();
+    const std::string& getDescriptor();
     int32_t getMutCount();
     int32_t getMinMutCount();
     int32_t getMaxMutCount();
     const char* getOutputFileName();
     const char* getInputFileName();
+    const char* getSocketPath();
+    StatsFormat getStatsFormat();
+    const char* getTraceFileName();
+    const char* getTreeRoot();
+    const char* getFileListName();
+    const char* getOutputDirName();
+    int32_t getJobs();
+    int32_t getTimeLimit();  // milliseconds
+    const char* getTestCommand();
+    const char* getKillPattern();
+    const char* getWorkDirName();
+
+    // All zeros unless one of the --regex-*-limit options was given
+    const RegexLimits& getRegexLimits();
+
+    // Empty unless --glob was given
+    const std::vector<std::string>& getGlobs();
+
+    // The --language lexer, else the one for the extension of --input, else the C++ one
+    const SourceLexer& getLexer();
+
+    // --match, TEXT when it was not given
+    MatchMode getMatchMode();
+
+    // nullptr unless --stats was given, so callers can pass it straight to ScopedPhase
+    PipelineStats* getStats();
 
     Format getFormat();
 
     void addWarning(std::string str);
     void addNoMatchLine(int n);
     void addMultipleMatchLine(int n);
+    void addRegexLimitLine(int n);
     std::string getWarnings();
 
     ~CLIOptions();
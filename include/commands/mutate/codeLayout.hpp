@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * codeLayout.hpp: Tells where a C or C++ source has statements and expressions that can be switched at runtime, for
+ --schemata
+ *
+ * - Works on the tokens of the lexer, so braces and operators in comments and literals do not count, with preprocessor
+ lines left out and punctuation joined into operators
+ * - Every brace is a function body or a block of one (lambdas included), a namespace / class / enum / linkage scope or
+ an initializer, told apart by what comes before it. Statements are only found in function bodies and blocks
+ * - An expression is a run of tokens the original parse groups on its own: the operators next to it bind looser than
+ every one at its top level. Types, casts, template arguments and constant expressions are not expressions here
+ * - A heuristic rather than a parser: what it cannot tell apart is treated as not switchable
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_CODELAYOUT_HPP
+#define _INCLUDED_CODELAYOUT_HPP
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "commands/sourceLexer.hpp"
+
+class CodeLayout {
+    enum class BraceKind : unsigned char { CODE, SCOPE, INITIALIZER };
+
+    struct Brace {
+        size_t open;  // token index
+        size_t parent;  // NONE at file scope
+        BraceKind kind;
+        bool lambda;  // a CODE brace that is part of an expression
+        bool doBody;  // a CODE brace whose statement goes on with while
+        bool constant;  // a CODE brace of a constexpr or consteval function, which may run at compile time
+    };
+
+    // A token with punctuation joined into operators
+    struct Piece {
+        size_t begin;
+        size_t end;
+        TokenKind kind;
+    };
+
+    // Where a piece is
+    struct Place {
+        size_t brace;  // the innermost one open, NONE at file scope
+        size_t open;  // the innermost parenthesis or bracket open in that brace, NONE for none
+        size_t statement;  // the first piece of the statement or declaration
+        bool startsStatement;  // a statement of a function body begins here
+    };
+
+    static constexpr size_t NONE = size_t( -1 );
+
+    const SourceLexer& lexer;
+
+    std::string source;
+
+    std::vector<Piece> pieces;
+
+    std::vector<Place> places;  // by piece
+
+    std::vector<size_t> matches;  // by piece, the other one of a pair of (), [] or {}, NONE for anything else
+
+    std::vector<Brace> braces;
+
+    // The tokens of text outside preprocessor lines, with punctuation joined into operators
+    std::vector<Piece> split( std::string_view text ) const;
+
+    std::string_view textOf( const Piece& piece ) const {
+        return std::string_view( source ).substr( piece.begin, piece.end - piece.begin );
+    }
+
+    // Fills places, matches and braces
+    void walk();
+
+    // What the brace opened by piece i is, with the place before it
+    BraceKind kindOf( size_t i, const Place& place, bool& lambda ) const;
+
+    // Whether the statement starting at piece i declares something, or begins with a label
+    bool isDeclaration( size_t i ) const;
+
+    bool isLabel( size_t i ) const;
+
+    // The nearest brace around i that is not an initializer is a function body or block
+    bool inCode( size_t i ) const;
+
+    // Whether i is in the body of a constexpr or consteval function
+    bool inConstantBody( size_t i ) const;
+
+    // The first piece of the statement around i, the one of the declaration for a piece in an initializer
+    size_t outerStatement( size_t i ) const;
+
+    // The > that closes template arguments from piece i on, NONE when the expression around i ends first
+    size_t templateClose( size_t i ) const;
+
+    // Whether i is in template arguments or is the > closing them
+    bool inTemplateArguments( size_t i ) const;
+
+    // Whether i is where a declaration names what it declares rather than in one of its initializers
+    bool inDeclarator( size_t i ) const;
+
+    // The lowest precedence of the operators of pieces [from, to) outside parentheses, 0 when they are not an
+    // expression on their own
+    static int precedenceOf( const std::vector<Piece>& list, std::string_view text, size_t from, size_t to );
+
+   public:
+    CodeLayout( const SourceLexer& _lexer, std::string _source );
+    CodeLayout( const CodeLayout& ) = delete;
+    CodeLayout& operator=( const CodeLayout& ) = delete;
+
+    // Whether [begin, end) on line boundaries is whole statements of a function body, none of them a declaration or
+    // label, so that an if / else chain can take their place. A point between two statements for begin == end
+    bool isStatements( size_t begin, size_t end ) const;
+
+    // Whether [begin, end) is an expression evaluated at runtime in a function body that every one of alternatives
+    // can stand in for inside a conditional expression
+    bool isExpression( size_t begin, size_t end, const std::vector<std::string_view>& alternatives ) const;
+};
+
+#endif  // _INCLUDED_CODELAYOUT_HPP
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * commentStripper.hpp: Removes comments from source code in a single pass, before mutations are applied
+ *
+ * - The SourceLexer of the language finds the comments, so comment markers inside literals are left alone
+ * - A comment is removed together with the blanks before it on its line, a line left blank by that is removed whole,
+ a block comment between two tokens becomes a single space and one spanning lines becomes a single line break
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_COMMENTSTRIPPER_HPP
+#define _INCLUDED_COMMENTSTRIPPER_HPP
+
+#include <string>
+#include <string_view>
+
+#include "commands/sourceLexer.hpp"
+
+class CommentStripper {
+    const SourceLexer& lexer;
+
+    std::string_view src;
+
+    std::string out;
+
+    bool lineHadComment;  // whether a comment was removed from the output line being written
+
+    bool pendingSpace;  // a block comment was removed right after a token, separate it from the next one
+
+    void appendCode( size_t start, size_t end );
+
+    void copyCode( size_t start, size_t end );
+
+    size_t removeComment( const Token& comment );
+
+    void endLine();
+
+    void trimTrailingBlanks();
+
+   public:
+    explicit CommentStripper( const SourceLexer& _lexer = SourceLexer::getDefault() ) : lexer{ _lexer } {}
+
+    std::string operator()( std::string_view source );
+};
+
+#endif  // _INCLUDED_COMMENTSTRIPPER_HPP
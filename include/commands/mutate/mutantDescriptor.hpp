@@ -0,0 +1,75 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutantDescriptor.hpp: A few dozen bytes telling which mutations make a mutant, to store instead of the mutant and
+ rebuild it from with --apply
+ *
+ * - Written as "1:TSVHASH:SRCHASH:LANGUAGE:MATCH:LINE.PERMUTATION,LINE.PERMUTATION,...", the hashes being the
+ hashBytes() of the TSV and of the source (before comments are stripped) in 16 hexadecimal digits, LANGUAGE the name of
+ the lexer the comments were stripped with and MATCH the --match mode, text or tokens
+ * - Each mutation is the line number of its row in the TSV and the permutation picked, counted from 1, listed in the
+ order they are applied. Line numbers rather than positions among the rows, so that the descriptors of --tree, whose
+ files only get the rows of their "#paths:" scopes, replay with the whole TSV
+ * - Replaying one needs neither the seed nor the selection: the rows are looked up and applied as they are, with the
+ lexer and match mode it names, since either can change what a row matches
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_MUTANTDESCRIPTOR_HPP
+#define _INCLUDED_MUTANTDESCRIPTOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "commands/cli-options.hpp"
+#include "commands/mutate/mutateDataStructures.hpp"
+
+struct MutantDescriptor {
+    struct Mutation {
+        size_t lineNumber;  // of the row in the TSV
+        size_t permutation;  // counted from 1
+    };
+
+    std::uint64_t tsvHash = 0;
+    std::uint64_t srcHash = 0;
+    std::string language;  // the name of the lexer
+    MatchMode matchMode = MatchMode::TEXT;
+    std::vector<Mutation> mutations;  // in the order they are applied
+
+    MutantDescriptor() = default;
+
+    MutantDescriptor( const std::string& tsv, const std::string& src, const SourceLexer& lexer, MatchMode _matchMode,
+                      std::vector<Mutation> _mutations );
+
+    // What a selection is made of, in the order it is applied
+    static std::vector<Mutation> mutationsOf( const SelectedMutVec& selected );
+
+    std::string toString() const;
+
+    // Throws InvalidArgumentException when text is not a descriptor
+    static MutantDescriptor parse( const std::string& text );
+
+    // Gives opts the lexer and match mode the mutant was made with. Throws InvalidArgumentException when --language or
+    // --match named other ones, or the lexer is not known
+    void applySettings( CLIOptions* opts ) const;
+
+    // The mutations to apply again, taken from rows, the parsed tsv. Throws InvalidArgumentException when the
+    // descriptor was made from another TSV or source, or names a row or permutation rows lacks
+    SelectedMutVec select( const std::string& tsv, const std::string& src, const PossibleMutVec& rows ) const;
+};
+
+#endif  // _INCLUDED_MUTANTDESCRIPTOR_HPP
@@ -24,6 +24,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -49,10 +50,20 @@ struct SelectedLineInfo {
           lineNumber{ 0 } {}
 };
 
+// The files the rows below a "#paths:" line of the TSV apply to, in tree mode
+struct PathScope {
+    std::vector<std::string> patterns;  // globs, or path prefixes where they end in '/'
+
+    // path is relative to the tree root (or as listed), an empty scope matches every path
+    bool matches( const std::string& path ) const;
+};
+using PathScopes = std::vector<PathScope>;  // the first one is the empty scope of rows before any "#paths:" line
+
 struct TsvFileLine {
     std::string pattern;
     std::vector<std::string> permutations;
     SelectedLineInfo data;
+    size_t scope = 0;  // index into the PathScopes of the TSV
 
     TsvFileLine( std::string _pattern, std::vector<std::string> _permutations = std::vector<std::string>{} )
         : pattern{ _pattern }, permutations{ _permutations } {}
@@ -63,10 +74,47 @@ struct SelectedMutation {
     std::string pattern;
     std::string replacement;
     SelectedLineInfo data;
+    size_t permutation = 0;  // index of replacement among the permutations of its row
 
     SelectedMutation( std::string _pattern, std::string _replacement, SelectedLineInfo info )
         : pattern{ _pattern }, replacement{ _replacement }, data{ info } {}
 };
 using SelectedMutVec = std::vector<SelectedMutation>;
 
+// Told about every edit a replacer makes to its subject, in the order they are made and in the offsets of the subject
+// at the time
+class EditListener {
+   public:
+    virtual ~EditListener() = default;
+
+    // removed bytes at pos were replaced by inserted bytes
+    virtual void replaced( size_t pos, size_t removed, size_t inserted ) = 0;
+};
+
+// The part of a subject changed by the replacements made since it was last cleared, as a single range in the offsets
+// of the subject as it is now
+struct EditWindow : EditListener {
+    size_t begin = std::string::npos;
+    size_t end = 0;
+
+    bool isEmpty() const { return begin == std::string::npos; }
+
+    void clear() {
+        begin = std::string::npos;
+        end = 0;
+    }
+
+    void replaced( size_t pos, size_t removed, size_t inserted ) override {
+        if ( !isEmpty() && end > pos ) {
+            // what was changed before shifts with the bytes after the edit
+            end = std::max( end, pos + removed ) - removed + inserted;
+            if ( begin >= pos + removed ) {
+                begin = begin - removed + inserted;
+            }
+        }
+        begin = std::min( begin, pos );
+        end = std::max( end, pos + inserted );
+    }
+};
+
 #endif  // _INCLUDED_MUTATEDATASTRUCTURES_HPP_
\ No newline at end of file
@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutationEngine.hpp: The embeddable C++ entry point of libmutateplaceholder
+ *
+ * - Takes the source and TSV as buffers and returns the mutant, no files or stdin involved
+ * - Parsed TSVs, comment stripped sources and compiled regexes are cached between calls, keyed by a hash of the raw
+ input and verified against the raw input on every hit
+ * - Reentrant: separate engines share no state, so use one engine per thread. A single engine is not thread safe
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_MUTATIONENGINE_HPP_
+#define _INCLUDED_MUTATIONENGINE_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "commands/cli-options.hpp"
+#include "commands/mutate/mutateDataStructures.hpp"
+#include "commands/mutate/regexCache.hpp"
+#include "commands/sourceLexer.hpp"
+
+struct MutateOptions {
+    std::string seed;  // 64 hexadecimal digits, empty to generate a new seed
+    std::int32_t count = -1;  // -1 when unspecified, same for the two below
+    std::int32_t minCount = -1;
+    std::int32_t maxCount = -1;
+    std::string language;  // a SourceLexer name, empty for cpp
+    bool matchTokens = false;  // --match=tokens
+};
+
+struct MutateResult {
+    std::string mutant;
+    std::string seed;  // the seed actually used, so that the mutant can be reproduced
+    std::string warnings;
+};
+
+class MutationEngine {
+   private:
+    struct CachedTsv {
+        std::string tsv;
+        PossibleMutVec possibleMutations;
+    };
+
+    struct CachedSrc {
+        std::string src;
+        const SourceLexer* lexer;
+        std::string stripped;
+        std::optional<TokenStream> tokens;  // of stripped, tokenized on first use
+    };
+
+    CachedSrc& getCachedSrc( const std::string& src, const SourceLexer& lexer );
+
+    std::unordered_map<std::uint64_t, CachedTsv> tsvCache;
+
+    std::unordered_map<std::uint64_t, CachedSrc> srcCache;
+
+    RegexCache regexCache;
+
+    size_t maxCacheEntries;
+
+    void applyOptions( const MutateOptions& options, CLIOptions* opts );
+
+   public:
+    explicit MutationEngine( size_t _maxCacheEntries = 64 ) : maxCacheEntries{ _maxCacheEntries } {}
+
+    // These throw the exceptions from excepts.hpp when the input is bad
+    const PossibleMutVec& getPossibleMutations( const std::string& tsv );
+
+    const std::string& getStrippedSrc( const std::string& src, const SourceLexer& lexer = SourceLexer::getDefault() );
+
+    const TokenStream& getTokens( const std::string& src, const SourceLexer& lexer = SourceLexer::getDefault() );
+
+    MutateResult mutate( const std::string& src, const std::string& tsv, const MutateOptions& options );
+
+    RegexCache& getRegexCache() { return regexCache; }
+};
+
+#endif  // _INCLUDED_MUTATIONENGINE_HPP_
@@ -30,6 +30,7 @@
 struct TSVRow {
     std::string row;
     int lineNumber;
+    size_t scope;
 };
 
 class MutationsRetriever {
@@ -38,18 +39,25 @@ class MutationsRetriever {
 
     PossibleMutVec possibleMutations;
 
-    void capturePossibleMutations();
-
-    void categorizeMutations();
-
-    void checkNesting();
+    PathScopes scopes{ PathScope{} };
 
    public:
     MutationsRetriever(std::string tsvInput);
 
     std::vector<TSVRow> getRows();
 
+    // getPossibleMutations() runs the three steps below in order unless they were already run. They are only public
+    // so that they can be timed apart
+    void capturePossibleMutations();
+
+    void categorizeMutations();
+
+    void checkNesting();
+
     PossibleMutVec& getPossibleMutations();
+
+    // Filled in by getRows()
+    const PathScopes& getPathScopes() const { return scopes; }
 };
 
 #endif  // _INCLUDED_MUTATIONSRETRIEVER_HPP_
@@ -71,6 +71,9 @@ class MutationsSelector {
 
     SelectedMutVec& getSelectedMutations();
 
+    // The pattern cell of row without its operators and the whitespace around it, as it is matched
+    static std::string getBarePattern(const TsvFileLine& row);
+
     std::vector<size_t> selectedIndexes;  // Public for testing purposes
 };
 
@@ -21,15 +21,21 @@
 #ifndef _INCLUDED_MUTATOR_HPP_
 #define _INCLUDED_MUTATOR_HPP_
 
-#include <set>
 #include <string>
 #include <tuple>
+#include <vector>
 
 #include "../cli-options.hpp"
+#include "commands/mutate/mutantDescriptor.hpp"
 #include "commands/mutate/mutateDataStructures.hpp"
 #include "commands/mutate/mutationsRetriever.hpp"
 #include "commands/mutate/mutationsSelector.hpp"
+#include "commands/mutate/regexCache.hpp"
+#include "commands/mutate/regexPrefilter.hpp"
+#include "commands/mutate/regexReplacer.hpp"
 #include "commands/mutate/textReplacer.hpp"
+#include "commands/mutate/tokenMatcher.hpp"
+#include "commands/sourceLexer.hpp"
 
 class Mutator {
 
@@ -38,20 +44,93 @@ class Mutator {
 
     TextReplacer replacer;
 
-    void regexReplace( std::string& subject, const SelectedMutation& sm );
+    TokenMatcher tokenMatcher;  // used instead of replacer with --match=tokens
 
-    std::set<std::string> getRegexMatches( const std::string& pattern, const std::string& subject,
-                                           const std::string& modifiers );
+    RegexReplacer regexReplacer;
 
-    std::tuple<std::string, std::string> getPatternAndModifiers( size_t index, const SelectedMutation& sm );
+    RegexCache ownRegexCache;
+
+    RegexCache* regexCache;  // either ownRegexCache or one shared across calls
+
+    size_t prefilterSkips = 0;  // regex rows not run as the subject lacks a literal they require
+
+    RequiredLiteralsScan literalsScan;  // of the regex rows of the current call, when it has enough of them
+
+    std::vector<size_t> literalsScanRows;  // by selected mutation, its row in literalsScan or NO_SCAN_ROW
+
+    EditWindow edits;  // made since literalsScan last looked at the subject
+
+    EditListener* editLog = nullptr;  // told about every edit instead of edits when set
+
+    std::vector<MutantDescriptor::Mutation>* selectionLog = nullptr;  // set to every selection made when set
+
+    static constexpr size_t NO_SCAN_ROW = SIZE_MAX;
+
+    std::vector<size_t>* chunkMatchCounts = nullptr;  // set while applyMutationsToChunk() runs
+
+    // Running totals of the replacer and regex cache, diffed to get the --stats counters of one call
+    struct CounterSnapshot {
+        size_t regexCompilations;
+        size_t findCalls;
+        size_t bytesCopied;
+        size_t prefilterSkips;
+        size_t regexLimitHits;
+    };
+
+    CounterSnapshot takeCounterSnapshot() const;
+
+    void recordCounters( const CounterSnapshot& before, PipelineStats* stats ) const;
 
-    std::string removeStrComments( const std::string& str );
+    void selectAndApply( std::string& strippedStr, PossibleMutVec& possibleMutations, CLIOptions* opts,
+                         const TokenStream* tokens );
+
+    // Sets up literalsScan when enough of the rows are regex rows requiring literals, the replacers report their
+    // edits to it then
+    void prepareLiteralsScan( const SelectedMutVec& selectedMutations );
+
+    // Returns the number of replacements made, selectedIndex is that of sm in the selected mutations
+    int regexReplace( std::string& subject, const SelectedMutation& sm, size_t selectedIndex );
+
+    std::tuple<std::string, std::string> getPatternAndModifiers( size_t index, const SelectedMutation& sm );
 
     void checkMatchCount( int matches, const SelectedMutation& sm );
 
    public:
-    Mutator() = default;
+    Mutator() : regexCache{ &ownRegexCache } {}
+
+    explicit Mutator( RegexCache* sharedRegexCache ) : regexCache{ sharedRegexCache } {}
+
     std::string operator()( const std::string& srcString, const std::string& tsvString, CLIOptions* opts );
+
+    // Same as above but for callers that already hold the parsed TSV and the comment stripped source (i.e. the serve
+    // command's caches). possibleMutations is modified by the selection so pass in a copy if it is to be reused.
+    // tokens are those of strippedStr if already at hand, for --match=tokens
+    std::string mutateStripped( std::string strippedStr, PossibleMutVec& possibleMutations, CLIOptions* opts,
+                                const TokenStream* tokens = nullptr );
+
+    // The replace step of the above on its own, for timing it apart from the selection
+    void applyMutations( std::string& strippedStr, const SelectedMutVec& selectedMutations, CLIOptions* opts,
+                         const TokenStream* tokens = nullptr );
+
+    // The replace step of a source mutated a chunk at a time (--stream). The replacements made by each plain pattern
+    // cell are added to matchCounts, by position in selectedMutations, instead of being checked as only the totals
+    // over every chunk tell whether a row had no match or several
+    void applyMutationsToChunk( std::string& chunk, const SelectedMutVec& selectedMutations, CLIOptions* opts,
+                                std::vector<size_t>& matchCounts );
+
+    // Warns about the rows whose totals from applyMutationsToChunk() are 0 or more than 1
+    void checkMatchCounts( const SelectedMutVec& selectedMutations, const std::vector<size_t>& matchCounts,
+                           CLIOptions* opts );
+
+    // Every edit the replacers make is reported to log from now on, which turns off the shared scan of the regex rows'
+    // literals as that needs them, none when it is null
+    void setEditLog( EditListener* log ) { editLog = log; }
+
+    // The mutations selected by every call that selects some are written to log from now on, for the descriptor of
+    // the mutant, none when it is null
+    void setSelectionLog( std::vector<MutantDescriptor::Mutation>* log ) { selectionLog = log; }
+
+    std::string removeStrComments( const std::string& str, const SourceLexer& lexer = SourceLexer::getDefault() );
 };
 
 #endif  // _INCLUDED_MUTATOR_HPP_
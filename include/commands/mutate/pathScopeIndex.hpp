@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * pathScopeIndex.hpp: Which TSV rows apply to which file of a tree mode run
+ *
+ * - Built once when the files are known: each path is matched against every "#paths:" scope of the TSV (there are
+ few of them, however many rows there are) and paths with the same matching scopes share one filtered row set
+ * - Files only search and select among the rows that apply to them, so rows scoped elsewhere neither cost matching
+ time nor dilute the random selection
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_PATHSCOPEINDEX_HPP
+#define _INCLUDED_PATHSCOPEINDEX_HPP
+
+#include <string>
+#include <vector>
+
+#include "commands/mutate/mutateDataStructures.hpp"
+
+class PathScopeIndex {
+    std::vector<PossibleMutVec> rowSets;
+
+    std::vector<size_t> rowSetOfPath;  // by the index of the path
+
+   public:
+    PathScopeIndex() = default;
+
+    PathScopeIndex( const PossibleMutVec& rows, const PathScopes& scopes, const std::vector<std::string>& paths );
+
+    // The rows that apply to the path at pathIndex, in TSV order, empty if none does
+    const PossibleMutVec& getRows( size_t pathIndex ) const { return rowSets[rowSetOfPath[pathIndex]]; }
+
+    size_t getRowSetCount() const { return rowSets.size(); }
+};
+
+#endif  // _INCLUDED_PATHSCOPEINDEX_HPP
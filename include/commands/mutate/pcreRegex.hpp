@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * pcreRegex.hpp: The PCRE2 backend of the regex pattern cells, for the whole of the PCRE2 syntax
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_PCREREGEX_HPP
+#define _INCLUDED_PCREREGEX_HPP
+
+#include "commands/mutate/regexEngine.hpp"
+
+typedef jpcre2::select<char> jp;
+
+class PcreRegex : public RegexEngine {
+    jp::Regex regex;  // compiled without options, as the pattern cells have always been
+
+   public:
+    explicit PcreRegex( const std::string& pattern ) : regex( pattern ) {}
+
+    const char* getName() const override { return "pcre2"; }
+
+    // Runs into the limits of scratch.matchContext, not into scratch.deadlineNs as pcre2_match() cannot be stopped
+    Found search( const std::string& subject, std::size_t start, std::uint32_t flags,
+                  RegexScratch& scratch ) const override;
+
+    bool expand( const std::string& subject, const std::string& replacement, std::uint32_t flags,
+                 RegexScratch& scratch, std::string& expansion ) const override;
+
+    // One character further, past the whole of a CRLF when it counts as a newline and of a UTF-8 sequence with (*UTF)
+    std::size_t nextCharacter( const std::string& subject, std::size_t pos ) const override;
+
+    bool hasFullSyntax() const override { return true; }
+};
+
+#endif  // _INCLUDED_PCREREGEX_HPP
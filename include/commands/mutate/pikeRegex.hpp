@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * pikeRegex.hpp: A linear time backend of the regex pattern cells, a Thompson NFA run as a Pike VM
+ *
+ * - Every thread of the NFA is stepped over the subject at once, so a search takes time proportional to the subject
+ times the program whatever the pattern, and catastrophic backtracking cannot happen
+ * - Threads are kept in the order a backtracking engine would try them, so matches and capture groups are the ones
+ PCRE2 finds
+ * - Only the part of the PCRE2 syntax whose meaning is certain is compiled: literals, classes, \d \w \s \h \v and
+ their negations, ., ^, $, \A, \z, \Z, \b, \B, capturing and (?:) groups, alternation and greedy or lazy quantifiers.
+ Anything else, or a repeated group that can match empty, makes compile() return null so PCRE2 is used instead
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_PIKEREGEX_HPP
+#define _INCLUDED_PIKEREGEX_HPP
+
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "commands/mutate/regexEngine.hpp"
+
+class PikeRegex : public RegexEngine {
+   public:
+    enum class Op : unsigned char { BYTE, SET, SPLIT, JUMP, SAVE, ASSERT, MATCH };
+
+    enum class Assertion : unsigned char {
+        SUBJECT_START,     // ^ and \A
+        SUBJECT_END,       // \z
+        END_OR_FINAL_NL,   // $ and \Z
+        WORD_BOUNDARY,     // \b
+        NOT_WORD_BOUNDARY  // \B
+    };
+
+    // x is the byte, the set, the slot, the assertion or the preferred branch of a SPLIT, y its other branch or the
+    // target of a JUMP. The next instruction of the others is the one after them
+    struct Inst {
+        Op op;
+        std::uint32_t x;
+        std::uint32_t y;
+    };
+
+   private:
+    std::vector<Inst> program;
+
+    std::vector<std::bitset<256>> sets;
+
+    std::uint32_t slotCount;  // two per capture group, group 0 included
+
+    std::bitset<256> firstBytes;  // the bytes a match can start with, unless matchesEmpty
+
+    int firstByte;  // the only one of firstBytes, -1 when there are more, to look for it with memchr()
+
+    std::string prefix;  // the literal bytes every match starts with, looked for with memmem() when there are several
+
+    bool matchesEmpty;
+
+    PikeRegex() = default;
+
+    // Follows the empty transitions from pc at pos and adds the threads they reach to list, with captures as their
+    // capture slots
+    void addThread( PikeThreadList& list, std::uint32_t pc, const std::string& subject, std::size_t pos,
+                    std::size_t* captures, std::vector<PikeFrame>& frames ) const;
+
+    bool holds( Assertion assertion, const std::string& subject, std::size_t pos ) const;
+
+   public:
+    // Null when the pattern uses syntax PikeRegex leaves to PCRE2, or does not compile
+    static std::unique_ptr<PikeRegex> compile( const std::string& pattern );
+
+    const char* getName() const override { return "pike"; }
+
+    // Gives up with LIMIT_HIT once scratch.deadlineNs has passed
+    Found search( const std::string& subject, std::size_t start, std::uint32_t flags,
+                  RegexScratch& scratch ) const override;
+
+    // Implements the syntax pcre2_substitute() has without EXTENDED, and returns false with it
+    bool expand( const std::string& subject, const std::string& replacement, std::uint32_t flags,
+                 RegexScratch& scratch, std::string& expansion ) const override;
+
+    std::size_t nextCharacter( const std::string& subject, std::size_t pos ) const override;
+
+    bool hasFullSyntax() const override { return false; }
+
+    std::size_t getProgramSize() const { return program.size(); }
+};
+
+#endif  // _INCLUDED_PIKEREGEX_HPP
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * regexCache.hpp: Keeps compiled regex pattern cells around so that each pattern is only compiled once.
+ *
+ * - A single Mutator call compiles each regex row's pattern once for matching and once per match for the
+ replacement. Long running users (the serve command) share one cache across many Mutator calls.
+ * - The literals every match must contain are found along with the compilation, see regexPrefilter.hpp
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_REGEXCACHE_HPP_
+#define _INCLUDED_REGEXCACHE_HPP_
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "commands/mutate/regexEngine.hpp"
+
+class RegexCache {
+   public:
+    struct Entry {
+        std::unique_ptr<RegexEngine> engine;
+        std::unique_ptr<RegexEngine> fullSyntaxEngine;  // compiled on first use when engine lacks the full syntax
+        std::vector<std::string> requiredLiterals;
+
+        // For the rows needing what only PCRE2 implements, e.g. the x modifier
+        const RegexEngine& getFullSyntaxEngine( const std::string& pattern );
+    };
+
+   private:
+    std::unordered_map<std::string, std::unique_ptr<Entry>> regexes;
+
+    size_t maxEntries;
+
+    size_t compilations = 0;
+
+   public:
+    explicit RegexCache( size_t _maxEntries = 4096 ) : maxEntries{ _maxEntries } {}
+
+    // Returns the compiled regex for `pattern`, compiling it on first use
+    const RegexEngine& get( const std::string& pattern ) { return *getEntry( pattern ).engine; }
+
+    Entry& getEntry( const std::string& pattern );
+
+    size_t size() const { return regexes.size(); }
+
+    // Cache misses since construction, for --stats
+    size_t getCompilations() const { return compilations; }
+
+    void clear() { regexes.clear(); }
+};
+
+#endif  // _INCLUDED_REGEXCACHE_HPP_
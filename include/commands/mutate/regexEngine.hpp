@@ -0,0 +1,112 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * regexEngine.hpp: The interface every regex backend of the regex pattern cells implements
+ *
+ * - A compiled engine is immutable, everything a search changes lives in a RegexScratch owned by the caller, so one
+ engine can be searched from several threads at once
+ * - RegexEngine::compile() picks the backend of each pattern: the linear time PikeRegex when the pattern stays within
+ the syntax it knows, PCRE2 for everything else (backreferences, lookarounds, inline options, ...)
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_REGEXENGINE_HPP
+#define _INCLUDED_REGEXENGINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "commands/mutate/jpcre2.hpp"
+
+struct PcreMatchDataDeleter {
+    void operator()( pcre2_match_data_8* matchData ) const { pcre2_match_data_free_8( matchData ); }
+};
+
+// Thread list of the Pike VM: a sparse set of program counters, each with the capture slots of its thread
+struct PikeThreadList {
+    std::vector<std::uint32_t> sparse;
+    std::vector<std::uint32_t> dense;
+    std::vector<std::size_t> slots;
+    std::uint32_t size = 0;
+};
+
+// Pending work while following the empty transitions of the Pike VM, restoreSlot is NO_RESTORE for a program counter
+struct PikeFrame {
+    static constexpr std::uint32_t NO_RESTORE = UINT32_MAX;
+    std::uint32_t pc;
+    std::uint32_t restoreSlot;
+    std::size_t restoreValue;
+};
+
+// The state of the searches of one thread, kept between them so that they do not allocate
+struct RegexScratch {
+    std::size_t matchStart = 0;
+    std::size_t matchEnd = 0;
+
+    pcre2_match_context_8* matchContext = nullptr;  // the limits of the PCRE2 searches, null for the defaults
+
+    std::uint64_t deadlineNs = 0;  // statsClockNs() time a search gives up at, 0 when there is none
+
+    std::unique_ptr<pcre2_match_data_8, PcreMatchDataDeleter> matchData;  // of the last PCRE2 search
+
+    // of the last Pike VM search: start and end of the match, then of every capture group, npos when unset
+    std::vector<std::size_t> captures;
+    std::vector<std::size_t> threadCaptures;
+    PikeThreadList threads[2];
+    std::vector<PikeFrame> frames;
+};
+
+class RegexEngine {
+   public:
+    enum class Found : unsigned char { MATCH, NO_MATCH, LIMIT_HIT };
+
+    // Search flags
+    static constexpr std::uint32_t ANCHORED = 1;             // the match has to start at the start offset
+    static constexpr std::uint32_t NOT_EMPTY_AT_START = 2;  // an empty match at the start offset does not count
+
+    // Expansion flags, as pcre2_substitute() has them
+    static constexpr std::uint32_t UNSET_EMPTY = 1;    // an unset group expands to nothing instead of failing
+    static constexpr std::uint32_t UNKNOWN_UNSET = 2;  // an unknown group counts as unset instead of failing
+    static constexpr std::uint32_t EXTENDED = 4;       // escapes and ${n:-...}/${n:+...:...} in the replacement
+
+    virtual ~RegexEngine() = default;
+
+    // The linear time engine when the pattern allows it, else PCRE2. Never null, a pattern that does not compile
+    // gives an engine that matches nothing
+    static std::unique_ptr<RegexEngine> compile( const std::string& pattern );
+
+    virtual const char* getName() const = 0;
+
+    // Looks for the first match at or after start, its offsets are left in scratch.matchStart and scratch.matchEnd
+    virtual Found search( const std::string& subject, std::size_t start, std::uint32_t flags,
+                          RegexScratch& scratch ) const = 0;
+
+    // Expands the replacement ($n, ${n}, $$, ...) against the last match of this engine in scratch. False when the
+    // replacement is rejected for that match, e.g. it names a group that is unset without UNSET_EMPTY
+    virtual bool expand( const std::string& subject, const std::string& replacement, std::uint32_t flags,
+                         RegexScratch& scratch, std::string& expansion ) const = 0;
+
+    // Where to look after an empty match that nothing else could be found at
+    virtual std::size_t nextCharacter( const std::string& subject, std::size_t pos ) const = 0;
+
+    // False for the engines that do not implement EXTENDED, PCRE2 does
+    virtual bool hasFullSyntax() const = 0;
+};
+
+#endif  // _INCLUDED_REGEXENGINE_HPP
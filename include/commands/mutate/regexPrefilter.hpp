@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * regexPrefilter.hpp: Finds the literals every match of a regex pattern cell contains, to skip the regex when the
+ subject lacks one of them
+ *
+ * - Only runs of plain characters outside of any group, class or alternation are taken, a character made optional
+ by a quantifier ends its run without being part of it
+ * - Patterns whose literals cannot be told safely (top level alternation, inline options such as (?i), \Q...\E or
+ escapes that are not understood) give no literals, so they are always matched
+ * - RequiredLiteralsScan looks for the literals of all the regex rows of a mutant in a single pass, and after that only
+ around the edits the rows make. It only tells which rows may match, the rows are still matched one at a time
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_REGEXPREFILTER_HPP
+#define _INCLUDED_REGEXPREFILTER_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "commands/mutate/mutateDataStructures.hpp"
+
+// Longest first, empty when nothing is known to be required
+std::vector<std::string> findRequiredLiterals( const std::string& pattern );
+
+// False when the subject cannot hold a match as one of the literals is missing from it
+bool containsRequiredLiterals( const std::string& subject, const std::vector<std::string>& literals );
+
+// containsRequiredLiterals() for many rows at once. An Aho-Corasick automaton over the literals of every row finds
+// them all in one pass over the subject rather than one search per literal per row. A literal can only appear where
+// the subject was edited, so the scans that follow only cover the edits made since and the bytes around them
+class RequiredLiteralsScan {
+    static constexpr std::uint32_t NONE = UINT32_MAX;
+
+    static constexpr std::uint32_t REPORTS = 1u << 31;  // flag of the transitions into a state where a literal ends
+
+    std::array<std::uint8_t, 256> byteClasses;  // 0 for the bytes none of the literals has
+
+    std::uint32_t classCount = 0;
+
+    std::array<bool, 256> startsLiteral;  // the first bytes of the literals, the others are skipped in between them
+
+    int firstByte = -1;  // the only one of startsLiteral, -1 when there are more, to look for it with memchr()
+
+    std::vector<std::uint32_t> transitions;  // next state, by state and byte class, with REPORTS
+
+    std::vector<std::uint32_t> outputs;  // by state, the literal ending there or NONE
+
+    std::vector<std::uint32_t> outputLinks;  // by state, the nearest shorter suffix state with an output, or 0
+
+    std::vector<std::uint32_t> rowLiterals;  // the literals of every row one after the other, as indexes into found
+
+    std::vector<size_t> rowStarts;  // by row, where its literals start in rowLiterals, with one more for the end
+
+    std::vector<char> found;  // by literal, seen in the subject at some point since the first scan
+
+    size_t foundCount = 0;
+
+    size_t maxLength = 0;
+
+    bool hasScanned = false;
+
+    void scan( const std::string& subject, size_t from, size_t to );
+
+   public:
+    // literals[row] are the required literals of that row, as findRequiredLiterals() gives them. The storage of the
+    // previous rows is reused
+    void reset( const std::vector<const std::vector<std::string>*>& literals );
+
+    size_t getRowCount() const { return rowStarts.size() - 1; }
+
+    // False when the subject cannot hold a match of row. The first call scans the whole subject, the next ones the
+    // part of it in edits, which is cleared
+    bool mayMatch( size_t row, const std::string& subject, EditWindow& edits );
+};
+
+#endif  // _INCLUDED_REGEXPREFILTER_HPP
@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * regexReplacer.hpp: Replaces the matches of a regex pattern cell at their offsets in a single pass
+ *
+ * - Every match is replaced where it was found, the permutation cell is expanded by the regex engine against that
+ match, so capture references see the match in its context and nothing is searched twice
+ * - The subject is rebuilt once per row however many matches there are
+ * - Newlined rows insert the replacement on a line of its own after the line the match ends on and keep the match
+ * - One match context carries the --regex-*-limit options to every PCRE2 row, a row running into one of them or into
+ the --time-limit deadline is left out whole rather than half applied
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_REGEXREPLACER_HPP
+#define _INCLUDED_REGEXREPLACER_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "commands/cli-options.hpp"
+#include "commands/mutate/mutateDataStructures.hpp"
+#include "commands/mutate/regexEngine.hpp"
+
+class RegexReplacer {
+    struct MatchContextDeleter {
+        void operator()( pcre2_match_context_8* context ) const;
+    };
+
+    std::unique_ptr<pcre2_match_context_8, MatchContextDeleter> matchContext;  // null while no limit is set
+
+    RegexLimits limits;
+
+    size_t findCalls = 0;
+
+    size_t bytesCopied = 0;
+
+    size_t limitHits = 0;
+
+    // The subject with the replacements, swapped with it afterwards. Kept per thread rather than per replacer so that
+    // its buffer is reused across rows and across mutants, whichever Mutator makes them
+    static thread_local std::string rebuilt;
+
+    std::string expansion;  // of the permutation cell for the current match, reused between matches
+
+    RegexScratch scratch;  // holds the match context and deadline too
+
+    EditListener* edits = nullptr;
+
+    struct Splice {
+        size_t pos;  // in the rebuilt subject
+        size_t removed;
+        size_t inserted;
+    };
+
+    std::vector<Splice> splices;  // of the current row, only reported once it can no longer give up
+
+   public:
+    // Returned instead of a number of matches when a limit or the deadline was hit
+    static constexpr int LIMIT_HIT = -1;
+
+    // Cheap when the limits did not change since the last call
+    void setLimits( const RegexLimits& _limits );
+
+    // Rows starting or still searching after it are given up, 0 removes it
+    void setDeadline( std::uint64_t deadlineNs ) { scratch.deadlineNs = deadlineNs; }
+
+    // Every replacement is reported to _edits from now on, none when it is null
+    void setEditListener( EditListener* _edits ) { edits = _edits; }
+
+    // Modifiers are the ones of the pattern cell: A anchors the matches, g replaces all of them instead of the first
+    // one, e, E and x are passed on to the expansion of the replacement, so x needs an engine with the full syntax.
+    // Returns the number of matches replaced, or LIMIT_HIT with the subject untouched
+    int operator()( std::string& subject, const RegexEngine& regex, const std::string& replacement,
+                    const std::string& modifiers, bool isNewLined );
+
+    // Running totals since construction, for --stats
+    size_t getFindCalls() const { return findCalls; }
+
+    size_t getBytesCopied() const { return bytesCopied; }
+
+    size_t getLimitHits() const { return limitHits; }
+};
+
+#endif  // _INCLUDED_REGEXREPLACER_HPP
@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * schemataBuilder.hpp: Puts every mutant of a C or C++ source behind a runtime switch in a single source, for
+ --schemata
+ *
+ * - Every permutation of every row that matches is a mutant of its own, numbered from 1 in the order of the TSV.
+ Groups are not combined, each mutant applies one row
+ * - The MUTANT_ID environment variable picks the mutant the compiled program runs, unset or 0 runs the original
+ * - The places a row changes are wrapped where they are: one that covers whole lines in an if / else if / else chain
+ over the lines, a newlined row in an if chain of its own, anything else in a chain of conditional expressions, so
+ regex rows have to match whole expressions
+ * - Rows whose places overlap those of an earlier row without being the same, touch a preprocessor line, or are not
+ whole statements or a whole expression of a function body cannot be switched and are left out with a warning.
+ Statements that declare something are left out too, as the block around them would end the scope of the name
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_SCHEMATABUILDER_HPP
+#define _INCLUDED_SCHEMATABUILDER_HPP
+
+#include <string>
+#include <vector>
+
+#include "commands/cli-options.hpp"
+#include "commands/mutate/codeLayout.hpp"
+#include "commands/mutate/mutateDataStructures.hpp"
+#include "commands/mutate/mutator.hpp"
+
+class SchemataBuilder {
+    struct Edit {
+        size_t pos;
+        size_t removed;
+        size_t inserted;
+    };
+
+    struct EditLog : EditListener {
+        std::vector<Edit> edits;
+
+        void replaced( size_t pos, size_t removed, size_t inserted ) override {
+            edits.push_back( { pos, removed, inserted } );
+        }
+    };
+
+    struct Alternative {
+        size_t mutantId;
+        std::string text;  // replaces the site when the mutant is selected
+    };
+
+    // A range of the source the mutants change, empty for the lines newlined rows insert
+    struct Site {
+        size_t begin;
+        size_t end;
+        bool wholeLines;  // begin and end are on line boundaries
+        std::vector<Alternative> alternatives;
+    };
+
+    struct Mutant {
+        size_t lineNumber;  // of the row in the TSV
+        size_t permutation;  // counted from 1
+    };
+
+    CLIOptions* opts;
+
+    std::string source;  // comment stripped, ending with a line break
+
+    Mutator mutator;
+
+    EditLog log;
+
+    std::vector<Site> sites;  // ordered by begin then end
+
+    std::vector<Mutant> mutants;  // by id - 1
+
+    std::vector<size_t> skippedLines;  // of the rows left out
+
+    CodeLayout layout;  // of source
+
+    // The sites the permutation of row changes, in the offsets of source and none when it does not match. False when
+    // the edits cannot be mapped back onto source
+    bool findSites( const TsvFileLine& row, size_t permutation, std::vector<Site>& found );
+
+    // Extends the range of a site to whole lines when it only has whitespace around it on them
+    void setLineBounds( Site& site );
+
+    // Only whole statements of a function body that declare nothing, or an expression there, see CodeLayout. Never
+    // when it touches a preprocessor line
+    bool canBeSwitched( const Site& site ) const;
+
+    // The ranges of a and b overlap without being the same
+    static bool overlap( const Site& a, const Site& b );
+
+    // Adds the alternatives of site to the one with the same range, or adds site where it goes
+    void insert( Site site );
+
+   public:
+    SchemataBuilder( CLIOptions* _opts, std::string strippedSource );
+    SchemataBuilder( const SchemataBuilder& ) = delete;
+    SchemataBuilder& operator=( const SchemataBuilder& ) = delete;
+
+    // Adds the mutants of every row, in order
+    void add( const PossibleMutVec& rows );
+
+    // The source with the selector and every site wrapped. Warns about the rows left out
+    std::string build();
+
+    size_t getMutantCount() const { return mutants.size(); }
+};
+
+#endif  // _INCLUDED_SCHEMATABUILDER_HPP
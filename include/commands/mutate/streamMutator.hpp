@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * streamMutator.hpp: Mutates the source a chunk at a time and writes the mutant as it goes, for --stream
+ *
+ * - The selection does not depend on the source, so it is made up front and every chunk gets the same mutations
+ * - Chunks are cut on a line break outside of any comment or literal, so stripping them one by one gives the same
+ text as stripping the whole source. Until a cut is found the lexer carries on where it left off, so a comment,
+ literal or line spanning many chunks is only lexed once, and the rest after a cut once more
+ * - The last lines of a chunk, as many as the longest plain pattern cell has line breaks, are held back and mutated
+ with the next chunk when no replacement touched them, so multi-line pattern cells still match across chunk
+ boundaries. Regex pattern cells only match within a chunk
+ * - Memory stays around a few chunks whatever the size of the source, byte counts are 64 bits
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_STREAMMUTATOR_HPP
+#define _INCLUDED_STREAMMUTATOR_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "commands/cli-options.hpp"
+#include "commands/mutate/mutateDataStructures.hpp"
+#include "commands/mutate/mutator.hpp"
+#include "commands/sourceLexer.hpp"
+
+constexpr size_t STREAM_CHUNK_SIZE = 4 << 20;  // bytes of source read at a time
+
+class StreamMutator {
+    CLIOptions* opts;
+
+    size_t chunkSize;
+
+    const SourceLexer& lexer;
+
+    Mutator mutator;
+
+    SelectedMutVec selectedMutations;
+
+    std::vector<size_t> matchCounts;  // totals over the chunks, by position in selectedMutations
+
+    size_t heldLines = 0;
+
+    std::string pending;  // source read but not yet stripped
+
+    LexerResume lexerResume;  // where lexing pending left off
+
+    size_t classifiedTo = 0;  // the line breaks of pending before it are known to be inside a token or not
+
+    std::string held;  // stripped lines held back unmutated from the previous chunk
+
+    std::uint64_t bytesRead = 0;
+
+    std::uint64_t bytesWritten = 0;
+
+    // Length of the start of pending that can be stripped on its own, 0 when there is none yet. Only lexes what was
+    // added to pending since the last call, unless pending was cut since
+    size_t findCut();
+
+    void mutateWindow( std::string window, bool isLast );
+
+    void write( std::string text );
+
+   public:
+    explicit StreamMutator( CLIOptions* _opts, size_t _chunkSize = STREAM_CHUNK_SIZE );
+
+    // Parses the TSV and selects the mutations, then reads the source from opts and writes the mutant to it. Throws
+    // InvalidArgumentException when the source is empty
+    void run( const std::string& tsv );
+
+    std::uint64_t getBytesRead() const { return bytesRead; }
+
+    std::uint64_t getBytesWritten() const { return bytesWritten; }
+};
+
+#endif  // _INCLUDED_STREAMMUTATOR_HPP
@@ -49,6 +49,12 @@ class TextReplacer {
 
     bool isNewLined;
 
+    size_t findCalls = 0;
+
+    size_t bytesCopied = 0;
+
+    EditListener* edits = nullptr;
+
     int singleLineReplace( std::string& subject, const std::string& _replacement );
 
     int multilineReplace( std::string& subject, const std::string& _replacement );
@@ -72,10 +78,22 @@ class TextReplacer {
 
     std::vector<std::string> separateLinesIntoVector( const std::string& str );
 
+    size_t findInSubject( const std::string& subject, const std::string& str );
+
+    void replaceInSubject( std::string& subject );
+
    public:
     TextReplacer() = default;
     int operator()( std::string& subject, const std::string& _pattern, const std::string& _replacement,
                     bool _isNewLined );
+
+    // Every replacement is reported to _edits from now on, none when it is null
+    void setEditListener( EditListener* _edits ) { edits = _edits; }
+
+    // Running totals since construction, for --stats
+    size_t getFindCalls() const { return findCalls; }
+
+    size_t getBytesCopied() const { return bytesCopied; }
 };
 
 #endif  // _INCLUDED_TEXTREPLACER_HPP
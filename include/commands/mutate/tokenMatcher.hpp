@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * tokenMatcher.hpp: Replaces plain pattern cells matched as token sequences, for --match=tokens
+ *
+ * - The pattern is tokenized with the lexer of the source and found wherever its tokens appear in a row, whitespace
+ between tokens does not matter and a match can never start or end inside an identifier, literal or operator
+ * - Every source token carries a hash of its text, candidates are the tokens whose hash equals the one of the leading
+ pattern token. Replacements splice the token stream in place so it stays valid for the rows applied after them
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_TOKENMATCHER_HPP
+#define _INCLUDED_TOKENMATCHER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "commands/mutate/mutateDataStructures.hpp"
+#include "commands/sourceLexer.hpp"
+
+class TokenMatcher {
+    const SourceLexer* lexer = &SourceLexer::getDefault();
+
+    TokenStream tokens;  // of the subject, once it has been tokenized
+
+    std::vector<std::uint64_t> hashes;  // one per token, the lowest bit is set when it is glued to the one before
+
+    bool stale = true;  // the subject was changed by something else since tokens were taken
+
+    size_t findCalls = 0;
+
+    size_t bytesCopied = 0;
+
+    EditListener* edits = nullptr;
+
+    void hashTokens( const std::string& text, const TokenStream& toHash, std::vector<std::uint64_t>& out, size_t from,
+                     size_t to ) const;
+
+    bool isMatchAt( const std::string& subject, size_t first, const std::string& pattern,
+                    const TokenStream& patternTokens, const std::vector<std::uint64_t>& patternHashes ) const;
+
+    // Returns the index of the first token after the inserted replacement
+    size_t replaceAt( std::string& subject, size_t first, size_t count, const std::string& replacement,
+                      bool isNewLined );
+
+   public:
+    TokenMatcher() = default;
+
+    // Starts on a new subject, sourceTokens (of the subject, if they are already known) are copied
+    void reset( const SourceLexer& _lexer, const TokenStream* sourceTokens = nullptr );
+
+    // The subject was changed behind the matcher's back, it is tokenized again on the next call
+    void invalidate() { stale = true; }
+
+    // Returns the number of replacements made
+    int operator()( std::string& subject, const std::string& pattern, const std::string& replacement,
+                    bool isNewLined );
+
+    // Every replacement is reported to _edits from now on, none when it is null
+    void setEditListener( EditListener* _edits ) { edits = _edits; }
+
+    // Running totals since construction, for --stats
+    size_t getFindCalls() const { return findCalls; }
+
+    size_t getBytesCopied() const { return bytesCopied; }
+};
+
+#endif  // _INCLUDED_TOKENMATCHER_HPP
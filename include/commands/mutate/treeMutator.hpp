@@ -0,0 +1,84 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * treeMutator.hpp: Mutates a whole directory tree or list of files with one TSV, for --tree and --file-list
+ *
+ * - The TSV is parsed once and shared by every file, files are spread over a thread pool (--jobs) whose workers
+ each keep their own Mutator and regex cache
+ * - Mutants are written to the same relative path under --output-dir, files are picked with --glob
+ * - Every file gets its own seed derived from the run seed and its relative path, so the run is reproducible
+ whatever the number of threads
+ * - Rows under a "#paths:" line of the TSV only apply to the files it matches, a file no row applies to is copied
+ unchanged
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_TREEMUTATOR_HPP
+#define _INCLUDED_TREEMUTATOR_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "commands/cli-options.hpp"
+#include "commands/mutate/mutateDataStructures.hpp"
+#include "commands/mutate/mutator.hpp"
+#include "commands/mutate/pathScopeIndex.hpp"
+
+class TreeMutator {
+    CLIOptions* opts;
+
+    std::vector<std::string> paths;  // relative to the tree root, or as listed, in order
+
+    PathScopeIndex scopeIndex;  // the rows of each path, copied for every file as the selection modifies them
+
+    std::string runSeed;
+
+    std::uint64_t tsvHash;
+
+    std::vector<std::string> descriptors;  // by path, its "path\tdescriptor" line when it was mutated
+
+    void listTree();
+
+    void readFileList();
+
+    bool isSelected( const std::string& path ) const;
+
+    std::filesystem::path getSourcePath( const std::string& path ) const;
+
+    std::filesystem::path getOutputPath( const std::string& path ) const;
+
+    // Returns the warnings of the file
+    std::string mutateFile( size_t pathIndex, Mutator& mutator );
+
+   public:
+    // Parses the TSV and lists the files, throws when the TSV is bad or a file cannot be mirrored
+    TreeMutator( CLIOptions* _opts, const std::string& tsv );
+
+    const std::vector<std::string>& getPaths() const { return paths; }
+
+    // Filled by run() with --write-descriptor, empty for the files copied as they were
+    const std::vector<std::string>& getDescriptors() const { return descriptors; }
+
+    // Mutates every file and returns how many of them had warnings. Rethrows the first error a file ran into
+    size_t run();
+
+    // 64 hexadecimal digits
+    static std::string deriveSeed( const std::string& runSeed, const std::string& path );
+};
+
+#endif  // _INCLUDED_TREEMUTATOR_HPP
@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutantRunner.hpp: Runs a build and test command against a batch of mutant trees in parallel, for the run command
+ *
+ * - Every job gets a workspace of its own, made once out of the project tree by a WorkspaceBuilder, which the mutants
+ it runs are laid over one at a time: only the files of a mutant that differ from the project are written, and
+ restored afterwards
+ * - The workspaces are made next to the project unless told where, as files can only be cloned or hardlinked within
+ the file system they are on
+ * - With hardlinked workspaces, the linked files are checked after the baseline and after every mutant, and the run
+ stops as soon as the test command wrote through one into the project
+ * - The command is run with /bin/sh in its own process group, so a time limit or an early kill stops everything it
+ started
+ * - A mutant is killed when the command fails, or as soon as a line of its output matches the kill pattern, survives
+ when it succeeds and times out when it is still running after the time limit
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_COMMANDS_RUN_MUTANTRUNNER_HPP
+#define _INCLUDED_COMMANDS_RUN_MUTANTRUNNER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "commands/mutate/regexEngine.hpp"
+#include "commands/run/workspaceBuilder.hpp"
+
+enum class MutantOutcome : unsigned char { KILLED, SURVIVED, TIMEOUT };
+
+struct MutantResult {
+    MutantOutcome outcome = MutantOutcome::SURVIVED;
+    int exitStatus = 0;  // of the command, 128 + the signal when one ended it, -1 when it was stopped
+    std::uint64_t durationNs = 0;
+    std::string killingLine;  // the output line that matched the kill pattern, empty when none did
+    size_t changedFiles = 0;  // of the mutant, that were laid over the workspace
+};
+
+class MutantRunner {
+    std::filesystem::path projectRoot;
+
+    WorkspaceBuilder workspaceBuilder;
+
+    std::string command;
+
+    std::unique_ptr<RegexEngine> killPattern;  // null without one
+
+    std::uint64_t timeLimitNs;  // 0 for none
+
+    bool verbose;  // report the workspaces and every mutant's outcome on stderr
+
+    std::filesystem::path workRoot;  // temporary, holds one workspace per job
+
+    std::string workspaceWarning;  // why the project had to be copied into the workspaces, empty when it did not
+
+    std::vector<std::filesystem::path> workspaces;
+
+    // Writes the files of mutantDir that differ from the project over workspace, returns their relative paths
+    std::vector<std::filesystem::path> layOver( const std::filesystem::path& mutantDir,
+                                                const std::filesystem::path& workspace ) const;
+
+    // Puts back the project's version of the files layOver() wrote
+    void restore( const std::vector<std::filesystem::path>& changed, const std::filesystem::path& workspace );
+
+   public:
+    // Makes jobs workspaces out of the project in workDir, or next to the project when it is empty, hardlinking the
+    // files it cannot clone when hardlinks. Throws IOErrorException when it cannot
+    MutantRunner( const std::filesystem::path& _projectRoot, std::string _command, size_t jobs,
+                  std::uint64_t _timeLimitNs, const std::string& killPatternStr, bool hardlinks = false,
+                  bool _verbose = false, const std::filesystem::path& workDir = {} );
+    MutantRunner( const MutantRunner& ) = delete;
+    MutantRunner& operator=( const MutantRunner& ) = delete;
+
+    // Removes the workspaces
+    ~MutantRunner();
+
+    // Says why the workspaces are copies of the project rather than clones or hardlinks, when that is unexpected:
+    // they are on another file system than the project, or hardlinks were asked for and turned down. Empty otherwise
+    const std::string& getWorkspaceWarning() const { return workspaceWarning; }
+
+    // The temporary directory holding the workspaces
+    const std::filesystem::path& getWorkRoot() const { return workRoot; }
+
+    // Runs the command without any mutant in every workspace at once, which also gives incremental builds something
+    // to start from. Throws IOErrorException when it does not succeed in one of them
+    void runBaseline();
+
+    // One result per mutant directory, in the same order. Rethrows the first error a job ran into
+    std::vector<MutantResult> run( const std::vector<std::string>& mutantDirs );
+
+    // Stops the commands running and makes runBaseline() and run() throw, safe to call from a signal handler
+    static void requestStop();
+
+    // Runs command with /bin/sh in dir until it exits, a line of its output matches killPattern (which may be null) or
+    // timeLimitNs passes (0 for never)
+    static MutantResult runCommand( const std::string& command, const std::filesystem::path& dir,
+                                    std::uint64_t timeLimitNs, const RegexEngine* killPattern );
+};
+
+#endif  // _INCLUDED_COMMANDS_RUN_MUTANTRUNNER_HPP
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * runCommand.hpp: Header to be used only by main.cpp to bolt things together
+ *
+ * - This can be thought of as a self-contained subprogram within the larger mutation program
+ * - This runs a build and test command against every mutant tree given to it, in parallel, and tells which mutants
+ the tests killed, which survived and which timed out
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_COMMANDS_RUN_HPP
+#define _INCLUDED_COMMANDS_RUN_HPP
+
+#include <string>
+#include <vector>
+
+#include "commands/cli-options.hpp"
+#include "commands/run/mutantRunner.hpp"
+#include "common.hpp"
+
+std::string printRunHelp(const char *indent);
+
+std::string printRunHelp(std::string indent);
+
+std::string printRunHelp(void);
+
+void validateRunArgs(CLIOptions *opts, std::vector<std::string> *nonpositionals);
+
+// One line per mutant, in the order given, then a summary with the mutation score
+std::string getRunReport(const std::vector<std::string> &mutantDirs, const std::vector<MutantResult> &results);
+
+void doRunAction(CLIOptions *opts, std::vector<std::string> *nonpositionals);
+
+ParseArgvStatusCode execRun(CLIOptions *opts, std::vector<std::string> *nonpositionals);
+
+#endif  //_INCLUDED_COMMANDS_RUN_HPP
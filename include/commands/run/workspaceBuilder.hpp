@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * workspaceBuilder.hpp: Makes the workspaces of the run command out of the project tree without copying its files
+ *
+ * - Every file of the project is cloned into a workspace with FICLONE, sharing its blocks copy-on-write, where the
+ file system has reflinks, and copied elsewhere. Hardlinks are only made when asked for (run --hardlink), in place of
+ the copies
+ * - Files keep the modification time they have in the project, so a build in the workspace is only redone for what
+ a mutant changes
+ * - A hardlinked file is the project's file, so the files of a mutant are written to a new file renamed over it and
+ never through it. A test command rewriting one in place changes the project, which checkLinkedFiles() tells by the
+ size and modification time each had when it was linked
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_COMMANDS_RUN_WORKSPACEBUILDER_HPP
+#define _INCLUDED_COMMANDS_RUN_WORKSPACEBUILDER_HPP
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <filesystem>
+#include <map>
+#include <string>
+
+class WorkspaceBuilder {
+    std::filesystem::path projectRoot;
+
+    std::atomic<bool> canClone{ true };  // cleared once the file system turned FICLONE down
+
+    std::atomic<bool> canLink;  // hardlinks were asked for and not turned down yet
+
+    std::atomic<int> linkError{ 0 };  // the errno link() turned hardlinks down with
+
+    struct FileStamp {
+        off_t size;
+        struct timespec modificationTime;
+    };
+
+    std::map<std::filesystem::path, FileStamp> linked;  // the project's files, relative, as they were when linked
+
+    std::atomic<size_t> clonedFiles{ 0 };
+
+    std::atomic<size_t> linkedFiles{ 0 };
+
+    std::atomic<size_t> copiedFiles{ 0 };
+
+    // Clones from into to, a new file. False when the file system cannot
+    bool clone( const std::filesystem::path& from, const std::filesystem::path& to );
+
+    // Hardlinks to to from, remembering how from was. False when the file system cannot
+    bool hardlink( const std::filesystem::path& from, const std::filesystem::path& to );
+
+    // Copies from into to, a new file. Throws IOErrorException when it cannot
+    void copy( const std::filesystem::path& from, const std::filesystem::path& to );
+
+   public:
+    // Hardlinks the files it cannot clone when allowLinks, copies them otherwise
+    explicit WorkspaceBuilder( std::filesystem::path _projectRoot, bool allowLinks = false )
+        : projectRoot{ std::move( _projectRoot ) }, canLink{ allowLinks } {}
+
+    // Makes workspace, which must not exist yet, a tree of the project's files as described above. Symbolic links are
+    // recreated as they are. Throws IOErrorException when it cannot. Not to be called by several threads at once
+    void materialize( const std::filesystem::path& workspace );
+
+    // Throws IOErrorException naming the first hardlinked file whose size or modification time changed since it was
+    // linked, i.e. that was written through a workspace into the project
+    void checkLinkedFiles() const;
+
+    // Puts the project's version of relative back into workspace as a file of its own, with a new modification time
+    // so that a build redoes what was built from the mutant's version
+    void restore( const std::filesystem::path& relative, const std::filesystem::path& workspace );
+
+    // Replaces path with a new file holding contents, with the permissions path had, so that a link to the project is
+    // never written through. Throws IOErrorException when it cannot
+    static void replaceFile( const std::filesystem::path& path, const std::string& contents );
+
+    // Counts of the files materialize() and restore() handled so far, by how they were made
+    size_t getClonedFiles() const { return clonedFiles; }
+
+    size_t getLinkedFiles() const { return linkedFiles; }
+
+    size_t getCopiedFiles() const { return copiedFiles; }
+
+    // The errno of the link() that made hardlinks give way to copies, 0 when they were not asked for or all worked
+    int getLinkError() const { return linkError; }
+};
+
+#endif  // _INCLUDED_COMMANDS_RUN_WORKSPACEBUILDER_HPP
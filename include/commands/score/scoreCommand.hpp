@@ -44,6 +44,9 @@ std::string printScoreHelp(void);
 
 void validateScoreArgs(CLIOptions *opts, std::vector<std::string> *nonpositionals);
 
+// Builds the report text for already read input. Shared with the serve command
+std::string getScoreReport(const std::string &srcString);
+
 void doScoreAction(CLIOptions *opts, std::vector<std::string> *nonpositionals);
 
 ParseArgvStatusCode execScore(CLIOptions *opts, std::vector<std::string> *nonpositional);
@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutationService.hpp: Answers serve requests while keeping parsed inputs warm in memory
+ *
+ * - Parsed TSVs, comment stripped sources and compiled regexes are cached between requests by a MutationEngine
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_COMMANDS_SERVE_MUTATIONSERVICE_HPP
+#define _INCLUDED_COMMANDS_SERVE_MUTATIONSERVICE_HPP
+
+#include <string>
+#include <utility>
+
+#include "commands/mutate/mutationEngine.hpp"
+#include "commands/serve/serveProtocol.hpp"
+
+class MutationService {
+   private:
+    MutationEngine engine;
+
+    std::string defaultLanguage;
+
+    bool matchTokens;  // the daemon's --match=tokens
+
+   public:
+    explicit MutationService( std::string _defaultLanguage = "cpp", bool _matchTokens = false )
+        : defaultLanguage{ std::move( _defaultLanguage ) }, matchTokens{ _matchTokens } {}
+
+    // Never throws for bad input, errors are reported in the response instead
+    ServeResponse handle( const ServeRequest& request );
+};
+
+#endif  //_INCLUDED_COMMANDS_SERVE_MUTATIONSERVICE_HPP
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * serveCommand.hpp: Header to be used only by main.cpp to bolt things together
+ *
+ * - This can be thought of as a self-contained subprogram within the larger mutation program
+ * - This keeps a long running daemon listening on a Unix domain socket which answers mutate/validate/score requests
+ without paying for process startup and input parsing on every mutant
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_COMMANDS_SERVE_HPP
+#define _INCLUDED_COMMANDS_SERVE_HPP
+
+#include <string>
+#include <vector>
+
+#include "commands/cli-options.hpp"
+#include "commands/serve/mutationService.hpp"
+#include "common.hpp"
+
+std::string printServeHelp(const char *indent);
+
+std::string printServeHelp(std::string indent);
+
+std::string printServeHelp(void);
+
+// Answers the request frames read from inFd with response frames written to outFd until EOF or a shutdown request,
+// which returns false. A request with a TSV and a tsvId keeps the TSV under that id for the rest of the stream, and one
+// with a tsvId but no TSV uses the TSV kept under it. Throws IOErrorException when the stream breaks
+bool serveStream(int inFd, int outFd, MutationService &service);
+
+void validateServeArgs(CLIOptions *opts, std::vector<std::string> *nonpositionals);
+
+void doServeAction(CLIOptions *opts, std::vector<std::string> *nonpositionals);
+
+ParseArgvStatusCode execServe(CLIOptions *opts, std::vector<std::string> *nonpositionals);
+
+#endif  //_INCLUDED_COMMANDS_SERVE_HPP
@@ -0,0 +1,110 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * serveProtocol.hpp: The compact framed protocol spoken by the serve command
+ *
+ * - Every frame is a big endian u32 holding the length of the body followed by the body itself
+ * - Inside of a body, a `str` is a big endian u32 length followed by that many bytes
+ * - Request body:  u8 version | u8 op | i32 count | i32 minCount | i32 maxCount | str seed | str src | str tsv
+ *   \- count/minCount/maxCount are -1 when unspecified, an empty seed means generate a new seed
+ * - Response body: u8 version | u8 status | str seed | str output | str warnings
+ *   \- On error, output holds the error message
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_COMMANDS_SERVE_PROTOCOL_HPP
+#define _INCLUDED_COMMANDS_SERVE_PROTOCOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+constexpr std::uint8_t SERVE_PROTOCOL_VERSION = 1;
+constexpr std::uint32_t SERVE_MAX_FRAME_SIZE = 1U << 30;
+
+enum class ServeOp : std::uint8_t { MUTATE = 1, VALIDATE = 2, SCORE = 3, PING = 4, SHUTDOWN = 5 };
+
+enum class ServeStatus : std::uint8_t { OK = 0, ERROR = 1 };
+
+struct ServeRequest {
+    ServeOp op = ServeOp::PING;
+    std::int32_t count = -1;
+    std::int32_t minCount = -1;
+    std::int32_t maxCount = -1;
+    std::string seed;
+    std::string src;
+    std::string tsv;
+    std::string language;  // empty for the daemon's --language, sent last so that older clients can leave it out
+    std::uint32_t tsvId = 0;  // 0 for none, may be left out too. See serveStream()
+};
+
+struct ServeResponse {
+    ServeStatus status = ServeStatus::OK;
+    std::string seed;
+    std::string output;
+    std::string warnings;
+};
+
+class FrameWriter {
+   private:
+    std::string body;
+
+   public:
+    void putU8( std::uint8_t value );
+    void putU32( std::uint32_t value );
+    void putI32( std::int32_t value );
+    void putU64( std::uint64_t value );
+    void putStr( std::string_view str );
+
+    const std::string& getBody() const { return body; }
+};
+
+// Throws IOErrorException when the body is too short for what is being read
+class FrameReader {
+   private:
+    std::string_view body;
+
+    std::size_t pos;
+
+    void need( std::size_t size ) const;
+
+   public:
+    explicit FrameReader( std::string_view _body ) : body{ _body }, pos{ 0 } {}
+
+    std::uint8_t getU8();
+    std::uint32_t getU32();
+    std::int32_t getI32();
+    std::uint64_t getU64();
+    std::string getStr();
+
+    bool atEnd() const { return pos == body.size(); }
+};
+
+// Returns false on a clean EOF before the frame started
+bool readFrame( int fd, std::string& body );
+
+void writeFrame( int fd, const std::string& body );
+
+std::string encodeRequest( const ServeRequest& request );
+
+ServeRequest decodeRequest( const std::string& body );
+
+std::string encodeResponse( const ServeResponse& response );
+
+ServeResponse decodeResponse( const std::string& body );
+
+#endif  //_INCLUDED_COMMANDS_SERVE_PROTOCOL_HPP
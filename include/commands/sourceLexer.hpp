@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * sourceLexer.hpp: Per-language lexers splitting a source into a token stream
+ *
+ * - Languages are described by LexerRules (comment markers and literal syntax) rather than by code, a new one is
+ plugged in with SourceLexer::add() and picked by name (--language) or by the extension of the input file
+ * - Tokens are only offsets into the source, so a token stream is cheap to keep cached next to its source and to
+ share between the commands that need it
+ * - findComments() skips code 16 bytes at a time with SSE2 where available and only reports comments, for stripping
+ them without paying for a full tokenization
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_COMMANDS_SOURCELEXER_HPP
+#define _INCLUDED_COMMANDS_SOURCELEXER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class TokenKind : unsigned char { IDENTIFIER, NUMBER, STRING, CHARACTER, COMMENT, PUNCTUATION };
+
+// Sources must be smaller than 4 GiB, lexing a larger one throws InvalidArgumentException. Whitespace is not
+// tokenized, punctuation is one token per character
+struct Token {
+    std::uint32_t offset;
+    std::uint32_t length;
+    TokenKind kind;
+};
+
+using TokenStream = std::vector<Token>;
+
+// Where a scan of a source that grows at the end left off, see SourceLexer::findCommentsAndLiterals()
+struct LexerResume {
+    std::size_t pos = 0;         // the tokens before it are final, the next scan starts there
+    std::size_t searchFrom = 0;  // where to look for the end of the comment or literal at pos that was cut short
+};
+
+struct LexerRules {
+    const char* name;
+    const char* extensions;      // space separated, e.x. ".c .h"
+    const char* lineComment;     // "//" or "#", nullptr for none
+    const char* stringPrefixes;  // space separated identifiers that belong to a string right after them, e.x. u8
+    bool blockComments;          // /* */
+    bool lineSplicing;           // a backslash at the end of a line continues a // comment onto the next one
+    bool characterLiterals;      // ' quotes a character, otherwise it quotes a string like "
+    bool digitSeparators;        // 1'000'000
+    bool rawStrings;             // R"delimiter(...)delimiter", the prefix ends in R
+    bool tripleQuotedStrings;    // """...""" (and '''...''' unless characterLiterals), may span lines
+    bool backtickStrings;        // `...`, may span lines
+    bool backtickEscapes;        // a backslash escapes inside `...`
+    bool regexLiterals;          // /.../ where an operand is expected
+};
+
+class SourceLexer {
+   private:
+    LexerRules rules;
+    char stopChars[5];  // the characters findComments() cannot skip over
+    std::size_t stopCharCount;
+
+    // With resume, only from resume->pos on and up to the first token more of src could change
+    template <bool ALL_TOKENS, bool LITERALS = ALL_TOKENS>
+    TokenStream scan(std::string_view src, LexerResume* resume = nullptr) const;
+
+    // The *End() functions look for the end from `from` on when it is further. When leftOff is given and src ends
+    // before the token does, they set it to where to look from once src has grown
+    std::size_t lineCommentEnd(std::string_view src, std::size_t pos, std::size_t from = 0,
+                               std::size_t* leftOff = nullptr) const;
+    std::size_t blockCommentEnd(std::string_view src, std::size_t pos, std::size_t from = 0,
+                                std::size_t* leftOff = nullptr) const;
+    std::size_t literalEnd(std::string_view src, std::size_t quotePos, bool raw, std::size_t from = 0,
+                           std::size_t* leftOff = nullptr) const;
+    std::size_t regexLiteralEnd(std::string_view src, std::size_t pos, bool* ranOut = nullptr) const;
+    bool isStringPrefix(std::string_view identifier) const;
+    bool startsLineComment(std::string_view src, std::size_t pos) const;
+
+   public:
+    explicit SourceLexer(const LexerRules& _rules);
+
+    const LexerRules& getRules() const { return rules; }
+    const char* getName() const { return rules.name; }
+
+    // Every token of src in order
+    TokenStream tokenize(std::string_view src) const;
+
+    // Only the COMMENT tokens of src, literals are still lexed so that comment markers inside them are left alone
+    TokenStream findComments(std::string_view src) const;
+
+    // The COMMENT, STRING and CHARACTER tokens of src, i.e. everything that can span lines
+    TokenStream findCommentsAndLiterals(std::string_view src) const;
+
+    // The above for a src that only grows at the end between calls, e.x. read a chunk at a time: the tokens from
+    // resume.pos on that no more of src can change, with resume moved past them. The rest is lexed again by the next
+    // call, except for a comment or literal src ends in, whose end is only looked for in what was added. All the calls
+    // together give the tokens one call on the whole src would
+    TokenStream findCommentsAndLiterals(std::string_view src, LexerResume& resume) const;
+
+    // Throws InvalidArgumentException for an unknown name
+    static const SourceLexer& get(const std::string& name);
+
+    // By the extension of path, the C++ lexer when none matches (or for stdin)
+    static const SourceLexer& forPath(const std::string& path);
+
+    static const SourceLexer& getDefault();
+
+    // Plugs in another language, or replaces the one with the same name. Call it before any lexing starts
+    static void add(const LexerRules& rules);
+
+    // e.x. "c, cpp, java"
+    static std::string getNames();
+};
+
+#endif  //_INCLUDED_COMMANDS_SOURCELEXER_HPP
@@ -44,6 +44,9 @@ std::string printValidateHelp(void);
 
 void validateValidateArgs(CLIOptions *opts, std::vector<std::string> *nonpositionals);
 
+// Builds the report text for already read input. Shared with the serve command
+std::string getValidateReport(const std::string &tsvString);
+
 void doValidateAction(CLIOptions *opts, std::vector<std::string> *nonpositionals);
 
 ParseArgvStatusCode execValidate(CLIOptions *opts, std::vector<std::string> *nonpositionals);
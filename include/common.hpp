@@ -25,6 +25,7 @@
 #define _INCLUDED_COMMON_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 #define PROGRAM_NAME "mutateplaceholder"
@@ -49,9 +50,8 @@
     } while (0)
 #endif
 
-enum class ParseArgvStatusCode : unsigned char { SUCCESS, ERROR, SHOWHELP, SHOWVERSION };
-
-extern bool verbose;  // for printing status of process messages in classes
+// SUCCESS_QUIET is SUCCESS for a command whose stdout must hold nothing but what it wrote itself
+enum class ParseArgvStatusCode : unsigned char { SUCCESS, SUCCESS_QUIET, ERROR, SHOWHELP, SHOWVERSION };
 
 // remove special characters from a string so it can be safely shown in the console without risk of introducing security
 // vulnerabilities
@@ -71,4 +71,14 @@ unsigned int isWhiteSpace(const std::string::iterator& it, const std::string::it
 //      USE CASES IN THIS PROJECT DO NUT RUN THAT RISK IT IS OK FOR OUR PURPOSES.
 size_t lastNonWhiteSpace(std::string::iterator begin, std::string::iterator end);
 
+// 64 bit FNV-1a hash of a byte range. Used for keying cached inputs, not for anything security related
+std::uint64_t hashBytes(const char* data, std::size_t size);
+
+std::uint64_t hashBytes(const std::string& str);
+
+// The replacement text of a match starting at pos, its lines after the first indented like the line pos is on. A
+// newlined replacement goes on lines of its own, so its first line is indented too
+std::string indentReplacement(const std::string& subject, std::size_t pos, const std::string& replacement,
+                              bool isNewLined);
+
 #endif  //_INCLUDED_COMMON_HPP
@@ -31,6 +31,7 @@
 
 #include <optional>
 #include <string>
+#include <string_view>
 
 #include "common.hpp"
 
@@ -43,7 +44,15 @@ constexpr size_t IO_BUFF_SIZE = 16384;
 
 std::string readWholeFileIntoString(std::FILE* handle, const char* errMsg);
 
-void initializeSrcTsvTogetherFromStdin(std::optional<std::string>* srcString, std::optional<std::string>* tsvString);
+// Splits input whose first line is a deliminator into the source code after it, up to the next line that is the same
+// as the deliminator, and the TSV mutations after that line, up to another such line or the end. Both views point
+// into input. Returns false when the deliminator line does not come again
+bool splitSrcTsvInput(std::string_view input, std::string_view* src, std::string_view* tsv);
+
+// The first line of stdin is the deliminator, see splitSrcTsvInput(). srcString keeps the buffer stdin was read into,
+// cut after the source which starts at *srcOffset, so that the source is neither copied nor moved
+void initializeSrcTsvTogetherFromStdin(std::optional<std::string>* srcString, std::size_t* srcOffset,
+                                       std::optional<std::string>* tsvString);
 
 void writeStringToFileHandle(std::FILE* handle, std::string text);
 
@@ -51,4 +60,10 @@ void readSeedFileIntoString(std::FILE* seedInput, std::optional<std::string>* ou
 
 void closeAndNullifyFileHandle(std::FILE** handle);
 
+// Reads exactly `size` bytes from a file descriptor (e.x. a socket). Returns false if EOF is reached before anything
+// was read and throws if EOF is reached part way through
+bool readExactFromFd(int fd, char* buffer, std::size_t size);
+
+void writeAllToFd(int fd, const char* data, std::size_t size);
+
 #endif  //_INCLUDED_IOHELPERS_HPP
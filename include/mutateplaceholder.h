@@ -0,0 +1,83 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutateplaceholder.h: The C interface of libmutateplaceholder
+ *
+ * - A thin wrapper around MutationEngine (see commands/mutate/mutationEngine.hpp) for non C++ callers
+ * - No C++ exception ever crosses this interface, failures are reported as an mp_status plus a message that can be
+ read with mp_engine_last_error()
+ * - Separate engines share no state, so use one engine per thread. A single engine is not thread safe
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_MUTATEPLACEHOLDER_H_
+#define _INCLUDED_MUTATEPLACEHOLDER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MP_API_VERSION 1
+#define MP_SEED_BUFFER_SIZE 65  // 64 hexadecimal digits plus the terminating null
+
+typedef struct mp_engine mp_engine;
+
+typedef enum mp_status {
+    MP_OK = 0,
+    MP_ERROR_TSV = 1,       // the mutations TSV failed to parse
+    MP_ERROR_SEED = 2,      // the given seed is not 64 hexadecimal digits
+    MP_ERROR_ARGUMENT = 3,  // bad counts, empty source or NULL pointers
+    MP_ERROR_IO = 4,
+    MP_ERROR_OTHER = 5  // includes running out of memory
+} mp_status;
+
+// Output buffer owned by the library, release it with mp_buffer_free(). data is always null terminated
+typedef struct mp_buffer {
+    char* data;
+    size_t size;
+} mp_buffer;
+
+// Returns MP_API_VERSION of the library actually linked, for checking against the header used at build time
+int mp_api_version(void);
+
+// Returns NULL when out of memory
+mp_engine* mp_engine_new(void);
+
+void mp_engine_free(mp_engine* engine);
+
+// Mutates src with the mutations in tsv. Neither input needs to be null terminated
+// - seed may be NULL to generate a new seed, count/minCount/maxCount may be -1 when unspecified
+// - on MP_OK, out holds the mutant and seedOut (if not NULL) the seed that reproduces it
+mp_status mp_mutate(mp_engine* engine, const char* src, size_t srcSize, const char* tsv, size_t tsvSize,
+                    const char* seed, int32_t count, int32_t minCount, int32_t maxCount, mp_buffer* out,
+                    char seedOut[MP_SEED_BUFFER_SIZE]);
+
+// Message of the last failing call on this engine, empty if the last call succeeded. Valid until the next call
+const char* mp_engine_last_error(const mp_engine* engine);
+
+// Warnings raised by the last mp_mutate() call on this engine, empty if there were none. Valid until the next call
+const char* mp_engine_last_warnings(const mp_engine* engine);
+
+void mp_buffer_free(mp_buffer* buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _INCLUDED_MUTATEPLACEHOLDER_H_
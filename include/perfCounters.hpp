@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * perfCounters.hpp: Hardware performance counters of the calling thread through perf_event_open(2)
+ *
+ * - Every counter is opened on its own, so a CPU or VM missing one counter (often the cache ones) still reports
+ * the others
+ * - Counters that cannot be opened (not Linux, kernel.perf_event_paranoid, no PMU in a VM...) read as 0 and
+ * isAvailable() tells them apart, nothing throws
+ * - Only user space of the thread that constructed the PerfCounters is counted
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_PERFCOUNTERS_HPP
+#define _INCLUDED_PERFCOUNTERS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum class PerfEvent : unsigned char { CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES, COUNT };
+
+constexpr std::size_t PERF_EVENT_COUNT = static_cast<std::size_t>(PerfEvent::COUNT);
+
+struct PerfSample {
+    std::array<std::uint64_t, PERF_EVENT_COUNT> values{};
+
+    std::uint64_t operator[](PerfEvent event) const { return values[static_cast<std::size_t>(event)]; }
+    PerfSample operator-(const PerfSample& other) const;
+    PerfSample& operator+=(const PerfSample& other);
+};
+
+class PerfCounters {
+   private:
+    std::array<int, PERF_EVENT_COUNT> fds;
+    std::string unavailableReason;
+
+   public:
+    PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters();
+
+    static const char* eventName(PerfEvent event);
+
+    bool isAvailable(PerfEvent event) const { return fds[static_cast<std::size_t>(event)] >= 0; }
+    bool anyAvailable() const;
+
+    // Why the first counter that failed could not be opened, empty if all of them were
+    const std::string& getUnavailableReason() const { return unavailableReason; }
+
+    // Totals since construction, scaled up when the kernel multiplexed a counter with others
+    PerfSample read() const;
+};
+
+#endif  //_INCLUDED_PERFCOUNTERS_HPP
@@ -0,0 +1,128 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * pipelineStats.hpp: Phase timings and counters of a mutate run, reported by --stats
+ *
+ * - Disabled stats are passed around as a nullptr, so that a run without --stats only pays for a pointer check
+ * - ScopedPhase adds the wall time of its scope to a phase, nested or repeated scopes of one phase add up
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_PIPELINESTATS_HPP
+#define _INCLUDED_PIPELINESTATS_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "allocProfiler.hpp"
+#include "perfCounters.hpp"
+
+enum class StatsFormat : unsigned char { TEXT, JSON };
+
+enum class StatsPhase : unsigned char { READ, STRIP, PARSE, CATEGORIZE, NESTING, SELECT, REPLACE, WRITE, COUNT };
+
+enum class StatsCounter : unsigned char {
+    ROWS_PARSED,
+    ROWS_SELECTED,
+    REGEX_COMPILATIONS,
+    FIND_CALLS,
+    BYTES_COPIED,  // bytes written or moved by replacements
+    NO_MATCHES,
+    MULTIPLE_MATCHES,
+    PREFILTER_SKIPS,   // regex rows skipped as the source lacks a literal they require
+    REGEX_LIMIT_HITS,  // regex rows skipped as they ran into --regex-*-limit or --time-limit
+    COUNT
+};
+
+struct ReplacementStats {
+    std::size_t lineNumber;  // of the TSV row
+    std::uint64_t ns;
+    int matches;
+    bool isRegex;
+};
+
+class PipelineStats {
+   private:
+    std::array<std::uint64_t, static_cast<std::size_t>(StatsPhase::COUNT)> phaseNs{};
+    std::array<std::uint64_t, static_cast<std::size_t>(StatsCounter::COUNT)> counters{};
+    std::vector<ReplacementStats> replacements;
+    std::unique_ptr<PerfCounters> hardwareCounters;  // nullptr unless enabled
+    std::array<PerfSample, static_cast<std::size_t>(StatsPhase::COUNT)> phaseCounters{};
+    std::array<AllocationTally, static_cast<std::size_t>(StatsPhase::COUNT)> phaseAllocations{};  // see allocProfiler
+
+    std::string getTextReport() const;
+    std::string getJsonReport() const;
+
+   public:
+    static const char* phaseName(StatsPhase phase);
+    static const char* counterName(StatsCounter counter);
+
+    void addPhaseTime(StatsPhase phase, std::uint64_t ns) { phaseNs[static_cast<std::size_t>(phase)] += ns; }
+    void add(StatsCounter counter, std::uint64_t amount = 1) { counters[static_cast<std::size_t>(counter)] += amount; }
+    void addReplacement(std::size_t lineNumber, std::uint64_t ns, int matches, bool isRegex);
+
+    // Opens the hardware counters of the calling thread, phases timed on it from then on also count them
+    void enableHardwareCounters();
+    PerfCounters* getHardwareCounters() { return hardwareCounters.get(); }
+    void addPhaseCounters(StatsPhase phase, const PerfSample& sample) {
+        phaseCounters[static_cast<std::size_t>(phase)] += sample;
+    }
+    const PerfSample& getPhaseCounters(StatsPhase phase) const {
+        return phaseCounters[static_cast<std::size_t>(phase)];
+    }
+
+    void addPhaseAllocations(StatsPhase phase, const AllocationTally& tally) {
+        phaseAllocations[static_cast<std::size_t>(phase)] += tally;
+    }
+    const AllocationTally& getPhaseAllocations(StatsPhase phase) const {
+        return phaseAllocations[static_cast<std::size_t>(phase)];
+    }
+
+    std::uint64_t getPhaseTime(StatsPhase phase) const { return phaseNs[static_cast<std::size_t>(phase)]; }
+    std::uint64_t get(StatsCounter counter) const { return counters[static_cast<std::size_t>(counter)]; }
+    const std::vector<ReplacementStats>& getReplacements() const { return replacements; }
+
+    std::string getReport(StatsFormat format) const;
+};
+
+// Monotonic clock in nanoseconds, for timing things that are not a whole scope
+std::uint64_t statsClockNs();
+
+// Times (and counts, see PipelineStats::enableHardwareCounters()) its scope into a phase of stats and records it as a
+// --trace span, does nothing if stats is nullptr and tracing is off. Allocation profiling builds attribute the
+// allocations of the scope to the phase either way
+class ScopedPhase {
+   private:
+    PipelineStats* stats;
+    StatsPhase phase;
+    StatsPhase previousAllocPhase;
+    bool traced;
+    std::uint64_t startNs;
+    PerfSample startCounters;
+    AllocationTally startAllocations;
+
+   public:
+    ScopedPhase(PipelineStats* _stats, StatsPhase _phase);
+    ScopedPhase(const ScopedPhase&) = delete;
+    ScopedPhase& operator=(const ScopedPhase&) = delete;
+    ~ScopedPhase();
+};
+
+#endif  //_INCLUDED_PIPELINESTATS_HPP
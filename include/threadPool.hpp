@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * threadPool.hpp: A fixed set of worker threads running queued jobs
+ *
+ * - Workers are named "worker N" in --trace output
+ * - A job that throws does not take its worker down, the first exception is kept and rethrown by wait()
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_THREADPOOL_HPP
+#define _INCLUDED_THREADPOOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+   private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable jobQueued;
+    std::condition_variable jobsDone;
+    std::size_t running = 0;
+    bool stopping = false;
+    std::exception_ptr firstException;
+
+    void work(std::size_t index);
+
+   public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(std::size_t threads = 0);
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Runs the jobs still queued, then joins the workers
+    ~ThreadPool();
+
+    void submit(std::function<void()> job);
+
+    // Blocks until every submitted job has finished, then rethrows the first exception a job threw if any
+    void wait();
+
+    std::size_t size() const { return workers.size(); }
+
+    static std::size_t hardwareThreads();
+};
+
+#endif  //_INCLUDED_THREADPOOL_HPP
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * traceRecorder.hpp: Chrome/Perfetto trace-event spans of a run, written by --trace=FILE
+ *
+ * - Every thread records into its own fixed size ring buffer without locking, the oldest spans are overwritten
+ * (and counted as dropped) once a buffer is full
+ * - Ring buffers are owned by the recorder, not the thread, so spans of finished worker threads are kept until
+ * the trace is written at exit
+ * - While tracing is off a span costs one relaxed atomic load
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_TRACERECORDER_HPP
+#define _INCLUDED_TRACERECORDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+constexpr std::size_t TRACE_EVENTS_PER_THREAD = 1 << 16;
+
+constexpr std::int64_t TRACE_NO_ARG = -1;
+
+// name and category must be string literals (or otherwise outlive the recorder) as only the pointers are kept
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    std::uint64_t startNs;
+    std::uint64_t durationNs;
+    std::int64_t arg;  // shown as "line" in the trace, TRACE_NO_ARG for none
+};
+
+class TraceRecorder {
+   public:
+    // Turns tracing on and writes the trace to path when the program exits
+    static void start(const std::string& path, std::size_t eventsPerThread = TRACE_EVENTS_PER_THREAD);
+    static bool isEnabled();
+
+    // Names the calling thread in the trace, e.x. "main" or "worker 3"
+    static void setThreadName(const std::string& name);
+
+    static void record(const char* name, const char* category, std::uint64_t startNs, std::uint64_t endNs,
+                       std::int64_t arg = TRACE_NO_ARG);
+
+    // Only call once every recording thread has finished or been joined
+    static std::string getJson();
+    static std::size_t getDroppedEvents();
+
+    // Drops every recorded span and turns tracing off, for tests
+    static void reset();
+};
+
+// Records its scope as a span, does nothing while tracing is off
+class TraceSpan {
+   private:
+    const char* name;
+    const char* category;
+    std::int64_t arg;
+    std::uint64_t startNs;
+
+   public:
+    TraceSpan(const char* _name, const char* _category, std::int64_t _arg = TRACE_NO_ARG);
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+    ~TraceSpan();
+};
+
+#endif  //_INCLUDED_TRACERECORDER_HPP
@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * allocProfiler.cpp: Heap allocations attributed to pipeline phases, in builds configured with
+ * -DMUTATEPLACEHOLDER_ALLOC_PROFILING=ON
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "allocProfiler.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "pipelineStats.hpp"
+
+static constexpr std::size_t SLOT_COUNT = static_cast<std::size_t>(StatsPhase::COUNT) + 1;
+
+// Plain thread_local arrays need no dynamic initialization, so operator new can use them at any time
+static thread_local AllocationTally phaseTallies[SLOT_COUNT];
+static thread_local std::size_t currentSlot = SLOT_COUNT - 1;
+
+static std::atomic<std::uint64_t> totalAllocations{0};
+static std::atomic<std::uint64_t> totalBytes{0};
+
+StatsPhase AllocProfiler::enterPhase(StatsPhase phase) {
+    StatsPhase previous = static_cast<StatsPhase>(currentSlot);
+    currentSlot = static_cast<std::size_t>(phase);
+    return previous;
+}
+
+AllocationTally AllocProfiler::get(StatsPhase phase) { return phaseTallies[static_cast<std::size_t>(phase)]; }
+
+AllocationTally AllocProfiler::total() {
+    return {totalAllocations.load(std::memory_order_relaxed), totalBytes.load(std::memory_order_relaxed)};
+}
+
+#ifdef MUTATEPLACEHOLDER_ALLOC_PROFILING
+
+static void* countedAlloc(std::size_t size) {
+    AllocationTally& tally = phaseTallies[currentSlot];
+    ++tally.allocations;
+    tally.bytes += size;
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+    totalBytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size) {
+    if (void* ptr = countedAlloc(size)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+#endif
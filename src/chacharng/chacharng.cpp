@@ -29,7 +29,7 @@
      d = CHACHARNG_ROTL(d, 8), c += d, b ^= c, b = CHACHARNG_ROTL(b, 7))
 #define CHACHARNG_ROUNDS 20
 
-static void chacha_block(std::uint32_t out[16], std::uint32_t const in[16]) {
+void chacha_block(std::uint32_t out[16], std::uint32_t const in[16]) {
     std::uint32_t x[16];
 
     for (int i = 0; i < 16; ++i) x[i] = in[i];
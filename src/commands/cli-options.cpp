@@ -60,7 +60,12 @@
 // declared in definition file
 
 CLIOptions::CLIOptions()
-    : srcInput(stdin), tsvInput(stdin), resOutput(stdout), seedInput(nullptr), seedOutput(nullptr) {}
+    : srcInput(stdin),
+      tsvInput(stdin),
+      resOutput(stdout),
+      seedInput(nullptr),
+      seedOutput(nullptr),
+      descriptorOutput(nullptr) {}
 
 void CLIOptions::setSrcOrTsvInput(FILE **srcOrTsv, const char *path, const char *mode, int bufferMode,
                                   const char *which) {
@@ -125,6 +130,200 @@ void CLIOptions::setTsvInput(const char *path) {
 
 void CLIOptions::setOutputFileName(const char *path) { outputFileName = std::string(path); }
 
+void CLIOptions::setSocketPath(const char *path) {
+    if (socketPath.has_value()) {
+        throw InvalidArgumentException("socket path can only be specified once");
+    }
+    socketPath = std::string(path);
+}
+
+void CLIOptions::setTraceFileName(const char *path) {
+    if (traceFileName.has_value()) {
+        throw InvalidArgumentException("--trace can only be specified once");
+    }
+    traceFileName = std::string(path);
+}
+
+void CLIOptions::requestHardwareCounters() { hardwareCounters = true; }
+
+void CLIOptions::requestStreaming() { streaming = true; }
+
+void CLIOptions::requestSchemata() { schemata = true; }
+
+void CLIOptions::requestJobsFromStdin() { jobsFromStdin = true; }
+
+void CLIOptions::requestHardlinks() { hardlinks = true; }
+
+void CLIOptions::requestVerboseOutput() { verboseOutput = true; }
+
+void CLIOptions::setLanguage(const char *name) {
+    if (language) {
+        throw InvalidArgumentException("--language can only be specified once");
+    }
+    language = &SourceLexer::get(name);
+}
+
+void CLIOptions::setMatchMode(const char *mode) {
+    if (matchMode.has_value()) {
+        throw InvalidArgumentException("--match can only be specified once");
+    }
+    if (0 == std::strcmp(mode, "text")) {
+        matchMode = MatchMode::TEXT;
+    }
+    else if (0 == std::strcmp(mode, "tokens")) {
+        matchMode = MatchMode::TOKENS;
+    }
+    else {
+        std::string lastError = "invalid --match option value. Must be one of text or tokens. Got \"";
+        lastError.append(sanitizeOutputMessage(mode));
+        lastError.append("\"");
+        throw InvalidArgumentException(lastError);
+    }
+}
+
+void CLIOptions::setTreeRoot(const char *path) {
+    if (treeRoot.has_value()) {
+        throw InvalidArgumentException("--tree can only be specified once");
+    }
+    if (!std::filesystem::is_directory(path)) {
+        std::ostringstream os;
+        os << "Source directory \'" << path << "\' was not found.";
+        throw IOErrorException(sanitizeOutputMessage(os.str()));
+    }
+    treeRoot = std::string(path);
+}
+
+void CLIOptions::setFileListName(const char *path) {
+    if (fileListName.has_value()) {
+        throw InvalidArgumentException("--file-list can only be specified once");
+    }
+    if (std::strcmp(path, "-") && !std::filesystem::exists(path)) {
+        std::ostringstream os;
+        os << "File list \'" << path << "\' was not found.";
+        throw IOErrorException(sanitizeOutputMessage(os.str()));
+    }
+    fileListName = std::string(path);
+}
+
+void CLIOptions::setOutputDirName(const char *path) {
+    if (outputDirName.has_value()) {
+        throw InvalidArgumentException("--output-dir can only be specified once");
+    }
+    outputDirName = std::string(path);
+}
+
+void CLIOptions::addGlob(const char *glob) { globs.emplace_back(glob); }
+
+void CLIOptions::setJobs(const char *count) {
+    if (jobs.has_value()) {
+        throw InvalidArgumentException("--jobs can only be specified once");
+    }
+    char *endPtr = (char *)count;
+    unsigned long retStatus = strtoul(count, &endPtr, 0);
+    if (endPtr == count || *endPtr || !retStatus || 1024 < retStatus) {
+        throw InvalidArgumentException("invalid value specified for --jobs. Expected a number from 1 to 1024");
+    }
+    jobs = (std::int32_t)retStatus;
+}
+
+void CLIOptions::setRegexLimit(std::uint32_t *limit, const char *value, const char *fullName) {
+    if (*limit) {
+        throw InvalidArgumentException(std::string(fullName) + " can only be specified once");
+    }
+    char *endPtr = (char *)value;
+    unsigned long retStatus = strtoul(value, &endPtr, 0);
+    if (endPtr == value || *endPtr || !retStatus || UINT32_MAX < retStatus) {
+        throw InvalidArgumentException(std::string("invalid value specified for ") + fullName +
+                                       ". Expected a number from 1 to 4294967295");
+    }
+    *limit = (std::uint32_t)retStatus;
+}
+
+void CLIOptions::setRegexMatchLimit(const char *limit) {
+    setRegexLimit(&regexLimits.matchLimit, limit, "--regex-match-limit");
+}
+
+void CLIOptions::setRegexDepthLimit(const char *limit) {
+    setRegexLimit(&regexLimits.depthLimit, limit, "--regex-depth-limit");
+}
+
+void CLIOptions::setRegexHeapLimit(const char *kib) {
+    setRegexLimit(&regexLimits.heapLimitKib, kib, "--regex-heap-limit");
+}
+
+void CLIOptions::setRegexLimits(const RegexLimits &limits) { regexLimits = limits; }
+
+void CLIOptions::setTimeLimit(const char *ms) {
+    if (timeLimitMs.has_value()) {
+        throw InvalidArgumentException("--time-limit can only be specified once");
+    }
+    char *endPtr = (char *)ms;
+    unsigned long retStatus = strtoul(ms, &endPtr, 0);
+    if (endPtr == ms || *endPtr || !retStatus || INT32_MAX < retStatus) {
+        throw InvalidArgumentException("invalid value specified for --time-limit. Expected a number of milliseconds"
+                                       " from 1 to 2147483647");
+    }
+    timeLimitMs = (std::int32_t)retStatus;
+}
+
+void CLIOptions::setTestCommand(const char *command) {
+    if (testCommand.has_value()) {
+        throw InvalidArgumentException("--test-command can only be specified once");
+    }
+    if (!*command) {
+        throw InvalidArgumentException("--test-command cannot be empty");
+    }
+    testCommand = std::string(command);
+}
+
+void CLIOptions::setDescriptor(const char *text) {
+    if (descriptor.has_value()) {
+        throw InvalidArgumentException("--apply can only be specified once");
+    }
+    descriptor = std::string(text);
+}
+
+void CLIOptions::setDescriptorOutput(const char *path) {
+    setSeedInputOrOutput(&(descriptorOutput), path, "w", _IOFBF, "descriptor output");
+}
+
+void CLIOptions::setKillPattern(const char *pattern) {
+    if (killPattern.has_value()) {
+        throw InvalidArgumentException("--kill-pattern can only be specified once");
+    }
+    killPattern = std::string(pattern);
+}
+
+void CLIOptions::setWorkDirName(const char *path) {
+    if (workDirName.has_value()) {
+        throw InvalidArgumentException("--work-dir can only be specified once");
+    }
+    if (!std::filesystem::is_directory(path)) {
+        std::ostringstream os;
+        os << "Work directory \'" << path << "\' was not found.";
+        throw IOErrorException(sanitizeOutputMessage(os.str()));
+    }
+    workDirName = std::string(path);
+}
+
+void CLIOptions::setStats(const char *fmt) {
+    if (statsFormat.has_value()) {
+        throw InvalidArgumentException("--stats can only be specified once");
+    }
+    if (fmt == nullptr || 0 == std::strcmp(fmt, "text")) {
+        statsFormat = StatsFormat::TEXT;
+    }
+    else if (0 == std::strcmp(fmt, "json")) {
+        statsFormat = StatsFormat::JSON;
+    }
+    else {
+        std::string lastError = "invalid --stats option value. Must be one of text or json. Got \"";
+        lastError.append(sanitizeOutputMessage(fmt));
+        lastError.append("\"");
+        throw InvalidArgumentException(sanitizeOutputMessage(lastError));
+    }
+}
+
 void CLIOptions::setResOutput(const char *path) {
     setSrcOrTsvInput(&(resOutput), path, "w", _IONBF, "resulting output");  // NOTICE: no buffering here for performance
 }
@@ -232,40 +431,54 @@ void CLIOptions::setFormat(const char *fmt) {
     }
 }
 
-std::string CLIOptions::getSrcString() {
-    if (CLIOptions::srcInput == stdin && CLIOptions::tsvInput == stdin) {
-        if (isatty(fileno(CLIOptions::srcInput)) && isatty(fileno(CLIOptions::tsvInput))) {
-            std::cerr << "File paths for source and tsv files not specified,  retrieving input content from stdin...\n";
-        }
-        initializeSrcTsvTogetherFromStdin(&(CLIOptions::srcString), &(CLIOptions::tsvString));
+void CLIOptions::readSrcTsvTogether() {
+    if (CLIOptions::srcInput != stdin || CLIOptions::tsvInput != stdin) return;
+    if (srcString.has_value() && tsvString.has_value()) return;
+    if (isatty(fileno(CLIOptions::srcInput)) && isatty(fileno(CLIOptions::tsvInput))) {
+        std::cerr << "File paths for source and tsv files not specified,  retrieving input content from stdin...\n";
     }
+    ScopedPhase phase(getStats(), StatsPhase::READ);
+    std::size_t srcOffset = 0;
+    initializeSrcTsvTogetherFromStdin(&(CLIOptions::srcString), &srcOffset, &(CLIOptions::tsvString));
+    // so that the source can be handed out by reference, moves it down without reallocating
+    srcString->erase(0, srcOffset);
+}
+
+const std::string &CLIOptions::getSrcString() {
+    readSrcTsvTogether();
 
     if (!CLIOptions::srcString.has_value()) {
         if (isatty(fileno(CLIOptions::srcInput))) {
             std::cerr
                 << "File path for input source file not specified, attempting to retrieve content from stdin...\n";
         }
+        ScopedPhase phase(getStats(), StatsPhase::READ);
         srcString = readWholeFileIntoString(CLIOptions::srcInput, "I/O error reading source code file");
     }
     return srcString.value();
 }
 
-std::string CLIOptions::getTsvString() {
-    if (CLIOptions::srcInput == stdin && CLIOptions::tsvInput == stdin) {
-        if (isatty(fileno(CLIOptions::srcInput)) && isatty(fileno(CLIOptions::tsvInput))) {
-            std::cerr << "File paths for source and tsv files not specified,  retrieving input content from stdin...\n";
-        }
-        initializeSrcTsvTogetherFromStdin(&(CLIOptions::srcString), &(CLIOptions::tsvString));
-    }
+const std::string &CLIOptions::getTsvString() {
+    readSrcTsvTogether();
     if (!tsvString.has_value()) {
         if (isatty(fileno(CLIOptions::tsvInput))) {
             std::cerr << "File path for tsv file not specified, attempting to retrieve content from stdin...\n";
         }
+        ScopedPhase phase(getStats(), StatsPhase::READ);
         tsvString = readWholeFileIntoString(tsvInput, "I/O error reading TSV mutations file");
     }
     return tsvString.value();
 }
 
+std::size_t CLIOptions::readSrcChunk(char *buffer, std::size_t size) {
+    ScopedPhase phase(getStats(), StatsPhase::READ);
+    std::size_t read = std::fread(buffer, 1, size, srcInput);
+    if (read < size && std::ferror(srcInput)) {
+        throw IOErrorException("I/O error reading source code file");
+    }
+    return read;
+}
+
 void CLIOptions::putResOutput(std::string result) {
     // resOutput defaults to stdout if left unspecified
     writeStringToFileHandle(resOutput, result);
@@ -273,8 +486,12 @@ void CLIOptions::putResOutput(std::string result) {
 
 void CLIOptions::putSeedOutput(std::string result) { writeStringToFileHandle(seedOutput, result); }
 
+void CLIOptions::putDescriptorOutput(std::string result) { writeStringToFileHandle(descriptorOutput, result); }
+
 bool CLIOptions::hasSeed() { return seedString.has_value() || seedInput != nullptr; }
 
+bool CLIOptions::hasDescriptor() { return descriptor.has_value(); }
+
 bool CLIOptions::hasMutCount() { return mutCount.has_value(); }
 
 bool CLIOptions::hasMinMutCount() { return minMutCount.has_value(); }
@@ -285,18 +502,107 @@ bool CLIOptions::hasFormat() { return format.has_value(); }
 
 bool CLIOptions::seedNeedsExporting() { return seedOutput != nullptr; }
 
+bool CLIOptions::descriptorNeedsExporting() { return descriptorOutput != nullptr; }
+
 bool CLIOptions::hasOutputFileName() { return outputFileName.has_value(); }
 
 bool CLIOptions::hasInputFileName() { return inputFileName.has_value(); }
 
+bool CLIOptions::hasTsvFile() { return tsvInput != stdin; }
+
 bool CLIOptions::hasSrcString() { return srcString.has_value(); }
 
+bool CLIOptions::hasSocketPath() { return socketPath.has_value(); }
+
+bool CLIOptions::hasStats() { return statsFormat.has_value(); }
+
+bool CLIOptions::hasTraceFileName() { return traceFileName.has_value(); }
+
+bool CLIOptions::wantsHardwareCounters() { return hardwareCounters; }
+
+bool CLIOptions::wantsStreaming() { return streaming; }
+
+bool CLIOptions::wantsSchemata() { return schemata; }
+
+bool CLIOptions::wantsJobsFromStdin() { return jobsFromStdin; }
+
+bool CLIOptions::hasLanguage() { return language; }
+
+bool CLIOptions::hasMatchMode() { return matchMode.has_value(); }
+
+bool CLIOptions::hasTreeRoot() { return treeRoot.has_value(); }
+
+bool CLIOptions::hasFileListName() { return fileListName.has_value(); }
+
+bool CLIOptions::hasOutputDirName() { return outputDirName.has_value(); }
+
+bool CLIOptions::hasJobs() { return jobs.has_value(); }
+
+bool CLIOptions::hasRegexLimits() { return !(regexLimits == RegexLimits{}); }
+
+bool CLIOptions::hasTimeLimit() { return timeLimitMs.has_value(); }
+
+bool CLIOptions::hasTestCommand() { return testCommand.has_value(); }
+
+bool CLIOptions::hasKillPattern() { return killPattern.has_value(); }
+
+bool CLIOptions::hasWorkDirName() { return workDirName.has_value(); }
+
+bool CLIOptions::wantsHardlinks() { return hardlinks; }
+
+bool CLIOptions::wantsVerboseOutput() { return verboseOutput; }
+
+bool CLIOptions::isTreeMode() { return treeRoot.has_value() || fileListName.has_value(); }
+
+bool CLIOptions::hasTreeOptions() {
+    return isTreeMode() || outputDirName.has_value() || globs.size() || jobs.has_value();
+}
+
+bool CLIOptions::hasRunOptions() {
+    return testCommand.has_value() || killPattern.has_value() || hardlinks || workDirName.has_value();
+}
+
 bool CLIOptions::okToOverwriteOutputFile() { return overwriteOutputFile; }
 
 const char *CLIOptions::getOutputFileName() { return (*outputFileName).c_str(); }
 
 const char *CLIOptions::getInputFileName() { return (*inputFileName).c_str(); }
 
+const char *CLIOptions::getSocketPath() { return (*socketPath).c_str(); }
+
+StatsFormat CLIOptions::getStatsFormat() { return *statsFormat; }
+
+const char *CLIOptions::getTraceFileName() { return traceFileName->c_str(); }
+
+const char *CLIOptions::getTreeRoot() { return treeRoot->c_str(); }
+
+const char *CLIOptions::getFileListName() { return fileListName->c_str(); }
+
+const char *CLIOptions::getOutputDirName() { return outputDirName->c_str(); }
+
+int32_t CLIOptions::getJobs() { return *jobs; }
+
+int32_t CLIOptions::getTimeLimit() { return *timeLimitMs; }
+
+const char *CLIOptions::getTestCommand() { return testCommand->c_str(); }
+
+const char *CLIOptions::getKillPattern() { return killPattern->c_str(); }
+
+const char *CLIOptions::getWorkDirName() { return workDirName->c_str(); }
+
+const RegexLimits &CLIOptions::getRegexLimits() { return regexLimits; }
+
+const std::vector<std::string> &CLIOptions::getGlobs() { return globs; }
+
+const SourceLexer &CLIOptions::getLexer() {
+    if (language) return *language;
+    return inputFileName.has_value() ? SourceLexer::forPath(*inputFileName) : SourceLexer::getDefault();
+}
+
+MatchMode CLIOptions::getMatchMode() { return matchMode.value_or(MatchMode::TEXT); }
+
+PipelineStats *CLIOptions::getStats() { return statsFormat.has_value() ? &stats : nullptr; }
+
 void CLIOptions::forceOverwrite() { overwriteOutputFile = true; }
 
 std::string CLIOptions::getSeed() {
@@ -317,6 +623,8 @@ std::string CLIOptions::getSeed() {
     return seedString.value();
 }
 
+const std::string &CLIOptions::getDescriptor() { return *descriptor; }
+
 int32_t CLIOptions::getMutCount() { return mutCount.value(); }
 int32_t CLIOptions::getMinMutCount() { return minMutCount.value(); }
 int32_t CLIOptions::getMaxMutCount() { return maxMutCount.value(); }
@@ -329,6 +637,7 @@ CLIOptions::~CLIOptions() {
     closeAndNullifyFileHandle(&(resOutput));
     closeAndNullifyFileHandle(&(seedInput));
     closeAndNullifyFileHandle(&(seedOutput));
+    closeAndNullifyFileHandle(&(descriptorOutput));
 }
 
 void CLIOptions::addWarning(std::string str) { warnings.push_back(sanitizeOutputMessage(str)); }
@@ -346,6 +655,16 @@ std::string CLIOptions::getWarnings() {
         }
         os << "}\n   ";
     }
+    if (regexLimitLines.size()) {
+        os << "The regex pattern cell" << (regexLimitLines.size() > 1 ? "s" : "") << " beginning at the"
+           << (regexLimitLines.size() > 1 ? "se" : "") << " following line number"
+           << (regexLimitLines.size() > 1 ? "s" : "") << " ran into a regex or time limit and "
+           << (regexLimitLines.size() > 1 ? "were" : "was") << " skipped: { ";
+        for (auto i = regexLimitLines.begin(); i < regexLimitLines.end(); ++i) {
+            os << *i << ((i + 1) == regexLimitLines.end() ? " " : ", ");
+        }
+        os << "}\n   ";
+    }
     if (multipleMatchLines.size()) {
         os << "The pattern cell" << (multipleMatchLines.size() > 1 ? "s" : "") << " beginning at the"
            << (multipleMatchLines.size() > 1 ? "se" : "") << " following line number"
@@ -369,6 +688,19 @@ std::string CLIOptions::getWarnings() {
     return os.str();
 }
 
-void CLIOptions::addNoMatchLine(int n) { noMatchLines.push_back(n); }
+// A line is listed once however many times its row failed to match, e.x. once per chunk with --stream
+void CLIOptions::addNoMatchLine(int n) {
+    if (std::find(noMatchLines.begin(), noMatchLines.end(), n) == noMatchLines.end()) noMatchLines.push_back(n);
+}
 
-void CLIOptions::addMultipleMatchLine(int n) { multipleMatchLines.push_back(n); }
\ No newline at end of file
+void CLIOptions::addMultipleMatchLine(int n) {
+    if (std::find(multipleMatchLines.begin(), multipleMatchLines.end(), n) == multipleMatchLines.end()) {
+        multipleMatchLines.push_back(n);
+    }
+}
+
+void CLIOptions::addRegexLimitLine(int n) {
+    if (std::find(regexLimitLines.begin(), regexLimitLines.end(), n) == regexLimitLines.end()) {
+        regexLimitLines.push_back(n);
+    }
+}
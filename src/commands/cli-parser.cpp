@@ -36,9 +36,34 @@
 #include "common.hpp"
 #include "excepts.hpp"
 
-bool verbose = false;
-
-enum class MutateOpts : int { _PADD_START = 255, MIN_COUNT, MAX_COUNT };
+enum class MutateOpts : int {
+    _PADD_START = 255,
+    MIN_COUNT,
+    MAX_COUNT,
+    SOCKET,
+    STATS,
+    TRACE,
+    HW_COUNTERS,
+    LANGUAGE,
+    MATCH,
+    TREE,
+    FILE_LIST,
+    OUTPUT_DIR,
+    GLOB,
+    STREAM,
+    SCHEMATA,
+    JOBS_FROM_STDIN,
+    REGEX_MATCH_LIMIT,
+    REGEX_DEPTH_LIMIT,
+    REGEX_HEAP_LIMIT,
+    TIME_LIMIT,
+    TEST_COMMAND,
+    KILL_PATTERN,
+    HARDLINK,
+    WORK_DIR,
+    APPLY,
+    WRITE_DESCRIPTOR
+};
 
 static std::string genErrorMessage( const char* arg ) {
     std::string s( " (at " );
@@ -52,7 +77,7 @@ const char* STDIN_DASH_INIDCATOR = "-";
 // adapted from https://www.gnu.org/software/libc/manual/html_node/Getopt-Long-Option-Example.html
 ParseArgvStatusCode parseArgs( CLIOptions* output, std::vector<std::string>* nonPositionals, int argc,
                                const char** argv ) {
-    static const char* short_options = "+i:m:o:r:w:s:p:c:f:hvFV";
+    static const char* short_options = "+i:m:o:r:w:s:p:c:f:j:hvFV";
 
     static struct option long_options[] = { { "input", required_argument, NULL, 'i' },
                                             { "mutations", required_argument, NULL, 'm' },
@@ -64,6 +89,36 @@ ParseArgvStatusCode parseArgs( CLIOptions* output, std::vector<std::string>* non
                                             { "min-count", required_argument, NULL, (int)MutateOpts::MIN_COUNT },
                                             { "max-count", required_argument, NULL, (int)MutateOpts::MAX_COUNT },
                                             { "format", required_argument, NULL, 'f' },
+                                            { "socket", required_argument, NULL, (int)MutateOpts::SOCKET },
+                                            { "stats", optional_argument, NULL, (int)MutateOpts::STATS },
+                                            { "trace", required_argument, NULL, (int)MutateOpts::TRACE },
+                                            { "hw-counters", no_argument, NULL, (int)MutateOpts::HW_COUNTERS },
+                                            { "language", required_argument, NULL, (int)MutateOpts::LANGUAGE },
+                                            { "match", required_argument, NULL, (int)MutateOpts::MATCH },
+                                            { "tree", required_argument, NULL, (int)MutateOpts::TREE },
+                                            { "file-list", required_argument, NULL, (int)MutateOpts::FILE_LIST },
+                                            { "output-dir", required_argument, NULL, (int)MutateOpts::OUTPUT_DIR },
+                                            { "glob", required_argument, NULL, (int)MutateOpts::GLOB },
+                                            { "stream", no_argument, NULL, (int)MutateOpts::STREAM },
+                                            { "schemata", no_argument, NULL, (int)MutateOpts::SCHEMATA },
+                                            { "jobs-from-stdin", no_argument, NULL, (int)MutateOpts::JOBS_FROM_STDIN },
+                                            { "jobs", required_argument, NULL, 'j' },
+                                            { "regex-match-limit", required_argument, NULL,
+                                              (int)MutateOpts::REGEX_MATCH_LIMIT },
+                                            { "regex-depth-limit", required_argument, NULL,
+                                              (int)MutateOpts::REGEX_DEPTH_LIMIT },
+                                            { "regex-heap-limit", required_argument, NULL,
+                                              (int)MutateOpts::REGEX_HEAP_LIMIT },
+                                            { "time-limit", required_argument, NULL, (int)MutateOpts::TIME_LIMIT },
+                                            { "test-command", required_argument, NULL,
+                                              (int)MutateOpts::TEST_COMMAND },
+                                            { "kill-pattern", required_argument, NULL,
+                                              (int)MutateOpts::KILL_PATTERN },
+                                            { "hardlink", no_argument, NULL, (int)MutateOpts::HARDLINK },
+                                            { "work-dir", required_argument, NULL, (int)MutateOpts::WORK_DIR },
+                                            { "apply", required_argument, NULL, (int)MutateOpts::APPLY },
+                                            { "write-descriptor", required_argument, NULL,
+                                              (int)MutateOpts::WRITE_DESCRIPTOR },
                                             { "help", no_argument, NULL, 'h' },
                                             { "license", no_argument, NULL, 'v' },
                                             { "version", no_argument, NULL, 'v' },
@@ -164,12 +219,144 @@ ParseArgvStatusCode parseArgs( CLIOptions* output, std::vector<std::string>* non
                     output->setFormat( optarg );
                     break;
 
+                case (int)MutateOpts::SOCKET:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setSocketPath( optarg );
+                    break;
+
+                case (int)MutateOpts::STATS:
+                    output->setStats( optarg );  // optarg stays nullptr for a plain --stats
+                    break;
+
+                case (int)MutateOpts::TRACE:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setTraceFileName( optarg );
+                    break;
+
+                case (int)MutateOpts::HW_COUNTERS:
+                    output->requestHardwareCounters();
+                    break;
+
+                case (int)MutateOpts::LANGUAGE:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setLanguage( optarg );
+                    break;
+
+                case (int)MutateOpts::MATCH:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setMatchMode( optarg );
+                    break;
+
+                case (int)MutateOpts::TREE:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setTreeRoot( optarg );
+                    break;
+
+                case (int)MutateOpts::FILE_LIST:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setFileListName( optarg );
+                    break;
+
+                case (int)MutateOpts::OUTPUT_DIR:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setOutputDirName( optarg );
+                    break;
+
+                case (int)MutateOpts::GLOB:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->addGlob( optarg );
+                    break;
+
+                case (int)MutateOpts::STREAM:
+                    output->requestStreaming();
+                    break;
+
+                case (int)MutateOpts::SCHEMATA:
+                    output->requestSchemata();
+                    break;
+
+                case (int)MutateOpts::JOBS_FROM_STDIN:
+                    output->requestJobsFromStdin();
+                    break;
+
+                case 'j':
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setJobs( optarg );
+                    break;
+
+                case (int)MutateOpts::REGEX_MATCH_LIMIT:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setRegexMatchLimit( optarg );
+                    break;
+
+                case (int)MutateOpts::REGEX_DEPTH_LIMIT:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setRegexDepthLimit( optarg );
+                    break;
+
+                case (int)MutateOpts::REGEX_HEAP_LIMIT:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setRegexHeapLimit( optarg );
+                    break;
+
+                case (int)MutateOpts::TIME_LIMIT:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setTimeLimit( optarg );
+                    break;
+
+                case (int)MutateOpts::TEST_COMMAND:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setTestCommand( optarg );
+                    break;
+
+                case (int)MutateOpts::KILL_PATTERN:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setKillPattern( optarg );
+                    break;
+
+                case (int)MutateOpts::HARDLINK:
+                    output->requestHardlinks();
+                    break;
+
+                case (int)MutateOpts::WORK_DIR:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setWorkDirName( optarg );
+                    break;
+
+                case (int)MutateOpts::APPLY:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setDescriptor( optarg );
+                    break;
+
+                case (int)MutateOpts::WRITE_DESCRIPTOR:
+                    if ( optarg == nullptr )
+                        throw std::runtime_error( genErrorMessage( rawArgCur ) );
+                    output->setDescriptorOutput( optarg );
+                    break;
+
                 case 'F':
                     output->forceOverwrite();
                     break;
 
                 case 'V':
-                    verbose = true;
+                    output->requestVerboseOutput();
                     break;
 
                 case 'h':
@@ -51,6 +51,29 @@ void validateHighlightArgs(CLIOptions *opts, std::vector<std::string> *nonpositi
     if (opts->hasMutCount()) throw InvalidArgumentException("Cannot use the --count option in highlight mode");
     if (opts->hasMinMutCount()) throw InvalidArgumentException("Cannot use the --min-count option in highlight mode");
     if (opts->hasMaxMutCount()) throw InvalidArgumentException("Cannot use the --max-count option in highlight mode");
+    if (opts->hasSocketPath()) throw InvalidArgumentException("Cannot use the --socket option in highlight mode");
+    if (opts->hasStats()) throw InvalidArgumentException("Cannot use the --stats option in highlight mode");
+    if (opts->wantsHardwareCounters())
+        throw InvalidArgumentException("Cannot use the --hw-counters option in highlight mode");
+    if (opts->wantsStreaming())
+        throw InvalidArgumentException("Cannot use the --stream option in highlight mode");
+    if (opts->wantsSchemata())
+        throw InvalidArgumentException("Cannot use the --schemata option in highlight mode");
+    if (opts->hasDescriptor() || opts->descriptorNeedsExporting())
+        throw InvalidArgumentException("Cannot use the --apply or --write-descriptor options in highlight mode");
+    if (opts->hasRegexLimits() || opts->hasTimeLimit())
+        throw InvalidArgumentException("Cannot use the --regex-*-limit or --time-limit options in highlight mode");
+    if (opts->wantsJobsFromStdin())
+        throw InvalidArgumentException("Cannot use the --jobs-from-stdin option in highlight mode");
+    if (opts->hasTraceFileName()) throw InvalidArgumentException("Cannot use the --trace option in highlight mode");
+    if (opts->hasLanguage()) throw InvalidArgumentException("Cannot use the --language option in highlight mode");
+    if (opts->hasMatchMode()) throw InvalidArgumentException("Cannot use the --match option in highlight mode");
+    if (opts->hasTreeOptions())
+        throw InvalidArgumentException(
+            "Cannot use the --tree, --file-list, --output-dir, --glob or --jobs options in highlight mode");
+    if (opts->hasRunOptions())
+        throw InvalidArgumentException(
+            "Cannot use the --test-command, --kill-pattern, --hardlink or --work-dir options in highlight mode");
     if (1 < nonpositionals->size())
         throw InvalidArgumentException("highlight mode does not accept extra non-positional arguments");
 
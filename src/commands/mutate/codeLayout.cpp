@@ -0,0 +1,676 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * codeLayout.cpp: Tells where a C or C++ source has statements and expressions that can be switched at runtime, for
+ --schemata
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/codeLayout.hpp"
+
+#include <algorithm>
+#include <initializer_list>
+#include <utility>
+
+// Longest first, so that the first one that matches is the one the compiler reads
+static const std::string_view OPERATORS[] = { "<<=", ">>=", "<=>", "->*", "...", "::", "->", "++", "--",
+                                              "<<", ">>", "<=", ">=", "==", "!=", "&&", "||", "+=",
+                                              "-=", "*=", "/=", "%=", "&=", "|=", "^=", ".*" };
+
+// Binding strengths, higher binds tighter. Binary operators are between ASSIGNMENT and PREFIX
+static constexpr int COMMA = 1;
+static constexpr int ASSIGNMENT = 2;  // and the conditional operator, both group right to left
+static constexpr int PREFIX = 15;  // unary operators and casts, also right to left
+static constexpr int POSTFIX = 16;  // calls, subscripts, member access
+static constexpr int PRIMARY = 20;  // no operator at all
+
+static bool isOneOf( std::string_view word, std::initializer_list<std::string_view> words ) {
+    return std::find( words.begin(), words.end(), word ) != words.end();
+}
+
+// Words that begin a declaration or name a type
+static bool isDeclarationWord( std::string_view word ) {
+    return isOneOf( word, { "bool", "char", "char8_t", "char16_t", "char32_t", "wchar_t", "short", "int", "long",
+                            "signed", "unsigned", "float", "double", "void", "auto", "const", "volatile", "static",
+                            "extern", "register", "inline", "thread_local", "constexpr", "consteval", "constinit",
+                            "mutable", "struct", "class", "union", "enum", "typedef", "using", "template", "typename",
+                            "namespace", "virtual", "explicit", "friend", "decltype", "static_assert", "alignas",
+                            "_Bool", "_Complex", "_Alignas", "_Static_assert", "restrict", "__restrict" } );
+}
+
+static bool isStatementWord( std::string_view word ) {
+    return isOneOf( word, { "if", "else", "for", "while", "do", "switch", "case", "default", "break", "continue",
+                            "goto", "return", "try", "catch", "co_return", "asm", "__asm__" } );
+}
+
+// Words that an operand follows, like a prefix operator
+static bool isPrefixWord( std::string_view word ) {
+    return isOneOf( word, { "sizeof", "alignof", "_Alignof", "new", "delete", "throw", "co_await", "co_yield" } );
+}
+
+// Statements whose expressions are constants or that do not run where they stand
+static bool isConstantWord( std::string_view word ) {
+    return isOneOf( word, { "case", "default", "static", "static_assert", "_Static_assert", "constexpr", "consteval",
+                            "constinit", "thread_local", "extern", "typedef", "using", "template", "goto" } );
+}
+
+static bool isAssignment( std::string_view op ) {
+    return isOneOf( op, { "=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>=" } );
+}
+
+// 0 for what cannot be a binary operator
+static int binaryPrecedence( std::string_view op ) {
+    if ( isAssignment( op ) ) {
+        return ASSIGNMENT;
+    }
+    static const std::pair<std::string_view, int> PRECEDENCES[] = {
+        { ".*", 14 }, { "->*", 14 }, { "*", 13 }, { "/", 13 }, { "%", 13 }, { "+", 12 }, { "-", 12 },
+        { "<<", 11 }, { ">>", 11 },  { "<=>", 10 }, { "<", 9 }, { "<=", 9 }, { ">", 9 },  { ">=", 9 },
+        { "==", 8 },  { "!=", 8 },   { "&", 7 },  { "^", 6 },  { "|", 5 },  { "&&", 4 }, { "||", 3 },
+        { ",", COMMA } };
+    for ( const auto& entry : PRECEDENCES ) {
+        if ( entry.first == op ) {
+            return entry.second;
+        }
+    }
+    return 0;
+}
+
+template <typename Pieces>
+static std::string_view wordOf( const Pieces& list, std::string_view text, size_t k ) {
+    return text.substr( list[k].begin, list[k].end - list[k].begin );
+}
+
+// Whether piece k can end an operand, so that a + - * & after it is binary
+template <typename Pieces>
+static bool isOperandEnd( const Pieces& list, std::string_view text, size_t k ) {
+    std::string_view word = wordOf( list, text, k );
+    switch ( list[k].kind ) {
+        case TokenKind::IDENTIFIER:
+            return !isDeclarationWord( word ) && !isStatementWord( word ) && !isPrefixWord( word );
+        case TokenKind::PUNCTUATION:
+            return word == ")" || word == "]" ||
+                   ( ( word == "++" || word == "--" ) && k && isOperandEnd( list, text, k - 1 ) );
+        case TokenKind::COMMENT:
+            return false;
+        default:
+            return true;
+    }
+}
+
+template <typename Pieces>
+static bool isOperandStart( const Pieces& list, std::string_view text, size_t k ) {
+    std::string_view word = wordOf( list, text, k );
+    switch ( list[k].kind ) {
+        case TokenKind::IDENTIFIER:
+            return !isDeclarationWord( word ) && !isStatementWord( word );
+        case TokenKind::PUNCTUATION:
+            return isOneOf( word, { "(", "[", "!", "~", "-", "+", "*", "&", "++", "--", "::" } );
+        case TokenKind::COMMENT:
+            return false;
+        default:
+            return true;
+    }
+}
+
+template <typename Pieces>
+static bool isBinary( const Pieces& list, std::string_view text, size_t k ) {
+    std::string_view op = wordOf( list, text, k );
+    if ( isOneOf( op, { "+", "-", "*", "&", "&&" } ) ) {
+        return k && isOperandEnd( list, text, k - 1 );
+    }
+    return binaryPrecedence( op ) > 0;
+}
+
+CodeLayout::CodeLayout( const SourceLexer& _lexer, std::string _source )
+    : lexer{ _lexer }, source{ std::move( _source ) } {
+    pieces = split( source );
+    walk();
+}
+
+std::vector<CodeLayout::Piece> CodeLayout::split( std::string_view text ) const {
+    TokenStream tokens = lexer.tokenize( text );
+    std::vector<Piece> list;
+    list.reserve( tokens.size() );
+    size_t directiveEnd = 0;
+    for ( size_t t = 0; t < tokens.size(); ++t ) {
+        const Token& token = tokens[t];
+        if ( token.kind == TokenKind::COMMENT || token.offset < directiveEnd ) {
+            continue;
+        }
+        if ( token.kind != TokenKind::PUNCTUATION ) {
+            list.push_back( { token.offset, token.offset + size_t( token.length ), token.kind } );
+            continue;
+        }
+        size_t lineStart = token.offset ? text.rfind( '\n', token.offset - 1 ) + 1 : 0;  // npos + 1 == 0
+        if ( text[token.offset] == '#' && text.find_first_not_of( " \t", lineStart ) == token.offset ) {
+            directiveEnd = token.offset;
+            do {
+                directiveEnd = text.find( '\n', directiveEnd + 1 );
+            } while ( directiveEnd != std::string_view::npos && text[directiveEnd - 1] == '\\' );
+            continue;
+        }
+        size_t length = 1;
+        for ( std::string_view op : OPERATORS ) {
+            bool joined = text.compare( token.offset, op.size(), op ) == 0 && t + op.size() <= tokens.size();
+            for ( size_t k = 1; joined && k < op.size(); ++k ) {
+                joined = tokens[t + k].kind == TokenKind::PUNCTUATION && tokens[t + k].offset == token.offset + k;
+            }
+            if ( joined ) {
+                length = op.size();
+                break;
+            }
+        }
+        list.push_back( { token.offset, token.offset + length, TokenKind::PUNCTUATION } );
+        t += length - 1;
+    }
+    return list;
+}
+
+void CodeLayout::walk() {
+    struct Context {
+        size_t brace;
+        size_t statement;
+        std::vector<size_t> opens;  // of the parentheses and brackets
+    };
+    std::vector<Context> contexts{ { NONE, 0, {} } };
+    places.resize( pieces.size() );
+    matches.assign( pieces.size(), NONE );
+    bool startsStatement = false;
+
+    for ( size_t i = 0; i < pieces.size(); ++i ) {
+        Context& context = contexts.back();
+        bool code = context.brace != NONE && braces[context.brace].kind == BraceKind::CODE;
+        places[i] = { context.brace, context.opens.empty() ? NONE : context.opens.back(), context.statement,
+                      startsStatement };
+        startsStatement = false;
+        if ( pieces[i].kind != TokenKind::PUNCTUATION ) {
+            continue;
+        }
+        std::string_view text = textOf( pieces[i] );
+        if ( text == "(" || text == "[" ) {
+            context.opens.push_back( i );
+        }
+        else if ( ( text == ")" || text == "]" ) && context.opens.size() ) {
+            matches[i] = context.opens.back();
+            matches[context.opens.back()] = i;
+            context.opens.pop_back();
+        }
+        else if ( text == "{" ) {
+            bool lambda = false;
+            BraceKind kind = kindOf( i, places[i], lambda );
+            bool doBody = kind == BraceKind::CODE && i && textOf( pieces[i - 1] ) == "do";
+            bool constant = kind == BraceKind::CODE && context.brace != NONE && braces[context.brace].constant;
+            for ( size_t j = context.statement; kind == BraceKind::CODE && j < i; ++j ) {
+                std::string_view word = textOf( pieces[j] );
+                constant = constant || ( ( word == "constexpr" || word == "consteval" ) &&
+                                         !( j && textOf( pieces[j - 1] ) == "if" ) );
+            }
+            braces.push_back( { i, context.brace, kind, lambda, doBody, constant } );
+            contexts.push_back( { braces.size() - 1, i + 1, {} } );
+            startsStatement = kind == BraceKind::CODE;
+        }
+        else if ( text == "}" && contexts.size() > 1 ) {  // unbalanced, e.x. across preprocessor branches
+            const Brace& brace = braces[context.brace];
+            matches[i] = brace.open;
+            matches[brace.open] = i;
+            contexts.pop_back();
+            if ( brace.kind != BraceKind::INITIALIZER && !brace.lambda && !brace.doBody ) {
+                Context& outer = contexts.back();
+                outer.statement = i + 1;
+                startsStatement = brace.kind == BraceKind::CODE && outer.brace != NONE &&
+                                  braces[outer.brace].kind == BraceKind::CODE;
+            }
+        }
+        else if ( text == ";" && context.opens.empty() ) {
+            context.statement = i + 1;
+            startsStatement = code;
+        }
+        else if ( text == ":" && context.opens.empty() && code && isLabel( context.statement ) ) {
+            context.statement = i + 1;
+            startsStatement = true;
+        }
+    }
+}
+
+CodeLayout::BraceKind CodeLayout::kindOf( size_t i, const Place& place, bool& lambda ) const {
+    std::string_view before = i ? textOf( pieces[i - 1] ) : "";
+    if ( before == "]" || before == "mutable" || before == "constexpr" ||
+         ( before == ")" && matches[i - 1] != NONE && matches[i - 1] &&
+           textOf( pieces[matches[i - 1] - 1] ) == "]" ) ) {
+        lambda = true;
+        return BraceKind::CODE;
+    }
+
+    // what the declaration or statement in front of it has at its top level
+    bool parameters = false;
+    bool arrow = false;
+    bool assigned = false;
+    bool scope = false;
+    for ( size_t j = place.statement; j < i; ++j ) {
+        if ( places[j].open != place.open || places[j].brace != place.brace ) {
+            continue;
+        }
+        std::string_view word = textOf( pieces[j] );
+        parameters = parameters || word == "(";
+        arrow = arrow || ( word == "->" && parameters );
+        assigned = assigned || word == "=";
+        scope = scope || isOneOf( word, { "namespace", "class", "struct", "union", "enum" } ) ||
+                ( pieces[j].kind == TokenKind::STRING && j && textOf( pieces[j - 1] ) == "extern" );
+    }
+    if ( place.open != NONE || assigned ) {
+        return BraceKind::INITIALIZER;
+    }
+
+    if ( place.brace != NONE && braces[place.brace].kind != BraceKind::SCOPE ) {
+        if ( braces[place.brace].kind == BraceKind::INITIALIZER ) {
+            return BraceKind::INITIALIZER;
+        }
+        if ( i == place.statement || isOneOf( before, { ")", "else", "do", "try", ";", "{", "}", ":" } ) ) {
+            return BraceKind::CODE;  // a block, with if, for, while, switch or catch before a )
+        }
+        return scope ? BraceKind::SCOPE : BraceKind::INITIALIZER;
+    }
+
+    // at file, namespace or class scope
+    bool specified =
+        isOneOf( before, { ")", "}", "const", "volatile", "noexcept", "override", "final", "&", "&&", "try" } );
+    if ( parameters && ( specified || arrow ) ) {
+        return BraceKind::CODE;  // a function body, } ends a constructor's member initializer
+    }
+    return scope ? BraceKind::SCOPE : BraceKind::INITIALIZER;
+}
+
+bool CodeLayout::isDeclaration( size_t i ) const {
+    if ( i >= pieces.size() ) {
+        return false;
+    }
+    std::string_view word = textOf( pieces[i] );
+    if ( isDeclarationWord( word ) ) {
+        return true;
+    }
+    if ( ( pieces[i].kind != TokenKind::IDENTIFIER && word != "::" ) || isStatementWord( word ) ||
+         isPrefixWord( word ) ) {
+        return false;
+    }
+
+    // a qualified name, maybe with template arguments, then pointers or references to a declarator
+    size_t j = i + ( word == "::" );
+    while ( j < pieces.size() && pieces[j].kind == TokenKind::IDENTIFIER ) {
+        ++j;
+        if ( j < pieces.size() && textOf( pieces[j] ) == "<" ) {
+            for ( int depth = 0; j < pieces.size(); ++j ) {
+                std::string_view angle = textOf( pieces[j] );
+                if ( angle == ";" || angle == "{" || angle == "}" ) {
+                    return false;
+                }
+                depth += ( angle == "<" ) - ( angle == ">" ) - 2 * ( angle == ">>" );
+                if ( depth <= 0 ) {
+                    ++j;
+                    break;
+                }
+            }
+        }
+        if ( j >= pieces.size() || textOf( pieces[j] ) != "::" ) {
+            break;
+        }
+        ++j;
+    }
+    while ( j < pieces.size() && isOneOf( textOf( pieces[j] ), { "*", "&", "&&", "const", "volatile" } ) ) {
+        ++j;
+    }
+    return j < pieces.size() && pieces[j].kind == TokenKind::IDENTIFIER && !isPrefixWord( textOf( pieces[j] ) );
+}
+
+bool CodeLayout::isLabel( size_t i ) const {
+    if ( i >= pieces.size() ) {
+        return false;
+    }
+    std::string_view word = textOf( pieces[i] );
+    return word == "case" || word == "default" ||
+           ( pieces[i].kind == TokenKind::IDENTIFIER && !isStatementWord( word ) && i + 1 < pieces.size() &&
+             textOf( pieces[i + 1] ) == ":" );
+}
+
+bool CodeLayout::inCode( size_t i ) const {
+    size_t brace = places[i].brace;
+    while ( brace != NONE && braces[brace].kind == BraceKind::INITIALIZER ) {
+        brace = braces[brace].parent;
+    }
+    return brace != NONE && braces[brace].kind == BraceKind::CODE;
+}
+
+bool CodeLayout::inConstantBody( size_t i ) const {
+    size_t brace = places[i].brace;
+    while ( brace != NONE && braces[brace].kind == BraceKind::INITIALIZER ) {
+        brace = braces[brace].parent;
+    }
+    return brace != NONE && braces[brace].constant;
+}
+
+size_t CodeLayout::outerStatement( size_t i ) const {
+    while ( places[i].brace != NONE && braces[places[i].brace].kind == BraceKind::INITIALIZER ) {
+        i = braces[places[i].brace].open;
+    }
+    return places[i].statement;
+}
+
+// Where scanning for the other end of template arguments stops
+static bool endsTemplateScan( std::string_view word ) {
+    return isOneOf( word, { ";", "{", "}", "(", ")", "[", "]", "&&", "||", "?", ":", "return" } ) ||
+           isAssignment( word );
+}
+
+size_t CodeLayout::templateClose( size_t i ) const {
+    for ( size_t k = i; k < pieces.size(); ++k ) {
+        std::string_view word = textOf( pieces[k] );
+        if ( ( word == "(" || word == "[" ) && matches[k] != NONE ) {
+            k = matches[k];
+            continue;
+        }
+        if ( word == ">" || word == ">>" ) {
+            return k;
+        }
+        if ( endsTemplateScan( word ) ) {
+            return NONE;
+        }
+    }
+    return NONE;
+}
+
+bool CodeLayout::inTemplateArguments( size_t i ) const {
+    size_t k = i;
+    while ( k-- ) {
+        std::string_view word = textOf( pieces[k] );
+        if ( ( word == ")" || word == "]" ) && matches[k] != NONE ) {
+            k = matches[k];
+            continue;
+        }
+        if ( endsTemplateScan( word ) ) {
+            return false;
+        }
+        if ( word == "<" ) {
+            size_t close = k && pieces[k - 1].kind == TokenKind::IDENTIFIER ? templateClose( k + 1 ) : NONE;
+            return close != NONE && close >= i;
+        }
+    }
+    return false;
+}
+
+bool CodeLayout::inDeclarator( size_t i ) const {
+    // the declaration starts the statement, or the part i is in of the parentheses of a for, if, while, switch or catch
+    size_t open = places[i].open;
+    size_t start = outerStatement( i );
+    if ( open != NONE && open && isOneOf( textOf( pieces[open - 1] ), { "for", "if", "while", "switch", "catch" } ) ) {
+        start = open + 1;
+        for ( size_t k = open + 1; k < i; ++k ) {
+            if ( places[k].open == open && textOf( pieces[k] ) == ";" ) {
+                start = k + 1;
+            }
+        }
+    }
+    else if ( open != NONE && open && textOf( pieces[open - 1] ) == "]" ) {
+        return true;  // the parameters of a lambda
+    }
+    else if ( open != NONE || places[i].brace != places[start].brace ) {
+        return false;  // in parentheses, brackets or braces of its own: arguments or an initializer
+    }
+    if ( !isDeclaration( start ) ) {
+        return false;
+    }
+    for ( size_t k = i; k-- > start; ) {
+        std::string_view word = textOf( pieces[k] );
+        if ( ( word == ")" || word == "]" || word == "}" ) && matches[k] != NONE ) {
+            k = matches[k];
+            continue;
+        }
+        if ( word == "=" || word == ":" ) {
+            return false;
+        }
+        if ( word == "," ) {
+            return true;
+        }
+    }
+    return true;
+}
+
+int CodeLayout::precedenceOf( const std::vector<Piece>& list, std::string_view text, size_t from, size_t to ) {
+    if ( from >= to || !isOperandStart( list, text, from ) ) {
+        return 0;
+    }
+    std::string_view last = wordOf( list, text, to - 1 );
+    if ( !isOperandEnd( list, text, to - 1 ) && last != "}" ) {
+        return 0;
+    }
+
+    int lowest = PRIMARY;
+    int depth = 0;
+    int conditionals = 0;
+    for ( size_t k = from; k < to; ++k ) {
+        std::string_view word = wordOf( list, text, k );
+        bool afterOperand = k > from && isOperandEnd( list, text, k - 1 );
+        if ( list[k].kind == TokenKind::PUNCTUATION && ( word == "(" || word == "[" || word == "{" ) ) {
+            if ( word == "(" && !afterOperand && k + 1 < to && wordOf( list, text, k + 1 ) == ")" ) {
+                return 0;  // the parentheses of a call, without what is called
+            }
+            if ( !depth && afterOperand ) {
+                lowest = std::min( lowest, wordOf( list, text, k - 1 ) == ")" ? PREFIX : POSTFIX );
+            }
+            ++depth;
+            continue;
+        }
+        if ( list[k].kind == TokenKind::PUNCTUATION && ( word == ")" || word == "]" || word == "}" ) ) {
+            if ( !depth-- ) {
+                return 0;
+            }
+            continue;
+        }
+        if ( depth ) {
+            continue;  // a parenthesized operand, an argument list or the body of a lambda
+        }
+        if ( word == ";" || word == "," ) {
+            return 0;
+        }
+        if ( list[k].kind != TokenKind::PUNCTUATION ) {
+            if ( list[k].kind == TokenKind::IDENTIFIER && ( isDeclarationWord( word ) || isStatementWord( word ) ) ) {
+                return 0;  // a type or a statement
+            }
+            if ( afterOperand ) {
+                if ( wordOf( list, text, k - 1 ) != ")" &&
+                     !( list[k].kind == TokenKind::STRING && list[k - 1].kind == TokenKind::STRING ) ) {
+                    return 0;  // two names in a row declare something
+                }
+                lowest = std::min( lowest, PREFIX );  // a cast
+            }
+            if ( isPrefixWord( word ) ) {
+                lowest = std::min( lowest, word == "throw" || word == "co_yield" ? ASSIGNMENT : PREFIX );
+            }
+            continue;
+        }
+        if ( word == "?" ) {
+            ++conditionals;
+            lowest = std::min( lowest, ASSIGNMENT );
+        }
+        else if ( word == ":" ) {
+            if ( !conditionals-- ) {
+                return 0;
+            }
+        }
+        else if ( word == "." || word == "->" ) {
+            lowest = std::min( lowest, POSTFIX );
+        }
+        else if ( word == "++" || word == "--" ) {
+            lowest = std::min( lowest, afterOperand ? POSTFIX : PREFIX );
+        }
+        else if ( word == "::" ) {
+            continue;
+        }
+        else if ( k > from && isBinary( list, text, k ) ) {
+            lowest = std::min( lowest, binaryPrecedence( word ) );
+        }
+        else if ( isOneOf( word, { "-", "+", "*", "&", "!", "~", "&&" } ) ) {
+            lowest = std::min( lowest, PREFIX );
+        }
+        else {
+            return 0;
+        }
+    }
+    return depth || conditionals ? 0 : lowest;
+}
+
+bool CodeLayout::isStatements( size_t begin, size_t end ) const {
+    auto byBegin = []( const Piece& piece, size_t pos ) { return piece.begin < pos; };
+    size_t first = std::lower_bound( pieces.begin(), pieces.end(), begin, byBegin ) - pieces.begin();
+    size_t next = std::lower_bound( pieces.begin() + first, pieces.end(), end, byBegin ) - pieces.begin();
+    if ( next == pieces.size() || !places[first].startsStatement || !places[next].startsStatement ||
+         places[first].brace != places[next].brace || inConstantBody( first ) ) {
+        return false;
+    }
+    if ( ( first && pieces[first - 1].end > begin ) || ( next > first && pieces[next - 1].end > end ) ) {
+        return false;  // inside a literal that spans lines
+    }
+    // else and catch go on with the statement before them
+    if ( isOneOf( textOf( pieces[first] ), { "else", "catch" } ) ||
+         isOneOf( textOf( pieces[next] ), { "else", "catch" } ) ) {
+        return false;
+    }
+    for ( size_t i = first; i < next; ++i ) {
+        if ( places[i].startsStatement && places[i].brace == places[first].brace &&
+             ( isDeclaration( i ) || isLabel( i ) ) ) {
+            return false;  // wrapped in a block, a name would go out of scope before its uses
+        }
+    }
+    return true;
+}
+
+bool CodeLayout::isExpression( size_t begin, size_t end, const std::vector<std::string_view>& alternatives ) const {
+    auto byBegin = []( const Piece& piece, size_t pos ) { return piece.begin < pos; };
+    size_t first = std::lower_bound( pieces.begin(), pieces.end(), begin, byBegin ) - pieces.begin();
+    size_t next = std::lower_bound( pieces.begin() + first, pieces.end(), end, byBegin ) - pieces.begin();
+    if ( first == next || pieces[first].begin != begin || pieces[next - 1].end != end || !inCode( first ) ||
+         inConstantBody( first ) ||
+         isConstantWord( textOf( pieces[outerStatement( first )] ) ) ) {
+        return false;
+    }
+    int lowest = precedenceOf( pieces, source, first, next );
+    if ( !lowest || isBinary( pieces, source, first ) || inDeclarator( first ) ||
+         ( isOneOf( textOf( pieces[first] ), { "::", "(", "[" } ) && first &&
+           isOperandEnd( pieces, source, first - 1 ) ) ||
+         ( next == first + 1 && isLabel( first ) ) ) {
+        return false;  // a + that would turn into a sign, arguments or a subscript, a declarator or a label
+    }
+    for ( std::string_view alternative : alternatives ) {
+        std::vector<Piece> list = split( alternative );
+        if ( !precedenceOf( list, alternative, 0, list.size() ) ) {
+            return false;
+        }
+    }
+
+    size_t open = places[first].open;
+    if ( open != NONE && textOf( pieces[open] ) == "[" &&
+         ( !open || !isOperandEnd( pieces, source, open - 1 ) || isDeclaration( outerStatement( first ) ) ) ) {
+        return false;  // a capture, a structured binding or an array bound
+    }
+    if ( open != NONE && textOf( pieces[open] ) == "(" && open ) {
+        std::string_view callee = textOf( pieces[open - 1] );
+        if ( isOneOf( callee, { "constexpr", "sizeof", "alignof", "_Alignof", "alignas", "_Alignas", "decltype",
+                                "typeid", "noexcept", "typeof", "__typeof__", "offsetof", "static_assert",
+                                "_Static_assert" } ) ) {
+            return false;
+        }
+        size_t close = matches[open];
+        if ( open + 1 == first && close == next && close + 1 < pieces.size() &&
+             isOperandStart( pieces, source, close + 1 ) && !isOneOf( callee, { "if", "while", "for", "switch" } ) ) {
+            return false;  // the type of a cast
+        }
+    }
+    if ( inTemplateArguments( first ) || ( first && inTemplateArguments( first - 1 ) ) ) {
+        return false;  // an argument, or what follows the arguments of a template
+    }
+    for ( size_t k = first; k < next; ++k ) {
+        if ( textOf( pieces[k] ) == "<" && k && pieces[k - 1].kind == TokenKind::IDENTIFIER ) {
+            size_t close = templateClose( k + 1 );
+            if ( close != NONE && close >= next ) {
+                return false;  // cuts template arguments apart
+            }
+        }
+    }
+
+    // the operators around it have to group it on its own, and not as something to assign to
+    if ( first ) {
+        std::string_view before = textOf( pieces[first - 1] );
+        int precedence = 0;
+        if ( pieces[first - 1].kind != TokenKind::PUNCTUATION ) {
+            if ( before == "new" ) {
+                return false;  // a type
+            }
+            if ( ( before == "return" || before == "co_return" ) && next == first + 1 && next < pieces.size() &&
+                 textOf( pieces[next] ) == ";" ) {
+                return false;  // a local returned by name is moved, a conditional expression would copy it
+            }
+            if ( isOneOf( before, { "co_await", "sizeof", "alignof", "delete" } ) ) {
+                precedence = PREFIX;
+            }
+            else if ( !isOneOf( before, { "return", "throw", "co_return", "co_yield", "else", "do" } ) ) {
+                return false;
+            }
+        }
+        else if ( isOneOf( before, { "]", ".", "->", "::", "++", "--" } ) ) {
+            return false;
+        }
+        else if ( before == "}" ) {
+            if ( !places[first].startsStatement ) {
+                return false;
+            }
+        }
+        else if ( before == ")" ) {
+            size_t opening = matches[first - 1];
+            if ( opening != NONE && opening && textOf( pieces[opening - 1] ) == "new" ) {
+                return false;  // the type after a placement
+            }
+            if ( opening == NONE || !opening ||
+                 !isOneOf( textOf( pieces[opening - 1] ), { "if", "while", "for", "switch" } ) ) {
+                precedence = PREFIX;  // a cast
+            }
+        }
+        else if ( before == "&" && !isBinary( pieces, source, first - 1 ) ) {
+            return false;  // taking the address
+        }
+        else if ( !isOneOf( before, { "(", "[", "{", ";", ",", "?", ":" } ) ) {
+            precedence = isBinary( pieces, source, first - 1 ) ? binaryPrecedence( before ) : PREFIX;
+        }
+        bool rightToLeft = precedence == ASSIGNMENT || precedence == PREFIX;
+        if ( precedence > lowest || ( precedence == lowest && !rightToLeft ) ) {
+            return false;
+        }
+    }
+    if ( next < pieces.size() ) {
+        std::string_view after = textOf( pieces[next] );
+        if ( pieces[next].kind != TokenKind::PUNCTUATION || isAssignment( after ) ) {
+            return false;
+        }
+        if ( after == "<" && pieces[next - 1].kind == TokenKind::IDENTIFIER && templateClose( next + 1 ) != NONE ) {
+            return false;  // the name of a template
+        }
+        if ( !isOneOf( after, { ")", "]", "}", ";", ",", ":" } ) ) {
+            int precedence = after == "?" ? ASSIGNMENT : binaryPrecedence( after );
+            if ( !precedence || precedence > lowest || ( precedence == lowest && precedence == ASSIGNMENT ) ) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * commentStripper.cpp: Removes comments from source code in a single pass, before mutations are applied
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/commentStripper.hpp"
+
+#include <cstring>
+
+static bool isBlank( char c ) { return c == ' ' || c == '\t'; }
+
+std::string CommentStripper::operator()( std::string_view source ) {
+    src = source;
+    out.clear();
+    out.reserve( src.size() );
+    lineHadComment = false;
+    pendingSpace = false;
+
+    size_t pos = 0;
+    for ( const Token& comment : lexer.findComments( src ) ) {
+        copyCode( pos, comment.offset );
+        pos = removeComment( comment );
+    }
+    copyCode( pos, src.size() );
+
+    if ( lineHadComment ) {
+        trimTrailingBlanks();
+        size_t lineStart = out.rfind( '\n' ) + 1;  // npos + 1 == 0
+        if ( out.size() == lineStart ) {
+            out.erase( lineStart );
+        }
+    }
+    return std::move( out );
+}
+
+void CommentStripper::appendCode( size_t start, size_t end ) {
+    if ( end > start ) {
+        if ( pendingSpace && !isBlank( src[start] ) && src[start] != '\n' && src[start] != '\r' ) {
+            out.push_back( ' ' );
+        }
+        pendingSpace = false;
+        out.append( src.data() + start, end - start );
+    }
+}
+
+void CommentStripper::copyCode( size_t start, size_t end ) {
+    if ( lineHadComment ) {
+        // the rest of the line a comment was removed from, which goes as a whole if that leaves it blank
+        const void* lineBreak = std::memchr( src.data() + start, '\n', end - start );
+        if ( !lineBreak ) {
+            appendCode( start, end );
+            return;
+        }
+        size_t lineEnd = static_cast<const char*>( lineBreak ) - src.data();
+        appendCode( start, lineEnd );
+        endLine();
+        start = lineEnd + 1;
+    }
+    appendCode( start, end );
+}
+
+// Returns the position right after the comment
+size_t CommentStripper::removeComment( const Token& comment ) {
+    std::string_view text = src.substr( comment.offset, comment.length );
+    size_t end = comment.offset + comment.length;
+    lineHadComment = true;
+
+    if ( text.compare( 0, 2, "/*" ) ) {
+        trimTrailingBlanks();  // a line comment, with its line continuations if any
+        pendingSpace = false;
+    }
+    else if ( text.find( '\n' ) == std::string_view::npos ) {
+        if ( out.empty() || isBlank( out.back() ) || out.back() == '\n' ) {
+            while ( end < src.size() && isBlank( src[end] ) ) {
+                ++end;  // the blanks before the comment already separate it, or indent the line
+            }
+        }
+        else {
+            pendingSpace = true;
+        }
+    }
+    else {
+        // everything up to the last line of the comment goes, code before and after it keep their own lines
+        size_t firstBreak = text.find( '\n' );
+        if ( firstBreak && text[firstBreak - 1] == '\r' ) {
+            out.push_back( '\r' );
+        }
+        endLine();
+        lineHadComment = true;
+    }
+    return end;
+}
+
+void CommentStripper::endLine() {
+    bool crlf = out.size() && out.back() == '\r';
+    if ( crlf ) {
+        out.pop_back();
+    }
+    trimTrailingBlanks();
+
+    size_t lineStart = out.rfind( '\n' ) + 1;  // npos + 1 == 0
+    if ( !lineHadComment || out.size() != lineStart ) {
+        out.append( crlf ? "\r\n" : "\n" );
+    }
+    lineHadComment = false;
+    pendingSpace = false;
+}
+
+void CommentStripper::trimTrailingBlanks() {
+    size_t keep = out.size();
+    while ( keep && isBlank( out[keep - 1] ) ) {
+        --keep;
+    }
+    out.erase( keep );
+}
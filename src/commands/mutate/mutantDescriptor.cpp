@@ -0,0 +1,170 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutantDescriptor.cpp: A few dozen bytes telling which mutations make a mutant, to store instead of the mutant and
+ rebuild it from with --apply
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/mutantDescriptor.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+#include "commands/mutate/mutationsSelector.hpp"
+#include "common.hpp"
+#include "excepts.hpp"
+
+static const char* const VERSION = "1";
+
+static const size_t HASH_DIGITS = 16;
+
+static InvalidArgumentException notADescriptor( const std::string& text ) {
+    return InvalidArgumentException( sanitizeOutputMessage( "\'" + text + "\' is not a mutant descriptor" ) );
+}
+
+// Whole field as an unsigned number, false when it is not one or overflows
+static bool parseNumber( const std::string& field, int base, std::uint64_t& value ) {
+    if ( field.empty() || field.size() > ( base == 16 ? HASH_DIGITS : 19 ) ) {
+        return false;
+    }
+    value = 0;
+    for ( char c : field ) {
+        int digit = c >= '0' && c <= '9'   ? c - '0'
+                    : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                           : base;
+        if ( digit >= base ) {
+            return false;
+        }
+        value = value * base + digit;
+    }
+    return true;
+}
+
+static std::vector<std::string> split( const std::string& text, char separator ) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for ( size_t end; ( end = text.find( separator, start ) ) != std::string::npos; start = end + 1 ) {
+        fields.push_back( text.substr( start, end - start ) );
+    }
+    fields.push_back( text.substr( start ) );
+    return fields;
+}
+
+static const char* matchModeName( MatchMode matchMode ) { return matchMode == MatchMode::TOKENS ? "tokens" : "text"; }
+
+MutantDescriptor::MutantDescriptor( const std::string& tsv, const std::string& src, const SourceLexer& lexer,
+                                    MatchMode _matchMode, std::vector<Mutation> _mutations )
+    : tsvHash{ hashBytes( tsv ) },
+      srcHash{ hashBytes( src ) },
+      language{ lexer.getName() },
+      matchMode{ _matchMode },
+      mutations{ std::move( _mutations ) } {}
+
+std::vector<MutantDescriptor::Mutation> MutantDescriptor::mutationsOf( const SelectedMutVec& selected ) {
+    std::vector<Mutation> mutations;
+    mutations.reserve( selected.size() );
+    for ( const SelectedMutation& sm : selected ) {
+        mutations.push_back( { sm.data.lineNumber, sm.permutation + 1 } );
+    }
+    return mutations;
+}
+
+std::string MutantDescriptor::toString() const {
+    char hashes[2 * HASH_DIGITS + 3];
+    std::snprintf( hashes, sizeof( hashes ), "%016llx:%016llx", static_cast<unsigned long long>( tsvHash ),
+                   static_cast<unsigned long long>( srcHash ) );
+    std::ostringstream os;
+    os << VERSION << ':' << hashes << ':' << language << ':' << matchModeName( matchMode ) << ':';
+    for ( size_t i = 0; i < mutations.size(); ++i ) {
+        os << ( i ? "," : "" ) << mutations[i].lineNumber << '.' << mutations[i].permutation;
+    }
+    return os.str();
+}
+
+MutantDescriptor MutantDescriptor::parse( const std::string& text ) {
+    std::vector<std::string> fields = split( text, ':' );
+    MutantDescriptor descriptor;
+    if ( fields.size() != 6 || fields[0] != VERSION || fields[1].size() != HASH_DIGITS ||
+         fields[2].size() != HASH_DIGITS || !parseNumber( fields[1], 16, descriptor.tsvHash ) ||
+         !parseNumber( fields[2], 16, descriptor.srcHash ) || fields[3].empty() ||
+         ( fields[4] != "text" && fields[4] != "tokens" ) ) {
+        throw notADescriptor( text );
+    }
+    descriptor.language = fields[3];
+    descriptor.matchMode = fields[4] == "tokens" ? MatchMode::TOKENS : MatchMode::TEXT;
+    if ( fields[5].empty() ) {
+        return descriptor;  // none of the selected rows were applied, i.e. they were all negated
+    }
+    for ( const std::string& field : split( fields[5], ',' ) ) {
+        size_t dot = field.find( '.' );
+        std::uint64_t lineNumber;
+        std::uint64_t permutation;
+        if ( dot == std::string::npos || !parseNumber( field.substr( 0, dot ), 10, lineNumber ) ||
+             !parseNumber( field.substr( dot + 1 ), 10, permutation ) || !lineNumber || !permutation ) {
+            throw notADescriptor( text );
+        }
+        descriptor.mutations.push_back( { static_cast<size_t>( lineNumber ), static_cast<size_t>( permutation ) } );
+    }
+    return descriptor;
+}
+
+void MutantDescriptor::applySettings( CLIOptions* opts ) const {
+    if ( opts->hasLanguage() && language != opts->getLexer().getName() ) {
+        throw InvalidArgumentException( sanitizeOutputMessage( "The mutant descriptor was made with --language=" +
+                                                               language + ", not the --language given" ) );
+    }
+    if ( opts->hasMatchMode() && matchMode != opts->getMatchMode() ) {
+        throw InvalidArgumentException( std::string( "The mutant descriptor was made with --match=" ) +
+                                        matchModeName( matchMode ) + ", not the --match given" );
+    }
+    if ( !opts->hasLanguage() ) {
+        opts->setLanguage( language.c_str() );
+    }
+    if ( !opts->hasMatchMode() ) {
+        opts->setMatchMode( matchModeName( matchMode ) );
+    }
+}
+
+SelectedMutVec MutantDescriptor::select( const std::string& tsv, const std::string& src,
+                                         const PossibleMutVec& rows ) const {
+    if ( hashBytes( tsv ) != tsvHash ) {
+        throw InvalidArgumentException( "The mutant descriptor was made with other mutations than the TSV given" );
+    }
+    if ( hashBytes( src ) != srcHash ) {
+        throw InvalidArgumentException( "The mutant descriptor was made from another source than the input given" );
+    }
+
+    SelectedMutVec selected;
+    selected.reserve( mutations.size() );
+    for ( const Mutation& mutation : mutations ) {
+        auto row = std::find_if( rows.begin(), rows.end(), [&mutation]( const TsvFileLine& candidate ) {
+            return candidate.data.lineNumber == mutation.lineNumber;
+        } );
+        if ( row == rows.end() || mutation.permutation > row->permutations.size() ) {
+            std::ostringstream os;
+            os << "The TSV has no permutation " << mutation.permutation << " on line " << mutation.lineNumber
+               << " that the mutant descriptor names";
+            throw InvalidArgumentException( os.str() );
+        }
+        selected.emplace_back( MutationsSelector::getBarePattern( *row ), row->permutations[mutation.permutation - 1],
+                               row->data );
+        selected.back().permutation = mutation.permutation - 1;
+    }
+    return selected;
+}
@@ -26,13 +26,20 @@
 
 #include "commands/mutate/mutateCommand.hpp"
 
+#include <cstring>
 #include <filesystem>
+#include <iostream>
 #include <sstream>
 
+#include "commands/mutate/mutantDescriptor.hpp"
 #include "commands/mutate/mutationsRetriever.hpp"
 #include "commands/mutate/mutationsSelector.hpp"
 #include "commands/mutate/mutator.hpp"
+#include "commands/mutate/schemataBuilder.hpp"
+#include "commands/mutate/streamMutator.hpp"
+#include "commands/mutate/treeMutator.hpp"
 #include "excepts.hpp"
+#include "traceRecorder.hpp"
 
 std::string printMutateHelp( const char *indent ) {
     std::ostringstream ss;
@@ -46,6 +53,50 @@ std::string printMutateHelp( const char *indent ) {
     ss << indent
        << "    --max-count=NUMBER   Maximum number of mutations to perform. Defaults to the available number of "
           "mutations\n";
+    ss << indent
+       << "    --stats[=FORMAT]     Print phase timings and counters of the run to stderr. FORMAT is text (default) or "
+          "json\n";
+    ss << indent
+       << "    --hw-counters        Add cycles, instructions, branch misses and L1d/LLC misses of every phase to "
+          "--stats\n";
+    ss << indent
+       << "    --trace=FILE         Write a Chrome/Perfetto trace of every phase, mutant and row to this file\n";
+    ss << indent << "    --language=NAME      Language of the input, one of " << SourceLexer::getNames()
+       << ". Defaults to going by the extension of --input, else cpp\n";
+    ss << indent
+       << "    --match=MODE         text (default) matches plain patterns as whole lines, tokens as token sequences "
+          "regardless of whitespace\n";
+    ss << indent
+       << "    --stream             Read, mutate and write the input a chunk at a time, for sources too big for "
+          "memory\n";
+    ss << indent
+       << "    --regex-match-limit=NUMBER  Skip a regex row whose search takes more than NUMBER match steps\n";
+    ss << indent << "    --regex-depth-limit=NUMBER  Skip a regex row whose search backtracks deeper than NUMBER\n";
+    ss << indent
+       << "    --regex-heap-limit=KIB      Skip a regex row whose search needs more than KIB kibibytes of heap\n";
+    ss << indent
+       << "    --time-limit=MS      Skip the regex rows still searching MS milliseconds after a mutant was started\n";
+    ss << indent
+       << "    --schemata           Write every mutant into one source, each behind a switch the MUTANT_ID environment "
+          "variable picks at runtime. C and C++ only\n";
+    ss << indent
+       << "    --write-descriptor=FILE  Write the descriptor of the mutant to FILE, a few dozen bytes --apply rebuilds "
+          "it from. With --tree, one line per file\n";
+    ss << indent
+       << "    --apply=DESCRIPTOR   Rebuild the mutant DESCRIPTOR names from --input and --mutations, without a seed\n";
+    ss << '\n';
+    ss << indent
+       << "    --tree=DIR           Mutate every file under DIR instead of --input, hidden directories are skipped\n";
+    ss << indent
+       << "    --file-list=FILE     Mutate every file listed in FILE (one path per line, - for stdin) instead of "
+          "--input\n";
+    ss << indent
+       << "    --output-dir=DIR     Where --tree and --file-list write each mutant, under the same relative path\n";
+    ss << indent
+       << "    --glob=PATTERN       Only mutate the files of --tree or --file-list whose path matches PATTERN. May be "
+          "repeated\n";
+    ss << indent
+       << "-j, --jobs=NUMBER        Number of files mutated at once. Defaults to the number of hardware threads\n";
     ss << '\n';
     ss << indent
        << "-F, --force              Overwrite existing file specified for mutated output. Defaults to aborting if "
@@ -61,6 +112,9 @@ std::string printMutateHelp( const char *indent ) {
        << "NOTE: If both --input and --mutations are unspecified, then the first line from stdin is swallowed and used "
           "to separate --input and "
        << "--mutations\n";
+    ss << indent
+       << "NOTE: --tree and --file-list apply --count, --min-count and --max-count to each file, whose seed is derived "
+          "from the run's seed and the file's path\n";
 
     return ss.str();
 };
@@ -69,18 +123,121 @@ std::string printMutateHelp( std::string indent ) { return printMutateHelp( inde
 
 std::string printMutateHelp( void ) { return printMutateHelp( "" ); }
 
+static void validateTreeArgs( CLIOptions *opts, std::vector<std::string> *nonpositionals ) {
+    if ( opts->hasTreeRoot() && opts->hasFileListName() ) {
+        throw InvalidArgumentException( "options --tree and --file-list are mutually exclusive. Please choose one" );
+    }
+    if ( opts->hasInputFileName() ) {
+        throw InvalidArgumentException( "Cannot use the --input option together with --tree or --file-list" );
+    }
+    if ( opts->hasOutputFileName() ) {
+        throw InvalidArgumentException( "Cannot use the --output option together with --tree or --file-list, use "
+                                        "--output-dir" );
+    }
+    if ( opts->hasStats() ) {
+        throw InvalidArgumentException( "Cannot use the --stats option together with --tree or --file-list" );
+    }
+    if ( !opts->hasTsvFile() ) {
+        throw InvalidArgumentException( "--tree and --file-list need the mutations in a file, given with --mutations" );
+    }
+    if ( !opts->hasOutputDirName() ) {
+        throw InvalidArgumentException( "--tree and --file-list need an output directory, given with --output-dir" );
+    }
+    if ( 1 < nonpositionals->size() ) {
+        throw InvalidArgumentException( "mutate mode does not accept extra non-positional arguments" );
+    }
+
+    const char *path = opts->getOutputDirName();
+    if ( std::filesystem::exists( path ) && !opts->okToOverwriteOutputFile() &&
+         ( !std::filesystem::is_directory( path ) || !std::filesystem::is_empty( path ) ) ) {
+        std::ostringstream os;
+        os << "Output directory \'" << path << "\' already exists and is not empty. Use \'-F\' to force overwrite.";
+        throw IOErrorException( sanitizeOutputMessage( os.str() ) );
+    }
+}
+
 void validateMutateArgs( CLIOptions *opts, std::vector<std::string> *nonpositionals ) {
     if ( opts->hasFormat() ) {
         throw InvalidArgumentException( "Cannot use the --format option in mutate mode" );
     }
 
+    if ( opts->hasSocketPath() ) {
+        throw InvalidArgumentException( "Cannot use the --socket option in mutate mode" );
+    }
+
+    if ( opts->wantsJobsFromStdin() ) {
+        throw InvalidArgumentException( "Cannot use the --jobs-from-stdin option in mutate mode, see serve" );
+    }
+
+    if ( opts->hasRunOptions() ) {
+        throw InvalidArgumentException(
+            "Cannot use the --test-command, --kill-pattern, --hardlink or --work-dir options in mutate mode, see run" );
+    }
+
+    if ( opts->wantsHardwareCounters() && !opts->hasStats() ) {
+        throw InvalidArgumentException( "The --hw-counters option needs --stats" );
+    }
+
+    if ( opts->wantsStreaming() ) {
+        if ( opts->isTreeMode() ) {
+            throw InvalidArgumentException( "Cannot use the --stream option together with --tree or --file-list" );
+        }
+        if ( !opts->hasTsvFile() ) {
+            throw InvalidArgumentException( "--stream needs the mutations in a file, given with --mutations" );
+        }
+        if ( opts->getMatchMode() == MatchMode::TOKENS ) {
+            throw InvalidArgumentException( "Cannot use --match=tokens together with --stream" );
+        }
+    }
+
+    if ( opts->wantsSchemata() ) {
+        if ( opts->isTreeMode() || opts->wantsStreaming() ) {
+            throw InvalidArgumentException(
+                "Cannot use the --schemata option together with --tree, --file-list or --stream" );
+        }
+        if ( opts->hasSeed() || opts->seedNeedsExporting() || opts->hasMutCount() || opts->hasMinMutCount() ||
+             opts->hasMaxMutCount() ) {
+            throw InvalidArgumentException( "--schemata writes every mutant, so it takes no seed or count options" );
+        }
+        const char *language = opts->getLexer().getName();
+        if ( std::strcmp( language, "c" ) && std::strcmp( language, "cpp" ) ) {
+            throw InvalidArgumentException( "--schemata only supports C and C++ sources, see --language" );
+        }
+    }
+
+    if ( opts->descriptorNeedsExporting() && ( opts->wantsStreaming() || opts->wantsSchemata() ) ) {
+        throw InvalidArgumentException(
+            "Cannot use the --write-descriptor option together with --stream or --schemata" );
+    }
+
+    if ( opts->hasDescriptor() ) {
+        if ( opts->isTreeMode() || opts->wantsStreaming() || opts->wantsSchemata() ) {
+            throw InvalidArgumentException(
+                "Cannot use the --apply option together with --tree, --file-list, --stream or --schemata" );
+        }
+        if ( opts->hasSeed() || opts->seedNeedsExporting() || opts->hasMutCount() || opts->hasMinMutCount() ||
+             opts->hasMaxMutCount() ) {
+            throw InvalidArgumentException(
+                "--apply rebuilds the mutant it is given, so it takes no seed or count options" );
+        }
+        // throws when it is not a descriptor, or was made with another --language or --match than the ones given
+        MutantDescriptor::parse( opts->getDescriptor() ).applySettings( opts );
+    }
+
+    if ( opts->isTreeMode() ) {
+        validateTreeArgs( opts, nonpositionals );
+        return;
+    }
+    if ( opts->hasTreeOptions() ) {
+        throw InvalidArgumentException( "The --output-dir, --glob and --jobs options need --tree or --file-list" );
+    }
+
     if ( 1 < nonpositionals->size() ) {
         throw InvalidArgumentException( "mutate mode does not accept extra non-positional arguments" );
     }
 
-    std::string input = opts->getSrcString();
-
-    if ( !input.length() ) {
+    // with --stream the input is only read once mutating starts, StreamMutator checks it is not empty
+    if ( !opts->wantsStreaming() && !opts->getSrcString().length() ) {
         std::ostringstream os;
         const char *path = opts->getInputFileName();
         os << "Input file \"" << path << "\" has no content.";
@@ -106,14 +263,100 @@ void validateMutateArgs( CLIOptions *opts, std::vector<std::string> *nonposition
     // doAction()
 }
 
-void doMutateAction( CLIOptions *opts, std::vector<std::string> *nonpositionals ) {
+static void doTreeMutateAction( CLIOptions *opts ) {
+    TreeMutator treeMutator( opts, opts->getTsvString() );
+    size_t filesWithWarnings = treeMutator.run();
 
-    (void)nonpositionals;  // silence unused warnings
+    if ( opts->seedNeedsExporting() ) {
+        opts->putSeedOutput( opts->getSeed() );
+    }
+    if ( opts->descriptorNeedsExporting() ) {
+        std::string lines;
+        for ( const std::string& line : treeMutator.getDescriptors() ) {
+            lines += line;
+        }
+        opts->putDescriptorOutput( lines );
+    }
+    if ( filesWithWarnings ) {
+        std::ostringstream os;
+        os << filesWithWarnings << " of " << treeMutator.getPaths().size()
+           << " files had pattern cells without a match or with multiple matches"
+           << ( opts->wantsVerboseOutput() ? ", listed above" : ", use --verbose to list them" );
+        opts->addWarning( os.str() );
+    }
+}
 
+static void doSchemataAction( CLIOptions *opts ) {
     Mutator mutator;
-    std::string outputString = mutator( opts->getSrcString(), opts->getTsvString(), opts );
+    std::string strippedStr = mutator.removeStrComments( opts->getSrcString(), opts->getLexer() );
+    MutationsRetriever retriever( opts->getTsvString() );
+    retriever.capturePossibleMutations();
+    retriever.categorizeMutations();
+    retriever.checkNesting();
 
+    SchemataBuilder builder( opts, std::move( strippedStr ) );
+    builder.add( retriever.getPossibleMutations() );
+    std::string outputString = builder.build();
+
+    ScopedPhase phase( opts->getStats(), StatsPhase::WRITE );
     opts->putResOutput( outputString );
+}
+
+static void doApplyAction( CLIOptions *opts ) {
+    MutantDescriptor descriptor = MutantDescriptor::parse( opts->getDescriptor() );
+    const std::string& srcString = opts->getSrcString();
+    const std::string& tsvString = opts->getTsvString();
+    MutationsRetriever retriever( tsvString );
+    retriever.capturePossibleMutations();
+    retriever.categorizeMutations();
+    retriever.checkNesting();
+    SelectedMutVec selectedMutations = descriptor.select( tsvString, srcString, retriever.getPossibleMutations() );
+
+    Mutator mutator;
+    std::string outputString = mutator.removeStrComments( srcString, opts->getLexer() );
+    mutator.applyMutations( outputString, selectedMutations, opts );
+    if ( opts->descriptorNeedsExporting() ) {
+        opts->putDescriptorOutput( descriptor.toString() + '\n' );
+    }
+
+    ScopedPhase phase( opts->getStats(), StatsPhase::WRITE );
+    opts->putResOutput( outputString );
+}
+
+void doMutateAction( CLIOptions *opts, std::vector<std::string> *nonpositionals ) {
+
+    (void)nonpositionals;  // silence unused warnings
+
+    if ( opts->isTreeMode() ) {
+        doTreeMutateAction( opts );
+        return;
+    }
+
+    if ( opts->wantsSchemata() ) {
+        doSchemataAction( opts );
+    }
+    else if ( opts->hasDescriptor() ) {
+        doApplyAction( opts );
+    }
+    else if ( opts->wantsStreaming() ) {
+        StreamMutator( opts ).run( opts->getTsvString() );
+    }
+    else {
+        Mutator mutator;
+        std::vector<MutantDescriptor::Mutation> selection;
+        if ( opts->descriptorNeedsExporting() ) {
+            mutator.setSelectionLog( &selection );
+        }
+        std::string outputString = mutator( opts->getSrcString(), opts->getTsvString(), opts );
+        if ( opts->descriptorNeedsExporting() ) {
+            MutantDescriptor descriptor( opts->getTsvString(), opts->getSrcString(), opts->getLexer(),
+                                         opts->getMatchMode(), std::move( selection ) );
+            opts->putDescriptorOutput( descriptor.toString() + '\n' );
+        }
+
+        ScopedPhase phase( opts->getStats(), StatsPhase::WRITE );
+        opts->putResOutput( outputString );
+    }
 
     // std::cerr << mutator.mutatedLines.size() << " mutations have been successfully applied across "
     // 		<< mutator.mutatedLineCount << " lines" << std::endl;
@@ -121,9 +364,19 @@ void doMutateAction( CLIOptions *opts, std::vector<std::string> *nonpositionals
     if ( opts->seedNeedsExporting() ) {
         opts->putSeedOutput( opts->getSeed() );
     }
+
+    if ( opts->hasStats() ) {
+        std::cerr << opts->getStats()->getReport( opts->getStatsFormat() );
+    }
 }
 
 ParseArgvStatusCode execMutate( CLIOptions *opts, std::vector<std::string> *nonpositionals ) {
+    if ( opts->hasTraceFileName() ) {
+        TraceRecorder::start( opts->getTraceFileName() );  // before validating so that reading the input is traced
+    }
+    if ( opts->hasStats() && opts->wantsHardwareCounters() ) {
+        opts->getStats()->enableHardwareCounters();
+    }
     validateMutateArgs( opts, nonpositionals );
     doMutateAction( opts, nonpositionals );
     return ParseArgvStatusCode::SUCCESS;
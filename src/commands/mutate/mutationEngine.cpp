@@ -0,0 +1,117 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutationEngine.cpp: The embeddable C++ entry point of libmutateplaceholder
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/mutationEngine.hpp"
+
+#include "commands/mutate/mutationsRetriever.hpp"
+#include "commands/mutate/mutator.hpp"
+#include "common.hpp"
+#include "excepts.hpp"
+
+const PossibleMutVec& MutationEngine::getPossibleMutations( const std::string& tsv ) {
+    std::uint64_t key = hashBytes( tsv );
+    auto found = tsvCache.find( key );
+    if ( found != tsvCache.end() && found->second.tsv == tsv ) {
+        return found->second.possibleMutations;
+    }
+
+    MutationsRetriever retriever( tsv );
+    PossibleMutVec parsed = retriever.getPossibleMutations();  // throws before the cache is touched
+
+    if ( tsvCache.size() >= maxCacheEntries ) {
+        tsvCache.clear();
+    }
+    CachedTsv& entry = tsvCache[key];
+    entry.tsv = tsv;
+    entry.possibleMutations = std::move( parsed );
+    return entry.possibleMutations;
+}
+
+MutationEngine::CachedSrc& MutationEngine::getCachedSrc( const std::string& src, const SourceLexer& lexer ) {
+    std::uint64_t key = hashBytes( src ) ^ std::hash<const SourceLexer*>()( &lexer );
+    auto found = srcCache.find( key );
+    if ( found != srcCache.end() && found->second.lexer == &lexer && found->second.src == src ) {
+        return found->second;
+    }
+
+    if ( srcCache.size() >= maxCacheEntries ) {
+        srcCache.clear();
+    }
+    Mutator stripper( &regexCache );
+    CachedSrc& entry = srcCache[key];
+    entry.src = src;
+    entry.lexer = &lexer;
+    entry.stripped = stripper.removeStrComments( src, lexer );
+    entry.tokens.reset();
+    return entry;
+}
+
+const std::string& MutationEngine::getStrippedSrc( const std::string& src, const SourceLexer& lexer ) {
+    return getCachedSrc( src, lexer ).stripped;
+}
+
+const TokenStream& MutationEngine::getTokens( const std::string& src, const SourceLexer& lexer ) {
+    CachedSrc& entry = getCachedSrc( src, lexer );
+    if ( !entry.tokens ) {
+        entry.tokens = lexer.tokenize( entry.stripped );
+    }
+    return *entry.tokens;
+}
+
+void MutationEngine::applyOptions( const MutateOptions& options, CLIOptions* opts ) {
+    if ( options.seed.size() ) {
+        opts->setSeed( options.seed.c_str() );
+    }
+    if ( options.count >= 0 ) {
+        opts->setMutCount( std::to_string( options.count ).c_str() );
+    }
+    if ( options.minCount >= 0 ) {
+        opts->setMinMutCount( std::to_string( options.minCount ).c_str() );
+    }
+    if ( options.maxCount >= 0 ) {
+        opts->setMaxMutCount( std::to_string( options.maxCount ).c_str() );
+    }
+    if ( options.language.size() ) {
+        opts->setLanguage( options.language.c_str() );
+    }
+    if ( options.matchTokens ) {
+        opts->setMatchMode( "tokens" );
+    }
+}
+
+MutateResult MutationEngine::mutate( const std::string& src, const std::string& tsv, const MutateOptions& options ) {
+    if ( !src.size() ) {
+        throw InvalidArgumentException( "Input source has no content." );
+    }
+
+    CLIOptions opts;  // never touches stdin/stdout as the input is already in memory
+    applyOptions( options, &opts );
+
+    PossibleMutVec possibleMutations = getPossibleMutations( tsv );  // copied as selection modifies it
+    Mutator mutator( &regexCache );
+
+    MutateResult result;
+    const TokenStream* tokens =
+        opts.getMatchMode() == MatchMode::TOKENS ? &getTokens( src, opts.getLexer() ) : nullptr;
+    result.mutant = mutator.mutateStripped( getStrippedSrc( src, opts.getLexer() ), possibleMutations, &opts, tokens );
+    result.seed = opts.getSeed();
+    result.warnings = opts.getWarnings();
+    return result;
+}
@@ -58,6 +58,7 @@ void MutationsRetriever::capturePossibleMutations() {
             possibleMutations.back().permutations.push_back( std::move( permutation ) );
         }
         possibleMutations.back().data.lineNumber = rowsIt->lineNumber;
+        possibleMutations.back().scope = rowsIt->scope;
     } while ( ++rowsIt != rows.end() );
 }
 
@@ -94,9 +95,11 @@ void MutationsRetriever::categorizeMutations() {
 }
 
 PossibleMutVec& MutationsRetriever::getPossibleMutations() {
-    capturePossibleMutations();
-    categorizeMutations();
-    checkNesting();
+    if ( !possibleMutations.size() ) {  // already done if the steps were run one by one
+        capturePossibleMutations();
+        categorizeMutations();
+        checkNesting();
+    }
     return possibleMutations;
 }
 
@@ -118,13 +121,24 @@ void MutationsRetriever::checkNesting() {
              ( ( ( it + 1 )->data.depth > 2 ) && ( it + 1 )->data.depth <= it->data.depth ) ) {
             throwInvalidNesting();
         }
+        if ( ( it + 1 )->data.depth > 1 && ( it + 1 )->scope != it->scope ) {
+            std::ostringstream os;
+            os << " Error : A \"#paths:\" line splits a group in TSV File.\n"
+               << "Notice :\n     Nested pattern cell in row number " << ( it + 1 )->data.lineNumber
+               << " is scoped to other paths than the row above it." << std::endl;
+            throw TSVParsingException( os.str() );
+        }
         ++it;
     }
 }
 
+// The rows after a "#paths: GLOB..." line only apply to matching files, until the next such line. A bare "#paths:"
+// makes the rows after it apply everywhere again
+static bool isPathScopeLine( const std::string& row ) { return !row.compare( 0, 7, "#paths:" ); }
+
 std::vector<TSVRow> MutationsRetriever::getRows() {
     std::vector<TSVRow> temp;
-    temp.push_back( { "", 1 } );
+    temp.push_back( { "", 1, 0 } );
     char c, last;
     int QMarkCount = 0,
         lineNumber = 1;  // QMarks are quotation marks not question marks
@@ -165,7 +179,7 @@ std::vector<TSVRow> MutationsRetriever::getRows() {
             if ( last == '\n' && !( QMarkCount % 2 ) )
                 continue;
             if ( ( last != '\n' && !( QMarkCount % 2 ) ) || temp.back().row[0] == '#' ) {
-                temp.push_back( { "", lineNumber } );
+                temp.push_back( { "", lineNumber, 0 } );
                 QMarkCount = 0;
                 last = c;
                 continue;
@@ -179,9 +193,24 @@ std::vector<TSVRow> MutationsRetriever::getRows() {
 
     std::vector<TSVRow> rows;
     rows.reserve( temp.size() );
+    size_t scope = 0;
     std::for_each( temp.begin(), temp.end(), [&]( TSVRow& Row ) {
-        if ( Row.row[0] != '#' )
+        if ( isPathScopeLine( Row.row ) ) {
+            std::istringstream is{ Row.row.substr( 7 ) };
+            PathScope pathScope;
+            std::string pattern;
+            while ( is >> pattern ) {
+                pathScope.patterns.push_back( pattern );
+            }
+            scope = pathScope.patterns.empty() ? 0 : scopes.size();
+            if ( scope ) {
+                scopes.push_back( std::move( pathScope ) );
+            }
+        }
+        else if ( Row.row[0] != '#' ) {
+            Row.scope = scope;
             rows.push_back( Row );
+        }
     } );
 
     if ( !rows.size() ) {
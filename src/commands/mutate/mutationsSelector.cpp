@@ -43,7 +43,7 @@ MutationsSelector::MutationsSelector( CLIOptions* _opts, PossibleMutVec& _possib
 
 SelectedMutVec& MutationsSelector::getSelectedMutations() {
     selectMutations();
-    if ( verbose ) {
+    if ( opts->wantsVerboseOutput() ) {
         std::cerr << selectedMutations.size() << " possible mutations have been selected" << std::endl;
     }
 
@@ -104,7 +104,7 @@ void MutationsSelector::setSeedArray() {
         if ( !parseHexString( seedString.c_str(), seedArray.data(), SEED_SIZE_BYTES ) ) {
             throw InvalidSeedException( " Error : Seed being passed in is not valid hexidecimal number" );
         }
-        if ( verbose ) {
+        if ( opts->wantsVerboseOutput() ) {
             std::cerr << "Using provided seed: " << seedString << std::endl;
         }
     }
@@ -115,7 +115,7 @@ void MutationsSelector::setSeedArray() {
             throw InvalidSeedException( " Error: Failed to write out a string as hexadecimal" );
         }
         opts->setSeed( (char*)hexSeedString );
-        if ( verbose ) {
+        if ( opts->wantsVerboseOutput() ) {
             std::cerr << "Using generated seed: " << hexSeedString << std::endl;
         }
     }
@@ -145,21 +145,25 @@ void MutationsSelector::setSelectedMutCount() {
 void MutationsSelector::selectPermutation( size_t index, PossibleMutVec::iterator& it ) {
     index = index > ( it->permutations.size() - 1 ) ? it->permutations.size() - 1
                                                     : index;  // for synced lines with less permutations than leader
-    size_t offset = ( ( it->data.depth ? it->data.depth - 1 : 0 ) + it->data.isOptional + it->data.isNewLined +
-                      it->data.mustPass + it->data.isRegex );
-    auto patIt = it->pattern.begin();
-    auto end = it->pattern.end();
+    std::string mutation = it->permutations[index];
+    selectedMutations.emplace_back( getBarePattern( *it ), mutation, it->data );
+    selectedMutations.back().permutation = index;
+    // printDatos();
+}
+
+std::string MutationsSelector::getBarePattern( const TsvFileLine& row ) {
+    size_t offset = ( ( row.data.depth ? row.data.depth - 1 : 0 ) + row.data.isOptional + row.data.isNewLined +
+                      row.data.mustPass + row.data.isRegex );
+    std::string pattern = row.pattern;  // the iterators below need a mutable string
+    auto patIt = pattern.begin();
+    auto end = pattern.end();
     size_t bytes{};
     while ( ( bytes = isWhiteSpace( ( patIt + offset ), end ) ) ) {
         offset += bytes;
     }
     auto endPos = lastNonWhiteSpace( patIt, end );
 
-    std::string pattern( it->pattern.c_str() + offset,
-                         ( endPos == std::string::npos ? it->pattern.size() : endPos + 1 ) - offset );
-    std::string mutation = it->permutations[index];
-    selectedMutations.emplace_back( pattern, mutation, it->data );
-    // printDatos();
+    return pattern.substr( offset, ( endPos == std::string::npos ? pattern.size() : endPos + 1 ) - offset );
 }
 
 void MutationsSelector::groupedSelectPermutation( const std::vector<size_t>& indexes, size_t groupNumber,
@@ -21,35 +21,207 @@
 #include "commands/mutate/mutator.hpp"
 
 #include <algorithm>
-#include <set>
 #include <sstream>
 
-#include "commands/mutate/jpcre2.hpp"
+#include "commands/mutate/commentStripper.hpp"
+#include "commands/mutate/regexPrefilter.hpp"
 #include "common.hpp"
 #include "excepts.hpp"
+#include "traceRecorder.hpp"
 
-typedef jpcre2::select<char> jp;
+// Regex rows requiring literals from which one RequiredLiteralsScan beats searching for the literals of each row
+static constexpr size_t LITERALS_SCAN_MIN_ROWS = 8;
 
 std::string Mutator::operator()( const std::string& srcString, const std::string& tsvString, CLIOptions* _opts ) {
-    opts = _opts;
+    TraceSpan mutant( "mutant", "mutant" );
+    PipelineStats* stats = _opts->getStats();
+    CounterSnapshot before = takeCounterSnapshot();
+
+    std::string strippedStr;
+    {
+        ScopedPhase phase( stats, StatsPhase::STRIP );
+        strippedStr = removeStrComments( srcString, _opts->getLexer() );
+    }
+
     MutationsRetriever retriever( tsvString );
-    MutationsSelector selector{ _opts, retriever.getPossibleMutations() };
-    SelectedMutVec selectedMutations = selector.getSelectedMutations();
+    {
+        ScopedPhase phase( stats, StatsPhase::PARSE );
+        retriever.capturePossibleMutations();
+    }
+    {
+        ScopedPhase phase( stats, StatsPhase::CATEGORIZE );
+        retriever.categorizeMutations();
+    }
+    {
+        ScopedPhase phase( stats, StatsPhase::NESTING );
+        retriever.checkNesting();
+    }
+    PossibleMutVec& possibleMutations = retriever.getPossibleMutations();
+    if ( stats ) {
+        stats->add( StatsCounter::ROWS_PARSED, possibleMutations.size() );
+    }
 
-    std::string strippedStr = removeStrComments( srcString );
-    for ( const auto& sm : selectedMutations ) {
+    selectAndApply( strippedStr, possibleMutations, _opts, nullptr );
+    recordCounters( before, stats );
+    return strippedStr;
+}
+
+std::string Mutator::mutateStripped( std::string strippedStr, PossibleMutVec& possibleMutations, CLIOptions* _opts,
+                                     const TokenStream* tokens ) {
+    TraceSpan mutant( "mutant", "mutant" );
+    CounterSnapshot before = takeCounterSnapshot();
+    selectAndApply( strippedStr, possibleMutations, _opts, tokens );
+    recordCounters( before, _opts->getStats() );
+    return strippedStr;
+}
+
+void Mutator::selectAndApply( std::string& strippedStr, PossibleMutVec& possibleMutations, CLIOptions* _opts,
+                              const TokenStream* tokens ) {
+    PipelineStats* stats = _opts->getStats();
+    SelectedMutVec selectedMutations;
+    {
+        ScopedPhase phase( stats, StatsPhase::SELECT );
+        MutationsSelector selector{ _opts, possibleMutations };
+        selectedMutations = std::move( selector.getSelectedMutations() );
+    }
+    if ( stats ) {
+        stats->add( StatsCounter::ROWS_SELECTED, selectedMutations.size() );
+    }
+    if ( selectionLog ) {
+        *selectionLog = MutantDescriptor::mutationsOf( selectedMutations );
+    }
+
+    applyMutations( strippedStr, selectedMutations, _opts, tokens );
+}
+
+void Mutator::applyMutations( std::string& strippedStr, const SelectedMutVec& selectedMutations, CLIOptions* _opts,
+                              const TokenStream* tokens ) {
+    opts = _opts;
+    PipelineStats* stats = opts->getStats();
+    ScopedPhase phase( stats, StatsPhase::REPLACE );
+    bool byTokens = opts->getMatchMode() == MatchMode::TOKENS;
+    if ( byTokens ) {
+        tokenMatcher.reset( opts->getLexer(), tokens );
+    }
+    regexReplacer.setLimits( opts->getRegexLimits() );
+    regexReplacer.setDeadline( opts->hasTimeLimit()
+                                   ? statsClockNs() + static_cast<std::uint64_t>( opts->getTimeLimit() ) * 1000000
+                                   : 0 );
+    prepareLiteralsScan( selectedMutations );
+
+    for ( size_t i = 0; i < selectedMutations.size(); ++i ) {
+        const SelectedMutation& sm = selectedMutations[i];
+        bool timed = stats || TraceRecorder::isEnabled();
+        std::uint64_t startNs = timed ? statsClockNs() : 0;
+        int matches;
         if ( sm.data.isRegex ) {
-            regexReplace( strippedStr, sm );
+            matches = regexReplace( strippedStr, sm, i );
+            if ( byTokens && matches ) {
+                tokenMatcher.invalidate();  // regex matches are still replaced as text
+            }
         }
         else {
-            int matches = replacer( strippedStr, sm.pattern, sm.replacement, sm.data.isNewLined );
-            checkMatchCount( matches, sm );
+            matches = byTokens ? tokenMatcher( strippedStr, sm.pattern, sm.replacement, sm.data.isNewLined )
+                               : replacer( strippedStr, sm.pattern, sm.replacement, sm.data.isNewLined );
+            if ( chunkMatchCounts ) {
+                ( *chunkMatchCounts )[i] += matches;
+            }
+            else {
+                checkMatchCount( matches, sm );
+            }
+        }
+        if ( timed ) {
+            std::uint64_t endNs = statsClockNs();
+            if ( stats ) {
+                stats->addReplacement( sm.data.lineNumber, endNs - startNs, matches, sm.data.isRegex );
+            }
+            TraceRecorder::record( sm.data.isRegex ? "regex row" : "row", "row", startNs, endNs,
+                                   static_cast<std::int64_t>( sm.data.lineNumber ) );
         }
     }
-    return strippedStr;
 }
 
-void Mutator::regexReplace( std::string& subject, const SelectedMutation& sm ) {
+void Mutator::applyMutationsToChunk( std::string& chunk, const SelectedMutVec& selectedMutations, CLIOptions* _opts,
+                                     std::vector<size_t>& matchCounts ) {
+    CounterSnapshot before = takeCounterSnapshot();
+    matchCounts.resize( selectedMutations.size() );
+    chunkMatchCounts = &matchCounts;
+    try {
+        applyMutations( chunk, selectedMutations, _opts );
+    } catch ( ... ) {
+        chunkMatchCounts = nullptr;
+        throw;
+    }
+    chunkMatchCounts = nullptr;
+    recordCounters( before, _opts->getStats() );
+}
+
+void Mutator::checkMatchCounts( const SelectedMutVec& selectedMutations, const std::vector<size_t>& matchCounts,
+                                CLIOptions* _opts ) {
+    opts = _opts;
+    for ( size_t i = 0; i < selectedMutations.size() && i < matchCounts.size(); ++i ) {
+        if ( !selectedMutations[i].data.isRegex ) {
+            checkMatchCount( static_cast<int>( std::min<size_t>( matchCounts[i], 2 ) ), selectedMutations[i] );
+        }
+    }
+}
+
+Mutator::CounterSnapshot Mutator::takeCounterSnapshot() const {
+    return { regexCache->getCompilations(),
+             replacer.getFindCalls() + tokenMatcher.getFindCalls() + regexReplacer.getFindCalls(),
+             replacer.getBytesCopied() + tokenMatcher.getBytesCopied() + regexReplacer.getBytesCopied(),
+             prefilterSkips,
+             regexReplacer.getLimitHits() };
+}
+
+void Mutator::recordCounters( const CounterSnapshot& before, PipelineStats* stats ) const {
+    if ( stats ) {
+        CounterSnapshot after = takeCounterSnapshot();
+        stats->add( StatsCounter::REGEX_COMPILATIONS, after.regexCompilations - before.regexCompilations );
+        stats->add( StatsCounter::FIND_CALLS, after.findCalls - before.findCalls );
+        stats->add( StatsCounter::BYTES_COPIED, after.bytesCopied - before.bytesCopied );
+        stats->add( StatsCounter::PREFILTER_SKIPS, after.prefilterSkips - before.prefilterSkips );
+        stats->add( StatsCounter::REGEX_LIMIT_HITS, after.regexLimitHits - before.regexLimitHits );
+    }
+}
+
+void Mutator::prepareLiteralsScan( const SelectedMutVec& selectedMutations ) {
+    literalsScanRows.assign( selectedMutations.size(), NO_SCAN_ROW );
+    std::vector<const std::vector<std::string>*> rowLiterals;
+    size_t cacheSize = regexCache->size();
+    for ( size_t i = 0; i < selectedMutations.size(); ++i ) {
+        const SelectedMutation& sm = selectedMutations[i];
+        size_t index = sm.pattern.find_last_of( '/' );
+        if ( !sm.data.isRegex || index == std::string::npos ) {
+            continue;  // regexReplace() reports the missing '/'
+        }
+        const RegexCache::Entry& regex = regexCache->getEntry( std::get<0>( getPatternAndModifiers( index, sm ) ) );
+        if ( regexCache->size() < cacheSize ) {
+            rowLiterals.clear();  // the cache was emptied, taking the literals of the rows before with it
+            break;
+        }
+        cacheSize = regexCache->size();
+        if ( regex.requiredLiterals.size() ) {
+            literalsScanRows[i] = rowLiterals.size();
+            rowLiterals.push_back( &regex.requiredLiterals );
+        }
+    }
+
+    bool useScan = !editLog && rowLiterals.size() >= LITERALS_SCAN_MIN_ROWS;
+    if ( useScan ) {
+        literalsScan.reset( rowLiterals );
+    }
+    else {
+        literalsScanRows.assign( selectedMutations.size(), NO_SCAN_ROW );
+    }
+    edits.clear();
+    EditListener* reportTo = editLog ? editLog : useScan ? &edits : nullptr;
+    replacer.setEditListener( reportTo );
+    tokenMatcher.setEditListener( reportTo );
+    regexReplacer.setEditListener( reportTo );
+}
+
+int Mutator::regexReplace( std::string& subject, const SelectedMutation& sm, size_t selectedIndex ) {
     size_t index = sm.pattern.find_last_of( '/' );
     if ( index == std::string::npos ) {
         std::ostringstream os;
@@ -59,35 +231,40 @@ void Mutator::regexReplace( std::string& subject, const SelectedMutation& sm ) {
     }
 
     auto [pattern, modifiers] = getPatternAndModifiers( index, sm );
-    std::set<std::string> matches = getRegexMatches( pattern, subject, modifiers );
-
-    for ( const auto& str : matches ) {
-        std::string regexMutation = jp::Regex( pattern ).replace( str, sm.replacement, modifiers );
-        SelectedMutation regexSm( str, regexMutation, sm.data );
-        if ( regexSm.pattern.size() ) {
-            int matches = replacer( subject, regexSm.pattern, regexSm.replacement, regexSm.data.isNewLined );
-            checkMatchCount( matches, sm );
-        }
+    RegexCache::Entry& regex = regexCache->getEntry( pattern );
+    size_t scanRow = selectedIndex < literalsScanRows.size() ? literalsScanRows[selectedIndex] : NO_SCAN_ROW;
+    if ( scanRow != NO_SCAN_ROW ? !literalsScan.mayMatch( scanRow, subject, edits )
+                                : !containsRequiredLiterals( subject, regex.requiredLiterals ) ) {
+        ++prefilterSkips;  // cannot match, no need to run the regex over the whole subject
+        return 0;
+    }
+    bool needsFullSyntax = modifiers.find( 'x' ) != std::string::npos;
+    const RegexEngine& engine = needsFullSyntax ? regex.getFullSyntaxEngine( pattern ) : *regex.engine;
+    int matches = regexReplacer( subject, engine, sm.replacement, modifiers, sm.data.isNewLined );
+    if ( matches == RegexReplacer::LIMIT_HIT ) {
+        opts->addRegexLimitLine( sm.data.lineNumber );
+        return 0;
     }
+    return matches;
 }
 
-// This is just a temporary stand in method to use until we have better regex patterns
-// So that we can continue developing meanwhile
-std::string Mutator::removeStrComments( const std::string& str ) {
-    std::string subject = jp::Regex( "\\/\\*.*\\*\\/" ).replace( str, "", "gm" );
-    subject = jp::Regex( ";.*?\\/\\/[^\"\n]*\n" ).replace( subject, ";\n", "gm" );
-    subject = jp::Regex( "({\\s*?\\/\\/[^\"\n]*\n)" ).replace( subject, "{\n", "gm" );
-    subject = jp::Regex( "()\\s*?\\/\\/[^\"\n]*\n)" ).replace( subject, ")\n", "gm" );
-    subject = jp::Regex( "\n\\s*?\\/\\/.*\n" ).replace( subject, "\n", "gm" );
-    return subject;
+std::string Mutator::removeStrComments( const std::string& str, const SourceLexer& lexer ) {
+    return CommentStripper( lexer )( str );
 }
 
 void Mutator::checkMatchCount( int matches, const SelectedMutation& sm ) {
+    PipelineStats* stats = opts->getStats();
     if ( !matches ) {
         opts->addNoMatchLine( sm.data.lineNumber );
+        if ( stats ) {
+            stats->add( StatsCounter::NO_MATCHES );
+        }
     }
     if ( matches > 1 ) {
         opts->addMultipleMatchLine( sm.data.lineNumber );
+        if ( stats ) {
+            stats->add( StatsCounter::MULTIPLE_MATCHES );
+        }
     }
 }
 
@@ -114,24 +291,3 @@ std::tuple<std::string, std::string> Mutator::getPatternAndModifiers( size_t ind
     }
     return { pattern, modifiers };
 }
-
-std::set<std::string> Mutator::getRegexMatches( const std::string& pattern, const std::string& subject,
-                                                const std::string& modifiers ) {
-    jp::VecNum vec_num;
-    jp::Regex re( pattern );
-    jp::RegexMatch rr;
-    rr.setRegexObject( &re )
-        .setSubject( &subject )
-        .addModifier( modifiers )
-        .setNumberedSubstringVector( &vec_num )
-        .match();
-
-    std::set<std::string> strSet;
-    for ( auto& vec : vec_num ) {
-        for ( auto& n : vec ) {
-            strSet.insert( n );
-        }
-    }
-
-    return strSet;
-}
@@ -0,0 +1,59 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * pathScopeIndex.cpp: Which TSV rows apply to which file of a tree mode run
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/pathScopeIndex.hpp"
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+bool PathScope::matches( const std::string& path ) const {
+    if ( patterns.empty() ) {
+        return true;
+    }
+    return std::any_of( patterns.begin(), patterns.end(), [&path]( const std::string& pattern ) {
+        if ( pattern.back() == '/' ) {
+            return !path.compare( 0, pattern.size(), pattern );
+        }
+        return !fnmatch( pattern.c_str(), path.c_str(), 0 );
+    } );
+}
+
+PathScopeIndex::PathScopeIndex( const PossibleMutVec& rows, const PathScopes& scopes,
+                                const std::vector<std::string>& paths ) {
+    std::unordered_map<std::string, size_t> rowSetOfScopes;  // keyed by one '0' or '1' per scope
+    rowSetOfPath.reserve( paths.size() );
+
+    for ( const std::string& path : paths ) {
+        std::string matching( scopes.size(), '0' );
+        for ( size_t scope = 0; scope < scopes.size(); ++scope ) {
+            matching[scope] = scopes[scope].matches( path ) ? '1' : '0';
+        }
+
+        auto [found, added] = rowSetOfScopes.try_emplace( matching, rowSets.size() );
+        if ( added ) {
+            PossibleMutVec& rowSet = rowSets.emplace_back();
+            std::copy_if( rows.begin(), rows.end(), std::back_inserter( rowSet ),
+                          [&matching]( const TsvFileLine& row ) { return matching[row.scope] == '1'; } );
+        }
+        rowSetOfPath.push_back( found->second );
+    }
+}
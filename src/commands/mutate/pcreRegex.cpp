@@ -0,0 +1,105 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * pcreRegex.cpp: The PCRE2 backend of the regex pattern cells, for the whole of the PCRE2 syntax
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/pcreRegex.hpp"
+
+#include <algorithm>
+
+RegexEngine::Found PcreRegex::search( const std::string& subject, std::size_t start, std::uint32_t flags,
+                                      RegexScratch& scratch ) const {
+    const pcre2_code_8* code = regex.getPcre2Code();
+    if ( !code ) {
+        return Found::NO_MATCH;  // the pattern did not compile, so it matches nothing
+    }
+    std::uint32_t captureCount = 0;
+    pcre2_pattern_info_8( code, PCRE2_INFO_CAPTURECOUNT, &captureCount );
+    if ( !scratch.matchData || pcre2_get_ovector_count_8( scratch.matchData.get() ) <= captureCount ) {
+        scratch.matchData.reset( pcre2_match_data_create_from_pattern_8( code, nullptr ) );
+    }
+
+    std::uint32_t options = ( flags & ANCHORED ? PCRE2_ANCHORED : 0 ) |
+                            ( flags & NOT_EMPTY_AT_START ? PCRE2_NOTEMPTY_ATSTART : 0 );
+    int rc = pcre2_match_8( code, reinterpret_cast<PCRE2_SPTR8>( subject.data() ), subject.size(), start, options,
+                            scratch.matchData.get(), scratch.matchContext );
+    if ( rc == PCRE2_ERROR_MATCHLIMIT || rc == PCRE2_ERROR_DEPTHLIMIT || rc == PCRE2_ERROR_HEAPLIMIT ) {
+        return Found::LIMIT_HIT;
+    }
+    if ( rc < 0 ) {
+        return Found::NO_MATCH;  // errors end the search too
+    }
+    PCRE2_SIZE* ovector = pcre2_get_ovector_pointer_8( scratch.matchData.get() );
+    scratch.matchStart = ovector[0];
+    scratch.matchEnd = ovector[1];
+    return Found::MATCH;
+}
+
+bool PcreRegex::expand( const std::string& subject, const std::string& replacement, std::uint32_t flags,
+                        RegexScratch& scratch, std::string& expansion ) const {
+    std::uint32_t options =
+        PCRE2_SUBSTITUTE_MATCHED | PCRE2_SUBSTITUTE_REPLACEMENT_ONLY | PCRE2_SUBSTITUTE_OVERFLOW_LENGTH;
+    if ( flags & UNSET_EMPTY ) {
+        options |= PCRE2_SUBSTITUTE_UNSET_EMPTY;
+    }
+    if ( flags & UNKNOWN_UNSET ) {
+        options |= PCRE2_SUBSTITUTE_UNKNOWN_UNSET;
+    }
+    if ( flags & EXTENDED ) {
+        options |= PCRE2_SUBSTITUTE_EXTENDED;
+    }
+
+    expansion.resize( std::max( expansion.capacity(), replacement.size() * 2 + 16 ) );
+    for ( int attempt = 0; attempt < 2; ++attempt ) {
+        PCRE2_SIZE length = expansion.size();
+        int rc = pcre2_substitute_8( regex.getPcre2Code(), reinterpret_cast<PCRE2_SPTR8>( subject.data() ),
+                                     subject.size(), 0, options, scratch.matchData.get(), nullptr,
+                                     reinterpret_cast<PCRE2_SPTR8>( replacement.data() ), replacement.size(),
+                                     reinterpret_cast<PCRE2_UCHAR8*>( &expansion[0] ), &length );
+        if ( rc >= 0 ) {
+            expansion.resize( length );
+            return true;
+        }
+        if ( rc != PCRE2_ERROR_NOMEMORY ) {
+            return false;
+        }
+        expansion.resize( length );  // the length needed, as PCRE2_SUBSTITUTE_OVERFLOW_LENGTH is set
+    }
+    return false;
+}
+
+std::size_t PcreRegex::nextCharacter( const std::string& subject, std::size_t pos ) const {
+    const pcre2_code_8* code = regex.getPcre2Code();
+    std::uint32_t allOptions = 0;
+    std::uint32_t newline = 0;
+    pcre2_pattern_info_8( code, PCRE2_INFO_ALLOPTIONS, &allOptions );
+    pcre2_pattern_info_8( code, PCRE2_INFO_NEWLINE, &newline );
+    bool crlfIsNewline =
+        newline == PCRE2_NEWLINE_ANY || newline == PCRE2_NEWLINE_CRLF || newline == PCRE2_NEWLINE_ANYCRLF;
+
+    if ( crlfIsNewline && pos + 1 < subject.size() && subject[pos] == '\r' && subject[pos + 1] == '\n' ) {
+        return pos + 2;
+    }
+    ++pos;
+    if ( allOptions & PCRE2_UTF ) {
+        while ( pos < subject.size() && ( subject[pos] & 0xc0 ) == 0x80 ) {
+            ++pos;
+        }
+    }
+    return pos;
+}
@@ -0,0 +1,990 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * pikeRegex.cpp: A linear time backend of the regex pattern cells, a Thompson NFA run as a Pike VM
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/pikeRegex.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "pipelineStats.hpp"
+
+// Bigger programs are left to PCRE2, they come from large counted repeats and would make every search slow
+static constexpr std::size_t MAX_PROGRAM_SIZE = 1 << 14;
+
+// Limit on the capture slots of all the threads of one list
+static constexpr std::size_t MAX_THREAD_SLOTS = 1 << 20;
+
+static constexpr std::uint32_t UNBOUNDED = UINT32_MAX;
+
+static constexpr int MAX_NESTING = 250;  // the PCRE2 default
+
+static constexpr std::size_t NO_POS = static_cast<std::size_t>( -1 );
+
+namespace {
+struct Node {
+    enum class Kind : unsigned char { CONCAT, ALTERNATE, SET, ASSERT, REPEAT, CAPTURE };
+
+    Kind kind;
+    std::bitset<256> set;                                               // of SET
+    PikeRegex::Assertion assertion = PikeRegex::Assertion::SUBJECT_START;  // of ASSERT
+    std::uint32_t group = 0;                                            // of CAPTURE
+    std::uint32_t min = 0;                                              // of REPEAT
+    std::uint32_t max = 0;                                              // of REPEAT, UNBOUNDED when there is none
+    bool greedy = true;                                                 // of REPEAT
+    std::vector<std::unique_ptr<Node>> children;
+
+    explicit Node( Kind _kind ) : kind{ _kind } {}
+
+    bool isNullable() const {
+        switch ( kind ) {
+            case Kind::SET:
+                return false;
+            case Kind::ASSERT:
+                return true;
+            case Kind::ALTERNATE:
+                return std::any_of( children.begin(), children.end(),
+                                    []( const std::unique_ptr<Node>& child ) { return child->isNullable(); } );
+            case Kind::REPEAT:
+                return !min || children[0]->isNullable();
+            default:
+                return std::all_of( children.begin(), children.end(),
+                                    []( const std::unique_ptr<Node>& child ) { return child->isNullable(); } );
+        }
+    }
+};
+
+bool isAsciiAlnum( unsigned char c ) {
+    return ( c >= '0' && c <= '9' ) || ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' );
+}
+
+bool isWordByte( unsigned char c ) { return isAsciiAlnum( c ) || c == '_'; }
+
+int hexValue( char c ) {
+    if ( c >= '0' && c <= '9' ) {
+        return c - '0';
+    }
+    if ( ( c | 0x20 ) >= 'a' && ( c | 0x20 ) <= 'f' ) {
+        return ( c | 0x20 ) - 'a' + 10;
+    }
+    return -1;
+}
+
+std::bitset<256> rangeSet( int first, int last ) {
+    std::bitset<256> set;
+    for ( int c = first; c <= last; ++c ) {
+        set.set( c );
+    }
+    return set;
+}
+
+// The sets of the PCRE2 default character tables, which follow the C locale
+std::bitset<256> wordSet() {
+    return rangeSet( '0', '9' ) | rangeSet( 'a', 'z' ) | rangeSet( 'A', 'Z' ) | rangeSet( '_', '_' );
+}
+
+std::bitset<256> spaceSet() { return rangeSet( '\t', '\r' ) | rangeSet( ' ', ' ' ); }
+
+// Of \d \w \s \h \v and their negations, false for any other letter
+bool escapeSet( char letter, std::bitset<256>* set ) {
+    switch ( letter | 0x20 ) {
+        case 'd':
+            *set = rangeSet( '0', '9' );
+            break;
+        case 'w':
+            *set = wordSet();
+            break;
+        case 's':
+            *set = spaceSet();
+            break;
+        case 'h':
+            *set = rangeSet( '\t', '\t' ) | rangeSet( ' ', ' ' ) | rangeSet( 0xa0, 0xa0 );
+            break;
+        case 'v':
+            *set = rangeSet( '\n', '\r' ) | rangeSet( 0x85, 0x85 );
+            break;
+        default:
+            return false;
+    }
+    if ( letter >= 'A' && letter <= 'Z' ) {
+        set->flip();
+    }
+    return true;
+}
+
+bool posixSet( const std::string& name, std::bitset<256>* set ) {
+    std::bitset<256> alpha = rangeSet( 'a', 'z' ) | rangeSet( 'A', 'Z' );
+    std::bitset<256> digit = rangeSet( '0', '9' );
+    const std::pair<const char*, std::bitset<256>> classes[] = {
+        { "alpha", alpha },
+        { "digit", digit },
+        { "alnum", alpha | digit },
+        { "lower", rangeSet( 'a', 'z' ) },
+        { "upper", rangeSet( 'A', 'Z' ) },
+        { "space", spaceSet() },
+        { "blank", rangeSet( '\t', '\t' ) | rangeSet( ' ', ' ' ) },
+        { "cntrl", rangeSet( 0, 31 ) | rangeSet( 127, 127 ) },
+        { "graph", rangeSet( 33, 126 ) },
+        { "print", rangeSet( 32, 126 ) },
+        { "punct", rangeSet( 33, 126 ) & ~( alpha | digit ) },
+        { "xdigit", digit | rangeSet( 'a', 'f' ) | rangeSet( 'A', 'F' ) },
+        { "word", wordSet() },
+        { "ascii", rangeSet( 0, 127 ) } };
+    for ( const auto& [className, classSet] : classes ) {
+        if ( name == className ) {
+            *set = classSet;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Recursive descent over the pattern, every method returns null (or false) for what is left to PCRE2
+class Parser {
+    const std::string& pattern;
+    std::size_t i = 0;
+    int depth = 0;
+
+    std::unique_ptr<Node> setNode( const std::bitset<256>& set ) {
+        auto node = std::make_unique<Node>( Node::Kind::SET );
+        node->set = set;
+        return node;
+    }
+
+    std::unique_ptr<Node> assertNode( PikeRegex::Assertion assertion ) {
+        auto node = std::make_unique<Node>( Node::Kind::ASSERT );
+        node->assertion = assertion;
+        return node;
+    }
+
+    // Length of the {n}, {n,} or {n,m} quantifier at at, 0 when there is none. ambiguous is set for braces that
+    // other PCRE2 versions could read as a quantifier ({,m}, spaces, numbers too big)
+    std::size_t braceQuantifier( std::size_t at, std::uint32_t* min, std::uint32_t* max, bool* ambiguous ) const {
+        *ambiguous = false;
+        std::size_t close = pattern.find( '}', at );
+        if ( at >= pattern.size() || pattern[at] != '{' || close == std::string::npos ) {
+            return 0;
+        }
+        std::string inside = pattern.substr( at + 1, close - at - 1 );
+        if ( inside.empty() || inside.find_first_not_of( "0123456789, " ) != std::string::npos ||
+             inside.find_first_of( "0123456789" ) == std::string::npos ) {
+            return 0;
+        }
+        std::size_t comma = inside.find( ',' );
+        std::string low = inside.substr( 0, comma );
+        std::string high = comma == std::string::npos ? low : inside.substr( comma + 1 );
+        if ( inside.find( ' ' ) != std::string::npos || low.empty() || high.find( ',' ) != std::string::npos ||
+             low.size() > 5 || high.size() > 5 ) {
+            *ambiguous = true;
+            return 0;
+        }
+        *min = static_cast<std::uint32_t>( std::stoul( low ) );
+        *max = high.empty() ? UNBOUNDED : static_cast<std::uint32_t>( std::stoul( high ) );
+        if ( *min > 65535 || ( *max != UNBOUNDED && ( *max > 65535 || *max < *min ) ) ) {
+            *ambiguous = true;  // errors in PCRE2
+            return 0;
+        }
+        return close - at + 1;
+    }
+
+    bool startsQuantifier( std::size_t at ) const {
+        std::uint32_t min, max;
+        bool ambiguous;
+        return at < pattern.size() &&
+               ( std::strchr( "*+?", pattern[at] ) || braceQuantifier( at, &min, &max, &ambiguous ) || ambiguous );
+    }
+
+    // at is on the character after the '[' of [:name:], [.x.] or [=x=], true when PCRE2 reads it as such
+    bool looksLikePosix( std::size_t at ) const {
+        char terminator = pattern[at];
+        for ( std::size_t p = at + 1; p < pattern.size(); ++p ) {
+            if ( pattern[p] == '\\' && p + 1 < pattern.size() && ( pattern[p + 1] == ']' || pattern[p + 1] == '\\' ) ) {
+                ++p;
+            }
+            else if ( ( pattern[p] == '[' && p + 1 < pattern.size() && pattern[p + 1] == terminator ) ||
+                      pattern[p] == ']' ) {
+                return false;
+            }
+            else if ( pattern[p] == terminator && p + 1 < pattern.size() && pattern[p + 1] == ']' ) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // i is after a '\', gives the byte or the set of the escape, or returns false
+    bool parseEscape( bool inClass, int* byte, std::bitset<256>* set, bool* isSet ) {
+        if ( i >= pattern.size() ) {
+            return false;
+        }
+        char escaped = pattern[i++];
+        *isSet = false;
+        const char* controls = "nrtfea";
+        const char* controlBytes = "\n\r\t\f\x1b\a";
+        if ( !isAsciiAlnum( static_cast<unsigned char>( escaped ) ) ) {
+            *byte = static_cast<unsigned char>( escaped );
+        }
+        else if ( const char* control = std::strchr( controls, escaped ) ) {
+            *byte = static_cast<unsigned char>( controlBytes[control - controls] );
+        }
+        else if ( escapeSet( escaped, set ) ) {
+            *isSet = true;
+        }
+        else if ( escaped == 'b' && inClass ) {
+            *byte = '\b';
+        }
+        else if ( escaped == 'x' ) {
+            int value = 0;
+            int digits = 0;
+            if ( i < pattern.size() && pattern[i] == '{' ) {
+                std::size_t close = pattern.find( '}', i );
+                for ( std::size_t p = i + 1; close != std::string::npos && p < close; ++p, ++digits ) {
+                    if ( hexValue( pattern[p] ) < 0 || ( value = value * 16 + hexValue( pattern[p] ) ) > 0xff ) {
+                        return false;
+                    }
+                }
+                if ( close == std::string::npos ) {
+                    return false;
+                }
+                i = close + 1;
+            }
+            else {
+                for ( ; digits < 2 && i < pattern.size() && hexValue( pattern[i] ) >= 0; ++digits ) {
+                    value = value * 16 + hexValue( pattern[i++] );
+                }
+            }
+            if ( !digits ) {
+                return false;
+            }
+            *byte = value;
+        }
+        else {
+            return false;  // backreferences, \p, \Q, \K, \R, \G and the like
+        }
+        return true;
+    }
+
+    // i is on the '['
+    std::unique_ptr<Node> parseClass() {
+        ++i;
+        if ( i < pattern.size() && std::strchr( ":.=", pattern[i] ) && looksLikePosix( i ) ) {
+            return nullptr;  // a POSIX class outside of a class is an error
+        }
+        bool negated = i < pattern.size() && pattern[i] == '^';
+        if ( negated ) {
+            ++i;
+        }
+        std::bitset<256> set;
+        for ( bool first = true;; first = false ) {
+            if ( i >= pattern.size() ) {
+                return nullptr;
+            }
+            char c = pattern[i];
+            if ( c == ']' && !first ) {
+                ++i;
+                break;
+            }
+
+            int low = 0;
+            bool isSet = false;
+            std::bitset<256> escaped;
+            if ( c == '[' && i + 1 < pattern.size() && std::strchr( ":.=", pattern[i + 1] ) &&
+                 looksLikePosix( i + 1 ) ) {
+                if ( pattern[i + 1] != ':' ) {
+                    return nullptr;
+                }
+                std::size_t end = pattern.find( ":]", i + 2 );
+                std::string name = pattern.substr( i + 2, end - i - 2 );
+                bool negatedName = name.size() && name[0] == '^';
+                if ( !posixSet( negatedName ? name.substr( 1 ) : name, &escaped ) ) {
+                    return nullptr;
+                }
+                if ( negatedName ) {
+                    escaped.flip();
+                }
+                isSet = true;
+                i = end + 2;
+            }
+            else if ( c == '\\' ) {
+                ++i;
+                if ( !parseEscape( true, &low, &escaped, &isSet ) ) {
+                    return nullptr;
+                }
+            }
+            else {
+                low = static_cast<unsigned char>( c );
+                ++i;
+            }
+
+            bool isRange = i + 1 < pattern.size() && pattern[i] == '-' && pattern[i + 1] != ']';
+            if ( isSet ) {
+                if ( isRange ) {
+                    return nullptr;  // a range from a class
+                }
+                set |= escaped;
+                continue;
+            }
+            if ( !isRange ) {
+                set.set( low );
+                continue;
+            }
+            ++i;
+            int high;
+            if ( pattern[i] == '[' && i + 1 < pattern.size() && std::strchr( ":.=", pattern[i + 1] ) ) {
+                return nullptr;
+            }
+            if ( pattern[i] == '\\' ) {
+                ++i;
+                if ( !parseEscape( true, &high, &escaped, &isSet ) || isSet ) {
+                    return nullptr;
+                }
+            }
+            else {
+                high = static_cast<unsigned char>( pattern[i++] );
+            }
+            if ( high < low ) {
+                return nullptr;
+            }
+            set |= rangeSet( low, high );
+        }
+        if ( negated ) {
+            set.flip();
+        }
+        return setNode( set );
+    }
+
+    std::unique_ptr<Node> parseAtom() {
+        char c = pattern[i];
+        std::uint32_t min, max;
+        bool ambiguous;
+        switch ( c ) {
+            case '(': {
+                if ( ++depth > MAX_NESTING ) {
+                    return nullptr;
+                }
+                ++i;
+                std::unique_ptr<Node> group;
+                if ( i < pattern.size() && pattern[i] == '?' ) {
+                    if ( i + 1 >= pattern.size() || pattern[i + 1] != ':' ) {
+                        return nullptr;  // lookarounds, atomic and named groups, inline options, comments, ...
+                    }
+                    i += 2;
+                    group = parseAlternation();
+                }
+                else {
+                    group = std::make_unique<Node>( Node::Kind::CAPTURE );
+                    group->group = ++groupCount;
+                    std::unique_ptr<Node> body = parseAlternation();
+                    if ( !body ) {
+                        return nullptr;
+                    }
+                    group->children.push_back( std::move( body ) );
+                }
+                if ( !group || i >= pattern.size() || pattern[i] != ')' ) {
+                    return nullptr;
+                }
+                ++i;
+                --depth;
+                return group;
+            }
+            case '[':
+                return parseClass();
+            case '.':
+                ++i;
+                return setNode( ~rangeSet( '\n', '\n' ) );
+            case '^':
+                ++i;
+                return assertNode( PikeRegex::Assertion::SUBJECT_START );
+            case '$':
+                ++i;
+                return assertNode( PikeRegex::Assertion::END_OR_FINAL_NL );
+            case '\\': {
+                ++i;
+                if ( i < pattern.size() ) {
+                    switch ( pattern[i] ) {
+                        case 'b':
+                            ++i;
+                            return assertNode( PikeRegex::Assertion::WORD_BOUNDARY );
+                        case 'B':
+                            ++i;
+                            return assertNode( PikeRegex::Assertion::NOT_WORD_BOUNDARY );
+                        case 'A':
+                            ++i;
+                            return assertNode( PikeRegex::Assertion::SUBJECT_START );
+                        case 'z':
+                            ++i;
+                            return assertNode( PikeRegex::Assertion::SUBJECT_END );
+                        case 'Z':
+                            ++i;
+                            return assertNode( PikeRegex::Assertion::END_OR_FINAL_NL );
+                    }
+                }
+                int byte = 0;
+                bool isSet;
+                std::bitset<256> set;
+                if ( !parseEscape( false, &byte, &set, &isSet ) ) {
+                    return nullptr;
+                }
+                return setNode( isSet ? set : rangeSet( byte, byte ) );
+            }
+            case '*':
+            case '+':
+            case '?':
+                return nullptr;  // nothing to repeat
+            case '{':
+                if ( braceQuantifier( i, &min, &max, &ambiguous ) || ambiguous ) {
+                    return nullptr;
+                }
+                break;
+        }
+        ++i;
+        return setNode( rangeSet( static_cast<unsigned char>( c ), static_cast<unsigned char>( c ) ) );
+    }
+
+    std::unique_ptr<Node> parseQuantifier( std::unique_ptr<Node> atom ) {
+        std::uint32_t min = 0;
+        std::uint32_t max = 0;
+        bool ambiguous;
+        std::size_t length = 1;
+        if ( i >= pattern.size() ) {
+            return atom;
+        }
+        switch ( pattern[i] ) {
+            case '*':
+                max = UNBOUNDED;
+                break;
+            case '+':
+                min = 1;
+                max = UNBOUNDED;
+                break;
+            case '?':
+                max = 1;
+                break;
+            default:
+                length = braceQuantifier( i, &min, &max, &ambiguous );
+                if ( ambiguous ) {
+                    return nullptr;
+                }
+                if ( !length ) {
+                    return atom;
+                }
+        }
+        i += length;
+        if ( atom->kind == Node::Kind::ASSERT ) {
+            return nullptr;
+        }
+        if ( max > 1 && atom->isNullable() ) {
+            return nullptr;  // PCRE2 ends a loop on an empty iteration, which a Pike VM cannot tell
+        }
+
+        auto repeat = std::make_unique<Node>( Node::Kind::REPEAT );
+        repeat->min = min;
+        repeat->max = max;
+        if ( i < pattern.size() && pattern[i] == '?' ) {
+            repeat->greedy = false;
+            ++i;
+        }
+        else if ( i < pattern.size() && pattern[i] == '+' ) {
+            return nullptr;  // possessive
+        }
+        if ( startsQuantifier( i ) ) {
+            return nullptr;
+        }
+        repeat->children.push_back( std::move( atom ) );
+        return repeat;
+    }
+
+    std::unique_ptr<Node> parseConcat() {
+        auto concat = std::make_unique<Node>( Node::Kind::CONCAT );
+        while ( i < pattern.size() && pattern[i] != '|' && pattern[i] != ')' ) {
+            std::unique_ptr<Node> atom = parseAtom();
+            if ( !atom || !( atom = parseQuantifier( std::move( atom ) ) ) ) {
+                return nullptr;
+            }
+            concat->children.push_back( std::move( atom ) );
+        }
+        return concat;
+    }
+
+   public:
+    std::uint32_t groupCount = 0;
+
+    explicit Parser( const std::string& _pattern ) : pattern{ _pattern } {}
+
+    std::unique_ptr<Node> parseAlternation() {
+        std::unique_ptr<Node> first = parseConcat();
+        if ( !first || i >= pattern.size() || pattern[i] != '|' ) {
+            return first;
+        }
+        auto alternation = std::make_unique<Node>( Node::Kind::ALTERNATE );
+        alternation->children.push_back( std::move( first ) );
+        while ( i < pattern.size() && pattern[i] == '|' ) {
+            ++i;
+            std::unique_ptr<Node> next = parseConcat();
+            if ( !next ) {
+                return nullptr;
+            }
+            alternation->children.push_back( std::move( next ) );
+        }
+        return alternation;
+    }
+
+    bool isAtEnd() const { return i == pattern.size(); }
+};
+
+class Compiler {
+    std::vector<PikeRegex::Inst>& program;
+    std::vector<std::bitset<256>>& sets;
+
+    std::uint32_t emit( PikeRegex::Op op, std::uint32_t x = 0, std::uint32_t y = 0 ) {
+        program.push_back( { op, x, y } );
+        return static_cast<std::uint32_t>( program.size() - 1 );
+    }
+
+    std::uint32_t here() const { return static_cast<std::uint32_t>( program.size() ); }
+
+    // Sets up the SPLIT at split to prefer taking `preferred` when greedy
+    void patchSplit( std::uint32_t split, std::uint32_t taken, std::uint32_t skipped, bool greedy ) {
+        program[split].x = greedy ? taken : skipped;
+        program[split].y = greedy ? skipped : taken;
+    }
+
+   public:
+    Compiler( std::vector<PikeRegex::Inst>& _program, std::vector<std::bitset<256>>& _sets )
+        : program{ _program }, sets{ _sets } {}
+
+    // False once the program grows too big
+    bool compile( const Node& node ) {
+        if ( program.size() > MAX_PROGRAM_SIZE ) {
+            return false;
+        }
+        switch ( node.kind ) {
+            case Node::Kind::SET:
+                if ( node.set.count() == 1 ) {
+                    int byte = 0;
+                    while ( !node.set[byte] ) {
+                        ++byte;
+                    }
+                    emit( PikeRegex::Op::BYTE, byte );
+                }
+                else {
+                    sets.push_back( node.set );
+                    emit( PikeRegex::Op::SET, static_cast<std::uint32_t>( sets.size() - 1 ) );
+                }
+                return true;
+            case Node::Kind::ASSERT:
+                emit( PikeRegex::Op::ASSERT, static_cast<std::uint32_t>( node.assertion ) );
+                return true;
+            case Node::Kind::CONCAT:
+                return std::all_of( node.children.begin(), node.children.end(),
+                                    [this]( const std::unique_ptr<Node>& child ) { return compile( *child ); } );
+            case Node::Kind::CAPTURE:
+                emit( PikeRegex::Op::SAVE, node.group * 2 );
+                if ( !compile( *node.children[0] ) ) {
+                    return false;
+                }
+                emit( PikeRegex::Op::SAVE, node.group * 2 + 1 );
+                return true;
+            case Node::Kind::ALTERNATE: {
+                std::vector<std::uint32_t> jumps;
+                for ( std::size_t k = 0; k + 1 < node.children.size(); ++k ) {
+                    std::uint32_t split = emit( PikeRegex::Op::SPLIT );
+                    if ( !compile( *node.children[k] ) ) {
+                        return false;
+                    }
+                    jumps.push_back( emit( PikeRegex::Op::JUMP ) );
+                    patchSplit( split, split + 1, here(), true );
+                }
+                if ( !compile( *node.children.back() ) ) {
+                    return false;
+                }
+                for ( std::uint32_t jump : jumps ) {
+                    program[jump].y = here();
+                }
+                return true;
+            }
+            case Node::Kind::REPEAT: {
+                const Node& body = *node.children[0];
+                for ( std::uint32_t r = 0; r < node.min; ++r ) {
+                    if ( !compile( body ) ) {
+                        return false;
+                    }
+                }
+                if ( node.max == UNBOUNDED ) {
+                    std::uint32_t split = emit( PikeRegex::Op::SPLIT );
+                    if ( !compile( body ) ) {
+                        return false;
+                    }
+                    emit( PikeRegex::Op::JUMP, 0, split );
+                    patchSplit( split, split + 1, here(), node.greedy );
+                    return true;
+                }
+                // each optional copy gives up on all the ones after it
+                std::vector<std::uint32_t> splits;
+                for ( std::uint32_t r = node.min; r < node.max; ++r ) {
+                    splits.push_back( emit( PikeRegex::Op::SPLIT ) );
+                    if ( !compile( body ) ) {
+                        return false;
+                    }
+                }
+                for ( std::uint32_t split : splits ) {
+                    patchSplit( split, split + 1, here(), node.greedy );
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+};
+}  // namespace
+
+std::unique_ptr<PikeRegex> PikeRegex::compile( const std::string& pattern ) {
+    Parser parser( pattern );
+    std::unique_ptr<Node> root = parser.parseAlternation();
+    if ( !root || !parser.isAtEnd() ) {
+        return nullptr;  // unsupported syntax, or a ')' too many
+    }
+
+    std::unique_ptr<PikeRegex> regex( new PikeRegex() );
+    Compiler compiler( regex->program, regex->sets );
+    if ( !compiler.compile( *root ) ) {
+        return nullptr;
+    }
+    regex->program.push_back( { Op::MATCH, 0, 0 } );
+    regex->slotCount = ( parser.groupCount + 1 ) * 2;
+    if ( regex->program.size() > MAX_PROGRAM_SIZE || regex->program.size() * regex->slotCount > MAX_THREAD_SLOTS ) {
+        return nullptr;
+    }
+
+    // the bytes the threads at the start can consume, or that a match can be empty
+    regex->matchesEmpty = false;
+    std::vector<bool> seen( regex->program.size() );
+    std::vector<std::uint32_t> pending{ 0 };
+    while ( pending.size() ) {
+        std::uint32_t pc = pending.back();
+        pending.pop_back();
+        if ( seen[pc] ) {
+            continue;
+        }
+        seen[pc] = true;
+        const Inst& inst = regex->program[pc];
+        switch ( inst.op ) {
+            case Op::BYTE:
+                regex->firstBytes.set( inst.x );
+                break;
+            case Op::SET:
+                regex->firstBytes |= regex->sets[inst.x];
+                break;
+            case Op::SPLIT:
+                pending.push_back( inst.x );
+                pending.push_back( inst.y );
+                break;
+            case Op::JUMP:
+                pending.push_back( inst.y );
+                break;
+            case Op::MATCH:
+                regex->matchesEmpty = true;
+                break;
+            default:
+                pending.push_back( pc + 1 );
+        }
+    }
+    regex->firstByte = -1;
+    if ( regex->firstBytes.count() == 1 ) {
+        for ( regex->firstByte = 0; !regex->firstBytes[regex->firstByte]; ++regex->firstByte ) {
+        }
+    }
+    for ( std::uint32_t pc = 0; regex->program[pc].op == Op::BYTE || regex->program[pc].op == Op::SAVE; ++pc ) {
+        if ( regex->program[pc].op == Op::BYTE ) {
+            regex->prefix.push_back( static_cast<char>( regex->program[pc].x ) );
+        }
+    }
+    return regex;
+}
+
+bool PikeRegex::holds( Assertion assertion, const std::string& subject, std::size_t pos ) const {
+    auto isWordAt = [&subject]( std::size_t at ) {
+        return at < subject.size() && isWordByte( static_cast<unsigned char>( subject[at] ) );
+    };
+    switch ( assertion ) {
+        case Assertion::SUBJECT_START:
+            return pos == 0;
+        case Assertion::SUBJECT_END:
+            return pos == subject.size();
+        case Assertion::END_OR_FINAL_NL:
+            return pos == subject.size() || ( pos + 1 == subject.size() && subject[pos] == '\n' );
+        case Assertion::WORD_BOUNDARY:
+            return ( pos && isWordAt( pos - 1 ) ) != isWordAt( pos );
+        case Assertion::NOT_WORD_BOUNDARY:
+            return ( pos && isWordAt( pos - 1 ) ) == isWordAt( pos );
+    }
+    return false;
+}
+
+void PikeRegex::addThread( PikeThreadList& list, std::uint32_t pc, const std::string& subject, std::size_t pos,
+                           std::size_t* captures, std::vector<PikeFrame>& frames ) const {
+    // the captures are changed on the way and put back by the restore frames, so callers see them unchanged
+    frames.clear();
+    frames.push_back( { pc, PikeFrame::NO_RESTORE, 0 } );
+    while ( frames.size() ) {
+        PikeFrame frame = frames.back();
+        frames.pop_back();
+        if ( frame.restoreSlot != PikeFrame::NO_RESTORE ) {
+            captures[frame.restoreSlot] = frame.restoreValue;
+            continue;
+        }
+        std::uint32_t at = list.sparse[frame.pc];
+        if ( at < list.size && list.dense[at] == frame.pc ) {
+            continue;  // a thread of higher priority got there first
+        }
+        list.sparse[frame.pc] = list.size;
+        list.dense[list.size] = frame.pc;
+        std::uint32_t index = list.size++;
+
+        const Inst& inst = program[frame.pc];
+        switch ( inst.op ) {
+            case Op::JUMP:
+                frames.push_back( { inst.y, PikeFrame::NO_RESTORE, 0 } );
+                break;
+            case Op::SPLIT:
+                frames.push_back( { inst.y, PikeFrame::NO_RESTORE, 0 } );
+                frames.push_back( { inst.x, PikeFrame::NO_RESTORE, 0 } );
+                break;
+            case Op::SAVE:
+                frames.push_back( { 0, inst.x, captures[inst.x] } );
+                captures[inst.x] = pos;
+                frames.push_back( { frame.pc + 1, PikeFrame::NO_RESTORE, 0 } );
+                break;
+            case Op::ASSERT:
+                if ( holds( static_cast<Assertion>( inst.x ), subject, pos ) ) {
+                    frames.push_back( { frame.pc + 1, PikeFrame::NO_RESTORE, 0 } );
+                }
+                break;
+            default:
+                std::copy( captures, captures + slotCount, &list.slots[index * slotCount] );
+        }
+    }
+}
+
+RegexEngine::Found PikeRegex::search( const std::string& subject, std::size_t start, std::uint32_t flags,
+                                      RegexScratch& scratch ) const {
+    for ( PikeThreadList& list : scratch.threads ) {
+        if ( list.sparse.size() < program.size() ) {
+            list.sparse.resize( program.size() );
+            list.dense.resize( program.size() );
+        }
+        if ( list.slots.size() < program.size() * slotCount ) {
+            list.slots.resize( program.size() * slotCount );
+        }
+        list.size = 0;
+    }
+    scratch.captures.resize( slotCount );
+    scratch.threadCaptures.resize( slotCount );
+    PikeThreadList* current = &scratch.threads[0];
+    PikeThreadList* next = &scratch.threads[1];
+
+    bool anchored = flags & ANCHORED;
+    bool matched = false;
+    for ( std::size_t pos = start;; ++pos ) {
+        if ( !matched ) {
+            if ( !current->size && !anchored && !matchesEmpty ) {
+                // skip to where a match can start
+                if ( prefix.size() > 1 ) {
+                    const void* found = pos < subject.size() ? memmem( subject.data() + pos, subject.size() - pos,
+                                                                       prefix.data(), prefix.size() )
+                                                             : nullptr;
+                    if ( !found ) {
+                        break;
+                    }
+                    pos = static_cast<const char*>( found ) - subject.data();
+                }
+                else if ( firstByte >= 0 ) {
+                    const void* found = pos < subject.size()
+                                            ? std::memchr( subject.data() + pos, firstByte, subject.size() - pos )
+                                            : nullptr;
+                    if ( !found ) {
+                        break;
+                    }
+                    pos = static_cast<const char*>( found ) - subject.data();
+                }
+                else {
+                    while ( pos < subject.size() && !firstBytes[static_cast<unsigned char>( subject[pos] )] ) {
+                        ++pos;
+                    }
+                    if ( pos == subject.size() ) {
+                        break;
+                    }
+                }
+            }
+            if ( !anchored || pos == start ) {
+                // the lowest priority thread, a match starting further only counts when none started before
+                std::fill( scratch.threadCaptures.begin(), scratch.threadCaptures.end(), NO_POS );
+                scratch.threadCaptures[0] = pos;
+                addThread( *current, 0, subject, pos, scratch.threadCaptures.data(), scratch.frames );
+            }
+        }
+        if ( scratch.deadlineNs && ( ( pos - start ) & 0xfff ) == 0xfff && statsClockNs() >= scratch.deadlineNs ) {
+            return Found::LIMIT_HIT;
+        }
+
+        next->size = 0;
+        int c = pos < subject.size() ? static_cast<unsigned char>( subject[pos] ) : -1;
+        for ( std::uint32_t t = 0; t < current->size; ++t ) {
+            const Inst& inst = program[current->dense[t]];
+            std::size_t* captures = &current->slots[t * slotCount];
+            if ( inst.op == Op::MATCH ) {
+                if ( ( flags & NOT_EMPTY_AT_START ) && pos == start && captures[0] == start ) {
+                    continue;
+                }
+                std::copy( captures, captures + slotCount, scratch.captures.begin() );
+                scratch.captures[1] = pos;
+                matched = true;
+                break;  // the threads after this one have a lower priority
+            }
+            if ( ( inst.op == Op::BYTE && c == static_cast<int>( inst.x ) ) ||
+                 ( inst.op == Op::SET && c >= 0 && sets[inst.x][c] ) ) {
+                addThread( *next, current->dense[t] + 1, subject, pos + 1, captures, scratch.frames );
+            }
+        }
+        std::swap( current, next );
+        if ( pos >= subject.size() || ( matched && !current->size ) || ( anchored && !current->size ) ) {
+            break;
+        }
+    }
+
+    if ( !matched ) {
+        return Found::NO_MATCH;
+    }
+    scratch.matchStart = scratch.captures[0];
+    scratch.matchEnd = scratch.captures[1];
+    return Found::MATCH;
+}
+
+bool PikeRegex::expand( const std::string& subject, const std::string& replacement, std::uint32_t flags,
+                        RegexScratch& scratch, std::string& expansion ) const {
+    if ( flags & EXTENDED ) {
+        return false;
+    }
+    expansion.clear();
+    std::size_t topGroup = slotCount / 2 - 1;
+    std::size_t i = 0;
+    auto isDigit = []( char c ) { return c >= '0' && c <= '9'; };
+    while ( i < replacement.size() ) {
+        if ( replacement[i] != '$' ) {
+            expansion.push_back( replacement[i++] );
+            continue;
+        }
+        if ( ++i >= replacement.size() ) {
+            return false;
+        }
+        char next = replacement[i];
+        if ( next == '$' ) {
+            expansion.push_back( '$' );
+            ++i;
+            continue;
+        }
+        bool inBraces = next == '{';
+        if ( inBraces ) {
+            if ( ++i >= replacement.size() ) {
+                return false;
+            }
+            next = replacement[i];
+        }
+        bool star = next == '*';
+        if ( star ) {
+            if ( ++i >= replacement.size() ) {
+                return false;
+            }
+            next = replacement[i];
+        }
+
+        std::size_t group = NO_POS;  // NO_POS for a name
+        std::size_t nameStart = i;
+        if ( !star && isDigit( next ) ) {
+            group = next - '0';
+            while ( ++i < replacement.size() ) {
+                next = replacement[i];
+                if ( !isDigit( next ) ) {
+                    break;
+                }
+                group = group * 10 + ( next - '0' );
+                if ( group > topGroup ) {
+                    if ( !( flags & UNKNOWN_UNSET ) ) {
+                        return false;
+                    }
+                    while ( ++i < replacement.size() && isDigit( replacement[i] ) ) {
+                    }
+                    next = i < replacement.size() ? replacement[i] : next;
+                    break;
+                }
+            }
+        }
+        else {
+            while ( isWordByte( static_cast<unsigned char>( next ) ) ) {
+                if ( i - nameStart >= 32 ) {
+                    return false;
+                }
+                if ( ++i >= replacement.size() ) {
+                    break;
+                }
+                next = replacement[i];
+            }
+            if ( i == nameStart ) {
+                return false;
+            }
+        }
+        if ( inBraces ) {
+            if ( next != '}' ) {
+                return false;
+            }
+            ++i;
+        }
+
+        if ( star ) {
+            if ( replacement.compare( nameStart, i - nameStart - inBraces, "MARK" ) ) {
+                return false;
+            }
+            continue;  // no marks, as (*MARK) is left to PCRE2
+        }
+        bool isUnset = true;
+        if ( group == NO_POS || group > topGroup ) {
+            if ( !( flags & UNKNOWN_UNSET ) ) {
+                return false;  // there are no named groups either
+            }
+        }
+        else {
+            isUnset = scratch.captures[group * 2] == NO_POS;
+        }
+        if ( isUnset ) {
+            if ( !( flags & UNSET_EMPTY ) ) {
+                return false;
+            }
+            continue;
+        }
+        expansion.append( subject, scratch.captures[group * 2],
+                          scratch.captures[group * 2 + 1] - scratch.captures[group * 2] );
+    }
+    return true;
+}
+
+std::size_t PikeRegex::nextCharacter( const std::string& subject, std::size_t pos ) const {
+    (void)subject;  // no UTF and LF newlines, a character is a byte
+    return pos + 1;
+}
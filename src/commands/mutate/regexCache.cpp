@@ -0,0 +1,49 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * regexCache.cpp: Keeps compiled regex pattern cells around so that each pattern is only compiled once.
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/regexCache.hpp"
+
+#include "commands/mutate/pcreRegex.hpp"
+#include "commands/mutate/regexPrefilter.hpp"
+
+RegexCache::Entry& RegexCache::getEntry( const std::string& pattern ) {
+    auto found = regexes.find( pattern );
+    if ( found != regexes.end() ) {
+        return *found->second;
+    }
+
+    if ( regexes.size() >= maxEntries ) {
+        regexes.clear();  // a crude bound, but TSVs large enough to hit it are not realistic
+    }
+    ++compilations;
+    auto entry =
+        std::make_unique<Entry>( Entry{ RegexEngine::compile( pattern ), nullptr, findRequiredLiterals( pattern ) } );
+    return *regexes.emplace( pattern, std::move( entry ) ).first->second;
+}
+
+const RegexEngine& RegexCache::Entry::getFullSyntaxEngine( const std::string& pattern ) {
+    if ( engine->hasFullSyntax() ) {
+        return *engine;
+    }
+    if ( !fullSyntaxEngine ) {
+        fullSyntaxEngine = std::make_unique<PcreRegex>( pattern );
+    }
+    return *fullSyntaxEngine;
+}
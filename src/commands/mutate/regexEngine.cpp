@@ -0,0 +1,43 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * regexEngine.cpp: Picks the backend of each regex pattern cell
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/regexEngine.hpp"
+
+#include "commands/mutate/pcreRegex.hpp"
+#include "commands/mutate/pikeRegex.hpp"
+
+// PikeRegex reads . and $ the way a PCRE2 built with LF newlines does
+static bool hasLfNewlines() {
+    static const bool isLf = []() {
+        std::uint32_t newline = 0;
+        pcre2_config_8( PCRE2_CONFIG_NEWLINE, &newline );
+        return newline == PCRE2_NEWLINE_LF;
+    }();
+    return isLf;
+}
+
+std::unique_ptr<RegexEngine> RegexEngine::compile( const std::string& pattern ) {
+    if ( hasLfNewlines() ) {
+        if ( std::unique_ptr<PikeRegex> pike = PikeRegex::compile( pattern ) ) {
+            return pike;
+        }
+    }
+    return std::make_unique<PcreRegex>( pattern );
+}
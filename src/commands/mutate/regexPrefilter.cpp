@@ -0,0 +1,363 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * regexPrefilter.cpp: Finds the literals every match of a regex pattern cell contains, to skip the regex when the
+ subject lacks one of them
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/regexPrefilter.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <deque>
+
+// Escapes matching a class of characters or a position, they end a run of literals
+static const char CLASS_ESCAPES[] = "dDwWsShHvVRbBAzZGKX";
+
+// i is on the '[', returns the index after the closing ']' or npos
+static size_t skipClass( const std::string& pattern, size_t i ) {
+    ++i;
+    if ( i < pattern.size() && pattern[i] == '^' ) {
+        ++i;
+    }
+    if ( i < pattern.size() && pattern[i] == ']' ) {
+        ++i;  // a leading ']' is part of the class
+    }
+    while ( i < pattern.size() ) {
+        if ( pattern[i] == '\\' ) {
+            i += 2;
+        }
+        else if ( pattern[i] == '[' && i + 1 < pattern.size() && pattern[i + 1] == ':' ) {
+            size_t end = pattern.find( ":]", i + 2 );
+            if ( end == std::string::npos ) {
+                return std::string::npos;
+            }
+            i = end + 2;
+        }
+        else if ( pattern[i] == ']' ) {
+            return i + 1;
+        }
+        else {
+            ++i;
+        }
+    }
+    return std::string::npos;
+}
+
+// i is on the '(', returns the index after the matching ')' or npos
+static size_t skipGroup( const std::string& pattern, size_t i ) {
+    int depth = 0;
+    while ( i < pattern.size() ) {
+        char c = pattern[i];
+        if ( c == '\\' ) {
+            i += 2;
+        }
+        else if ( c == '[' ) {
+            if ( ( i = skipClass( pattern, i ) ) == std::string::npos ) {
+                return std::string::npos;
+            }
+        }
+        else {
+            ++i;
+            if ( c == '(' ) {
+                ++depth;
+            }
+            else if ( c == ')' && !--depth ) {
+                return i;
+            }
+        }
+    }
+    return std::string::npos;
+}
+
+// Length of the quantifier starting at i, lazy or possessive suffix included, 0 when there is none
+static size_t quantifierLength( const std::string& pattern, size_t i, bool* makesOptional ) {
+    if ( i >= pattern.size() ) {
+        return 0;
+    }
+    size_t end = i + 1;
+    char c = pattern[i];
+    if ( c == '?' || c == '*' ) {
+        *makesOptional = true;
+    }
+    else if ( c == '+' ) {
+        *makesOptional = false;
+    }
+    else if ( c == '{' ) {
+        end = pattern.find( '}', i );
+        if ( end == std::string::npos || pattern.find_first_not_of( "0123456789, ", i + 1 ) != end ) {
+            return 0;  // a literal '{'
+        }
+        size_t min = pattern.find_first_not_of( ' ', i + 1 );
+        *makesOptional = !std::isdigit( static_cast<unsigned char>( pattern[min] ) ) ||
+                         pattern.find_first_not_of( '0', min ) == pattern.find_first_not_of( "0123456789", min );
+        ++end;
+    }
+    else {
+        return 0;
+    }
+    if ( end < pattern.size() && ( pattern[end] == '?' || pattern[end] == '+' ) ) {
+        ++end;
+    }
+    return end - i;
+}
+
+std::vector<std::string> findRequiredLiterals( const std::string& pattern ) {
+    if ( pattern.find( "\\Q" ) != std::string::npos || pattern.find( "(*" ) != std::string::npos ) {
+        return {};  // quoting, or a verb such as (*ACCEPT) or (*UTF) changing what the rest means
+    }
+
+    std::vector<std::string> literals;
+    std::string run;
+    auto endRun = [&]() {
+        if ( run.size() ) {
+            literals.push_back( std::move( run ) );
+            run.clear();
+        }
+    };
+
+    size_t i = 0;
+    while ( i < pattern.size() ) {
+        char c = pattern[i];
+        char literal = 0;
+        bool isLiteral = false;
+        size_t next = i + 1;
+
+        if ( c == '\\' ) {
+            if ( next >= pattern.size() ) {
+                return {};
+            }
+            char escaped = pattern[next++];
+            const char* controls = "nrtfea";
+            const char* controlChars = "\n\r\t\f\x1b\a";
+            if ( !std::isalnum( static_cast<unsigned char>( escaped ) ) ) {
+                literal = escaped;
+                isLiteral = true;
+            }
+            else if ( const char* control = std::strchr( controls, escaped ) ) {
+                literal = controlChars[control - controls];
+                isLiteral = true;
+            }
+            else if ( !std::strchr( CLASS_ESCAPES, escaped ) ) {
+                return {};  // backreferences, \x, \p{...} and the like
+            }
+        }
+        else if ( c == '[' ) {
+            if ( ( next = skipClass( pattern, i ) ) == std::string::npos ) {
+                return {};
+            }
+        }
+        else if ( c == '(' ) {
+            if ( next + 1 < pattern.size() && pattern[next] == '?' &&
+                 ( ( std::isalpha( static_cast<unsigned char>( pattern[next + 1] ) ) &&
+                     !std::strchr( "PCR", pattern[next + 1] ) ) ||
+                   pattern[next + 1] == '^' || pattern[next + 1] == '-' ) ) {
+                return {};  // inline options such as (?i) could apply to the literals after them
+            }
+            if ( ( next = skipGroup( pattern, i ) ) == std::string::npos ) {
+                return {};
+            }
+        }
+        else if ( c == '|' || c == ')' ) {
+            return {};
+        }
+        else if ( c != '.' && c != '^' && c != '$' && c != '*' && c != '+' && c != '?' ) {
+            bool unused;
+            if ( c == '{' && quantifierLength( pattern, i, &unused ) ) {
+                next = i + quantifierLength( pattern, i, &unused );  // nothing to repeat
+            }
+            else {
+                literal = c;
+                isLiteral = true;
+            }
+        }
+
+        bool makesOptional = false;
+        size_t quantifier = quantifierLength( pattern, next, &makesOptional );
+        if ( isLiteral && !makesOptional ) {
+            run.push_back( literal );
+        }
+        if ( !isLiteral || quantifier ) {
+            endRun();
+        }
+        i = next + quantifier;
+    }
+    endRun();
+
+    std::stable_sort( literals.begin(), literals.end(),
+                      []( const std::string& a, const std::string& b ) { return a.size() > b.size(); } );
+    return literals;
+}
+
+bool containsRequiredLiterals( const std::string& subject, const std::vector<std::string>& literals ) {
+    return std::all_of( literals.begin(), literals.end(), [&subject]( const std::string& literal ) {
+        return subject.find( literal ) != std::string::npos;
+    } );
+}
+
+void RequiredLiteralsScan::reset( const std::vector<const std::vector<std::string>*>& literals ) {
+    byteClasses.fill( 0 );
+    classCount = 1;
+    maxLength = 0;
+    for ( const std::vector<std::string>* rowLiteralsIn : literals ) {
+        for ( const std::string& literal : *rowLiteralsIn ) {
+            maxLength = std::max( maxLength, literal.size() );
+            for ( char c : literal ) {
+                std::uint8_t& byteClass = byteClasses[static_cast<unsigned char>( c )];
+                if ( !byteClass ) {
+                    byteClass = static_cast<std::uint8_t>( classCount++ );
+                }
+            }
+        }
+    }
+
+    // the trie of the literals, a literal ending where another one did is the same literal
+    transitions.assign( classCount, NONE );
+    outputs.assign( 1, NONE );
+    rowLiterals.clear();
+    rowStarts.clear();
+    std::uint32_t literalCount = 0;
+    for ( const std::vector<std::string>* rowLiteralsIn : literals ) {
+        rowStarts.push_back( rowLiterals.size() );
+        for ( const std::string& literal : *rowLiteralsIn ) {
+            std::uint32_t state = 0;
+            for ( char c : literal ) {
+                std::uint32_t& next = transitions[state * classCount + byteClasses[static_cast<unsigned char>( c )]];
+                if ( next == NONE ) {
+                    next = static_cast<std::uint32_t>( outputs.size() );
+                    outputs.push_back( NONE );
+                    transitions.resize( transitions.size() + classCount, NONE );
+                }
+                state = transitions[state * classCount + byteClasses[static_cast<unsigned char>( c )]];
+            }
+            if ( outputs[state] == NONE ) {
+                outputs[state] = literalCount++;
+            }
+            rowLiterals.push_back( outputs[state] );
+        }
+    }
+    rowStarts.push_back( rowLiterals.size() );
+
+    // breadth first, every state takes the missing transitions of the longest proper suffix of it in the trie
+    outputLinks.assign( outputs.size(), 0 );
+    std::vector<std::uint32_t> failures( outputs.size(), 0 );
+    std::deque<std::uint32_t> pending;
+    for ( std::uint32_t c = 0; c < classCount; ++c ) {
+        if ( transitions[c] == NONE ) {
+            transitions[c] = 0;
+        }
+        else {
+            pending.push_back( transitions[c] );
+        }
+    }
+    while ( pending.size() ) {
+        std::uint32_t state = pending.front();
+        pending.pop_front();
+        std::uint32_t failure = failures[state];
+        outputLinks[state] = outputs[failure] != NONE ? failure : outputLinks[failure];
+        for ( std::uint32_t c = 0; c < classCount; ++c ) {
+            std::uint32_t& next = transitions[state * classCount + c];
+            if ( next == NONE ) {
+                next = transitions[failure * classCount + c];
+            }
+            else {
+                failures[next] = transitions[failure * classCount + c];
+                pending.push_back( next );
+            }
+        }
+    }
+
+    // flags the transitions into the states where a literal ends, so that scan() only looks further at those
+    for ( std::uint32_t& next : transitions ) {
+        if ( outputs[next] != NONE || outputLinks[next] ) {
+            next |= REPORTS;
+        }
+    }
+
+    firstByte = -1;
+    size_t firstBytes = 0;
+    for ( int c = 0; c < 256; ++c ) {
+        startsLiteral[c] = transitions[byteClasses[c]] != 0;
+        if ( startsLiteral[c] ) {
+            firstByte = c;
+            ++firstBytes;
+        }
+    }
+    if ( firstBytes > 1 ) {
+        firstByte = -1;
+    }
+
+    found.assign( literalCount, 0 );
+    foundCount = 0;
+    hasScanned = false;
+}
+
+void RequiredLiteralsScan::scan( const std::string& subject, size_t from, size_t to ) {
+    if ( foundCount == found.size() ) {
+        return;
+    }
+    std::uint32_t state = 0;
+    for ( size_t i = from; i < to; ++i ) {
+        if ( !state ) {
+            // in between literals, skip to where one can start
+            if ( firstByte >= 0 ) {
+                const void* start = std::memchr( subject.data() + i, firstByte, to - i );
+                if ( !start ) {
+                    return;
+                }
+                i = static_cast<const char*>( start ) - subject.data();
+            }
+            else {
+                while ( i < to && !startsLiteral[static_cast<unsigned char>( subject[i] )] ) {
+                    ++i;
+                }
+                if ( i == to ) {
+                    return;
+                }
+            }
+        }
+        state = transitions[state * classCount + byteClasses[static_cast<unsigned char>( subject[i] )]];
+        if ( state & REPORTS ) {
+            state &= ~REPORTS;
+            for ( std::uint32_t at = outputs[state] != NONE ? state : outputLinks[state]; at; at = outputLinks[at] ) {
+                if ( !found[outputs[at]] ) {
+                    found[outputs[at]] = 1;
+                    if ( ++foundCount == found.size() ) {
+                        return;  // nothing left to look for
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool RequiredLiteralsScan::mayMatch( size_t row, const std::string& subject, EditWindow& edits ) {
+    if ( !hasScanned ) {
+        scan( subject, 0, subject.size() );
+        hasScanned = true;
+    }
+    else if ( !edits.isEmpty() ) {
+        // a literal that was not there before overlaps the edits
+        size_t from = edits.begin > maxLength ? edits.begin - maxLength + 1 : 0;
+        size_t to = std::min( subject.size(), edits.end + maxLength - 1 );
+        scan( subject, from, to );
+    }
+    edits.clear();
+    return std::all_of( rowLiterals.begin() + rowStarts[row], rowLiterals.begin() + rowStarts[row + 1],
+                        [this]( std::uint32_t literal ) { return found[literal]; } );
+}
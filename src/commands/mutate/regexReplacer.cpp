@@ -0,0 +1,148 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * regexReplacer.cpp: Replaces the matches of a regex pattern cell at their offsets in a single pass
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/regexReplacer.hpp"
+
+#include "common.hpp"
+#include "pipelineStats.hpp"
+
+thread_local std::string RegexReplacer::rebuilt;
+
+void RegexReplacer::MatchContextDeleter::operator()( pcre2_match_context_8* context ) const {
+    pcre2_match_context_free_8( context );
+}
+
+void RegexReplacer::setLimits( const RegexLimits& _limits ) {
+    if ( _limits == limits ) {
+        return;
+    }
+    limits = _limits;
+    matchContext.reset();
+    if ( !( limits == RegexLimits{} ) ) {
+        matchContext.reset( pcre2_match_context_create_8( nullptr ) );
+        if ( limits.matchLimit ) {
+            pcre2_set_match_limit_8( matchContext.get(), limits.matchLimit );
+        }
+        if ( limits.depthLimit ) {
+            pcre2_set_depth_limit_8( matchContext.get(), limits.depthLimit );
+        }
+        if ( limits.heapLimitKib ) {
+            pcre2_set_heap_limit_8( matchContext.get(), limits.heapLimitKib );
+        }
+    }
+    scratch.matchContext = matchContext.get();  // null keeps the defaults the patterns were built with
+}
+
+int RegexReplacer::operator()( std::string& subject, const RegexEngine& regex, const std::string& replacement,
+                               const std::string& modifiers, bool isNewLined ) {
+    auto has = [&modifiers]( char modifier ) { return modifiers.find( modifier ) != std::string::npos; };
+    bool global = has( 'g' );
+    std::uint32_t searchFlags = has( 'A' ) ? RegexEngine::ANCHORED : 0;
+    std::uint32_t expandFlags = 0;
+    if ( has( 'e' ) ) {
+        expandFlags |= RegexEngine::UNSET_EMPTY;
+    }
+    if ( has( 'E' ) ) {
+        expandFlags |= RegexEngine::UNKNOWN_UNSET | RegexEngine::UNSET_EMPTY;
+    }
+    if ( has( 'x' ) ) {
+        expandFlags |= RegexEngine::EXTENDED;
+    }
+
+    std::string& result = rebuilt;
+    result.clear();
+    size_t copied = 0;  // subject bytes up to here are in result
+    bool endsWithNewline = subject.size() && subject.back() == '\n';
+    int matches = 0;
+    splices.clear();
+    size_t start = 0;
+    std::uint32_t retryFlags = 0;  // set after an empty match so that the next one cannot be empty at the same place
+    while ( start <= subject.size() ) {
+        if ( scratch.deadlineNs && statsClockNs() >= scratch.deadlineNs ) {
+            ++limitHits;
+            return LIMIT_HIT;
+        }
+        ++findCalls;
+        RegexEngine::Found found = regex.search( subject, start, searchFlags | retryFlags, scratch );
+        if ( found == RegexEngine::Found::LIMIT_HIT ) {
+            ++limitHits;
+            return LIMIT_HIT;  // the subject is left as it was, whatever matched before
+        }
+        if ( found == RegexEngine::Found::NO_MATCH && retryFlags ) {
+            start = regex.nextCharacter( subject, start );
+            retryFlags = 0;
+            continue;
+        }
+        if ( found == RegexEngine::Found::NO_MATCH ) {
+            break;
+        }
+
+        size_t matchStart = scratch.matchStart;
+        size_t matchEnd = scratch.matchEnd;
+        if ( matchStart > matchEnd || ( !isNewLined && matchStart < copied ) ) {
+            break;  // \K in a lookaround can do this, and such a match cannot be spliced in
+        }
+        // a permutation cell the engine rejects leaves the match as it is
+        if ( regex.expand( subject, replacement, expandFlags, scratch, expansion ) ) {
+            ++matches;
+            std::string text = indentReplacement( subject, matchStart, expansion, isNewLined );
+            if ( isNewLined ) {
+                // goes in on a line of its own after the line the match ends on
+                size_t lineBreak = subject.find( '\n', matchEnd );
+                size_t insertAt = lineBreak == std::string::npos ? subject.size() : lineBreak + 1;
+                result.append( subject, copied, insertAt - copied );
+                size_t splicedAt = result.size();
+                if ( !endsWithNewline && insertAt == subject.size() ) {
+                    result.push_back( '\n' );
+                    endsWithNewline = true;
+                }
+                result += text;
+                result.push_back( '\n' );
+                if ( edits ) {
+                    splices.push_back( { splicedAt, 0, result.size() - splicedAt } );
+                }
+                copied = insertAt;
+            }
+            else {
+                result.append( subject, copied, matchStart - copied );
+                if ( edits ) {
+                    splices.push_back( { result.size(), matchEnd - matchStart, text.size() } );
+                }
+                result += text;
+                copied = matchEnd;
+            }
+        }
+        if ( !global ) {
+            break;
+        }
+        start = matchEnd;
+        retryFlags = matchStart == matchEnd ? RegexEngine::NOT_EMPTY_AT_START | RegexEngine::ANCHORED : 0;
+    }
+
+    if ( matches ) {
+        for ( const Splice& splice : splices ) {
+            edits->replaced( splice.pos, splice.removed, splice.inserted );
+        }
+        result.append( subject, copied, std::string::npos );
+        bytesCopied += result.size();
+        subject.swap( result );  // the old subject's buffer is reused by the next row
+    }
+    return matches;
+}
@@ -0,0 +1,265 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * schemataBuilder.cpp: Puts every mutant of a C or C++ source behind a runtime switch in a single source, for
+ --schemata
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/schemataBuilder.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+#include "commands/mutate/mutationsSelector.hpp"
+#include "common.hpp"
+
+// Reads MUTANT_ID once. Guarded so that schemata sources can include one another
+static const char* const SELECTOR =
+    "#ifndef MUTATEPLACEHOLDER_SCHEMATA\n"
+    "#define MUTATEPLACEHOLDER_SCHEMATA\n"
+    "#include <stdlib.h>\n"
+    "static inline int mutateplaceholder_mutant( int id ) {\n"
+    "    static int selected = -1;\n"
+    "    if ( selected < 0 ) {\n"
+    "        const char* value = getenv( \"MUTANT_ID\" );\n"
+    "        selected = value && atoi( value ) > 0 ? atoi( value ) : 0;\n"
+    "    }\n"
+    "    return selected == id;\n"
+    "}\n"
+    "#endif\n";
+
+static size_t lineStartOf( const std::string& text, size_t pos ) {
+    return pos ? text.rfind( '\n', pos - 1 ) + 1 : 0;  // npos + 1 == 0
+}
+
+// Whether one of the lines of text starting in [from, to) is a preprocessor directive, from is a line start
+static bool hasDirective( const std::string& text, size_t from, size_t to ) {
+    for ( size_t pos = from; pos < to; ) {
+        while ( pos < to && ( text[pos] == ' ' || text[pos] == '\t' ) ) {
+            ++pos;
+        }
+        if ( pos < to && text[pos] == '#' ) {
+            return true;
+        }
+        pos = text.find( '\n', pos );
+        pos = pos == std::string::npos ? to : pos + 1;
+    }
+    return false;
+}
+
+static std::string switchOf( size_t mutantId ) {
+    return "mutateplaceholder_mutant( " + std::to_string( mutantId ) + " )";
+}
+
+// So that newlined rows never add one
+static std::string endingWithLineBreak( std::string text ) {
+    if ( text.empty() || text.back() != '\n' ) {
+        text.push_back( '\n' );
+    }
+    return text;
+}
+
+SchemataBuilder::SchemataBuilder( CLIOptions* _opts, std::string strippedSource )
+    : opts{ _opts },
+      source{ endingWithLineBreak( std::move( strippedSource ) ) },
+      layout{ _opts->getLexer(), source } {
+    mutator.setEditLog( &log );
+}
+
+void SchemataBuilder::add( const PossibleMutVec& rows ) {
+    for ( const TsvFileLine& row : rows ) {
+        std::vector<std::vector<Site>> found( row.permutations.size() );
+        bool usable = true;
+        bool matched = false;
+        for ( size_t p = 0; p < row.permutations.size(); ++p ) {
+            usable = findSites( row, p, found[p] ) && usable;
+            matched = matched || found[p].size();
+            for ( const Site& site : found[p] ) {
+                usable = usable && canBeSwitched( site ) &&
+                         std::none_of( sites.begin(), sites.end(),
+                                       [&site]( const Site& other ) { return overlap( site, other ); } );
+                for ( size_t q = 0; usable && q < p; ++q ) {
+                    usable = std::none_of( found[q].begin(), found[q].end(),
+                                           [&site]( const Site& other ) { return overlap( site, other ); } );
+                }
+            }
+        }
+        if ( !usable ) {
+            skippedLines.push_back( row.data.lineNumber );
+            continue;
+        }
+        if ( !matched ) {
+            continue;  // the Mutator warned about it already
+        }
+
+        for ( size_t p = 0; p < found.size(); ++p ) {
+            if ( found[p].empty() ) {
+                continue;  // the regex engine rejected the permutation cell
+            }
+            mutants.push_back( { row.data.lineNumber, p + 1 } );
+            for ( Site& site : found[p] ) {
+                site.alternatives.front().mutantId = mutants.size();
+                insert( std::move( site ) );
+            }
+        }
+    }
+}
+
+bool SchemataBuilder::findSites( const TsvFileLine& row, size_t permutation, std::vector<Site>& found ) {
+    std::string mutated = source;
+    log.edits.clear();
+    SelectedMutVec selected{
+        SelectedMutation( MutationsSelector::getBarePattern( row ), row.permutations[permutation], row.data ) };
+    mutator.applyMutations( mutated, selected, opts );
+
+    // a row makes its edits front to back, so each one is in the offsets of source shifted by the ones before
+    size_t inserted = 0;
+    size_t removed = 0;
+    size_t reached = 0;
+    for ( const Edit& edit : log.edits ) {
+        size_t begin = edit.pos + removed - inserted;
+        if ( edit.pos < reached || begin + edit.removed > source.size() ) {
+            return false;
+        }
+        std::string text = mutated.substr( edit.pos, edit.inserted );
+        reached = edit.pos + edit.inserted;
+        inserted += edit.inserted;
+        removed += edit.removed;
+
+        if ( found.size() && !edit.removed && found.back().begin == begin && found.back().end == begin ) {
+            found.back().alternatives.front().text += text;  // lines inserted after the same one go in together
+            continue;
+        }
+        Site site{ begin, begin + edit.removed, false, { { 0, std::move( text ) } } };
+        setLineBounds( site );
+        found.push_back( std::move( site ) );
+    }
+    return true;
+}
+
+void SchemataBuilder::setLineBounds( Site& site ) {
+    size_t lineStart = lineStartOf( source, site.begin );
+    if ( site.begin == site.end ) {
+        site.wholeLines = lineStart == site.begin;
+        return;
+    }
+    size_t lineEnd = site.end;
+    if ( source[site.end - 1] != '\n' ) {
+        lineEnd = source.find( '\n', site.end ) + 1;  // source ends with a line break
+    }
+    if ( lastNonWhiteSpace( source.begin() + lineStart, source.begin() + site.begin ) != std::string::npos ||
+         lastNonWhiteSpace( source.begin() + site.end, source.begin() + lineEnd ) != std::string::npos ) {
+        return;
+    }
+    std::string& text = site.alternatives.front().text;
+    text = source.substr( lineStart, site.begin - lineStart ) + text + source.substr( site.end, lineEnd - site.end );
+    site.begin = lineStart;
+    site.end = lineEnd;
+    site.wholeLines = true;
+}
+
+bool SchemataBuilder::canBeSwitched( const Site& site ) const {
+    std::vector<std::string_view> texts;
+    for ( const Alternative& alternative : site.alternatives ) {
+        if ( site.wholeLines && hasDirective( alternative.text, 0, alternative.text.size() ) ) {
+            return false;
+        }
+        texts.push_back( alternative.text );
+    }
+    if ( site.wholeLines ? !layout.isStatements( site.begin, site.end )
+                         : !layout.isExpression( site.begin, site.end, texts ) ) {
+        return false;
+    }
+    size_t lineEnd = site.end > site.begin ? source.find( '\n', site.end - 1 ) : site.begin;
+    return !hasDirective( source, lineStartOf( source, site.begin ), lineEnd );
+}
+
+bool SchemataBuilder::overlap( const Site& a, const Site& b ) {
+    if ( a.begin == b.begin && a.end == b.end ) {
+        return false;
+    }
+    auto inside = []( size_t pos, const Site& site ) { return site.begin < pos && pos < site.end; };
+    return ( a.begin < b.end && b.begin < a.end ) || ( a.begin == a.end && inside( a.begin, b ) ) ||
+           ( b.begin == b.end && inside( b.begin, a ) );
+}
+
+void SchemataBuilder::insert( Site site ) {
+    auto it = std::lower_bound( sites.begin(), sites.end(), site, []( const Site& a, const Site& b ) {
+        return a.begin < b.begin || ( a.begin == b.begin && a.end < b.end );
+    } );
+    if ( it != sites.end() && it->begin == site.begin && it->end == site.end ) {
+        it->alternatives.insert( it->alternatives.end(), site.alternatives.begin(), site.alternatives.end() );
+    }
+    else {
+        sites.insert( it, std::move( site ) );
+    }
+}
+
+std::string SchemataBuilder::build() {
+    std::ostringstream os;
+    os << "/*\n * Mutant schemata made by mutateplaceholder: MUTANT_ID picks the mutant that runs, unset or 0 runs the "
+          "original\n";
+    for ( size_t i = 0; i < mutants.size(); ++i ) {
+        os << " *   mutant " << i + 1 << ": row on line " << mutants[i].lineNumber << " of the mutations, permutation "
+           << mutants[i].permutation << '\n';
+    }
+    os << " */\n" << SELECTOR;
+
+    size_t copied = 0;
+    for ( const Site& site : sites ) {
+        os.write( source.data() + copied, site.begin - copied );
+        std::string original = source.substr( site.begin, site.end - site.begin );
+        if ( site.wholeLines ) {
+            const std::string& first = original.size() ? original : site.alternatives.front().text;
+            std::string indent = first.substr( 0, first.find_first_not_of( " \t" ) );
+            for ( size_t i = 0; i < site.alternatives.size(); ++i ) {
+                const std::string& text = site.alternatives[i].text;
+                os << indent << ( i ? "else if ( " : "if ( " ) << switchOf( site.alternatives[i].mutantId )
+                   << " ) {\n"
+                   << text << ( text.size() && text.back() != '\n' ? "\n" : "" ) << indent << "}\n";
+            }
+            if ( original.size() ) {
+                os << indent << "else {\n" << original << indent << "}\n";
+            }
+        }
+        else {
+            os << "( ";
+            for ( const Alternative& alternative : site.alternatives ) {
+                os << switchOf( alternative.mutantId ) << " ? ( " << alternative.text << " ) : ";
+            }
+            os << "( " << original << " ) )";
+        }
+        copied = site.end;
+    }
+    os.write( source.data() + copied, source.size() - copied );
+
+    if ( skippedLines.size() ) {
+        std::ostringstream warning;
+        warning << "The pattern cell" << ( skippedLines.size() > 1 ? "s" : "" ) << " beginning at the"
+                << ( skippedLines.size() > 1 ? "se" : "" ) << " following line number"
+                << ( skippedLines.size() > 1 ? "s" : "" )
+                << " change a preprocessor line, a declaration, something else than whole statements or "
+                   "expressions of a function body or what an earlier row changes differently, and "
+                << ( skippedLines.size() > 1 ? "were" : "was" ) << " left out of the schemata: { ";
+        for ( size_t i = 0; i < skippedLines.size(); ++i ) {
+            warning << skippedLines[i] << ( i + 1 == skippedLines.size() ? " " : ", " );
+        }
+        warning << "}";
+        opts->addWarning( warning.str() );
+    }
+    return os.str();
+}
@@ -0,0 +1,154 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * streamMutator.cpp: Mutates the source a chunk at a time and writes the mutant as it goes, for --stream
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/streamMutator.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include "commands/mutate/commentStripper.hpp"
+#include "commands/mutate/mutationsRetriever.hpp"
+#include "commands/mutate/mutationsSelector.hpp"
+#include "common.hpp"
+#include "excepts.hpp"
+#include "traceRecorder.hpp"
+
+StreamMutator::StreamMutator( CLIOptions* _opts, size_t _chunkSize )
+    : opts{ _opts }, chunkSize{ std::max<size_t>( 1, _chunkSize ) }, lexer{ _opts->getLexer() } {}
+
+void StreamMutator::run( const std::string& tsv ) {
+    PipelineStats* stats = opts->getStats();
+    MutationsRetriever retriever( tsv );
+    PossibleMutVec& possibleMutations = retriever.getPossibleMutations();
+    {
+        ScopedPhase phase( stats, StatsPhase::SELECT );
+        MutationsSelector selector{ opts, possibleMutations };
+        selectedMutations = std::move( selector.getSelectedMutations() );
+    }
+    if ( stats ) {
+        stats->add( StatsCounter::ROWS_PARSED, possibleMutations.size() );
+        stats->add( StatsCounter::ROWS_SELECTED, selectedMutations.size() );
+    }
+    for ( const SelectedMutation& sm : selectedMutations ) {
+        if ( !sm.data.isRegex ) {
+            heldLines = std::max<size_t>( heldLines, std::count( sm.pattern.begin(), sm.pattern.end(), '\n' ) );
+        }
+    }
+
+    CommentStripper stripper( lexer );
+    bool isLast = false;
+    while ( !isLast ) {
+        TraceSpan span( "chunk", "chunk" );
+        size_t oldSize = pending.size();
+        pending.resize( oldSize + chunkSize );
+        size_t read = opts->readSrcChunk( pending.data() + oldSize, chunkSize );
+        pending.resize( oldSize + read );
+        bytesRead += read;
+        isLast = !read;
+
+        size_t cut = isLast ? pending.size() : findCut();
+        if ( !cut && !isLast ) {
+            continue;  // the line goes on, or so does a comment or literal spanning lines
+        }
+        std::string stripped;
+        {
+            ScopedPhase phase( stats, StatsPhase::STRIP );
+            stripped = stripper( std::string_view( pending ).substr( 0, cut ) );
+        }
+        pending.erase( 0, cut );
+        lexerResume = LexerResume();  // lexed again from its start, as the stripper will see it
+        classifiedTo = 0;
+
+        held += stripped;
+        std::string window = std::move( held );
+        held.clear();
+        mutateWindow( std::move( window ), isLast );
+    }
+
+    if ( !bytesRead ) {
+        std::ostringstream os;
+        os << "Input file \"" << ( opts->hasInputFileName() ? opts->getInputFileName() : "-" ) << "\" has no content.";
+        throw InvalidArgumentException( sanitizeOutputMessage( os.str() ) );
+    }
+    mutator.checkMatchCounts( selectedMutations, matchCounts, opts );
+}
+
+size_t StreamMutator::findCut() {
+    if ( pending.size() > std::numeric_limits<std::uint32_t>::max() ) {
+        throw InvalidArgumentException(
+            "--stream found no line break outside of a comment or literal in 4 GiB of the source" );
+    }
+    // the tokens from where the last call left off, the line breaks up to lexerResume.pos are settled by them
+    TokenStream tokens = lexer.findCommentsAndLiterals( pending, lexerResume );
+    std::string_view view( pending );
+    size_t gapEnd = lexerResume.pos;
+    for ( auto token = tokens.rbegin();; ++token ) {
+        size_t gapStart = classifiedTo;
+        if ( token != tokens.rend() ) {
+            gapStart = std::max<size_t>( gapStart, token->offset + token->length );
+        }
+        size_t lineBreak = gapStart < gapEnd ? view.substr( gapStart, gapEnd - gapStart ).rfind( '\n' ) : view.npos;
+        if ( lineBreak != view.npos ) {
+            return gapStart + lineBreak + 1;
+        }
+        if ( token == tokens.rend() ) {
+            break;
+        }
+        gapEnd = token->offset;
+    }
+    classifiedTo = lexerResume.pos;
+    return 0;
+}
+
+void StreamMutator::mutateWindow( std::string window, bool isLast ) {
+    if ( window.empty() ) {
+        return;
+    }
+    size_t heldStart = window.size();
+    if ( heldLines && !isLast ) {
+        size_t lineBreak = window.size() - 1;  // windows other than the last end in a line break
+        for ( size_t lines = 0; lines < heldLines && lineBreak != std::string::npos; ++lines ) {
+            lineBreak = lineBreak ? window.rfind( '\n', lineBreak - 1 ) : std::string::npos;
+        }
+        if ( lineBreak == std::string::npos ) {
+            held = std::move( window );  // not as many lines as a pattern cell yet, wait for more
+            return;
+        }
+        heldStart = lineBreak + 1;
+    }
+
+    std::string heldLinesText = window.substr( heldStart );
+    mutator.applyMutationsToChunk( window, selectedMutations, opts, matchCounts );
+
+    // held back lines a replacement touched cannot be mutated again with the next chunk, they go out as they are
+    if ( heldLinesText.size() && window.size() >= heldLinesText.size() &&
+         !window.compare( window.size() - heldLinesText.size(), heldLinesText.size(), heldLinesText ) ) {
+        window.resize( window.size() - heldLinesText.size() );
+        held = std::move( heldLinesText );
+    }
+    write( std::move( window ) );
+}
+
+void StreamMutator::write( std::string text ) {
+    ScopedPhase phase( opts->getStats(), StatsPhase::WRITE );
+    bytesWritten += text.size();
+    opts->putResOutput( std::move( text ) );
+}
@@ -20,6 +20,7 @@
 
 #include "commands/mutate/textReplacer.hpp"
 
+#include <algorithm>
 #include <sstream>
 
 #include "commands/mutate/mutateDataStructures.hpp"
@@ -45,9 +46,9 @@ int TextReplacer::singleLineReplace( std::string& subject, const std::string& _r
     matches = 0;
     pos = 0;
 
-    while ( ( pos = subject.find( patternStr, pos ) ) != std::string::npos ) {
+    while ( ( pos = findInSubject( subject, patternStr ) ) != std::string::npos ) {
         begin = subject.begin() + pos;
-        while ( *( begin - 1 ) != '\n' ) {
+        while ( begin != subject.begin() && *( begin - 1 ) != '\n' ) {
             --begin;
         }
 
@@ -94,10 +95,10 @@ int TextReplacer::multilineReplace( std::string& subject, const std::string& _re
     pos = 0;
     std::vector<std::string> lines = separateLinesIntoVector( patternStr );
 
-    while ( ( pos = subject.find( lines[0], pos ) ) != std::string::npos ) {
+    while ( ( pos = findInSubject( subject, lines[0] ) ) != std::string::npos ) {
         begin = subject.begin() + pos;
         indentation = 0;
-        while ( *( begin - 1 ) != '\n' ) {
+        while ( begin != subject.begin() && *( begin - 1 ) != '\n' ) {
             --begin;
             ++indentation;
         }
@@ -139,7 +140,7 @@ int TextReplacer::multilineReplace( std::string& subject, const std::string& _re
             replacementStr.push_back( '\n' );
             lengthToRemove = 0;
         }
-        subject.replace( pos, lengthToRemove, replacementStr );
+        replaceInSubject( subject );
         pos += replacementStr.length();
     }
     return matches;
@@ -214,6 +215,9 @@ bool TextReplacer::edgesGoodAndReplacementSuccessful( std::string& subject, cons
     if ( isNewLined ) {
         replacementStr.push_back( '\n' );
         if ( end == subject.end() ) {
+            if ( edits ) {
+                edits->replaced( subject.size(), 0, 1 );
+            }
             subject.push_back( '\n' );
             end = subject.end() - 1;
         }
@@ -222,7 +226,7 @@ bool TextReplacer::edgesGoodAndReplacementSuccessful( std::string& subject, cons
     }
 
     ++matches;
-    subject.replace( pos, lengthToRemove, replacementStr );
+    replaceInSubject( subject );
     pos += replacementStr.length();
     return true;
 }
@@ -273,4 +277,20 @@ bool TextReplacer::line2IsGood( const std::string& subject, std::vector<std::str
         return false;
     }
     return true;
-}
\ No newline at end of file
+}
+
+size_t TextReplacer::findInSubject( const std::string& subject, const std::string& str ) {
+    ++findCalls;
+    return subject.find( str, pos );
+}
+
+// Replaces lengthToRemove bytes at pos with replacementStr, counting the bytes written and the tail moved and
+// reporting the edit
+void TextReplacer::replaceInSubject( std::string& subject ) {
+    size_t tail = subject.size() - pos;
+    bytesCopied += replacementStr.size() + tail - std::min( lengthToRemove, tail );
+    if ( edits ) {
+        edits->replaced( pos, std::min( lengthToRemove, tail ), replacementStr.size() );
+    }
+    subject.replace( pos, lengthToRemove, replacementStr );
+}
@@ -0,0 +1,168 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * tokenMatcher.cpp: Replaces plain pattern cells matched as token sequences, for --match=tokens
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/tokenMatcher.hpp"
+
+#include <algorithm>
+
+#include "common.hpp"
+
+// Punctuation is one token per character, so "+=" and "+ =" only differ in whether the two tokens touch
+static bool isGlued( const TokenStream& tokens, size_t i ) {
+    return i && tokens[i].kind == TokenKind::PUNCTUATION && tokens[i - 1].kind == TokenKind::PUNCTUATION &&
+           tokens[i - 1].offset + tokens[i - 1].length == tokens[i].offset;
+}
+
+void TokenMatcher::reset( const SourceLexer& _lexer, const TokenStream* sourceTokens ) {
+    lexer = &_lexer;
+    hashes.clear();
+    stale = !sourceTokens;
+    if ( sourceTokens ) {
+        tokens = *sourceTokens;
+    }
+}
+
+void TokenMatcher::hashTokens( const std::string& text, const TokenStream& toHash, std::vector<std::uint64_t>& out,
+                               size_t from, size_t to ) const {
+    for ( size_t i = from; i < to; ++i ) {
+        std::uint64_t hash = hashBytes( text.data() + toHash[i].offset, toHash[i].length );
+        out[i] = ( hash & ~std::uint64_t{ 1 } ) | isGlued( toHash, i );
+    }
+}
+
+int TokenMatcher::operator()( std::string& subject, const std::string& pattern, const std::string& replacement,
+                              bool isNewLined ) {
+    if ( stale ) {
+        tokens = lexer->tokenize( subject );
+        hashes.clear();
+        stale = false;
+    }
+    if ( hashes.size() != tokens.size() ) {
+        hashes.resize( tokens.size() );
+        hashTokens( subject, tokens, hashes, 0, tokens.size() );
+    }
+
+    TokenStream patternTokens = lexer->tokenize( pattern );
+    patternTokens.erase( std::remove_if( patternTokens.begin(), patternTokens.end(),
+                                         []( const Token& t ) { return t.kind == TokenKind::COMMENT; } ),
+                         patternTokens.end() );
+    if ( patternTokens.empty() || patternTokens.size() > tokens.size() ) {
+        return 0;
+    }
+    std::vector<std::uint64_t> patternHashes( patternTokens.size() );
+    hashTokens( pattern, patternTokens, patternHashes, 0, patternTokens.size() );
+
+    int matches = 0;
+    size_t first = 0;
+    while ( first + patternTokens.size() <= tokens.size() ) {
+        ++findCalls;
+        auto lastCandidate = hashes.end() - ( patternTokens.size() - 1 );
+        first = std::find( hashes.begin() + first, lastCandidate, patternHashes[0] ) - hashes.begin();
+        if ( first + patternTokens.size() > tokens.size() ) {
+            break;
+        }
+        if ( isMatchAt( subject, first, pattern, patternTokens, patternHashes ) ) {
+            ++matches;
+            first = replaceAt( subject, first, patternTokens.size(), replacement, isNewLined );
+        }
+        else {
+            ++first;
+        }
+    }
+    return matches;
+}
+
+bool TokenMatcher::isMatchAt( const std::string& subject, size_t first, const std::string& pattern,
+                              const TokenStream& patternTokens,
+                              const std::vector<std::uint64_t>& patternHashes ) const {
+    for ( size_t i = 1; i < patternTokens.size(); ++i ) {
+        if ( hashes[first + i] != patternHashes[i] ) {
+            return false;
+        }
+    }
+    size_t after = first + patternTokens.size();
+    if ( after < tokens.size() && ( hashes[after] & 1 ) ) {
+        return false;  // the match would end in the middle of an operator
+    }
+    for ( size_t i = 0; i < patternTokens.size(); ++i ) {
+        const Token& token = tokens[first + i];
+        const Token& patternToken = patternTokens[i];
+        if ( subject.compare( token.offset, token.length, pattern, patternToken.offset, patternToken.length ) ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t TokenMatcher::replaceAt( std::string& subject, size_t first, size_t count, const std::string& replacement,
+                                bool isNewLined ) {
+    size_t start = tokens[first].offset;
+    size_t end = tokens[first + count - 1].offset + tokens[first + count - 1].length;
+    std::string text = indentReplacement( subject, start, replacement, isNewLined );
+
+    size_t pos = start;
+    size_t lengthToRemove = end - start;
+    size_t spliceAt = first;
+    size_t tokensToRemove = count;
+    if ( isNewLined ) {
+        // goes in on a line of its own after the line the match ends on
+        size_t lineBreak = subject.find( '\n', end );
+        if ( lineBreak == std::string::npos ) {
+            lineBreak = subject.size();
+            if ( edits ) {
+                edits->replaced( lineBreak, 0, 1 );
+            }
+            subject.push_back( '\n' );
+        }
+        text.push_back( '\n' );
+        pos = lineBreak + 1;
+        lengthToRemove = 0;
+        spliceAt = std::lower_bound( tokens.begin() + first + count, tokens.end(), pos,
+                                     []( const Token& t, size_t offset ) { return t.offset < offset; } ) -
+                   tokens.begin();
+        tokensToRemove = 0;
+    }
+
+    size_t tail = subject.size() - pos;
+    bytesCopied += text.size() + tail - std::min( lengthToRemove, tail );
+    if ( edits ) {
+        edits->replaced( pos, lengthToRemove, text.size() );
+    }
+    subject.replace( pos, lengthToRemove, text );
+
+    TokenStream inserted = lexer->tokenize( text );
+    for ( Token& token : inserted ) {
+        token.offset += static_cast<std::uint32_t>( pos );
+    }
+    std::uint32_t delta = static_cast<std::uint32_t>( text.size() - lengthToRemove );  // wraps around when shrinking
+    for ( size_t i = spliceAt + tokensToRemove; i < tokens.size(); ++i ) {
+        tokens[i].offset += delta;
+    }
+
+    tokens.erase( tokens.begin() + spliceAt, tokens.begin() + spliceAt + tokensToRemove );
+    tokens.insert( tokens.begin() + spliceAt, inserted.begin(), inserted.end() );
+    hashes.erase( hashes.begin() + spliceAt, hashes.begin() + spliceAt + tokensToRemove );
+    hashes.insert( hashes.begin() + spliceAt, inserted.size(), 0 );
+
+    // the token right after the replacement may now be glued to it, or no longer be
+    size_t next = spliceAt + inserted.size();
+    hashTokens( subject, tokens, hashes, spliceAt, std::min( next + 1, tokens.size() ) );
+    return next;
+}
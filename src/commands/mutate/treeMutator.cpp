@@ -0,0 +1,297 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * treeMutator.cpp: Mutates a whole directory tree or list of files with one TSV, for --tree and --file-list
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/mutate/treeMutator.hpp"
+
+#include <fnmatch.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include "chacharng/seedHelper.hpp"
+#include "commands/mutate/mutationsRetriever.hpp"
+#include "commands/mutate/regexCache.hpp"
+#include "common.hpp"
+#include "excepts.hpp"
+#include "iohelpers.hpp"
+#include "threadPool.hpp"
+#include "traceRecorder.hpp"
+
+namespace fs = std::filesystem;
+
+static std::string readFile( const fs::path& path ) {
+    std::FILE* handle = std::fopen( path.c_str(), "rb" );
+    if ( !handle ) {
+        std::ostringstream os;
+        os << "Source file \'" << path.string() << "\' could not be opened.";
+        throw IOErrorException( sanitizeOutputMessage( os.str() ) );
+    }
+    try {
+        std::string contents = readWholeFileIntoString( handle, "I/O error reading source code file" );
+        closeAndNullifyFileHandle( &handle );
+        return contents;
+    } catch ( ... ) {
+        closeAndNullifyFileHandle( &handle );
+        throw;
+    }
+}
+
+static void writeFile( const fs::path& path, const std::string& contents ) {
+    fs::create_directories( path.parent_path() );
+    std::FILE* handle = std::fopen( path.c_str(), "wb" );
+    if ( !handle ) {
+        std::ostringstream os;
+        os << "Output file \'" << path.string() << "\' could not be opened.";
+        throw IOErrorException( sanitizeOutputMessage( os.str() ) );
+    }
+    try {
+        writeStringToFileHandle( handle, contents );
+        closeAndNullifyFileHandle( &handle );
+    } catch ( ... ) {
+        closeAndNullifyFileHandle( &handle );
+        throw;
+    }
+}
+
+TreeMutator::TreeMutator( CLIOptions* _opts, const std::string& tsv ) : opts{ _opts }, tsvHash{ hashBytes( tsv ) } {
+    MutationsRetriever retriever( tsv );
+
+    if ( opts->hasTreeRoot() ) {
+        listTree();
+    }
+    else {
+        readFileList();
+    }
+
+    for ( const std::string& path : paths ) {
+        fs::path relative = fs::path( path ).lexically_normal();
+        if ( relative.has_root_path() ) {
+            std::ostringstream os;
+            os << "\'" << path << "\' is not relative to the current directory and cannot be mirrored into "
+                  "--output-dir.";
+            throw InvalidArgumentException( sanitizeOutputMessage( os.str() ) );
+        }
+        if ( relative.empty() || *relative.begin() == ".." ) {
+            std::ostringstream os;
+            os << "\'" << path << "\' is outside of the current directory and cannot be mirrored into --output-dir.";
+            throw InvalidArgumentException( sanitizeOutputMessage( os.str() ) );
+        }
+    }
+    scopeIndex = PathScopeIndex( retriever.getPossibleMutations(), retriever.getPathScopes(), paths );
+
+    if ( opts->hasSeed() ) {
+        runSeed = opts->getSeed();
+    }
+    else {
+        SeedArray seedArray = generateSeed();
+        std::uint8_t hexSeedString[SEED_SIZE_BYTES * 2 + 1] = { 0 };
+        if ( !writeHexString( (const char*)seedArray.data(), hexSeedString, SEED_SIZE_BYTES ) ) {
+            throw InvalidSeedException( " Error: Failed to write out a string as hexadecimal" );
+        }
+        runSeed = (char*)hexSeedString;
+        opts->setSeed( runSeed.c_str() );
+        if ( opts->wantsVerboseOutput() ) {
+            std::cerr << "Using generated seed: " << runSeed << std::endl;
+        }
+    }
+}
+
+// Hidden directories (.git and the like) are skipped, and so is the output directory when it is inside the tree
+void TreeMutator::listTree() {
+    fs::path root = opts->getTreeRoot();
+    std::error_code ec;
+    fs::path outputDir = fs::weakly_canonical( opts->getOutputDirName(), ec );
+
+    for ( auto it = fs::recursive_directory_iterator( root ); it != fs::recursive_directory_iterator(); ++it ) {
+        const fs::path& path = it->path();
+        if ( it->is_directory() ) {
+            if ( path.filename().string()[0] == '.' || fs::weakly_canonical( path, ec ) == outputDir ) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if ( it->is_regular_file() ) {
+            std::string relative = path.lexically_relative( root ).generic_string();
+            if ( isSelected( relative ) ) {
+                paths.push_back( std::move( relative ) );
+            }
+        }
+    }
+    std::sort( paths.begin(), paths.end() );
+}
+
+// One path per line, blank lines are ignored
+void TreeMutator::readFileList() {
+    std::string list;
+    if ( !std::strcmp( opts->getFileListName(), "-" ) ) {
+        list = readWholeFileIntoString( stdin, "I/O error reading file list" );
+    }
+    else {
+        list = readFile( opts->getFileListName() );
+    }
+
+    std::istringstream is{ list };
+    std::string line;
+    while ( std::getline( is, line ) ) {
+        if ( line.size() && line.back() == '\r' ) {
+            line.pop_back();
+        }
+        if ( line.size() && isSelected( line ) ) {
+            paths.push_back( line );
+        }
+    }
+}
+
+bool TreeMutator::isSelected( const std::string& path ) const {
+    const std::vector<std::string>& globs = opts->getGlobs();
+    return globs.empty() || std::any_of( globs.begin(), globs.end(), [&path]( const std::string& glob ) {
+               return !fnmatch( glob.c_str(), path.c_str(), 0 );
+           } );
+}
+
+fs::path TreeMutator::getSourcePath( const std::string& path ) const {
+    return opts->hasTreeRoot() ? fs::path( opts->getTreeRoot() ) / path : fs::path( path );
+}
+
+fs::path TreeMutator::getOutputPath( const std::string& path ) const {
+    return fs::path( opts->getOutputDirName() ) / fs::path( path ).lexically_normal();
+}
+
+std::string TreeMutator::deriveSeed( const std::string& runSeed, const std::string& path ) {
+    std::string key = runSeed + '\0' + path + '\0';
+    std::uint8_t seedBytes[SEED_SIZE_BYTES];
+    for ( size_t i = 0; i < SEED_SIZE_BYTES; i += sizeof( std::uint64_t ) ) {
+        key.back() = static_cast<char>( i );
+        std::uint64_t hash = hashBytes( key );
+        for ( size_t b = 0; b < sizeof( std::uint64_t ); ++b ) {
+            seedBytes[i + b] = static_cast<std::uint8_t>( hash >> ( 8 * b ) );
+        }
+    }
+    std::uint8_t hexSeedString[SEED_SIZE_BYTES * 2 + 1] = { 0 };
+    if ( !writeHexString( (const char*)seedBytes, hexSeedString, SEED_SIZE_BYTES ) ) {
+        throw InvalidSeedException( " Error: Failed to write out a string as hexadecimal" );
+    }
+    return (char*)hexSeedString;
+}
+
+std::string TreeMutator::mutateFile( size_t pathIndex, Mutator& mutator ) {
+    TraceSpan span( "file", "file" );
+    const std::string& path = paths[pathIndex];
+    std::string src = readFile( getSourcePath( path ) );
+    if ( src.empty() || scopeIndex.getRows( pathIndex ).empty() ) {
+        writeFile( getOutputPath( path ), src );
+        return std::string();
+    }
+
+    CLIOptions fileOpts;  // never touches stdin/stdout as the input is already in memory
+    fileOpts.setSeed( deriveSeed( runSeed, path ).c_str() );
+    if ( opts->hasMutCount() ) {
+        fileOpts.setMutCount( std::to_string( opts->getMutCount() ).c_str() );
+    }
+    if ( opts->hasMinMutCount() ) {
+        fileOpts.setMinMutCount( opts->getMinMutCount() );
+    }
+    if ( opts->hasMaxMutCount() ) {
+        fileOpts.setMaxMutCount( opts->getMaxMutCount() );
+    }
+    const SourceLexer& lexer = opts->hasLanguage() ? opts->getLexer() : SourceLexer::forPath( path );
+    fileOpts.setLanguage( lexer.getName() );
+    if ( opts->getMatchMode() == MatchMode::TOKENS ) {
+        fileOpts.setMatchMode( "tokens" );
+    }
+    fileOpts.setRegexLimits( opts->getRegexLimits() );
+    if ( opts->wantsVerboseOutput() ) {
+        fileOpts.requestVerboseOutput();
+    }
+    if ( opts->hasTimeLimit() ) {
+        fileOpts.setTimeLimit( std::to_string( opts->getTimeLimit() ).c_str() );
+    }
+
+    PossibleMutVec rows = scopeIndex.getRows( pathIndex );
+    MutantDescriptor descriptor;
+    mutator.setSelectionLog( descriptors.size() ? &descriptor.mutations : nullptr );
+    std::string mutant = mutator.mutateStripped( mutator.removeStrComments( src, lexer ), rows, &fileOpts );
+    writeFile( getOutputPath( path ), mutant );
+    if ( descriptors.size() ) {
+        descriptor.tsvHash = tsvHash;
+        descriptor.srcHash = hashBytes( src );
+        descriptor.language = lexer.getName();
+        descriptor.matchMode = fileOpts.getMatchMode();
+        descriptors[pathIndex] = path + '\t' + descriptor.toString() + '\n';
+    }
+    return fileOpts.getWarnings();
+}
+
+size_t TreeMutator::run() {
+    std::vector<std::string> warnings( paths.size() );
+    if ( opts->descriptorNeedsExporting() ) {
+        descriptors.assign( paths.size(), std::string() );
+    }
+    std::atomic<size_t> nextFile{ 0 };
+    std::atomic<bool> failed{ false };
+    std::mutex failureMutex;
+    std::exception_ptr firstFailure;
+    std::string failedPath;
+
+    size_t threads = opts->hasJobs() ? opts->getJobs() : ThreadPool::hardwareThreads();
+    ThreadPool pool( std::max<size_t>( 1, std::min( threads, paths.size() ) ) );
+    for ( size_t worker = 0; worker < pool.size(); ++worker ) {
+        pool.submit( [&]() {
+            RegexCache regexCache;
+            Mutator mutator( &regexCache );
+            size_t i;
+            while ( !failed && ( i = nextFile++ ) < paths.size() ) {
+                try {
+                    warnings[i] = mutateFile( i, mutator );
+                } catch ( ... ) {
+                    failed = true;  // the other workers stop after their current file
+                    std::lock_guard<std::mutex> lock( failureMutex );
+                    if ( !firstFailure ) {
+                        firstFailure = std::current_exception();
+                        failedPath = paths[i];
+                    }
+                }
+            }
+        } );
+    }
+
+    pool.wait();
+    if ( firstFailure ) {
+        std::cerr << "Failed to mutate \'" << sanitizeOutputMessage( failedPath ) << "\'" << std::endl;
+        std::rethrow_exception( firstFailure );
+    }
+
+    size_t filesWithWarnings = 0;
+    for ( size_t i = 0; i < paths.size(); ++i ) {
+        if ( warnings[i].size() ) {
+            ++filesWithWarnings;
+            if ( opts->wantsVerboseOutput() ) {
+                std::cerr << paths[i] << ":" << warnings[i];
+            }
+        }
+    }
+    return filesWithWarnings;
+}
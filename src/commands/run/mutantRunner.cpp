@@ -0,0 +1,379 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutantRunner.cpp: Runs a build and test command against a batch of mutant trees in parallel, for the run command
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/run/mutantRunner.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <sstream>
+#include <utility>
+
+#include "common.hpp"
+#include "excepts.hpp"
+#include "iohelpers.hpp"
+#include "pipelineStats.hpp"
+#include "threadPool.hpp"
+#include "traceRecorder.hpp"
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+// How long a command is waited on at most before checking for a stop request again
+static constexpr int STOP_CHECK_MS = 100;
+
+static std::string readFile( const std::filesystem::path& path ) {
+    std::ifstream file( path, std::ios::binary );
+    if ( !file ) {
+        throw IOErrorException( sanitizeOutputMessage( "Unable to read \'" + path.string() + "\'" ) );
+    }
+    return std::string{ std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() };
+}
+
+void MutantRunner::requestStop() { stopRequested = 1; }
+
+MutantRunner::MutantRunner( const std::filesystem::path& _projectRoot, std::string _command, size_t jobs,
+                            std::uint64_t _timeLimitNs, const std::string& killPatternStr, bool hardlinks,
+                            bool _verbose, const std::filesystem::path& workDir )
+    : projectRoot{ _projectRoot },
+      workspaceBuilder{ _projectRoot, hardlinks },
+      command{ std::move( _command ) },
+      timeLimitNs{ _timeLimitNs },
+      verbose{ _verbose } {
+    if ( killPatternStr.size() ) {
+        killPattern = RegexEngine::compile( killPatternStr );
+    }
+
+    // next to the project rather than in the temporary directory, which is often another file system (tmpfs)
+    std::filesystem::path workParent =
+        workDir.empty() ? std::filesystem::weakly_canonical( projectRoot ).parent_path() : workDir;
+    std::string workTemplate = ( workParent / ".mutateplaceholder-run-XXXXXX" ).string();
+    if ( !mkdtemp( workTemplate.data() ) ) {
+        throw IOErrorException( sanitizeOutputMessage( "Unable to create a directory for the workspaces in \'" +
+                                                       workParent.string() + "\': " + std::strerror( errno ) +
+                                                       ". Give one on the project's file system with --work-dir" ) );
+    }
+    workRoot = workTemplate;
+
+    try {
+        for ( size_t i = 0; i < jobs; ++i ) {
+            workspaces.push_back( workRoot / std::to_string( i + 1 ) );
+            workspaceBuilder.materialize( workspaces.back() );
+        }
+    } catch ( ... ) {
+        std::error_code ignored;
+        std::filesystem::remove_all( workRoot, ignored );
+        throw;
+    }
+
+    struct stat projectStat, workStat;
+    if ( stat( projectRoot.c_str(), &projectStat ) == 0 && stat( workRoot.c_str(), &workStat ) == 0 &&
+         projectStat.st_dev != workStat.st_dev ) {
+        workspaceWarning = "The workspaces in \'" + workParent.string() +
+                           "\' are on another file system than the project, so the project was copied into every one "
+                           "of them. Give a directory on the project's file system with --work-dir";
+    }
+    else if ( workspaceBuilder.getLinkError() ) {
+        workspaceWarning = std::string( "Hardlinks into the workspaces were turned down (" ) +
+                           std::strerror( workspaceBuilder.getLinkError() ) +
+                           "), so the project's files were copied instead";
+    }
+    if ( verbose ) {
+        std::cerr << "Workspaces made of " << workspaceBuilder.getClonedFiles() << " cloned, "
+                  << workspaceBuilder.getLinkedFiles() << " hardlinked and " << workspaceBuilder.getCopiedFiles()
+                  << " copied files" << std::endl;
+    }
+}
+
+MutantRunner::~MutantRunner() {
+    std::error_code ignored;
+    std::filesystem::remove_all( workRoot, ignored );
+}
+
+std::vector<std::filesystem::path> MutantRunner::layOver( const std::filesystem::path& mutantDir,
+                                                          const std::filesystem::path& workspace ) const {
+    std::vector<std::filesystem::path> changed;
+    for ( const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator( mutantDir ) ) {
+        if ( !entry.is_regular_file() ) {
+            continue;
+        }
+        std::filesystem::path relative = entry.path().lexically_relative( mutantDir );
+        std::filesystem::path original = projectRoot / relative;
+        std::string mutant = readFile( entry.path() );
+        std::error_code ec;
+        if ( std::filesystem::file_size( original, ec ) == mutant.size() && !ec && readFile( original ) == mutant ) {
+            continue;  // left as it was, rewriting it would only make the build redo it
+        }
+        std::filesystem::create_directories( ( workspace / relative ).parent_path() );
+        WorkspaceBuilder::replaceFile( workspace / relative, mutant );
+        changed.push_back( std::move( relative ) );
+    }
+    return changed;
+}
+
+void MutantRunner::restore( const std::vector<std::filesystem::path>& changed,
+                            const std::filesystem::path& workspace ) {
+    for ( const std::filesystem::path& relative : changed ) {
+        if ( std::filesystem::exists( projectRoot / relative ) ) {
+            workspaceBuilder.restore( relative, workspace );
+        }
+        else {
+            std::filesystem::remove( workspace / relative );  // the mutant added it
+        }
+    }
+}
+
+// The first complete line of output from lineStart on that matches killPattern, with lineStart moved past the lines
+// looked at. False when none does
+static bool findKillingLine( const std::string& output, size_t& lineStart, const RegexEngine& killPattern,
+                             RegexScratch& scratch, std::string& line ) {
+    size_t newline;
+    while ( ( newline = output.find( '\n', lineStart ) ) != std::string::npos ) {
+        line.assign( output, lineStart, newline - lineStart );
+        lineStart = newline + 1;
+        if ( killPattern.search( line, 0, 0, scratch ) == RegexEngine::Found::MATCH ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MutantResult MutantRunner::runCommand( const std::string& command, const std::filesystem::path& dir,
+                                       std::uint64_t timeLimitNs, const RegexEngine* killPattern ) {
+    int fds[2];
+    // close on exec so that the commands other jobs start at the same time do not hold this pipe open
+    if ( pipe2( fds, O_CLOEXEC ) < 0 ) {
+        throw IOErrorException( std::string( "Unable to create a pipe for the test command: " ) +
+                                std::strerror( errno ) );
+    }
+
+    std::uint64_t startNs = statsClockNs();
+    pid_t pid = fork();
+    if ( pid < 0 ) {
+        close( fds[0] );
+        close( fds[1] );
+        throw IOErrorException( std::string( "Unable to start the test command: " ) + std::strerror( errno ) );
+    }
+    if ( !pid ) {
+        // only async-signal-safe calls until exec, the other threads may have held locks at the fork
+        setpgid( 0, 0 );
+        int devNull = open( "/dev/null", O_RDONLY );
+        if ( devNull < 0 || dup2( devNull, STDIN_FILENO ) < 0 || dup2( fds[1], STDOUT_FILENO ) < 0 ||
+             dup2( fds[1], STDERR_FILENO ) < 0 || chdir( dir.c_str() ) < 0 ) {
+            _exit( 127 );
+        }
+        execl( "/bin/sh", "sh", "-c", command.c_str(), static_cast<char*>( nullptr ) );
+        _exit( 127 );
+    }
+    setpgid( pid, pid );  // in the parent too, so that killing the group cannot come before the child made it
+    close( fds[1] );
+
+    MutantResult result;
+    bool stopped = false;
+    bool exited = false;
+    int status = 0;
+    int outputFd = fds[0];
+    std::string output;
+    size_t lineStart = 0;
+    RegexScratch scratch;
+    char buffer[IO_BUFF_SIZE];
+    while ( !exited ) {
+        int waitMs = STOP_CHECK_MS;
+        std::uint64_t elapsedNs = statsClockNs() - startNs;
+        if ( timeLimitNs ) {
+            if ( timeLimitNs <= elapsedNs ) {
+                result.outcome = MutantOutcome::TIMEOUT;
+                stopped = true;
+                break;
+            }
+            std::uint64_t leftMs = ( timeLimitNs - elapsedNs + 999999 ) / 1000000;
+            waitMs = static_cast<int>( std::min<std::uint64_t>( waitMs, leftMs ) );
+        }
+        if ( stopRequested ) {
+            stopped = true;
+            break;
+        }
+
+        if ( outputFd < 0 ) {
+            // the output was closed, only the exit is left to wait for
+            pid_t waited = waitpid( pid, &status, WNOHANG );
+            if ( waited == pid ) {
+                exited = true;
+            }
+            else {
+                usleep( 1000 );
+            }
+            continue;
+        }
+
+        pollfd readable{ outputFd, POLLIN, 0 };
+        if ( poll( &readable, 1, waitMs ) <= 0 ) {
+            continue;  // EINTR included
+        }
+        ssize_t got = read( outputFd, buffer, sizeof( buffer ) );
+        if ( got < 0 && errno == EINTR ) {
+            continue;
+        }
+        if ( got <= 0 ) {
+            if ( killPattern && lineStart < output.size() ) {
+                output.push_back( '\n' );  // the last line did not end with one
+                if ( findKillingLine( output, lineStart, *killPattern, scratch, result.killingLine ) ) {
+                    result.outcome = MutantOutcome::KILLED;
+                    stopped = true;
+                    break;
+                }
+            }
+            close( outputFd );
+            outputFd = -1;
+            continue;
+        }
+        if ( killPattern ) {
+            // only the lines not looked at yet are kept
+            output.erase( 0, lineStart );
+            lineStart = 0;
+            output.append( buffer, got );
+            if ( findKillingLine( output, lineStart, *killPattern, scratch, result.killingLine ) ) {
+                result.outcome = MutantOutcome::KILLED;
+                stopped = true;
+                break;
+            }
+        }
+    }
+
+    // whatever the command started in the background does not outlive it either
+    kill( -pid, SIGKILL );
+    if ( outputFd >= 0 ) {
+        close( outputFd );
+    }
+    if ( !exited ) {
+        while ( waitpid( pid, &status, 0 ) < 0 && errno == EINTR ) {
+        }
+    }
+    result.durationNs = statsClockNs() - startNs;
+
+    if ( stopped ) {
+        result.exitStatus = -1;
+        return result;
+    }
+    result.exitStatus = WIFEXITED( status ) ? WEXITSTATUS( status ) : 128 + WTERMSIG( status );
+    result.outcome = result.exitStatus ? MutantOutcome::KILLED : MutantOutcome::SURVIVED;
+    return result;
+}
+
+void MutantRunner::runBaseline() {
+    std::vector<MutantResult> results( workspaces.size() );
+    {
+        ThreadPool pool( workspaces.size() );
+        for ( size_t i = 0; i < workspaces.size(); ++i ) {
+            pool.submit( [this, &results, i]() {
+                TraceSpan span( "baseline", "mutant" );
+                results[i] = runCommand( command, workspaces[i], 0, killPattern.get() );
+            } );
+        }
+        pool.wait();
+    }
+    if ( stopRequested ) {
+        throw IOErrorException( "Interrupted while running the test command on the project" );
+    }
+    workspaceBuilder.checkLinkedFiles();
+
+    for ( const MutantResult& result : results ) {
+        if ( result.outcome == MutantOutcome::SURVIVED ) {
+            continue;
+        }
+        std::ostringstream os;
+        os << "The test command has to succeed on the project before it can tell mutants apart, but ";
+        if ( result.killingLine.size() ) {
+            os << "a line of its output matches --kill-pattern: " << result.killingLine;
+        }
+        else {
+            os << "it exited with status " << result.exitStatus;
+        }
+        throw IOErrorException( sanitizeOutputMessage( os.str() ) );
+    }
+}
+
+std::vector<MutantResult> MutantRunner::run( const std::vector<std::string>& mutantDirs ) {
+    std::vector<MutantResult> results( mutantDirs.size() );
+    std::atomic<size_t> nextMutant{ 0 };
+    std::atomic<bool> failed{ false };
+    std::mutex failureMutex;
+    std::exception_ptr firstFailure;
+    std::string failedMutant;
+
+    ThreadPool pool( std::max<size_t>( 1, std::min( workspaces.size(), mutantDirs.size() ) ) );
+    for ( size_t worker = 0; worker < pool.size(); ++worker ) {
+        pool.submit( [&, worker]() {
+            const std::filesystem::path& workspace = workspaces[worker];
+            size_t i;
+            while ( !failed && !stopRequested && ( i = nextMutant++ ) < mutantDirs.size() ) {
+                try {
+                    TraceSpan span( "mutant", "mutant", static_cast<std::int64_t>( i ) );
+                    std::vector<std::filesystem::path> changed = layOver( mutantDirs[i], workspace );
+                    if ( changed.empty() ) {
+                        continue;  // the project itself, which the baseline showed to pass
+                    }
+                    results[i] = runCommand( command, workspace, timeLimitNs, killPattern.get() );
+                    results[i].changedFiles = changed.size();
+                    workspaceBuilder.checkLinkedFiles();
+                    restore( changed, workspace );
+                    if ( verbose ) {
+                        static const char* const outcomeNames[] = { "killed", "survived", "timed out" };
+                        std::ostringstream os;
+                        os << sanitizeOutputMessage( mutantDirs[i] ) << ": "
+                           << outcomeNames[static_cast<int>( results[i].outcome )] << '\n';
+                        std::cerr << os.str();
+                    }
+                } catch ( ... ) {
+                    failed = true;  // the other workers stop after their current mutant
+                    std::lock_guard<std::mutex> lock( failureMutex );
+                    if ( !firstFailure ) {
+                        firstFailure = std::current_exception();
+                        failedMutant = mutantDirs[i];
+                    }
+                }
+            }
+        } );
+    }
+
+    pool.wait();
+    if ( firstFailure ) {
+        std::cerr << "Failed to run mutant \'" << sanitizeOutputMessage( failedMutant ) << "\'" << std::endl;
+        std::rethrow_exception( firstFailure );
+    }
+    if ( stopRequested ) {
+        throw IOErrorException( "Interrupted while running the mutants" );
+    }
+    return results;
+}
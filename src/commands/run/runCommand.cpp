@@ -0,0 +1,188 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * runCommand.cpp: The main.cpp of running the tests against mutants
+ *
+ * - This can be thought of as a self-contained subprogram within the larger mutation program
+ * - Every positional argument after run is a mutant: a directory laid out like --tree, as mutate --tree writes them
+ to --output-dir, holding the files that differ from the project
+ * - The test command is first run on the project itself, which has to pass, then on every mutant in a pool of --jobs
+ workspaces. SIGINT/SIGTERM stop the commands running and clean up the workspaces
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/run/runCommand.hpp"
+
+#include <signal.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <sstream>
+
+#include "commands/mutate/pcreRegex.hpp"
+#include "excepts.hpp"
+#include "threadPool.hpp"
+#include "traceRecorder.hpp"
+
+static void onStopSignal(int) { MutantRunner::requestStop(); }
+
+std::string printRunHelp(const char *indent) {
+    std::ostringstream ss;
+    //              "--version                "
+    ss << indent << "    --tree=DIR           The project the mutants were made from, copied into every workspace\n";
+    ss << indent
+       << "    --test-command=CMD   Builds and tests the project from its root, with /bin/sh. A mutant is killed when "
+          "it fails\n";
+    ss << indent
+       << "    --kill-pattern=REGEX Kill the mutant as soon as a line of the test output matches REGEX, without "
+          "waiting for the rest of the tests\n";
+    ss << indent
+       << "-j, --jobs=NUMBER        Number of mutants run at once, each in a workspace of its own. Defaults to the "
+          "number of hardware threads\n";
+    ss << indent
+       << "    --time-limit=MS      A mutant whose test command is still running after MS milliseconds times out\n";
+    ss << indent
+       << "    --hardlink           Hardlink the project's files into the workspaces where they cannot be cloned, "
+          "instead of copying them. The run stops if the test command rewrites one in place\n";
+    ss << indent
+       << "    --work-dir=DIR       Where to make the workspaces, on the project's file system. Defaults to the "
+          "directory holding --tree\n";
+    ss << indent << "    --trace=FILE         Write a Chrome/Perfetto trace of the baseline and every mutant to FILE\n";
+    ss << indent
+       << "  NOTE: every argument after run is a mutant, a directory laid out like --tree as mutate --output-dir "
+          "writes them\n";
+
+    return ss.str();
+};
+
+std::string printRunHelp(std::string indent) { return printRunHelp(indent.c_str()); }
+
+std::string printRunHelp(void) { return printRunHelp(""); }
+
+void validateRunArgs(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
+    if (opts->hasSeed()) throw InvalidArgumentException("Cannot use the --seed/--read-seed options in run mode");
+    if (opts->hasMutCount()) throw InvalidArgumentException("Cannot use the --count option in run mode");
+    if (opts->hasMinMutCount()) throw InvalidArgumentException("Cannot use the --min-count option in run mode");
+    if (opts->hasMaxMutCount()) throw InvalidArgumentException("Cannot use the --max-count option in run mode");
+    if (opts->hasFormat()) throw InvalidArgumentException("Cannot use the --format option in run mode");
+    if (opts->hasSocketPath()) throw InvalidArgumentException("Cannot use the --socket option in run mode");
+    if (opts->hasStats()) throw InvalidArgumentException("Cannot use the --stats option in run mode");
+    if (opts->wantsHardwareCounters())
+        throw InvalidArgumentException("Cannot use the --hw-counters option in run mode");
+    if (opts->wantsStreaming()) throw InvalidArgumentException("Cannot use the --stream option in run mode");
+    if (opts->wantsSchemata()) throw InvalidArgumentException("Cannot use the --schemata option in run mode");
+    if (opts->hasDescriptor() || opts->descriptorNeedsExporting())
+        throw InvalidArgumentException("Cannot use the --apply or --write-descriptor options in run mode");
+    if (opts->hasRegexLimits())
+        throw InvalidArgumentException("Cannot use the --regex-*-limit options in run mode");
+    if (opts->wantsJobsFromStdin())
+        throw InvalidArgumentException("Cannot use the --jobs-from-stdin option in run mode");
+    if (opts->hasLanguage()) throw InvalidArgumentException("Cannot use the --language option in run mode");
+    if (opts->hasMatchMode()) throw InvalidArgumentException("Cannot use the --match option in run mode");
+    if (opts->hasInputFileName() || opts->hasTsvFile())
+        throw InvalidArgumentException("Cannot use the --input or --mutations options in run mode");
+    if (opts->hasFileListName() || opts->hasOutputDirName() || opts->getGlobs().size())
+        throw InvalidArgumentException("Cannot use the --file-list, --output-dir or --glob options in run mode");
+
+    if (!opts->hasTreeRoot())
+        throw InvalidArgumentException("run mode needs the project the mutants come from, given with --tree");
+    if (!opts->hasTestCommand())
+        throw InvalidArgumentException(
+            "run mode needs the command that builds and tests the project, given with --test-command");
+    if (nonpositionals->size() < 2)
+        throw InvalidArgumentException("run mode needs at least one mutant directory after run");
+    for (size_t i = 1; i < nonpositionals->size(); ++i) {
+        if (!std::filesystem::is_directory((*nonpositionals)[i])) {
+            std::ostringstream os;
+            os << "Mutant directory \'" << (*nonpositionals)[i] << "\' was not found.";
+            throw IOErrorException(sanitizeOutputMessage(os.str()));
+        }
+    }
+
+    if (opts->hasKillPattern()) {
+        jp::Regex killPattern(opts->getKillPattern());
+        if (!killPattern) {
+            throw InvalidArgumentException(sanitizeOutputMessage("--kill-pattern does not compile: " +
+                                                                 killPattern.getErrorMessage()));
+        }
+    }
+
+    if (opts->hasOutputFileName()) {
+        const char *path = opts->getOutputFileName();
+        if (std::filesystem::exists(path) && !opts->okToOverwriteOutputFile()) {
+            std::ostringstream os;
+            os << "Output file \'" << path << "\' already exists. Use \'-F\' to force overwrite.";
+            throw IOErrorException(sanitizeOutputMessage(os.str()));
+        }
+        opts->setResOutput(path);
+    }
+    else if (opts->okToOverwriteOutputFile()) {
+        throw InvalidArgumentException("Option --force invalid when no output file is specified.");
+    }
+}
+
+std::string getRunReport(const std::vector<std::string> &mutantDirs, const std::vector<MutantResult> &results) {
+    static const char *const outcomeNames[] = {"killed", "survived", "timeout"};
+    std::ostringstream os;
+    size_t counts[3] = {0, 0, 0};
+    for (size_t i = 0; i < results.size(); ++i) {
+        const MutantResult &result = results[i];
+        ++counts[static_cast<int>(result.outcome)];
+        os << outcomeNames[static_cast<int>(result.outcome)] << '\t' << std::fixed << std::setprecision(3)
+           << result.durationNs / 1e9 << '\t' << sanitizeOutputMessage(mutantDirs[i]);
+        if (result.killingLine.size()) {
+            os << '\t' << sanitizeOutputMessage(result.killingLine);
+        }
+        os << '\n';
+    }
+
+    size_t detected =
+        counts[static_cast<int>(MutantOutcome::KILLED)] + counts[static_cast<int>(MutantOutcome::TIMEOUT)];
+    os << results.size() << " mutants: " << counts[static_cast<int>(MutantOutcome::KILLED)] << " killed, "
+       << counts[static_cast<int>(MutantOutcome::SURVIVED)] << " survived, "
+       << counts[static_cast<int>(MutantOutcome::TIMEOUT)] << " timed out. Mutation score " << std::setprecision(1)
+       << (results.size() ? 100.0 * detected / results.size() : 0.0) << "%";
+    return os.str();
+}
+
+void doRunAction(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
+    std::vector<std::string> mutantDirs(nonpositionals->begin() + 1, nonpositionals->end());
+    size_t jobs = opts->hasJobs() ? opts->getJobs() : ThreadPool::hardwareThreads();
+    std::uint64_t timeLimitNs = opts->hasTimeLimit() ? static_cast<std::uint64_t>(opts->getTimeLimit()) * 1000000 : 0;
+
+    struct sigaction stopAction;
+    std::memset(&stopAction, 0, sizeof(stopAction));
+    stopAction.sa_handler = onStopSignal;
+    sigaction(SIGINT, &stopAction, nullptr);
+    sigaction(SIGTERM, &stopAction, nullptr);
+
+    MutantRunner runner(opts->getTreeRoot(), opts->getTestCommand(), std::min(jobs, mutantDirs.size()),
+                        timeLimitNs, opts->hasKillPattern() ? opts->getKillPattern() : "", opts->wantsHardlinks(),
+                        opts->wantsVerboseOutput(), opts->hasWorkDirName() ? opts->getWorkDirName() : "");
+    if (runner.getWorkspaceWarning().size()) opts->addWarning(runner.getWorkspaceWarning());
+    runner.runBaseline();
+    std::vector<MutantResult> results = runner.run(mutantDirs);
+    opts->putResOutput(getRunReport(mutantDirs, results));
+}
+
+ParseArgvStatusCode execRun(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
+    validateRunArgs(opts, nonpositionals);
+    if (opts->hasTraceFileName()) TraceRecorder::start(opts->getTraceFileName());
+    doRunAction(opts, nonpositionals);
+    return ParseArgvStatusCode::SUCCESS;
+}
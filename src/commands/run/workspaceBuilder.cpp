@@ -0,0 +1,213 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * workspaceBuilder.cpp: Makes the workspaces of the run command out of the project tree without copying its files
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/run/workspaceBuilder.hpp"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>  // FICLONE
+#endif
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include "common.hpp"
+#include "excepts.hpp"
+
+static IOErrorException ioError( const std::string& what, const std::filesystem::path& path, int error ) {
+    return IOErrorException( sanitizeOutputMessage( what + " \'" + path.string() + "\': " + std::strerror( error ) ) );
+}
+
+// Where a file is written before it is renamed over path
+static std::filesystem::path scratchPathOf( const std::filesystem::path& path ) {
+    std::filesystem::path scratch = path;
+    scratch += ".mutateplaceholder-new";
+    return scratch;
+}
+
+// Sets the modification time of to to that of from, to the nanosecond as ninja compares them
+static void keepModificationTime( const std::filesystem::path& from, const std::filesystem::path& to ) {
+    struct stat st;
+    if ( stat( from.c_str(), &st ) < 0 ) {
+        throw ioError( "Unable to read the modification time of", from, errno );
+    }
+    struct timespec times[2] = { { 0, UTIME_OMIT }, st.st_mtim };
+    if ( utimensat( AT_FDCWD, to.c_str(), times, 0 ) < 0 ) {
+        throw ioError( "Unable to set the modification time of", to, errno );
+    }
+}
+
+bool WorkspaceBuilder::clone( const std::filesystem::path& from, const std::filesystem::path& to ) {
+#ifdef FICLONE
+    if ( !canClone ) {
+        return false;
+    }
+    int source = open( from.c_str(), O_RDONLY | O_CLOEXEC );
+    if ( source < 0 ) {
+        return false;  // the copy that is tried next reports it
+    }
+    struct stat st;
+    int target = fstat( source, &st ) < 0 ? -1 : open( to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600 );
+    bool cloned = target >= 0 && ioctl( target, FICLONE, source ) == 0 && fchmod( target, st.st_mode & 07777 ) == 0;
+    int error = errno;
+    close( source );
+    if ( target >= 0 ) {
+        close( target );
+        if ( !cloned ) {
+            unlink( to.c_str() );
+        }
+    }
+    if ( cloned ) {
+        ++clonedFiles;
+    }
+    else if ( target >= 0 && ( error == EOPNOTSUPP || error == ENOTTY || error == EXDEV || error == EINVAL ) ) {
+        canClone = false;  // this file system, or this pair of them, has no reflinks
+    }
+    return cloned;
+#else
+    (void)from;
+    (void)to;
+    return false;
+#endif
+}
+
+bool WorkspaceBuilder::hardlink( const std::filesystem::path& from, const std::filesystem::path& to ) {
+    if ( !canLink ) {
+        return false;
+    }
+    if ( link( from.c_str(), to.c_str() ) < 0 ) {
+        int error = errno;
+        if ( error == EXDEV || error == EPERM ) {
+            canLink = false;  // another file system, or one that refuses hardlinks
+            linkError = error;
+        }
+        return false;
+    }
+    ++linkedFiles;  // shares the modification time with the project's file
+    struct stat st;
+    if ( stat( from.c_str(), &st ) < 0 ) {
+        throw ioError( "Unable to read the modification time of", from, errno );
+    }
+    linked.emplace( from.lexically_relative( projectRoot ), FileStamp{ st.st_size, st.st_mtim } );
+    return true;
+}
+
+void WorkspaceBuilder::copy( const std::filesystem::path& from, const std::filesystem::path& to ) {
+    std::error_code ec;
+    if ( !std::filesystem::copy_file( from, to, ec ) ) {
+        throw ioError( "Unable to copy", from, ec.value() );
+    }
+    ++copiedFiles;
+}
+
+void WorkspaceBuilder::materialize( const std::filesystem::path& workspace ) {
+    std::error_code ec;
+    if ( !std::filesystem::create_directory( workspace, ec ) ) {
+        throw ioError( "Unable to create the workspace", workspace, ec ? ec.value() : EEXIST );
+    }
+    std::filesystem::recursive_directory_iterator it( projectRoot, ec );
+    for ( ; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment( ec ) ) {
+        const std::filesystem::directory_entry& entry = *it;
+        std::filesystem::path target = workspace / entry.path().lexically_relative( projectRoot );
+        if ( entry.is_symlink( ec ) ) {
+            std::filesystem::copy_symlink( entry.path(), target, ec );
+        }
+        else if ( entry.is_directory( ec ) ) {
+            std::filesystem::create_directory( target, ec );
+        }
+        else if ( entry.is_regular_file( ec ) ) {
+            if ( clone( entry.path(), target ) ) {
+                keepModificationTime( entry.path(), target );
+            }
+            else if ( !hardlink( entry.path(), target ) ) {
+                copy( entry.path(), target );
+                keepModificationTime( entry.path(), target );
+            }
+        }
+        if ( ec ) {
+            throw ioError( "Unable to recreate", entry.path(), ec.value() );
+        }
+    }
+    if ( ec ) {
+        throw ioError( "Unable to list the files of", projectRoot, ec.value() );
+    }
+}
+
+void WorkspaceBuilder::checkLinkedFiles() const {
+    for ( const auto& [relative, stamp] : linked ) {
+        struct stat st;
+        if ( stat( ( projectRoot / relative ).c_str(), &st ) == 0 && st.st_size == stamp.size &&
+             st.st_mtim.tv_sec == stamp.modificationTime.tv_sec &&
+             st.st_mtim.tv_nsec == stamp.modificationTime.tv_nsec ) {
+            continue;
+        }
+        throw IOErrorException( sanitizeOutputMessage(
+            "The test command rewrote \'" + relative.string() +
+            "\' in place, which is hardlinked to the project: the project itself was changed. Restore it and run "
+            "again without --hardlink" ) );
+    }
+}
+
+void WorkspaceBuilder::restore( const std::filesystem::path& relative, const std::filesystem::path& workspace ) {
+    std::filesystem::path target = workspace / relative;
+    std::filesystem::path scratch = scratchPathOf( target );
+    unlink( scratch.c_str() );
+    if ( !clone( projectRoot / relative, scratch ) ) {
+        copy( projectRoot / relative, scratch );
+    }
+    if ( rename( scratch.c_str(), target.c_str() ) < 0 ) {
+        int error = errno;
+        unlink( scratch.c_str() );
+        throw ioError( "Unable to restore", target, error );
+    }
+}
+
+void WorkspaceBuilder::replaceFile( const std::filesystem::path& path, const std::string& contents ) {
+    struct stat st;
+    mode_t mode = stat( path.c_str(), &st ) == 0 ? st.st_mode & 07777 : 0644;
+    std::filesystem::path scratch = scratchPathOf( path );
+    int fd = open( scratch.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600 );
+    if ( fd < 0 ) {
+        throw ioError( "Unable to write", scratch, errno );
+    }
+    size_t written = 0;
+    while ( written < contents.size() ) {
+        ssize_t got = write( fd, contents.data() + written, contents.size() - written );
+        if ( got < 0 && errno == EINTR ) {
+            continue;
+        }
+        if ( got <= 0 ) {
+            break;
+        }
+        written += got;
+    }
+    bool failed = written < contents.size() || fchmod( fd, mode ) < 0;
+    int error = errno;
+    failed = close( fd ) < 0 || failed;
+    if ( failed || rename( scratch.c_str(), path.c_str() ) < 0 ) {
+        error = failed ? error : errno;
+        unlink( scratch.c_str() );
+        throw ioError( "Unable to write", path, error );
+    }
+}
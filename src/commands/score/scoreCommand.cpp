@@ -48,20 +48,47 @@ void validateScoreArgs(CLIOptions *opts, std::vector<std::string> *nonpositional
     if (opts->hasMinMutCount()) throw InvalidArgumentException("Cannot use the --min-count option in score mode");
     if (opts->hasMaxMutCount()) throw InvalidArgumentException("Cannot use the --max-count option in score mode");
     if (opts->hasFormat()) throw InvalidArgumentException("Cannot use the --format option in score mode");
+    if (opts->hasSocketPath()) throw InvalidArgumentException("Cannot use the --socket option in score mode");
+    if (opts->hasStats()) throw InvalidArgumentException("Cannot use the --stats option in score mode");
+    if (opts->wantsHardwareCounters())
+        throw InvalidArgumentException("Cannot use the --hw-counters option in score mode");
+    if (opts->wantsStreaming())
+        throw InvalidArgumentException("Cannot use the --stream option in score mode");
+    if (opts->wantsSchemata())
+        throw InvalidArgumentException("Cannot use the --schemata option in score mode");
+    if (opts->hasDescriptor() || opts->descriptorNeedsExporting())
+        throw InvalidArgumentException("Cannot use the --apply or --write-descriptor options in score mode");
+    if (opts->hasRegexLimits() || opts->hasTimeLimit())
+        throw InvalidArgumentException("Cannot use the --regex-*-limit or --time-limit options in score mode");
+    if (opts->wantsJobsFromStdin())
+        throw InvalidArgumentException("Cannot use the --jobs-from-stdin option in score mode");
+    if (opts->hasTraceFileName()) throw InvalidArgumentException("Cannot use the --trace option in score mode");
+    if (opts->hasLanguage()) throw InvalidArgumentException("Cannot use the --language option in score mode");
+    if (opts->hasMatchMode()) throw InvalidArgumentException("Cannot use the --match option in score mode");
+    if (opts->hasTreeOptions())
+        throw InvalidArgumentException(
+            "Cannot use the --tree, --file-list, --output-dir, --glob or --jobs options in score mode");
+    if (opts->hasRunOptions())
+        throw InvalidArgumentException(
+            "Cannot use the --test-command, --kill-pattern, --hardlink or --work-dir options in score mode");
     if (1 < nonpositionals->size())
         throw InvalidArgumentException("score mode does not accept extra non-positional arguments");
 
     // NOTE: this is the place to do file parsing and file syntax validation
 }
 
-void doScoreAction(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
+std::string getScoreReport(const std::string &srcString) {
     // TODO: actually do stuff here
+    (void)srcString;  // silence unused warnings
+
+    return "100% of code is mutated properly...0/0 mutations fulfilled or something...Just make this text look pretty and "
+           "functional and colored when implementing this";
+}
+
+void doScoreAction(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
     (void)nonpositionals;  // silence unused warnings
 
-    opts->getSrcString();  // ensure we read the file or stdin
-    opts->putResOutput(
-        "100% of code is mutated properly...0/0 mutations fulfilled or something...Just make this text look pretty and "
-        "functional and colored when implementing this");
+    opts->putResOutput(getScoreReport(opts->getSrcString()));
 }
 
 ParseArgvStatusCode execScore(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
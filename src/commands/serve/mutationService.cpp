@@ -0,0 +1,80 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutationService.cpp: Answers serve requests while keeping parsed inputs warm in memory
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/serve/mutationService.hpp"
+
+#include <exception>
+#include <sstream>
+
+#include "commands/score/scoreCommand.hpp"
+#include "commands/validate/validateCommand.hpp"
+#include "excepts.hpp"
+#include "traceRecorder.hpp"
+
+ServeResponse MutationService::handle( const ServeRequest& request ) {
+    TraceSpan span( "request", "request" );
+    ServeResponse response;
+
+    try {
+        switch ( request.op ) {
+            case ServeOp::MUTATE: {
+                MutateOptions options;
+                options.seed = request.seed;
+                options.count = request.count;
+                options.minCount = request.minCount;
+                options.maxCount = request.maxCount;
+                options.language = request.language.size() ? request.language : defaultLanguage;
+                options.matchTokens = matchTokens;
+
+                MutateResult result = engine.mutate( request.src, request.tsv, options );
+                response.output = std::move( result.mutant );
+                response.seed = std::move( result.seed );
+                response.warnings = std::move( result.warnings );
+                return response;
+            }
+            case ServeOp::VALIDATE:
+                engine.getPossibleMutations( request.tsv );
+                response.output = getValidateReport( request.tsv );
+                return response;
+            case ServeOp::SCORE:
+                response.output = getScoreReport( engine.getStrippedSrc(
+                    request.src, SourceLexer::get( request.language.size() ? request.language : defaultLanguage ) ) );
+                return response;
+            case ServeOp::PING:
+            case ServeOp::SHUTDOWN:
+                return response;
+        }
+
+        std::ostringstream os;
+        os << "Unknown request op " << static_cast<int>( request.op );
+        throw InvalidArgumentException( os.str() );
+    } catch ( const TSVParsingException& ex ) {
+        response.output = std::string( "Error parsing TSV file\n" ) + ex.what();
+    } catch ( const InvalidSeedException& ex ) {
+        response.output = std::string( "Error processing seed\n" ) + ex.what();
+    } catch ( const InvalidArgumentException& ex ) {
+        response.output = std::string( "Error processing arguments\n" ) + ex.what();
+    } catch ( const std::exception& ex ) {
+        response.output = std::string( "Error " ) + ex.what();
+    }
+
+    response.status = ServeStatus::ERROR;
+    return response;
+}
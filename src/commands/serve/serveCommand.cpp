@@ -0,0 +1,236 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * serveCommand.cpp: The main.cpp of the mutation daemon
+ *
+ * - This can be thought of as a self-contained subprogram within the larger mutation program
+ * - Listens on a Unix domain socket and answers framed requests (see serveProtocol.hpp) one connection at a time
+ * - A connection may send any number of requests. A SHUTDOWN request or SIGINT/SIGTERM stops the daemon
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/serve/serveCommand.hpp"
+
+#include <errno.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include "commands/serve/mutationService.hpp"
+#include "commands/serve/serveProtocol.hpp"
+#include "excepts.hpp"
+#include "traceRecorder.hpp"
+
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void onStopSignal(int) { stopRequested = 1; }
+
+std::string printServeHelp(const char *indent) {
+    std::ostringstream ss;
+    //              "--version                "
+    ss << indent << "    --socket=PATH        Unix domain socket to listen on for mutate, validate and score requests\n";
+    ss << indent
+       << "    --jobs-from-stdin    Read the requests from stdin and write the responses to stdout instead of using "
+          "--socket\n";
+    ss << indent
+       << "    --trace=FILE         Write a Chrome/Perfetto trace of every request, mutant and row to this file on "
+          "shutdown\n";
+    ss << indent << "    --language=NAME      Language of sources in requests that do not name one. Defaults to cpp\n";
+    ss << indent
+       << "    --match=MODE         How plain patterns of mutate requests are matched, text (default) or tokens\n";
+    ss << indent
+       << "-F, --force              Replace a stale socket file left at PATH. Defaults to aborting if PATH exists\n";
+
+    return ss.str();
+};
+
+std::string printServeHelp(std::string indent) { return printServeHelp(indent.c_str()); }
+
+std::string printServeHelp(void) { return printServeHelp(""); }
+
+void validateServeArgs(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
+    if (opts->hasSeed()) throw InvalidArgumentException("Cannot use the --seed/--read-seed options in serve mode");
+    if (opts->hasMutCount()) throw InvalidArgumentException("Cannot use the --count option in serve mode");
+    if (opts->hasMinMutCount()) throw InvalidArgumentException("Cannot use the --min-count option in serve mode");
+    if (opts->hasMaxMutCount()) throw InvalidArgumentException("Cannot use the --max-count option in serve mode");
+    if (opts->hasFormat()) throw InvalidArgumentException("Cannot use the --format option in serve mode");
+    if (opts->hasOutputFileName()) throw InvalidArgumentException("Cannot use the --output option in serve mode");
+    if (opts->hasStats()) throw InvalidArgumentException("Cannot use the --stats option in serve mode");
+    if (opts->hasTreeOptions())
+        throw InvalidArgumentException(
+            "Cannot use the --tree, --file-list, --output-dir, --glob or --jobs options in serve mode");
+    if (opts->wantsHardwareCounters())
+        throw InvalidArgumentException("Cannot use the --hw-counters option in serve mode");
+    if (opts->wantsStreaming())
+        throw InvalidArgumentException("Cannot use the --stream option in serve mode");
+    if (opts->wantsSchemata())
+        throw InvalidArgumentException("Cannot use the --schemata option in serve mode");
+    if (opts->hasDescriptor() || opts->descriptorNeedsExporting())
+        throw InvalidArgumentException("Cannot use the --apply or --write-descriptor options in serve mode");
+    if (opts->hasRegexLimits() || opts->hasTimeLimit())
+        throw InvalidArgumentException("Cannot use the --regex-*-limit or --time-limit options in serve mode");
+    if (opts->hasRunOptions())
+        throw InvalidArgumentException(
+            "Cannot use the --test-command, --kill-pattern, --hardlink or --work-dir options in serve mode");
+    if (1 < nonpositionals->size())
+        throw InvalidArgumentException("serve mode does not accept extra non-positional arguments");
+
+    if (opts->wantsJobsFromStdin()) {
+        if (opts->hasSocketPath())
+            throw InvalidArgumentException("options --socket and --jobs-from-stdin are mutually exclusive");
+        if (opts->okToOverwriteOutputFile())
+            throw InvalidArgumentException("Option --force invalid together with --jobs-from-stdin");
+        return;
+    }
+    if (!opts->hasSocketPath())
+        throw InvalidArgumentException("serve mode requires the --socket=PATH or the --jobs-from-stdin option");
+
+    const char *path = opts->getSocketPath();
+    if (sizeof(sockaddr_un::sun_path) <= std::strlen(path)) {
+        throw InvalidArgumentException("Socket path given to --socket is too long");
+    }
+    if (std::filesystem::exists(std::filesystem::symlink_status(path))) {
+        if (!opts->okToOverwriteOutputFile()) {
+            std::ostringstream os;
+            os << "Socket file \'" << path << "\' already exists. Use \'-F\' to force overwrite.";
+            throw IOErrorException(sanitizeOutputMessage(os.str()));
+        }
+        if (!std::filesystem::is_socket(path)) {
+            std::ostringstream os;
+            os << "Refusing to replace \'" << path << "\' as it is not a socket.";
+            throw IOErrorException(sanitizeOutputMessage(os.str()));
+        }
+        unlink(path);
+    }
+}
+
+// Fills in the TSV of a request that only names its id, or keeps the TSV of one that names both
+static void resolveTsvId(ServeRequest &request, std::unordered_map<std::uint32_t, std::string> &tsvsById) {
+    if (!request.tsvId) return;
+    if (request.tsv.size()) {
+        tsvsById[request.tsvId] = request.tsv;
+        return;
+    }
+    auto found = tsvsById.find(request.tsvId);
+    if (found == tsvsById.end()) {
+        std::ostringstream os;
+        os << "No TSV was sent with id " << request.tsvId << " earlier in the stream";
+        throw InvalidArgumentException(os.str());
+    }
+    request.tsv = found->second;
+}
+
+bool serveStream(int inFd, int outFd, MutationService &service) {
+    std::string body;
+    std::unordered_map<std::uint32_t, std::string> tsvsById;  // parsed TSVs themselves stay cached in service
+
+    while (!stopRequested && readFrame(inFd, body)) {
+        ServeRequest request;
+        ServeResponse response;
+        try {
+            request = decodeRequest(body);
+            resolveTsvId(request, tsvsById);
+            response = service.handle(request);
+        } catch (const IOErrorException &ex) {
+            response.status = ServeStatus::ERROR;
+            response.output = std::string("I/O error\n") + ex.what();
+        } catch (const InvalidArgumentException &ex) {
+            response.status = ServeStatus::ERROR;
+            response.output = std::string("Error processing arguments\n") + ex.what();
+        }
+        writeFrame(outFd, encodeResponse(response));
+
+        if (request.op == ServeOp::SHUTDOWN) return false;
+    }
+    return true;
+}
+
+void doServeAction(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
+    (void)nonpositionals;  // silence unused warnings
+
+    if (opts->wantsJobsFromStdin()) {
+        signal(SIGPIPE, SIG_IGN);  // a harness closing stdout early gets an I/O error instead
+        MutationService service(opts->getLexer().getName(), opts->getMatchMode() == MatchMode::TOKENS);
+        serveStream(STDIN_FILENO, STDOUT_FILENO, service);
+        return;
+    }
+
+    const char *path = opts->getSocketPath();
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) throw IOErrorException("Unable to create the serve socket");
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listenFd, 16) < 0) {
+        close(listenFd);
+        std::ostringstream os;
+        os << "Unable to listen on socket \'" << path << "\': " << std::strerror(errno);
+        throw IOErrorException(sanitizeOutputMessage(os.str()));
+    }
+
+    // no SA_RESTART so that accept() returns with EINTR and we get to clean up the socket file
+    struct sigaction stopAction;
+    std::memset(&stopAction, 0, sizeof(stopAction));
+    stopAction.sa_handler = onStopSignal;
+    sigaction(SIGINT, &stopAction, nullptr);
+    sigaction(SIGTERM, &stopAction, nullptr);
+    signal(SIGPIPE, SIG_IGN);  // a client hanging up mid response must not kill the daemon
+
+    if (opts->wantsVerboseOutput()) {
+        std::cerr << "Listening for requests on " << sanitizeOutputMessage(path) << std::endl;
+    }
+
+    MutationService service(opts->getLexer().getName(), opts->getMatchMode() == MatchMode::TOKENS);
+    bool keepServing = true;
+    while (keepServing && !stopRequested) {
+        int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+
+        try {
+            keepServing = serveStream(clientFd, clientFd, service);
+        } catch (const IOErrorException &ex) {
+            // only this connection is broken, keep serving the others
+            if (opts->wantsVerboseOutput()) {
+                std::cerr << "Dropping connection: " << ex.what() << std::endl;
+            }
+        }
+        close(clientFd);
+    }
+
+    close(listenFd);
+    unlink(path);
+}
+
+ParseArgvStatusCode execServe(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
+    validateServeArgs(opts, nonpositionals);
+    if (opts->hasTraceFileName()) TraceRecorder::start(opts->getTraceFileName());
+    doServeAction(opts, nonpositionals);
+    // stdout holds the response frames when serving stdin
+    return opts->wantsJobsFromStdin() ? ParseArgvStatusCode::SUCCESS_QUIET : ParseArgvStatusCode::SUCCESS;
+}
@@ -0,0 +1,173 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * serveProtocol.cpp: The compact framed protocol spoken by the serve command
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/serve/serveProtocol.hpp"
+
+#include <sstream>
+
+#include "excepts.hpp"
+#include "iohelpers.hpp"
+
+void FrameWriter::putU8( std::uint8_t value ) { body.push_back( static_cast<char>( value ) ); }
+
+void FrameWriter::putU32( std::uint32_t value ) {
+    for ( int shift = 24; shift >= 0; shift -= 8 ) {
+        body.push_back( static_cast<char>( ( value >> shift ) & 0xFF ) );
+    }
+}
+
+void FrameWriter::putI32( std::int32_t value ) { putU32( static_cast<std::uint32_t>( value ) ); }
+
+void FrameWriter::putU64( std::uint64_t value ) {
+    putU32( static_cast<std::uint32_t>( value >> 32 ) );
+    putU32( static_cast<std::uint32_t>( value ) );
+}
+
+void FrameWriter::putStr( std::string_view str ) {
+    putU32( static_cast<std::uint32_t>( str.size() ) );
+    body.append( str.data(), str.size() );
+}
+
+void FrameReader::need( std::size_t size ) const {
+    if ( body.size() - pos < size ) {
+        throw IOErrorException( "Truncated frame received" );
+    }
+}
+
+std::uint8_t FrameReader::getU8() {
+    need( 1 );
+    return static_cast<std::uint8_t>( body[pos++] );
+}
+
+std::uint32_t FrameReader::getU32() {
+    need( 4 );
+    std::uint32_t value = 0;
+    for ( int i = 0; i < 4; ++i ) {
+        value = ( value << 8 ) | static_cast<std::uint8_t>( body[pos++] );
+    }
+    return value;
+}
+
+std::int32_t FrameReader::getI32() { return static_cast<std::int32_t>( getU32() ); }
+
+std::uint64_t FrameReader::getU64() {
+    std::uint64_t high = getU32();
+    return ( high << 32 ) | getU32();
+}
+
+std::string FrameReader::getStr() {
+    std::uint32_t size = getU32();
+    need( size );
+    std::string str( body.substr( pos, size ) );
+    pos += size;
+    return str;
+}
+
+bool readFrame( int fd, std::string& body ) {
+    char header[4];
+    if ( !readExactFromFd( fd, header, sizeof( header ) ) ) {
+        return false;
+    }
+
+    std::uint32_t size = FrameReader( std::string_view( header, sizeof( header ) ) ).getU32();
+    if ( size > SERVE_MAX_FRAME_SIZE ) {
+        std::ostringstream os;
+        os << "Frame of " << size << " bytes exceeds the maximum frame size of " << SERVE_MAX_FRAME_SIZE << " bytes";
+        throw IOErrorException( os.str() );
+    }
+
+    body.resize( size );
+    if ( size && !readExactFromFd( fd, body.data(), size ) ) {
+        throw IOErrorException( "Unexpected EOF in the middle of a frame" );
+    }
+    return true;
+}
+
+void writeFrame( int fd, const std::string& body ) {
+    FrameWriter header;
+    header.putU32( static_cast<std::uint32_t>( body.size() ) );
+    writeAllToFd( fd, header.getBody().data(), header.getBody().size() );
+    writeAllToFd( fd, body.data(), body.size() );
+}
+
+static void checkVersion( std::uint8_t version ) {
+    if ( version != SERVE_PROTOCOL_VERSION ) {
+        std::ostringstream os;
+        os << "Unsupported protocol version " << static_cast<int>( version ) << ", expected "
+           << static_cast<int>( SERVE_PROTOCOL_VERSION );
+        throw IOErrorException( os.str() );
+    }
+}
+
+std::string encodeRequest( const ServeRequest& request ) {
+    FrameWriter writer;
+    writer.putU8( SERVE_PROTOCOL_VERSION );
+    writer.putU8( static_cast<std::uint8_t>( request.op ) );
+    writer.putI32( request.count );
+    writer.putI32( request.minCount );
+    writer.putI32( request.maxCount );
+    writer.putStr( request.seed );
+    writer.putStr( request.src );
+    writer.putStr( request.tsv );
+    writer.putStr( request.language );
+    writer.putU32( request.tsvId );
+    return writer.getBody();
+}
+
+ServeRequest decodeRequest( const std::string& body ) {
+    FrameReader reader( body );
+    ServeRequest request;
+    checkVersion( reader.getU8() );
+    request.op = static_cast<ServeOp>( reader.getU8() );
+    request.count = reader.getI32();
+    request.minCount = reader.getI32();
+    request.maxCount = reader.getI32();
+    request.seed = reader.getStr();
+    request.src = reader.getStr();
+    request.tsv = reader.getStr();
+    if ( !reader.atEnd() ) {
+        request.language = reader.getStr();
+    }
+    if ( !reader.atEnd() ) {
+        request.tsvId = reader.getU32();
+    }
+    return request;
+}
+
+std::string encodeResponse( const ServeResponse& response ) {
+    FrameWriter writer;
+    writer.putU8( SERVE_PROTOCOL_VERSION );
+    writer.putU8( static_cast<std::uint8_t>( response.status ) );
+    writer.putStr( response.seed );
+    writer.putStr( response.output );
+    writer.putStr( response.warnings );
+    return writer.getBody();
+}
+
+ServeResponse decodeResponse( const std::string& body ) {
+    FrameReader reader( body );
+    ServeResponse response;
+    checkVersion( reader.getU8() );
+    response.status = static_cast<ServeStatus>( reader.getU8() );
+    response.seed = reader.getStr();
+    response.output = reader.getStr();
+    response.warnings = reader.getStr();
+    return response;
+}
@@ -0,0 +1,450 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * sourceLexer.cpp: Per-language lexers splitting a source into a token stream
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "commands/sourceLexer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <sstream>
+
+#include "excepts.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static constexpr std::size_t MAX_RAW_DELIMITER = 16;  // as in the C++ standard
+
+// clang-format off
+static const LexerRules BUILTIN_RULES[] = {
+    // name, extensions, lineComment, stringPrefixes,
+    // blockComments, lineSplicing, characterLiterals, digitSeparators, rawStrings, tripleQuotedStrings,
+    // backtickStrings, backtickEscapes, regexLiterals
+    {"cpp", ".h .cc .cpp .cxx .c++ .C .hh .hpp .hxx .h++ .ipp .inl .tpp", "//", "u8 u U L R u8R uR UR LR",
+     true, true, true, true, true, false, false, false, false},
+    {"c", ".c", "//", "u8 u U L",
+     true, true, true, true, false, false, false, false, false},
+    {"java", ".java", "//", "",
+     true, false, true, false, false, true, false, false, false},
+    {"javascript", ".js .mjs .cjs .jsx", "//", "",
+     true, false, false, false, false, false, true, true, true},
+    {"typescript", ".ts .mts .cts .tsx", "//", "",
+     true, false, false, false, false, false, true, true, true},
+    {"python", ".py .pyi .pyw", "#", "r R b B f F u U br bR Br BR rb rB Rb RB fr fR Fr FR rf rF Rf RF",
+     false, false, false, false, false, true, false, false, false},
+    {"go", ".go", "//", "",
+     true, false, true, false, false, false, true, false, false},
+};
+// clang-format on
+
+// Deque so that references handed out stay valid when languages are added
+static std::deque<SourceLexer>& registry() {
+    static std::deque<SourceLexer> lexers(std::begin(BUILTIN_RULES), std::end(BUILTIN_RULES));
+    return lexers;
+}
+
+// Returns the first of the COUNT characters in chars found in [p, end), or end
+template <std::size_t COUNT>
+static const char* findFirstOf(const char* p, const char* end, const char* chars) {
+#ifdef __SSE2__
+    __m128i needles[COUNT];
+    for (std::size_t i = 0; i < COUNT; ++i) needles[i] = _mm_set1_epi8(chars[i]);
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hits = _mm_cmpeq_epi8(chunk, needles[0]);
+        for (std::size_t i = 1; i < COUNT; ++i) hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, needles[i]));
+        int mask = _mm_movemask_epi8(hits);
+        if (mask) return p + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+#endif
+    for (; p < end; ++p) {
+        for (std::size_t i = 0; i < COUNT; ++i) {
+            if (*p == chars[i]) return p;
+        }
+    }
+    return end;
+}
+
+// The above for a count only known at run time, which is at most 5
+static const char* findFirstOf(const char* p, const char* end, const char* chars, std::size_t count) {
+    switch (count) {
+        case 1: return findFirstOf<1>(p, end, chars);
+        case 2: return findFirstOf<2>(p, end, chars);
+        case 3: return findFirstOf<3>(p, end, chars);
+        case 4: return findFirstOf<4>(p, end, chars);
+        default: return findFirstOf<5>(p, end, chars);
+    }
+}
+
+static bool isIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '$' ||
+           static_cast<unsigned char>(c) >= 0x80;
+}
+
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+// Start of the identifier (or number) ending right before pos
+static std::size_t identifierStart(std::string_view src, std::size_t pos) {
+    while (pos && isIdentifierChar(src[pos - 1])) --pos;
+    return pos;
+}
+
+// Past the closing quote, or at the line break (unless multiline) or end of an unterminated literal. leftOff, when
+// given, is set to where to carry on from when src ends first: past the last escape, or at it when src ends within it
+static std::size_t skipQuoted(std::string_view src, std::size_t pos, char quote, bool escapes, bool multiline,
+                              std::size_t* leftOff = nullptr) {
+    const char stops[3] = {quote, escapes ? '\\' : quote, multiline ? quote : '\n'};
+    const char* end = src.data() + src.size();
+    const char* p = src.data() + pos;
+    while ((p = findFirstOf<3>(p, end, stops)) != end) {
+        if (*p == quote) return p + 1 - src.data();
+        if (*p == '\n') return p - src.data();
+        if (leftOff && p + 1 == end) {
+            *leftOff = p - src.data();
+            return src.size();
+        }
+        p = p + 2 < end ? p + 2 : end;  // escaped character
+    }
+    if (leftOff) *leftOff = src.size();
+    return src.size();
+}
+
+// 1'000'000 or 0xFF'FF, the quote is inside a number which unlike the u8 of u8'a' starts with a digit
+static bool isDigitSeparator(std::string_view src, std::size_t pos) {
+    std::size_t start = pos;
+    while (start && (isIdentifierChar(src[start - 1]) || src[start - 1] == '\'' || src[start - 1] == '.')) --start;
+    return start < pos && isDigit(src[start]) && pos + 1 < src.size() && isIdentifierChar(src[pos + 1]);
+}
+
+// Whether a / at pos starts a regex rather than dividing, i.e. an operand is expected there
+static bool regexAllowed(std::string_view src, std::size_t pos) {
+    static const char* const keywords[] = {"return", "typeof", "instanceof", "in",    "of",    "new",  "delete",
+                                           "void",   "throw",  "case",       "yield", "await", "else", "do"};
+    while (pos && isSpace(src[pos - 1])) --pos;
+    if (!pos) return true;
+
+    char previous = src[pos - 1];
+    if (previous == ')' || previous == ']' || previous == '}' || previous == '"' || previous == '\'' ||
+        previous == '`') {
+        return false;
+    }
+    if (!isIdentifierChar(previous)) return true;
+
+    std::string_view word = src.substr(identifierStart(src, pos), pos - identifierStart(src, pos));
+    for (const char* keyword : keywords) {
+        if (word == keyword) return true;
+    }
+    return false;
+}
+
+SourceLexer::SourceLexer(const LexerRules& _rules) : rules{_rules}, stopChars{}, stopCharCount{0} {
+    auto addStopChar = [this](char c) {
+        if (!std::memchr(stopChars, c, stopCharCount)) stopChars[stopCharCount++] = c;
+    };
+    if (rules.lineComment) addStopChar(rules.lineComment[0]);
+    if (rules.blockComments || rules.regexLiterals) addStopChar('/');
+    addStopChar('"');
+    addStopChar('\'');
+    if (rules.backtickStrings) addStopChar('`');
+}
+
+bool SourceLexer::startsLineComment(std::string_view src, std::size_t pos) const {
+    return rules.lineComment && src[pos] == rules.lineComment[0] &&
+           src.compare(pos, std::strlen(rules.lineComment), rules.lineComment) == 0;
+}
+
+std::size_t SourceLexer::lineCommentEnd(std::string_view src, std::size_t pos, std::size_t from,
+                                        std::size_t* leftOff) const {
+    std::size_t lineBreak = src.find('\n', std::max(pos, from));
+    while (lineBreak != std::string_view::npos && rules.lineSplicing) {
+        std::size_t last = lineBreak && src[lineBreak - 1] == '\r' ? lineBreak - 1 : lineBreak;
+        if (!last || src[last - 1] != '\\') break;
+        lineBreak = src.find('\n', lineBreak + 1);
+    }
+    if (lineBreak == std::string_view::npos) {
+        if (leftOff) *leftOff = src.size();  // the line breaks before it were all spliced
+        return src.size();
+    }
+    return src[lineBreak - 1] == '\r' ? lineBreak - 1 : lineBreak;  // the \r of \r\n belongs to the line break
+}
+
+std::size_t SourceLexer::blockCommentEnd(std::string_view src, std::size_t pos, std::size_t from,
+                                         std::size_t* leftOff) const {
+    std::size_t close = src.find("*/", std::max(pos + 2, from));
+    if (close != std::string_view::npos) return close + 2;
+    if (leftOff) *leftOff = std::max(pos + 2, src.size() - 1);  // the * may be the last character
+    return src.size();
+}
+
+// Whether src ends within what starting at pos, i.e. whether more of src could still make it start there
+static bool endsWithin(std::string_view src, std::size_t pos, std::string_view what) {
+    return src.size() - pos < what.size() && what.compare(0, src.size() - pos, src.substr(pos)) == 0;
+}
+
+std::size_t SourceLexer::literalEnd(std::string_view src, std::size_t quotePos, bool raw, std::size_t from,
+                                    std::size_t* leftOff) const {
+    char quote = src[quotePos];
+    if (raw) {
+        // only a ( right after a delimiter makes it raw, so the search does not need to go any further
+        std::size_t open = src.substr(0, quotePos + MAX_RAW_DELIMITER + 2).find('(', quotePos + 1);
+        if (open != std::string_view::npos) {
+            std::string closing = ")";
+            closing.append(src.data() + quotePos + 1, open - quotePos - 1);
+            closing.push_back('"');
+            std::size_t close = src.find(closing, std::max(open + 1, from));
+            if (close != std::string_view::npos) return close + closing.size();
+            if (leftOff) *leftOff = std::max(open + 1, src.size() + 1 - std::min(src.size() + 1, closing.size()));
+            return src.size();
+        }
+        if (leftOff && quotePos + MAX_RAW_DELIMITER + 2 > src.size()) {
+            *leftOff = 0;  // the ( may be yet to come
+            return src.size();
+        }
+    }
+    if (quote == '`') return skipQuoted(src, std::max(quotePos + 1, from), quote, rules.backtickEscapes, true, leftOff);
+
+    std::string_view tripleQuote = quote == '"' ? "\"\"\"" : "'''";
+    bool tripleAllowed = rules.tripleQuotedStrings && (quote == '"' || !rules.characterLiterals);
+    if (leftOff && tripleAllowed && endsWithin(src, quotePos, tripleQuote)) {
+        *leftOff = 0;  // "" may be an empty string or the start of a triple quote
+        return src.size();
+    }
+    bool triple = tripleAllowed && src.compare(quotePos, 3, tripleQuote) == 0;
+    if (!triple) return skipQuoted(src, std::max(quotePos + 1, from), quote, true, false, leftOff);
+
+    std::size_t pos = std::max(quotePos + 3, from);
+    std::size_t ranOut = std::string_view::npos;
+    while ((pos = skipQuoted(src, pos, quote, true, true, leftOff ? &ranOut : nullptr)) < src.size()) {
+        if (src.compare(pos, 2, tripleQuote.substr(1)) == 0) return pos + 2;
+        if (leftOff && endsWithin(src, pos, tripleQuote.substr(1))) break;
+    }
+    // carry on from the last quote when src ends within what may close the literal
+    if (leftOff) *leftOff = ranOut != std::string_view::npos ? ranOut : pos - 1;
+    return src.size();
+}
+
+std::size_t SourceLexer::regexLiteralEnd(std::string_view src, std::size_t pos, bool* ranOut) const {
+    bool inClass = false;
+    for (++pos; pos < src.size(); ++pos) {
+        char c = src[pos];
+        if (c == '\n') break;
+        if (c == '\\') {
+            ++pos;
+        }
+        else if (c == '[') {
+            inClass = true;
+        }
+        else if (c == ']') {
+            inClass = false;
+        }
+        else if (c == '/' && !inClass) {
+            for (++pos; pos < src.size() && isIdentifierChar(src[pos]);) ++pos;  // flags
+            if (ranOut && pos == src.size()) break;
+            return pos;
+        }
+    }
+    if (ranOut && pos >= src.size()) *ranOut = true;  // the closing / or flags may be yet to come
+    return std::string_view::npos;  // no closing / on the line, a division after all
+}
+
+bool SourceLexer::isStringPrefix(std::string_view identifier) const {
+    std::string_view prefixes = rules.stringPrefixes ? rules.stringPrefixes : "";
+    while (prefixes.size()) {
+        std::size_t space = prefixes.find(' ');
+        if (prefixes.substr(0, space) == identifier) return true;
+        prefixes = space == std::string_view::npos ? std::string_view() : prefixes.substr(space + 1);
+    }
+    return false;
+}
+
+template <bool ALL_TOKENS, bool LITERALS>
+TokenStream SourceLexer::scan(std::string_view src, LexerResume* resume) const {
+    if (src.size() > std::numeric_limits<std::uint32_t>::max()) {
+        // tokens hold 32 bit offsets, which would wrap around and point at the wrong text
+        throw InvalidArgumentException("Sources of 4 GiB or more cannot be lexed");
+    }
+    TokenStream tokens;
+    auto push = [&tokens](std::size_t start, std::size_t end, TokenKind kind) {
+        tokens.push_back({static_cast<std::uint32_t>(start), static_cast<std::uint32_t>(end - start), kind});
+    };
+    auto literalKind = [this](char quote) {
+        return quote == '\'' && rules.characterLiterals ? TokenKind::CHARACTER : TokenKind::STRING;
+    };
+
+    const char* base = src.data();
+    const char* end = base + src.size();
+    std::size_t pos = resume ? resume->pos : 0;
+    std::size_t resumedAt = pos;
+    std::size_t resumeFrom = resume ? resume->searchFrom : 0;  // for the token at resumedAt only
+    std::size_t stoppedAt = std::string_view::npos;  // with resume, the start of what more of src could change
+    std::size_t leftOff = std::string_view::npos;    // and where to look for its end from then
+    std::size_t* leftOffOut = resume ? &leftOff : nullptr;
+    bool regexRanOut = false;
+    while (pos < src.size()) {
+        if constexpr (!ALL_TOKENS) {
+            pos = findFirstOf(base + pos, end, stopChars, stopCharCount) - base;
+            if (pos == src.size()) break;
+        }
+
+        char c = src[pos];
+        std::size_t start = pos;
+        if (resume && (pos + 1 == src.size() ||
+                       (rules.lineComment && c == rules.lineComment[0] &&
+                        pos + std::strlen(rules.lineComment) > src.size()))) {
+            stoppedAt = start;  // what a quote or / at the end starts depends on what comes next
+            break;
+        }
+        if (startsLineComment(src, pos)) {
+            pos = lineCommentEnd(src, pos, start == resumedAt ? resumeFrom : 0, leftOffOut);
+            if (leftOff != std::string_view::npos) {
+                stoppedAt = start;
+                break;
+            }
+            push(start, pos, TokenKind::COMMENT);
+        }
+        else if (c == '/' && rules.blockComments && pos + 1 < src.size() && src[pos + 1] == '*') {
+            pos = blockCommentEnd(src, pos, start == resumedAt ? resumeFrom : 0, leftOffOut);
+            if (leftOff != std::string_view::npos) {
+                stoppedAt = start;
+                break;
+            }
+            push(start, pos, TokenKind::COMMENT);
+        }
+        else if (c == '"' || c == '\'' || (c == '`' && rules.backtickStrings)) {
+            if (!ALL_TOKENS && c == '\'' && rules.digitSeparators && isDigitSeparator(src, pos)) {
+                ++pos;  // tokenize() takes separators in as part of the number
+                continue;
+            }
+            std::size_t prefixStart = identifierStart(src, pos);
+            bool prefixed = prefixStart < pos && isStringPrefix(src.substr(prefixStart, pos - prefixStart));
+            if (prefixed) start = prefixStart;
+            pos = literalEnd(src, pos, prefixed && rules.rawStrings && c == '"' && src[pos - 1] == 'R',
+                             start == resumedAt ? resumeFrom : 0, leftOffOut);
+            if (leftOff != std::string_view::npos) {
+                stoppedAt = start;
+                break;
+            }
+            if constexpr (LITERALS) push(start, pos, literalKind(c));
+        }
+        else if (c == '/' && rules.regexLiterals && regexAllowed(src, pos) &&
+                 regexLiteralEnd(src, pos, resume ? &regexRanOut : nullptr) != std::string_view::npos) {
+            pos = regexLiteralEnd(src, pos);
+            if constexpr (LITERALS) push(start, pos, TokenKind::STRING);
+        }
+        else if (regexRanOut) {
+            stoppedAt = start;  // a regex or a division, depending on what comes next
+            break;
+        }
+        else if constexpr (!ALL_TOKENS) {
+            ++pos;
+        }
+        else if (isSpace(c)) {
+            ++pos;
+        }
+        else if (isDigit(c) || (c == '.' && pos + 1 < src.size() && isDigit(src[pos + 1]))) {
+            // a preprocessing number: 0x1F, 1.5e-3f, 1'000
+            for (++pos; pos < src.size(); ++pos) {
+                char n = src[pos];
+                bool exponentSign = (n == '+' || n == '-') && std::strchr("eEpP", src[pos - 1]);
+                bool separator = n == '\'' && rules.digitSeparators && pos + 1 < src.size() &&
+                                 isIdentifierChar(src[pos + 1]);
+                if (!isIdentifierChar(n) && n != '.' && !exponentSign && !separator) break;
+            }
+            push(start, pos, TokenKind::NUMBER);
+        }
+        else if (isIdentifierChar(c)) {
+            while (pos < src.size() && isIdentifierChar(src[pos])) ++pos;
+            if (pos < src.size() && (src[pos] == '"' || src[pos] == '\'') &&
+                isStringPrefix(src.substr(start, pos - start))) {
+                continue;  // u8"..." or r'...', the literal picks the prefix up
+            }
+            push(start, pos, TokenKind::IDENTIFIER);
+        }
+        else {
+            push(start, ++pos, TokenKind::PUNCTUATION);
+        }
+    }
+    if (resume) {
+        resume->pos = stoppedAt != std::string_view::npos ? stoppedAt : src.size();
+        resume->searchFrom = leftOff != std::string_view::npos ? leftOff : 0;
+    }
+    return tokens;
+}
+
+TokenStream SourceLexer::tokenize(std::string_view src) const { return scan<true>(src); }
+
+TokenStream SourceLexer::findComments(std::string_view src) const { return scan<false>(src); }
+
+TokenStream SourceLexer::findCommentsAndLiterals(std::string_view src) const { return scan<false, true>(src); }
+
+TokenStream SourceLexer::findCommentsAndLiterals(std::string_view src, LexerResume& resume) const {
+    return scan<false, true>(src, &resume);
+}
+
+const SourceLexer& SourceLexer::get(const std::string& name) {
+    for (const SourceLexer& lexer : registry()) {
+        if (name == lexer.getName()) return lexer;
+    }
+    std::ostringstream os;
+    os << "Unknown language \"" << name << "\", expected one of " << getNames();
+    throw InvalidArgumentException(os.str());
+}
+
+const SourceLexer& SourceLexer::forPath(const std::string& path) {
+    std::size_t dot = path.find_last_of("./");
+    if (dot != std::string::npos && path[dot] == '.') {
+        std::string_view extension = std::string_view(path).substr(dot);
+        for (const SourceLexer& lexer : registry()) {
+            std::string_view extensions = lexer.rules.extensions;
+            for (std::size_t found = extensions.find(extension); found != std::string_view::npos;
+                 found = extensions.find(extension, found + 1)) {
+                std::size_t after = found + extension.size();
+                if (after == extensions.size() || extensions[after] == ' ') return lexer;
+            }
+        }
+    }
+    return getDefault();
+}
+
+const SourceLexer& SourceLexer::getDefault() { return registry().front(); }
+
+void SourceLexer::add(const LexerRules& rules) {
+    for (SourceLexer& lexer : registry()) {
+        if (!std::strcmp(lexer.getName(), rules.name)) {
+            lexer = SourceLexer(rules);
+            return;
+        }
+    }
+    registry().emplace_back(rules);
+}
+
+std::string SourceLexer::getNames() {
+    std::string names;
+    for (const SourceLexer& lexer : registry()) {
+        if (names.size()) names.append(", ");
+        names.append(lexer.getName());
+    }
+    return names;
+}
@@ -48,20 +48,47 @@ void validateValidateArgs(CLIOptions *opts, std::vector<std::string> *nonpositio
     if (opts->hasMinMutCount()) throw InvalidArgumentException("Cannot use the --min-count option in validate mode");
     if (opts->hasMaxMutCount()) throw InvalidArgumentException("Cannot use the --max-count option in validate mode");
     if (opts->hasFormat()) throw InvalidArgumentException("Cannot use the --format option in validate mode");
+    if (opts->hasSocketPath()) throw InvalidArgumentException("Cannot use the --socket option in validate mode");
+    if (opts->hasStats()) throw InvalidArgumentException("Cannot use the --stats option in validate mode");
+    if (opts->wantsHardwareCounters())
+        throw InvalidArgumentException("Cannot use the --hw-counters option in validate mode");
+    if (opts->wantsStreaming())
+        throw InvalidArgumentException("Cannot use the --stream option in validate mode");
+    if (opts->wantsSchemata())
+        throw InvalidArgumentException("Cannot use the --schemata option in validate mode");
+    if (opts->hasDescriptor() || opts->descriptorNeedsExporting())
+        throw InvalidArgumentException("Cannot use the --apply or --write-descriptor options in validate mode");
+    if (opts->hasRegexLimits() || opts->hasTimeLimit())
+        throw InvalidArgumentException("Cannot use the --regex-*-limit or --time-limit options in validate mode");
+    if (opts->wantsJobsFromStdin())
+        throw InvalidArgumentException("Cannot use the --jobs-from-stdin option in validate mode");
+    if (opts->hasTraceFileName()) throw InvalidArgumentException("Cannot use the --trace option in validate mode");
+    if (opts->hasLanguage()) throw InvalidArgumentException("Cannot use the --language option in validate mode");
+    if (opts->hasMatchMode()) throw InvalidArgumentException("Cannot use the --match option in validate mode");
+    if (opts->hasTreeOptions())
+        throw InvalidArgumentException(
+            "Cannot use the --tree, --file-list, --output-dir, --glob or --jobs options in validate mode");
+    if (opts->hasRunOptions())
+        throw InvalidArgumentException(
+            "Cannot use the --test-command, --kill-pattern, --hardlink or --work-dir options in validate mode");
     if (1 < nonpositionals->size())
         throw InvalidArgumentException("validate mode does not accept extra non-positional arguments");
 
     // NOTE: this is the place to do file parsing and file syntax validation
 }
 
-void doValidateAction(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
+std::string getValidateReport(const std::string &tsvString) {
     // TODO: actually do stuff here
+    (void)tsvString;  // silence unused warnings
+
+    return "100% of mutations match source code lines...0/0 mutations do match or something...Just make this text look "
+           "pretty and functional and colored when implementing this";
+}
+
+void doValidateAction(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
     (void)nonpositionals;  // silence unused warnings
 
-    opts->getTsvString();  // ensure we read the file or stdin
-    opts->putResOutput(
-        "100% of mutations match source code lines...0/0 mutations do match or something...Just make this text look "
-        "pretty and functional and colored when implementing this");
+    opts->putResOutput(getValidateReport(opts->getTsvString()));
 }
 
 ParseArgvStatusCode execValidate(CLIOptions *opts, std::vector<std::string> *nonpositionals) {
@@ -105,4 +105,42 @@ size_t lastNonWhiteSpace(std::string::iterator begin, std::string::iterator end)
             return index;
     }
     return std::string::npos;  // for compiler
-}
\ No newline at end of file
+}
+
+// 64 bit FNV-1a, see http://www.isthe.com/chongo/tech/comp/fnv/
+std::uint64_t hashBytes(const char* data, std::size_t size) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<std::uint8_t>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::uint64_t hashBytes(const std::string& str) { return hashBytes(str.data(), str.size()); }
+
+// The blanks that start the line pos is on
+static std::string lineIndentation(const std::string& subject, std::size_t pos) {
+    std::size_t lineStart = pos ? subject.rfind('\n', pos - 1) + 1 : 0;  // npos + 1 == 0
+    std::size_t indentEnd = lineStart;
+    while (indentEnd < subject.size() && (subject[indentEnd] == ' ' || subject[indentEnd] == '\t')) {
+        ++indentEnd;
+    }
+    return subject.substr(lineStart, indentEnd - lineStart);
+}
+
+std::string indentReplacement(const std::string& subject, std::size_t pos, const std::string& replacement,
+                              bool isNewLined) {
+    std::string indent = lineIndentation(subject, pos);
+    std::string text = isNewLined ? indent : std::string();
+    for (std::size_t lineStart = 0; lineStart < replacement.size();) {
+        std::size_t lineEnd = replacement.find('\n', lineStart);
+        lineEnd = lineEnd == std::string::npos ? replacement.size() : lineEnd + 1;
+        if (lineStart && lineEnd > lineStart + 1) {
+            text += indent;
+        }
+        text.append(replacement, lineStart, lineEnd - lineStart);
+        lineStart = lineEnd;
+    }
+    return text;
+}
@@ -25,7 +25,10 @@
 #include "iohelpers.hpp"
 
 #include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
@@ -33,77 +36,77 @@
 
 #include "excepts.hpp"
 
-// helper method for reading a whole file into a std::string
+// helper method for reading a whole file into a std::string, straight into its storage which grows geometrically.
+// Regular files are read in a single allocation, one byte larger than the file so that its end is seen
 std::string readWholeFileIntoString(std::FILE *handle, const char *errMsg) {
-    char buffer[IO_BUFF_SIZE];
     std::string fileContents;
+    std::size_t size = 0;
+
+    struct stat status;
+    if (fstat(fileno(handle), &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0) {
+        fileContents.resize(static_cast<std::size_t>(status.st_size) + 1);
+    }
 
     while (!feof(handle)) {
-        size_t readN = fread((void *)buffer, 1, IO_BUFF_SIZE, handle);
+        if (fileContents.size() == size) {
+            fileContents.resize(std::max(2 * fileContents.size(), size + IO_BUFF_SIZE));
+        }
+        size_t readN = fread((void *)(fileContents.data() + size), 1, fileContents.size() - size, handle);
         int err = ferror(handle);
         if ((readN == 0 && !feof(handle)) || (err != EOK && err != EAGAIN)) {
             throw IOErrorException(errMsg);
-            return std::string("", 0);
         }
-
-        fileContents.append(buffer, readN);
+        size += readN;
     }
 
+    fileContents.resize(size);
     return fileContents;
 }
 
-// helper method for reading stdin up to a deliminator line or EOF
-void readStdinLinesIntoOptionalString(char *deliminator, std::optional<std::string> *output) {
-    char buffTmp[IO_BUFF_SIZE + 16];  // = {0};
-    int err = 0;
-
-    while (!feof(stdin)) {
-        if (nullptr == std::fgets(buffTmp, IO_BUFF_SIZE + 1, stdin)) {
-            err = ferror(stdin);
-            if (err == EAGAIN) continue;
-            if (feof(stdin)) break;
-            throw IOErrorException("I/O error reading from stdin");
-        }
-
-        if (0 == std::strcmp(deliminator, buffTmp)) {
-            break;
-        }
-
-        if (!output->has_value()) {
-            output->emplace(buffTmp);
-        }
-        else {
-            output->value().append(buffTmp);
-        }
+// The first line of input that is exactly line (line break included) from pos on, npos if there is none
+static std::size_t findLine(std::string_view input, std::string_view line, std::size_t pos) {
+    while (pos < input.size()) {
+        const void *found = memmem(input.data() + pos, input.size() - pos, line.data(), line.size());
+        if (!found) break;
+        std::size_t at = static_cast<const char *>(found) - input.data();
+        if (!at || input[at - 1] == '\n') return at;
+        pos = at + 1;
     }
+    return std::string_view::npos;
+}
 
-    err = ferror(stdin);
-    if (err != EOK && err != EAGAIN) {
-        throw IOErrorException("I/O error reading from stdin");
-    }
+bool splitSrcTsvInput(std::string_view input, std::string_view *src, std::string_view *tsv) {
+    std::size_t lineBreak = input.find('\n');
+    if (lineBreak == std::string_view::npos) return false;
+    std::string_view deliminator = input.substr(0, lineBreak + 1);
+
+    std::size_t srcEnd = findLine(input, deliminator, deliminator.size());
+    if (srcEnd == std::string_view::npos) return false;
+    *src = input.substr(deliminator.size(), srcEnd - deliminator.size());
 
-    if (!output->has_value()) output->emplace("", 0);
+    std::size_t tsvStart = srcEnd + deliminator.size();
+    std::size_t tsvEnd = findLine(input, deliminator, tsvStart);
+    *tsv = input.substr(tsvStart, tsvEnd == std::string_view::npos ? std::string_view::npos : tsvEnd - tsvStart);
+    return true;
 }
 
-void initializeSrcTsvTogetherFromStdin(std::optional<std::string> *srcString, std::optional<std::string> *tsvString) {
+void initializeSrcTsvTogetherFromStdin(std::optional<std::string> *srcString, std::size_t *srcOffset,
+                                       std::optional<std::string> *tsvString) {
     if (srcString->has_value() && tsvString->has_value()) return;
 
-    char deliminator[IO_BUFF_SIZE + 16];  // = {0};
-    if (nullptr == std::fgets(deliminator, IO_BUFF_SIZE + 1, stdin)) {
-        if (!feof(stdin)) {
-            throw IOErrorException("I/O error reading from stdin");
-        }
-    }
-
-    readStdinLinesIntoOptionalString(deliminator, srcString);
-
-    if (feof(stdin)) {
+    std::string input = readWholeFileIntoString(stdin, "I/O error reading from stdin");
+    std::string_view src, tsv;
+    if (!splitSrcTsvInput(input, &src, &tsv)) {
         throw IOErrorException(
             "Encountered EOF in stdin before encountering the second deliminator (first line of stdin) separating the "
             "mutation file and the source code file");
     }
 
-    readStdinLinesIntoOptionalString(deliminator, tsvString);
+    // the source is usually the bulk of the input, so its bytes stay where they are read into
+    tsvString->emplace(tsv);
+    *srcOffset = src.data() - input.data();
+    input.resize(*srcOffset + src.size());
+    srcString->emplace(std::move(input));
 }
 
 void writeStringToFileHandle(std::FILE *handle, std::string textData) {
@@ -150,3 +153,32 @@ void closeAndNullifyFileHandle(std::FILE **handle) {
         *handle = nullptr;
     }
 }
+
+bool readExactFromFd(int fd, char *buffer, std::size_t size) {
+    std::size_t got = 0;
+
+    while (got < size) {
+        ssize_t readN = read(fd, buffer + got, size - got);
+        if (readN < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            throw IOErrorException("I/O error reading from file descriptor");
+        }
+        if (readN == 0) {
+            if (got == 0) return false;
+            throw IOErrorException("Unexpected EOF in the middle of a frame");
+        }
+        got += static_cast<std::size_t>(readN);
+    }
+    return true;
+}
+
+void writeAllToFd(int fd, const char *data, std::size_t size) {
+    for (std::size_t pos = 0; pos < size;) {
+        ssize_t written = write(fd, data + pos, size - pos);
+        if (written < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            throw IOErrorException("I/O error writing to file descriptor");
+        }
+        pos += static_cast<std::size_t>(written);
+    }
+}
@@ -35,7 +35,9 @@
 #include "commands/cli-parser.hpp"
 #include "commands/highlight/highlightCommand.hpp"
 #include "commands/mutate/mutateCommand.hpp"
+#include "commands/run/runCommand.hpp"
 #include "commands/score/scoreCommand.hpp"
+#include "commands/serve/serveCommand.hpp"
 #include "commands/validate/validateCommand.hpp"
 #include "common.hpp"
 #include "excepts.hpp"
@@ -85,7 +87,9 @@ static commandsMap setCommandsMap() {
         commandsMap temp = { { "mutate", &execMutate },
                              { "highlight", &execHighlight },
                              { "score", &execScore },
-                             { "validate", &execValidate } };
+                             { "validate", &execValidate },
+                             { "serve", &execServe },
+                             { "run", &execRun } };
         for ( const auto &n : temp ) {
             if ( n.second == nullptr ) {
                 containsNullptr = true;
@@ -109,11 +113,12 @@ static ParseArgvStatusCode parseArgvAndPerformAction( int argc, const char **arg
 
     if ( status == ParseArgvStatusCode::SUCCESS && 1 < argc && 0 == nonpositionals.size() ) {
         throw InvalidArgumentException(
-            "No command specified (must be one of 'mutate', 'highlight', 'score', or 'validate')\n" );
+            "No command specified (must be one of 'mutate', 'highlight', 'score', 'validate', 'serve', or 'run')\n" );
     }
 
     switch ( status ) {
         case ParseArgvStatusCode::SUCCESS:
+        case ParseArgvStatusCode::SUCCESS_QUIET:
             // continue on with the rest of the program
             break;
         case ParseArgvStatusCode::ERROR:
@@ -148,6 +153,9 @@ static int processFinalStatus( ParseArgvStatusCode status ) {
             std::cout << std::endl;
             return 0;
 
+        case ParseArgvStatusCode::SUCCESS_QUIET:
+            return 0;
+
         case ParseArgvStatusCode::ERROR:
             std::cerr << "Try '" PROGRAM_NAME " --help' to see available options and information.\n\n";
             return 1;
@@ -167,6 +175,12 @@ static int processFinalStatus( ParseArgvStatusCode status ) {
             std::cout << "validate:\n";
             std::cout << printValidateHelp( indent ) << '\n';
 
+            std::cout << "serve:\n";
+            std::cout << printServeHelp( indent ) << '\n';
+
+            std::cout << "run:\n";
+            std::cout << printRunHelp( indent ) << '\n';
+
             std::cout << "Common options:\n";
             //           "  --version                ";
             std::cout << indent
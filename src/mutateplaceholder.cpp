@@ -0,0 +1,113 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * mutateplaceholder.cpp: The C interface of libmutateplaceholder
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mutateplaceholder.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <string>
+
+#include "commands/mutate/mutationEngine.hpp"
+#include "excepts.hpp"
+
+struct mp_engine {
+    MutationEngine engine;
+    std::string lastError;
+    std::string lastWarnings;
+};
+
+static mp_status fail(mp_engine* engine, mp_status status, const char* message) {
+    try {
+        engine->lastError = message;
+    } catch (...) {
+        engine->lastError.clear();
+    }
+    return status;
+}
+
+int mp_api_version(void) { return MP_API_VERSION; }
+
+mp_engine* mp_engine_new(void) { return new (std::nothrow) mp_engine(); }
+
+void mp_engine_free(mp_engine* engine) { delete engine; }
+
+mp_status mp_mutate(mp_engine* engine, const char* src, size_t srcSize, const char* tsv, size_t tsvSize,
+                    const char* seed, int32_t count, int32_t minCount, int32_t maxCount, mp_buffer* out,
+                    char seedOut[MP_SEED_BUFFER_SIZE]) {
+    if (!engine) return MP_ERROR_ARGUMENT;
+    engine->lastError.clear();
+    engine->lastWarnings.clear();
+
+    if (!out || (!src && srcSize) || (!tsv && tsvSize)) {
+        return fail(engine, MP_ERROR_ARGUMENT, "NULL pointer passed to mp_mutate()");
+    }
+    out->data = nullptr;
+    out->size = 0;
+
+    try {
+        MutateOptions options;
+        if (seed) options.seed = seed;
+        options.count = count;
+        options.minCount = minCount;
+        options.maxCount = maxCount;
+
+        MutateResult result = engine->engine.mutate(std::string(src ? src : "", srcSize),
+                                                    std::string(tsv ? tsv : "", tsvSize), options);
+
+        char* data = static_cast<char*>(std::malloc(result.mutant.size() + 1));
+        if (!data) return fail(engine, MP_ERROR_OTHER, "Out of memory");
+        std::memcpy(data, result.mutant.data(), result.mutant.size());
+        data[result.mutant.size()] = 0;
+        out->data = data;
+        out->size = result.mutant.size();
+
+        if (seedOut) {
+            std::strncpy(seedOut, result.seed.c_str(), MP_SEED_BUFFER_SIZE - 1);
+            seedOut[MP_SEED_BUFFER_SIZE - 1] = 0;
+        }
+        engine->lastWarnings = std::move(result.warnings);
+        return MP_OK;
+    } catch (const TSVParsingException& ex) {
+        return fail(engine, MP_ERROR_TSV, ex.what());
+    } catch (const InvalidSeedException& ex) {
+        return fail(engine, MP_ERROR_SEED, ex.what());
+    } catch (const InvalidArgumentException& ex) {
+        return fail(engine, MP_ERROR_ARGUMENT, ex.what());
+    } catch (const IOErrorException& ex) {
+        return fail(engine, MP_ERROR_IO, ex.what());
+    } catch (const std::exception& ex) {
+        return fail(engine, MP_ERROR_OTHER, ex.what());
+    } catch (...) {
+        return fail(engine, MP_ERROR_OTHER, "Unknown error");
+    }
+}
+
+const char* mp_engine_last_error(const mp_engine* engine) { return engine ? engine->lastError.c_str() : ""; }
+
+const char* mp_engine_last_warnings(const mp_engine* engine) { return engine ? engine->lastWarnings.c_str() : ""; }
+
+void mp_buffer_free(mp_buffer* buffer) {
+    if (!buffer) return;
+    std::free(buffer->data);
+    buffer->data = nullptr;
+    buffer->size = 0;
+}
@@ -0,0 +1,123 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * perfCounters.cpp: Hardware performance counters of the calling thread through perf_event_open(2)
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "perfCounters.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfSample PerfSample::operator-(const PerfSample& other) const {
+    PerfSample result;
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        result.values[i] = values[i] >= other.values[i] ? values[i] - other.values[i] : 0;
+    }
+    return result;
+}
+
+PerfSample& PerfSample::operator+=(const PerfSample& other) {
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i) values[i] += other.values[i];
+    return *this;
+}
+
+const char* PerfCounters::eventName(PerfEvent event) {
+    static const char* names[PERF_EVENT_COUNT] = {"cycles", "instructions", "branchMisses", "l1dMisses",
+                                                  "llcMisses"};
+    return names[static_cast<std::size_t>(event)];
+}
+
+#ifdef __linux__
+
+static int openCounter(std::uint32_t type, std::uint64_t config) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;  // allowed up to kernel.perf_event_paranoid=2, the usual default
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+static constexpr std::uint64_t cacheMissConfig(std::uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+PerfCounters::PerfCounters() {
+    static const std::pair<std::uint32_t, std::uint64_t> configs[PERF_EVENT_COUNT] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HW_CACHE, cacheMissConfig(PERF_COUNT_HW_CACHE_LL)}};
+
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        fds[i] = openCounter(configs[i].first, configs[i].second);
+        if (fds[i] < 0 && unavailableReason.empty()) {
+            int err = errno;
+            unavailableReason = std::string("perf_event_open() of ") + eventName(static_cast<PerfEvent>(i)) +
+                                " failed: " + std::strerror(err);
+            if (err == EACCES || err == EPERM) unavailableReason += " (see kernel.perf_event_paranoid)";
+        }
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+PerfSample PerfCounters::read() const {
+    PerfSample sample;
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i) {
+        std::uint64_t buffer[3];  // value, time enabled, time running
+        if (fds[i] < 0 || ::read(fds[i], buffer, sizeof(buffer)) != sizeof(buffer)) continue;
+        if (buffer[2] && buffer[2] < buffer[1]) {
+            buffer[0] = static_cast<std::uint64_t>(static_cast<double>(buffer[0]) * buffer[1] / buffer[2]);
+        }
+        sample.values[i] = buffer[0];
+    }
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters() : unavailableReason{"perf_event_open() is only available on Linux"} { fds.fill(-1); }
+
+PerfCounters::~PerfCounters() {}
+
+PerfSample PerfCounters::read() const { return PerfSample(); }
+
+#endif
+
+bool PerfCounters::anyAvailable() const {
+    for (int fd : fds) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
@@ -0,0 +1,223 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * pipelineStats.cpp: Phase timings and counters of a mutate run, reported by --stats
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "pipelineStats.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+
+#include "traceRecorder.hpp"
+
+static constexpr std::size_t PHASE_COUNT = static_cast<std::size_t>(StatsPhase::COUNT);
+static constexpr std::size_t COUNTER_COUNT = static_cast<std::size_t>(StatsCounter::COUNT);
+static constexpr std::size_t SLOWEST_REPLACEMENTS_SHOWN = 10;  // in the text report, the JSON report has all of them
+
+const char* PipelineStats::phaseName(StatsPhase phase) {
+    static const char* names[PHASE_COUNT] = {"read",   "strip",   "parse", "categorize", "nesting",
+                                             "select", "replace", "write"};
+    return names[static_cast<std::size_t>(phase)];
+}
+
+const char* PipelineStats::counterName(StatsCounter counter) {
+    static const char* names[COUNTER_COUNT] = {"rowsParsed",     "rowsSelected",  "regexCompilations",
+                                               "findCalls",      "bytesCopied",   "noMatches",
+                                               "multipleMatches", "prefilterSkips", "regexLimitHits"};
+    return names[static_cast<std::size_t>(counter)];
+}
+
+void PipelineStats::addReplacement(std::size_t lineNumber, std::uint64_t ns, int matches, bool isRegex) {
+    replacements.push_back({lineNumber, ns, matches, isRegex});
+}
+
+void PipelineStats::enableHardwareCounters() {
+    if (!hardwareCounters) hardwareCounters = std::make_unique<PerfCounters>();
+}
+
+std::string PipelineStats::getReport(StatsFormat format) const {
+    return format == StatsFormat::JSON ? getJsonReport() : getTextReport();
+}
+
+static double toMs(std::uint64_t ns) { return static_cast<double>(ns) / 1e6; }
+
+std::string PipelineStats::getTextReport() const {
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3);
+    os << "Pipeline stats:\n";
+
+    std::uint64_t totalNs = 0;
+    for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+        os << "   " << std::left << std::setw(20) << phaseName(static_cast<StatsPhase>(i)) << std::right
+           << std::setw(12) << toMs(phaseNs[i]) << " ms";
+        if (AllocProfiler::enabled) {
+            os << std::setw(12) << phaseAllocations[i].allocations << " allocations" << std::setw(14)
+               << phaseAllocations[i].bytes << " bytes";
+        }
+        os << '\n';
+        totalNs += phaseNs[i];
+    }
+    os << "   " << std::left << std::setw(20) << "total" << std::right << std::setw(12) << toMs(totalNs) << " ms\n";
+
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+        os << "   " << std::left << std::setw(20) << counterName(static_cast<StatsCounter>(i)) << std::right
+           << std::setw(12) << counters[i] << '\n';
+    }
+
+    if (hardwareCounters && !hardwareCounters->anyAvailable()) {
+        os << "   Hardware counters unavailable: " << hardwareCounters->getUnavailableReason() << '\n';
+    }
+    else if (hardwareCounters) {
+        os << "   " << std::left << std::setw(12) << "Counters" << std::right;
+        for (std::size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+            os << std::setw(14) << PerfCounters::eventName(static_cast<PerfEvent>(e));
+        }
+        os << std::setw(8) << "IPC" << '\n';
+        for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+            const PerfSample& sample = phaseCounters[i];
+            os << "   " << std::left << std::setw(12) << phaseName(static_cast<StatsPhase>(i)) << std::right;
+            for (std::size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+                if (hardwareCounters->isAvailable(static_cast<PerfEvent>(e))) {
+                    os << std::setw(14) << sample.values[e];
+                }
+                else {
+                    os << std::setw(14) << "n/a";
+                }
+            }
+            if (sample[PerfEvent::CYCLES]) {
+                os << std::setw(8) << std::setprecision(2)
+                   << static_cast<double>(sample[PerfEvent::INSTRUCTIONS]) / sample[PerfEvent::CYCLES]
+                   << std::setprecision(3);
+            }
+            os << '\n';
+        }
+    }
+
+    if (replacements.size()) {
+        std::vector<ReplacementStats> slowest = replacements;
+        std::sort(slowest.begin(), slowest.end(),
+                  [](const ReplacementStats& a, const ReplacementStats& b) { return a.ns > b.ns; });
+        if (slowest.size() > SLOWEST_REPLACEMENTS_SHOWN) slowest.resize(SLOWEST_REPLACEMENTS_SHOWN);
+
+        os << "   Slowest " << slowest.size() << " of " << replacements.size() << " replacements:\n";
+        for (const auto& r : slowest) {
+            os << "      row on line " << std::left << std::setw(8) << r.lineNumber << std::right << std::setw(12)
+               << toMs(r.ns) << " ms, " << r.matches << (r.matches == 1 ? " match" : " matches")
+               << (r.isRegex ? ", regex" : "") << '\n';
+        }
+    }
+    return os.str();
+}
+
+std::string PipelineStats::getJsonReport() const {
+    std::ostringstream os;
+    os << "{\"phasesNs\": {";
+    std::uint64_t totalNs = 0;
+    for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+        os << (i ? ", " : "") << '"' << phaseName(static_cast<StatsPhase>(i)) << "\": " << phaseNs[i];
+        totalNs += phaseNs[i];
+    }
+    os << "}, \"totalNs\": " << totalNs << ", \"counters\": {";
+    for (std::size_t i = 0; i < COUNTER_COUNT; ++i) {
+        os << (i ? ", " : "") << '"' << counterName(static_cast<StatsCounter>(i)) << "\": " << counters[i];
+    }
+    os << "}, \"allocations\": ";
+    if (AllocProfiler::enabled) {
+        os << '{';
+        for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+            os << (i ? ", " : "") << '"' << phaseName(static_cast<StatsPhase>(i))
+               << "\": {\"count\": " << phaseAllocations[i].allocations << ", \"bytes\": " << phaseAllocations[i].bytes
+               << '}';
+        }
+        os << '}';
+    }
+    else {
+        os << "null";  // not an allocation profiling build
+    }
+    os << ", \"hardwareCounters\": ";
+    if (!hardwareCounters) {
+        os << "null";
+    }
+    else if (!hardwareCounters->anyAvailable()) {
+        os << "{\"available\": false, \"reason\": \"";
+        for (char c : hardwareCounters->getUnavailableReason()) {
+            if (c == '"' || c == '\\') os << '\\';
+            os << c;
+        }
+        os << "\"}";
+    }
+    else {
+        os << "{\"available\": true, \"phases\": {";
+        for (std::size_t i = 0; i < PHASE_COUNT; ++i) {
+            os << (i ? ", " : "") << '"' << phaseName(static_cast<StatsPhase>(i)) << "\": {";
+            for (std::size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+                os << (e ? ", " : "") << '"' << PerfCounters::eventName(static_cast<PerfEvent>(e)) << "\": ";
+                if (hardwareCounters->isAvailable(static_cast<PerfEvent>(e))) {
+                    os << phaseCounters[i].values[e];
+                }
+                else {
+                    os << "null";
+                }
+            }
+            os << '}';
+        }
+        os << "}}";
+    }
+    os << ", \"replacements\": [";
+    for (std::size_t i = 0; i < replacements.size(); ++i) {
+        const ReplacementStats& r = replacements[i];
+        os << (i ? ", " : "") << "{\"lineNumber\": " << r.lineNumber << ", \"ns\": " << r.ns
+           << ", \"matches\": " << r.matches << ", \"regex\": " << (r.isRegex ? "true" : "false") << '}';
+    }
+    os << "]}\n";
+    return os.str();
+}
+
+std::uint64_t statsClockNs() {
+    auto sinceEpoch = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(sinceEpoch).count());
+}
+
+ScopedPhase::ScopedPhase(PipelineStats* _stats, StatsPhase _phase)
+    : stats{_stats}, phase{_phase}, traced{TraceRecorder::isEnabled()} {
+    if constexpr (AllocProfiler::enabled) {
+        previousAllocPhase = AllocProfiler::enterPhase(phase);
+        startAllocations = AllocProfiler::get(phase);
+    }
+    if (stats && stats->getHardwareCounters()) startCounters = stats->getHardwareCounters()->read();
+    startNs = stats || traced ? statsClockNs() : 0;
+}
+
+ScopedPhase::~ScopedPhase() {
+    if (stats || traced) {
+        std::uint64_t endNs = statsClockNs();
+        if (stats) {
+            stats->addPhaseTime(phase, endNs - startNs);
+            if (stats->getHardwareCounters()) {
+                stats->addPhaseCounters(phase, stats->getHardwareCounters()->read() - startCounters);
+            }
+        }
+        if (traced) TraceRecorder::record(PipelineStats::phaseName(phase), "phase", startNs, endNs);
+    }
+    if constexpr (AllocProfiler::enabled) {
+        if (stats) stats->addPhaseAllocations(phase, AllocProfiler::get(phase) - startAllocations);
+        AllocProfiler::enterPhase(previousAllocPhase);
+    }
+}
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * threadPool.cpp: A fixed set of worker threads running queued jobs
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "threadPool.hpp"
+
+#include <string>
+#include <utility>
+
+#include "traceRecorder.hpp"
+
+std::size_t ThreadPool::hardwareThreads() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count ? count : 1;  // 0 when it cannot be told
+}
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    if (!threads) threads = hardwareThreads();
+    workers.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobQueued.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+    }
+    jobQueued.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    jobsDone.wait(lock, [this] { return jobs.empty() && !running; });
+    if (firstException) {
+        std::rethrow_exception(std::exchange(firstException, nullptr));
+    }
+}
+
+void ThreadPool::work(std::size_t index) {
+    TraceRecorder::setThreadName("worker " + std::to_string(index + 1));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        jobQueued.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (jobs.empty()) return;  // stopping, and nothing is left to run
+
+        std::function<void()> job = std::move(jobs.front());
+        jobs.pop_front();
+        ++running;
+        lock.unlock();
+        try {
+            job();
+        } catch (...) {
+            lock.lock();
+            if (!firstException) firstException = std::current_exception();
+            lock.unlock();
+        }
+        lock.lock();
+        --running;
+        if (jobs.empty() && !running) jobsDone.notify_all();
+    }
+}
@@ -0,0 +1,201 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * traceRecorder.cpp: Chrome/Perfetto trace-event spans of a run, written by --trace=FILE
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "traceRecorder.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#include "common.hpp"
+#include "pipelineStats.hpp"
+
+struct TraceRing {
+    std::vector<TraceEvent> events;
+    std::atomic<std::uint64_t> written{0};  // ever recorded, the next event goes to events[written % size]
+    std::uint32_t tid;
+    std::string threadName;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;  // only taken by a thread's first span, setThreadName() and when writing the trace
+    std::vector<std::unique_ptr<TraceRing>> rings;
+    std::string path;
+    std::size_t eventsPerThread = TRACE_EVENTS_PER_THREAD;
+    std::uint64_t originNs = 0;
+    bool writeAtExitRegistered = false;
+};
+
+static std::atomic<bool> traceEnabled{false};
+static std::atomic<std::uint64_t> traceGeneration{0};  // bumped by reset() so threads drop their stale rings
+
+static thread_local TraceRing* threadRing = nullptr;
+static thread_local std::uint64_t threadRingGeneration = 0;
+
+static TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+static TraceRing* getThreadRing() {
+    std::uint64_t generation = traceGeneration.load(std::memory_order_acquire);
+    if (threadRing && threadRingGeneration == generation) return threadRing;
+
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    auto ring = std::make_unique<TraceRing>();
+    ring->events.resize(reg.eventsPerThread);
+    ring->tid = static_cast<std::uint32_t>(reg.rings.size() + 1);
+    ring->threadName = "thread " + std::to_string(ring->tid);
+    threadRing = ring.get();
+    threadRingGeneration = generation;
+    reg.rings.push_back(std::move(ring));
+    return threadRing;
+}
+
+static void writeTraceAtExit() {
+    if (!traceEnabled.exchange(false)) return;
+
+    const std::string& path = registry().path;
+    std::string json = TraceRecorder::getJson();
+    std::FILE* handle = std::fopen(path.c_str(), "w");
+    if (!handle || std::fwrite(json.data(), 1, json.size(), handle) != json.size()) {
+        std::cerr << PROGRAM_NAME << ": could not write trace file \'" << sanitizeOutputMessage(path) << "\'\n";
+    }
+    if (handle) std::fclose(handle);
+}
+
+void TraceRecorder::start(const std::string& path, std::size_t eventsPerThread) {
+    TraceRegistry& reg = registry();  // constructed before the atexit() below, so it is destroyed after it runs
+    {
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.path = path;
+        reg.eventsPerThread = eventsPerThread ? eventsPerThread : 1;
+        if (!reg.writeAtExitRegistered) {
+            std::atexit(writeTraceAtExit);
+            reg.writeAtExitRegistered = true;
+        }
+    }
+    traceEnabled.store(true, std::memory_order_release);
+    setThreadName("main");
+
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.originNs = statsClockNs();  // after allocating the main thread's ring, so the trace starts at the run
+}
+
+bool TraceRecorder::isEnabled() { return traceEnabled.load(std::memory_order_relaxed); }
+
+void TraceRecorder::setThreadName(const std::string& name) {
+    if (!isEnabled()) return;
+    TraceRing* ring = getThreadRing();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    ring->threadName = name;
+}
+
+void TraceRecorder::record(const char* name, const char* category, std::uint64_t startNs, std::uint64_t endNs,
+                           std::int64_t arg) {
+    if (!isEnabled()) return;
+    TraceRing* ring = getThreadRing();
+    std::uint64_t n = ring->written.load(std::memory_order_relaxed);
+    ring->events[n % ring->events.size()] = {name, category, startNs, endNs - startNs, arg};
+    ring->written.store(n + 1, std::memory_order_release);
+}
+
+static void putJsonString(std::ostream& os, const std::string& str) {
+    os << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec << std::setfill(' ');
+        }
+        else {
+            os << c;
+        }
+    }
+    os << '"';
+}
+
+std::string TraceRecorder::getJson() {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3);
+    os << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+    std::size_t dropped = 0;
+    for (const auto& ring : reg.rings) {
+        os << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->tid
+           << ", \"args\": {\"name\": ";
+        putJsonString(os, ring->threadName);
+        os << "}}";
+        first = false;
+
+        std::uint64_t written = ring->written.load(std::memory_order_acquire);
+        std::uint64_t size = ring->events.size();
+        std::uint64_t oldest = written > size ? written - size : 0;
+        dropped += oldest;
+        for (std::uint64_t i = oldest; i < written; ++i) {
+            const TraceEvent& ev = ring->events[i % size];
+            std::uint64_t sinceOrigin = ev.startNs > reg.originNs ? ev.startNs - reg.originNs : 0;
+            os << ",\n{\"name\": \"" << ev.name << "\", \"cat\": \"" << ev.category
+               << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->tid << ", \"ts\": " << sinceOrigin / 1e3
+               << ", \"dur\": " << ev.durationNs / 1e3;
+            if (ev.arg != TRACE_NO_ARG) os << ", \"args\": {\"line\": " << ev.arg << '}';
+            os << '}';
+        }
+    }
+    os << "\n], \"otherData\": {\"droppedEvents\": " << dropped << "}}\n";
+    return os.str();
+}
+
+std::size_t TraceRecorder::getDroppedEvents() {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::size_t dropped = 0;
+    for (const auto& ring : reg.rings) {
+        std::uint64_t written = ring->written.load(std::memory_order_acquire);
+        if (written > ring->events.size()) dropped += written - ring->events.size();
+    }
+    return dropped;
+}
+
+void TraceRecorder::reset() {
+    traceEnabled.store(false, std::memory_order_release);
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.rings.clear();
+    traceGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+TraceSpan::TraceSpan(const char* _name, const char* _category, std::int64_t _arg)
+    : name{_name}, category{_category}, arg{_arg}, startNs{TraceRecorder::isEnabled() ? statsClockNs() : 0} {}
+
+TraceSpan::~TraceSpan() {
+    if (startNs) TraceRecorder::record(name, category, startNs, statsClockNs(), arg);
+}
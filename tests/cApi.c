@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * cApi.c: Calls the library the way a C program does, so that mutateplaceholder.h is compiled as C
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "cApi.h"
+
+mp_status mutateFromC( const char* src, size_t srcSize, const char* tsv, size_t tsvSize, const char* seed,
+                       int32_t count, mp_buffer* out ) {
+    if ( mp_api_version() != MP_API_VERSION ) {
+        return MP_ERROR_OTHER;
+    }
+    mp_engine* engine = mp_engine_new();
+    if ( engine == NULL ) {
+        return MP_ERROR_OTHER;
+    }
+    char seedOut[MP_SEED_BUFFER_SIZE];
+    mp_status result = mp_mutate( engine, src, srcSize, tsv, tsvSize, seed, count, -1, -1, out, seedOut );
+    mp_engine_free( engine );
+    return result;
+}
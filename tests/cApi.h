@@ -0,0 +1,38 @@
+/* SPDX-License-Identifier: GPL-3.0-only or GPL-3.0-or-later */
+/*
+ * cApi.h: What cApi.c, built as C, offers to the C++ tests
+ *
+ * Copyright (c) 2023 RightEnd
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef _INCLUDED_TESTS_CAPI_H_
+#define _INCLUDED_TESTS_CAPI_H_
+
+#include "mutateplaceholder.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Mutates src with a fresh engine, from C. MP_ERROR_OTHER when the linked library is not of this header's version
+mp_status mutateFromC( const char* src, size_t srcSize, const char* tsv, size_t tsvSize, const char* seed,
+                       int32_t count, mp_buffer* out );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // _INCLUDED_TESTS_CAPI_H_
@@ -22,13 +22,19 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include <algorithm>
+#include <chrono>
 #include <cstdbool>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <iterator>
@@ -36,6 +42,7 @@
 #include <ranges>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -54,7 +61,26 @@
 #undef protected
 #undef private
 #undef class
+#include "cApi.h"
+#include "commands/mutate/commentStripper.hpp"
+#include "commands/mutate/mutantDescriptor.hpp"
+#include "commands/mutate/mutator.hpp"
+#include "commands/mutate/pathScopeIndex.hpp"
+#include "commands/mutate/pcreRegex.hpp"
+#include "commands/mutate/pikeRegex.hpp"
+#include "commands/mutate/regexPrefilter.hpp"
+#include "commands/mutate/schemataBuilder.hpp"
+#include "commands/mutate/streamMutator.hpp"
+#include "commands/mutate/treeMutator.hpp"
+#include "commands/run/runCommand.hpp"
+#include "commands/run/workspaceBuilder.hpp"
+#include "commands/serve/mutationService.hpp"
+#include "commands/serve/serveCommand.hpp"
+#include "commands/serve/serveProtocol.hpp"
 #include "excepts.hpp"
+#include "iohelpers.hpp"
+#include "mutateplaceholder.h"
+#include "traceRecorder.hpp"
 
 typedef std::pair<const char*, std::string> FailedTest;
 
@@ -579,6 +605,964 @@ static bool checkNesting() {
     return testMutationsRetrieverException( tsvFile, expected );
 }
 
+static bool testServeRequestsUseWarmCaches() {
+    const char* seed = "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6";
+    const char* argv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "-s", seed, "-c", "20", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    Mutator mutator;
+    std::string expected = mutator( parsedArgs.getSrcString(), parsedArgs.getTsvString(), &parsedArgs );
+
+    ServeRequest request;
+    request.op = ServeOp::MUTATE;
+    request.count = 20;
+    request.seed = seed;
+    request.src = parsedArgs.getSrcString();
+    request.tsv = parsedArgs.getTsvString();
+    request = decodeRequest( encodeRequest( request ) );
+
+    MutationService service;
+    for ( int i = 0; i < 2; ++i ) {  // the second request is answered from the caches
+        ServeResponse response = decodeResponse( encodeResponse( service.handle( request ) ) );
+        testLog << INDENT "Request " << i << " got status " << (int)response.status << " and "
+                << response.output.size() << " bytes, expected " << expected.size() << " bytes\n";
+        if ( response.status != ServeStatus::OK || response.output != expected || response.seed != seed ) {
+            return true;
+        }
+    }
+
+    request.tsv = "no permutation cell\n";
+    ServeResponse response = service.handle( request );
+    testLog << INDENT "Expected an error status for a bad TSV, got " << (int)response.status << "\n";
+    return response.status != ServeStatus::ERROR;
+}
+
+static bool testServeStreamTsvIds() {
+    const char* seed = "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6";
+    int requests[2], responses[2];
+    if ( pipe( requests ) || pipe( responses ) ) {
+        testLog << INDENT "Could not create the pipes\n";
+        return true;
+    }
+
+    ServeRequest request;
+    request.op = ServeOp::MUTATE;
+    request.count = 1;
+    request.seed = seed;
+    request.src = "int a = 1;\n";
+    request.tsv = "int a = 1;\tint a = 2;\n";
+    request.tsvId = 7;
+    writeFrame( requests[1], encodeRequest( request ) );
+    request.tsv.clear();  // refers to the TSV sent above
+    writeFrame( requests[1], encodeRequest( request ) );
+    request.tsvId = 8;  // never sent
+    writeFrame( requests[1], encodeRequest( request ) );
+    close( requests[1] );
+
+    MutationService service;
+    bool keepServing = serveStream( requests[0], responses[1], service );
+    close( requests[0] );
+    close( responses[1] );
+
+    std::vector<ServeStatus> statuses;
+    std::vector<std::string> outputs;
+    std::string body;
+    while ( readFrame( responses[0], body ) ) {
+        ServeResponse response = decodeResponse( body );
+        statuses.push_back( response.status );
+        outputs.push_back( response.output );
+    }
+    close( responses[0] );
+
+    testLog << INDENT "Got " << statuses.size() << " responses, expected 3\n";
+    return !keepServing || statuses.size() != 3 || statuses[0] != ServeStatus::OK || statuses[1] != ServeStatus::OK ||
+           statuses[2] != ServeStatus::ERROR || outputs[0] != "int a = 2;\n" || outputs[1] != outputs[0];
+}
+
+static bool testCApiMatchesCli() {
+    const char* seed = "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6";
+    const char* argv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "-s", seed, "-c", "20", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    Mutator mutator;
+    std::string expected = mutator( parsedArgs.getSrcString(), parsedArgs.getTsvString(), &parsedArgs );
+    std::string src = parsedArgs.getSrcString();
+    std::string tsv = parsedArgs.getTsvString();
+
+    mp_engine* engine = mp_engine_new();
+    mp_buffer out;
+    char seedOut[MP_SEED_BUFFER_SIZE];
+    mp_status result = mp_mutate( engine, src.data(), src.size(), tsv.data(), tsv.size(), seed, 20, -1, -1, &out,
+                                  seedOut );
+    testLog << INDENT "mp_mutate() returned " << (int)result << " with " << out.size << " bytes, expected "
+            << expected.size() << " bytes\n";
+    bool failed = result != MP_OK || std::string( out.data, out.size ) != expected || std::strcmp( seedOut, seed );
+    mp_buffer_free( &out );
+
+    result = mutateFromC( src.data(), src.size(), tsv.data(), tsv.size(), seed, 20, &out );
+    testLog << INDENT "From C, mp_mutate() returned " << (int)result << " with " << out.size << " bytes\n";
+    failed = failed || result != MP_OK || std::string( out.data, out.size ) != expected;
+    if ( result == MP_OK ) {
+        mp_buffer_free( &out );
+    }
+
+    const char* badTsv = "no permutation cell\n";
+    result = mp_mutate( engine, src.data(), src.size(), badTsv, std::strlen( badTsv ), seed, 20, -1, -1, &out,
+                        nullptr );
+    testLog << INDENT "Expected MP_ERROR_TSV for a bad TSV, got " << (int)result << ": "
+            << mp_engine_last_error( engine ) << "\n";
+    failed = failed || result != MP_ERROR_TSV || !std::strlen( mp_engine_last_error( engine ) );
+
+    mp_engine_free( engine );
+    return failed;
+}
+
+static bool testStatsCountMutateRun() {
+    const char* seed = "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6";
+    const char* argv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "-s", seed, "-c", "20", "--stats=json", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    if ( status != ParseArgvStatusCode::SUCCESS || !parsedArgs.hasStats() ) {
+        testLog << INDENT "ERR: failed to parse --stats=json. Got ParseArgvStatusCode code " << (int)status << '\n';
+        return true;
+    }
+
+    Mutator mutator;
+    std::string withStats = mutator( parsedArgs.getSrcString(), parsedArgs.getTsvString(), &parsedArgs );
+    const PipelineStats* stats = parsedArgs.getStats();
+
+    parsedArgs.statsFormat.reset();
+    Mutator plainMutator;
+    std::string withoutStats = plainMutator( parsedArgs.getSrcString(), parsedArgs.getTsvString(), &parsedArgs );
+
+    testLog << INDENT "Parsed " << stats->get( StatsCounter::ROWS_PARSED ) << " rows, selected "
+            << stats->get( StatsCounter::ROWS_SELECTED ) << " and timed " << stats->getReplacements().size()
+            << " replacements, expected 20\n";
+    testLog << INDENT "Output with and without --stats is " << ( withStats == withoutStats ? "" : "not " )
+            << "the same\n";
+
+    return withStats != withoutStats || !stats->get( StatsCounter::ROWS_PARSED ) ||
+           stats->get( StatsCounter::ROWS_SELECTED ) != 20 || stats->getReplacements().size() != 20 ||
+           !stats->get( StatsCounter::FIND_CALLS ) ||
+           stats->getReport( StatsFormat::JSON ).find( "\"rowsParsed\"" ) == std::string::npos;
+}
+
+static bool testTraceRecordsSpansPerThread() {
+    const char* argv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "-c", "5", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    TraceRecorder::start( "/dev/null", 4 );
+    Mutator mutator;
+    mutator( parsedArgs.getSrcString(), parsedArgs.getTsvString(), &parsedArgs );
+    std::thread worker( [] {
+        TraceRecorder::setThreadName( "worker 1" );
+        TraceSpan span( "mutant", "mutant" );
+    } );
+    worker.join();
+    std::string json = TraceRecorder::getJson();
+    std::size_t dropped = TraceRecorder::getDroppedEvents();
+    TraceRecorder::reset();
+
+    testLog << INDENT "Trace with 4 events per thread dropped " << dropped << " events:\n" << json;
+    bool failed = json.find( "\"name\": \"main\"" ) == std::string::npos ||
+                  json.find( "\"name\": \"worker 1\"" ) == std::string::npos ||
+                  json.find( "\"tid\": 2, \"ts\"" ) == std::string::npos;
+    // only the last 4 spans of the main thread are kept, ending with the mutant that encloses them
+    std::size_t mainSpans = 0;
+    for ( std::size_t pos = json.find( "\"tid\": 1, \"ts\"" ); pos != std::string::npos;
+          pos = json.find( "\"tid\": 1, \"ts\"", pos + 1 ) ) {
+        ++mainSpans;
+    }
+    failed = failed || !dropped || mainSpans != 4 || json.find( "\"cat\": \"row\"" ) == std::string::npos;
+    return failed || TraceRecorder::isEnabled();
+}
+
+static bool testHardwareCountersDegradeGracefully() {
+    const char* argv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "-c", "5", "--stats=json", "--hw-counters", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    parsedArgs.getStats()->enableHardwareCounters();
+    Mutator mutator;
+    mutator( parsedArgs.getSrcString(), parsedArgs.getTsvString(), &parsedArgs );
+    const PerfCounters* perf = parsedArgs.getStats()->getHardwareCounters();
+    std::string report = parsedArgs.getStats()->getReport( StatsFormat::JSON );
+
+    testLog << INDENT "Hardware counters are " << ( perf->anyAvailable() ? "available" : "unavailable: " )
+            << perf->getUnavailableReason() << '\n';
+    testLog << INDENT "Report: " << report;
+    if ( perf->anyAvailable() ) {
+        bool counted = !perf->isAvailable( PerfEvent::INSTRUCTIONS ) ||
+                       parsedArgs.getStats()->getPhaseCounters( StatsPhase::STRIP )[PerfEvent::INSTRUCTIONS];
+        return !counted || report.find( "\"hardwareCounters\": {\"available\": true" ) == std::string::npos;
+    }
+    return perf->getUnavailableReason().empty() ||
+           report.find( "\"hardwareCounters\": {\"available\": false" ) == std::string::npos;
+}
+
+static bool testAllocationsAttributedToPhases() {
+    const char* argv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "-c", "5", "--stats=json", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    Mutator mutator;
+    mutator( parsedArgs.getSrcString(), parsedArgs.getTsvString(), &parsedArgs );
+    const PipelineStats* stats = parsedArgs.getStats();
+    std::string report = stats->getReport( StatsFormat::JSON );
+
+    testLog << INDENT "Allocation profiling is " << ( AllocProfiler::enabled ? "on" : "off" ) << ", the parse phase made "
+            << stats->getPhaseAllocations( StatsPhase::PARSE ).allocations << " allocations\n";
+    if ( !AllocProfiler::enabled ) {
+        return stats->getPhaseAllocations( StatsPhase::PARSE ).allocations ||
+               report.find( "\"allocations\": null" ) == std::string::npos;
+    }
+
+    ScopedPhase phase( nullptr, StatsPhase::WRITE );
+    AllocationTally before = AllocProfiler::get( StatsPhase::WRITE );
+    std::unique_ptr<std::string> allocated = std::make_unique<std::string>( 100, 'x' );
+    AllocationTally written = AllocProfiler::get( StatsPhase::WRITE ) - before;
+    testLog << INDENT "Allocating a 100 character string in the write phase counted " << written.allocations
+            << " allocations of " << written.bytes << " bytes\n";
+    return !stats->getPhaseAllocations( StatsPhase::PARSE ).allocations || written.allocations != 2 ||
+           written.bytes < 100;
+}
+
+static bool testCommentStripping() {
+    const std::pair<std::string, std::string> cases[] = {
+        { "int a = 1; // one\nint b = 2;\n", "int a = 1;\nint b = 2;\n" },
+        { "// only\n// two\n    // three\nint c;\n", "int c;\n" },
+        { "s = \"// not /* a comment */\"; // but this is\n", "s = \"// not /* a comment */\";\n" },
+        { "r = R\"x(// kept )\" still kept)x\"; /* gone */\n", "r = R\"x(// kept )\" still kept)x\";\n" },
+        { "int/**/x = 1'000'000; c = '\\''; d = '/';\n", "int x = 1'000'000; c = '\\''; d = '/';\n" },
+        { "a /* spans\nlines\n*/ b\n  /* whole\n lines */\nf(); /* inline */ g();\r\n",
+          "a\n b\nf(); g();\r\n" },
+        { "if ( longerThanOneBlock ) { // comment past the first 16 bytes\n    x(); }",
+          "if ( longerThanOneBlock ) {\n    x(); }" },
+    };
+
+    bool failed = false;
+    for ( const auto& [input, expected] : cases ) {
+        std::string stripped = CommentStripper()( input );
+        if ( stripped != expected ) {
+            testLog << INDENT "Stripping " << std::quoted( input ) << " gave " << std::quoted( stripped )
+                    << ", expected " << std::quoted( expected ) << "\n";
+            failed = true;
+        }
+    }
+    return failed;
+}
+
+static bool testLexersPerLanguage() {
+    bool failed = false;
+    auto expect = [&failed]( const char* language, std::string_view src, const std::vector<std::string>& expected ) {
+        std::vector<std::string> texts;
+        for ( const Token& token : SourceLexer::get( language ).tokenize( src ) ) {
+            texts.emplace_back( src.substr( token.offset, token.length ) );
+        }
+        if ( texts != expected ) {
+            testLog << INDENT "Tokenizing " << std::quoted( src ) << " as " << language << " gave";
+            for ( const std::string& text : texts ) {
+                testLog << ' ' << std::quoted( text );
+            }
+            testLog << "\n";
+            failed = true;
+        }
+    };
+
+    expect( "cpp", "x = u8\"//\" + 1'000 + R\"(\")\";", { "x", "=", "u8\"//\"", "+", "1'000", "+", "R\"(\")\"", ";" } );
+    expect( "python", "s = '#' # c\nd = \"\"\"a\n#b\"\"\"", { "s", "=", "'#'", "# c", "d", "=", "\"\"\"a\n#b\"\"\"" } );
+    expect( "javascript", "r = /\\/\\//g / 2; t = `//${x}`",
+            { "r", "=", "/\\/\\//g", "/", "2", ";", "t", "=", "`//${x}`" } );
+    expect( "go", "s := `a\n// b` // c", { "s", ":", "=", "`a\n// b`", "// c" } );
+    expect( "java", "c = '\"'; /* x */", { "c", "=", "'\"'", ";", "/* x */" } );
+
+    std::string stripped = CommentStripper( SourceLexer::get( "python" ) )( "# header\nx = 1  # one\nurl = '//x'\n" );
+    if ( stripped != "x = 1\nurl = '//x'\n" ) {
+        testLog << INDENT "Stripping python gave " << std::quoted( stripped ) << "\n";
+        failed = true;
+    }
+
+    const char* paths[][2] = { { "a/b.py", "python" }, { "x.c", "c" }, { "x.hpp", "cpp" }, { "x.tsx", "typescript" },
+                               { "v1.2/README", "cpp" }, { "-", "cpp" } };
+    for ( auto [path, language] : paths ) {
+        if ( std::string( SourceLexer::forPath( path ).getName() ) != language ) {
+            testLog << INDENT << path << " was not lexed as " << language << "\n";
+            failed = true;
+        }
+    }
+    return failed;
+}
+
+static bool testLexersResumeOverGrowingSources() {
+    const char* sources[][2] = {
+        { "cpp", "int a = 1'000'000; // c \\\n spliced\nconst char* r = R\"xy(raw )\" \n)xy\"; /* block\n * */ "
+                 "char c = '\\''; s = u8\"pre\" \"esc\\\"aped\\\\\" x / y;\n" },
+        { "python", "s = \"\"\"doc \"\" \\\"\"\" \n more\"\"\"\nr = '''x''' + '' # c\nb = rb\"\\x\"\n" },
+        { "javascript", "let r = /a[/]b\\//gi; x = a / b / c; t = `tmpl \\` ${x}\n`; // c\n" },
+        { "java", "String s = \"\"\"\n text \"\n\"\"\"; char c = 'x'; /**/\n" },
+        { "go", "s := `raw\n` + \"x\" // c\n" } };
+    bool failed = false;
+    for ( auto [language, src] : sources ) {
+        const SourceLexer& lexer = SourceLexer::get( language );
+        TokenStream expected = lexer.findCommentsAndLiterals( src );
+        std::string_view whole( src );
+        for ( size_t chunkSize = 1; chunkSize <= 7; ++chunkSize ) {
+            // the source grows a chunk at a time and each call carries on where the one before left off
+            TokenStream tokens;
+            LexerResume resume;
+            for ( size_t size = 0; size < whole.size(); ) {
+                size = std::min( whole.size(), size + chunkSize );
+                TokenStream more = lexer.findCommentsAndLiterals( whole.substr( 0, size ), resume );
+                tokens.insert( tokens.end(), more.begin(), more.end() );
+            }
+            // only what the last call could not settle yet may be missing
+            bool same = tokens.size() <= expected.size();
+            for ( size_t i = 0; same && i < expected.size(); ++i ) {
+                same = i < tokens.size() ? tokens[i].offset == expected[i].offset &&
+                                               tokens[i].length == expected[i].length &&
+                                               tokens[i].kind == expected[i].kind
+                                         : expected[i].offset >= resume.pos;
+            }
+            if ( !same ) {
+                testLog << INDENT << language << " in chunks of " << chunkSize << " bytes gave " << tokens.size()
+                        << " tokens instead of " << expected.size() << "\n";
+                failed = true;
+            }
+        }
+    }
+    return failed;
+}
+
+static bool testTokenMatching() {
+    const char* src = "x = a+b;\nint aa = b;\ns = \"a = b\";\nif ( a == b ) {\n    y = a\n        + b;\n}\n";
+    const char* expected = "x = a-b;\nint aa = c;\ns = \"a = b\";\nif ( a == b ) {\n    y = a-b;\n}\n";
+    const char* argv[] = { "./test", "mutate", "--match=tokens", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    SelectedLineInfo info;
+    SelectedMutVec rows{ SelectedMutation( "a + b", "a-b", info ), SelectedMutation( "a = b", "a = 0", info ),
+                         SelectedMutation( "= b", "= c", info ) };
+    std::string subject = src;
+    Mutator mutator;
+    mutator.applyMutations( subject, rows, &parsedArgs );
+    testLog << INDENT "Token matching gave " << std::quoted( subject ) << "\n";
+    bool failed = subject != expected;
+
+    std::string warnings = parsedArgs.getWarnings();
+    testLog << INDENT "Warnings: " << std::quoted( warnings ) << "\n";
+    return failed || warnings.find( "multiple matches" ) == std::string::npos ||
+           warnings.find( "no match" ) == std::string::npos;
+}
+
+static bool testTreeModeMirrorsFiles() {
+    const char* seed = "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6";
+    char outputDirName[L_tmpnam] = { 0 };
+    std::filesystem::path outputDir = std::tmpnam( outputDirName );
+    std::string outputDirArg = "--output-dir=" + outputDir.string();
+    const char* argv[] = { "./test", "mutate", "--tree=./ioFiles/rawFiles", "--glob=*.c*", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "-s", seed, "-c", "3", "-j", "2",
+                           outputDirArg.c_str(), nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    TreeMutator treeMutator( &parsedArgs, parsedArgs.getTsvString() );
+    treeMutator.run();
+
+    bool failed = treeMutator.getPaths() != std::vector<std::string>{ "OperationsDV1.c", "cli-options.cpp" };
+    for ( const std::string& path : treeMutator.getPaths() ) {
+        std::string input = "./ioFiles/rawFiles/" + path;
+        std::string fileSeed = TreeMutator::deriveSeed( seed, path );
+        const char* fileArgv[] = { "./test", "mutate", "-i", input.c_str(), "-m", "./ioFiles/rawFiles/cli-options.tsv",
+                                   "-s", fileSeed.c_str(), "-c", "3", nullptr };
+        parsingBoilerPlate fileBp( fileArgv );
+        Mutator mutator;
+        std::string expected = mutator( fileBp.parsedArgs.getSrcString(), fileBp.parsedArgs.getTsvString(),
+                                        &fileBp.parsedArgs );
+
+        std::ifstream written( outputDir / path, std::ios::binary );
+        std::string mutant{ std::istreambuf_iterator<char>( written ), std::istreambuf_iterator<char>() };
+        testLog << INDENT << path << " was mutated into " << mutant.size() << " bytes, expected " << expected.size()
+                << " bytes\n";
+        failed = failed || mutant != expected;
+    }
+    std::filesystem::remove_all( outputDir );
+    return failed;
+}
+
+static bool testFileListStaysInCurrentDirectory() {
+    char listName[L_tmpnam] = { 0 };
+    std::filesystem::path list = std::tmpnam( listName );
+    std::string listArg = "--file-list=" + list.string();
+    std::ofstream( list ) << "\n";  // so that it is found
+    const char* argv[] = { "./test", "mutate", listArg.c_str(), "-m", "./ioFiles/rawFiles/cli-options.tsv",
+                           "--output-dir=./mutants", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    bool failed = false;
+    const char* const lists[] = { "/etc/hostname\n", "ioFiles/../../x.cpp\n", "../x.cpp\n",
+                                  "./ioFiles/rawFiles/../x.cpp\n" };
+    for ( const char* paths : lists ) {
+        std::ofstream( list ) << paths;
+        bool rejected = false;
+        try {
+            TreeMutator treeMutator( &parsedArgs, parsedArgs.getTsvString() );
+        } catch ( const InvalidArgumentException& ex ) {
+            testLog << INDENT << ex.what() << "\n";
+            rejected = true;
+        }
+        failed = failed || rejected != ( paths != lists[3] );
+    }
+    std::filesystem::remove( list );
+    return failed;
+}
+
+static bool testPathScopedRows() {
+    MutationsRetriever retriever( "a\tb\n#paths: *.c\nc\td\n#paths: src/\ne\tf\n#paths:\ng\th\n" );
+    std::vector<std::string> paths{ "x.c", "src/y.cpp", "z.h", "src/w.c", "q.h" };
+    PathScopeIndex index( retriever.getPossibleMutations(), retriever.getPathScopes(), paths );
+
+    std::vector<std::string> expected[] = { { "a", "c", "g" }, { "a", "e", "g" }, { "a", "g" }, { "a", "c", "e", "g" },
+                                            { "a", "g" } };
+    bool failed = index.getRowSetCount() != 4;  // z.h and q.h share theirs
+    for ( size_t i = 0; i < paths.size(); ++i ) {
+        std::vector<std::string> patterns;
+        for ( const TsvFileLine& row : index.getRows( i ) ) {
+            patterns.push_back( row.pattern );
+        }
+        testLog << INDENT << paths[i] << " has " << patterns.size() << " rows, expected " << expected[i].size() << "\n";
+        failed = failed || patterns != expected[i];
+    }
+    return failed;
+}
+
+static std::string readTestFile( const std::string& path ) {
+    std::ifstream file( path, std::ios::binary );
+    return std::string{ std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() };
+}
+
+static bool testStreamMatchesWholeSource() {
+    const char* seed = "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6";
+    const std::string tsv = "\"int a = 1;\nint b = 2;\"\t\"int ab = 3;\"\nx++\tx--\n";
+    char srcName[L_tmpnam] = { 0 }, outName[L_tmpnam] = { 0 };
+    std::string src = std::tmpnam( srcName ) + std::string( ".cpp" );
+    std::string out = std::tmpnam( outName );
+    std::ofstream( src, std::ios::binary ) << "// header\nint a = 1;\nint b = 2;\n/* block\n   comment */ x++;\n"
+                                           << "const char* s = \"x++ // not a comment\";\n    int a = 1;\n"
+                                           << "    int b = 2; // trailing\nx++;\n";
+
+    const char* argv[] = { "./test", "mutate", "-i", src.c_str(), "-s", seed, "-c", "2", nullptr };
+    parsingBoilerPlate bp( argv );
+    Mutator mutator;
+    std::string expected = mutator( bp.parsedArgs.getSrcString(), tsv, &bp.parsedArgs );
+    std::string expectedWarnings = bp.parsedArgs.getWarnings();
+
+    bool failed = false;
+    for ( size_t chunkSize : { 1, 5, 64, 4096 } ) {
+        std::string warnings;
+        {
+            parsingBoilerPlate streamBp( argv );
+            streamBp.parsedArgs.setResOutput( out.c_str() );
+            StreamMutator( &streamBp.parsedArgs, chunkSize ).run( tsv );
+            warnings = streamBp.parsedArgs.getWarnings();
+        }
+        std::string mutant = readTestFile( out );
+        testLog << INDENT << "chunks of " << chunkSize << " bytes gave " << mutant.size() << " bytes, expected "
+                << expected.size() << " bytes\n";
+        failed = failed || mutant != expected || warnings != expectedWarnings;
+    }
+    std::remove( src.c_str() );
+    std::remove( out.c_str() );
+    return failed;
+}
+
+static bool testRegexPrefilter() {
+    const std::vector<std::pair<std::string, std::vector<std::string>>> cases = {
+        { "int a = \\d;", { "int a = ", ";" } },   { "foo\\(\\w+\\)", { "foo(", ")" } },
+        { "colou?r", { "colo", "r" } },              { "x{0,2}yz+", { "yz" } },
+        { "[abc]+def(ghi|jkl)", { "def" } },         { "a|b", {} },
+        { "(?i)abc", {} },                           { "\\x41bc", {} } };
+    bool failed = false;
+    for ( const auto& [pattern, expected] : cases ) {
+        if ( findRequiredLiterals( pattern ) != expected ) {
+            testLog << INDENT "ERR: wrong literals found in " << pattern << '\n';
+            failed = true;
+        }
+    }
+
+    CLIOptions opts;
+    opts.setSeed( "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6" );
+    opts.setMutCount( "2" );
+    opts.setStats( nullptr );
+    Mutator mutator;
+    std::string tsv = "/int a = \\d;/\tint a = 3;\n/delete \\w+;/\tfree(p);\n";
+    std::string mutant = mutator( "int a = 1;\nint b = 2;\n", tsv, &opts );
+    size_t skipped = opts.getStats()->get( StatsCounter::PREFILTER_SKIPS );
+    testLog << INDENT << skipped << " regex rows skipped, expected 1\n";
+    return failed || mutant != "int a = 3;\nint b = 2;\n" || skipped != 1;
+}
+
+static bool testRequiredLiteralsScan() {
+    const std::vector<std::vector<std::string>> literals = {
+        { "foo(", ")" }, { "bar" }, { "free(", ";" }, { "oo(b" }, { "x" } };
+    std::vector<const std::vector<std::string>*> rows;
+    for ( const auto& row : literals ) {
+        rows.push_back( &row );
+    }
+    RequiredLiteralsScan scan;
+    scan.reset( rows );
+    EditWindow edits;
+    std::string subject = "foo( a );\nint b;\n";
+    bool failed = false;
+    auto check = [&]( const char* when ) {
+        for ( size_t row = 0; row < literals.size(); ++row ) {
+            // literals are only ever added to what was found, so one an edit removed may still count
+            if ( !scan.mayMatch( row, subject, edits ) && containsRequiredLiterals( subject, literals[row] ) ) {
+                testLog << INDENT "ERR: row " << row << " " << when << '\n';
+                failed = true;
+            }
+        }
+    };
+    check( "before the edits" );
+    // "oo(b" only appears across the edit, "bar" and "free(" inside it
+    subject.replace( 5, 3, "bar" );
+    edits.replaced( 5, 3, 3 );
+    subject.replace( 10, 0, "free(" );
+    edits.replaced( 10, 0, 5 );
+    subject.replace( 4, 1, "" );
+    edits.replaced( 4, 1, 0 );
+    check( "after the edits" );
+    return failed || !scan.mayMatch( 3, subject, edits ) || scan.mayMatch( 4, subject, edits );
+}
+
+static bool testRegexReplacesAtOffsets() {
+    const std::string src = "int a = 1 + 2;\n    f( 3 + 4 );\nint b = 1 + 2;\n";
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        { "/(\\d) \\+ (\\d)/-A\t$2 - $1\n", "int a = 2 - 1;\n    f( 4 - 3 );\nint b = 2 - 1;\n" },
+        { "/(\\d) \\+ (\\d)/-Ag\t$2 - $1\n", "int a = 2 - 1;\n    f( 3 + 4 );\nint b = 1 + 2;\n" },
+        { "/(?<=f\\( )\\d/-A\t0\n", "int a = 1 + 2;\n    f( 0 + 4 );\nint b = 1 + 2;\n" },
+        { "+/f\\((.*)\\);/-A\tg($1);\n", "int a = 1 + 2;\n    f( 3 + 4 );\n    g( 3 + 4 );\nint b = 1 + 2;\n" } };
+    bool failed = false;
+    for ( const auto& [tsv, expected] : cases ) {
+        CLIOptions opts;
+        opts.setSeed( "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6" );
+        Mutator mutator;
+        std::string mutant = mutator( src, tsv, &opts );
+        if ( mutant != expected ) {
+            testLog << INDENT "ERR: " << tsv << "gave\n" << mutant;
+            failed = true;
+        }
+    }
+    return failed;
+}
+
+static bool testRegexLimits() {
+    const std::string src = std::string( 28, 'a' ) + "\nx = \"!\";\nint a = 1;\n";
+    CLIOptions opts;
+    opts.setSeed( "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6" );
+    opts.setMutCount( "2" );
+    opts.setRegexMatchLimit( "10000" );
+    opts.setStats( nullptr );
+    Mutator mutator;
+    // the backreference keeps the row on PCRE2, the Pike VM would not backtrack
+    std::string mutant = mutator( src, "/(a+)+\\1!/-A\tb\nint a = 1;\tint a = 2;\n", &opts );
+    size_t hits = opts.getStats()->get( StatsCounter::REGEX_LIMIT_HITS );
+    testLog << INDENT << hits << " regex rows hit a limit, expected 1\n";
+    bool reported = opts.getWarnings().find( "were skipped" ) == std::string::npos &&
+                    opts.getWarnings().find( "was skipped: { 1 }" ) != std::string::npos;
+    return !reported || hits != 1 || mutant != std::string( 28, 'a' ) + "\nx = \"!\";\nint a = 2;\n";
+}
+
+static bool testPikeRegexMatchesPcre2() {
+    const std::vector<std::string> linear = { "(a+)+!", "a|ab|(abc)", "(a*?)(\\w+)\\b", "^\\s*(\\d{2,3})+?$",
+                                              "[^\\]a-c]+|x?", "(a|)(b)?c" };
+    const std::vector<std::string> fallback = { "(a)\\1", "(?=a)a", "(?i)a", "(|a)*", "a++", "\\p{L}" };
+    const std::string subject = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa abc 123 12345\n]xbc acb cc\n";
+    bool failed = false;
+    for ( const std::string& pattern : fallback ) {
+        if ( PikeRegex::compile( pattern ) || std::string( RegexEngine::compile( pattern )->getName() ) != "pcre2" ) {
+            testLog << INDENT "ERR: " << pattern << " did not fall back to PCRE2\n";
+            failed = true;
+        }
+    }
+    RegexScratch pikeScratch, pcreScratch;
+    for ( const std::string& pattern : linear ) {
+        std::unique_ptr<PikeRegex> pike = PikeRegex::compile( pattern );
+        PcreRegex pcre( pattern );
+        if ( !pike ) {
+            testLog << INDENT "ERR: " << pattern << " was left to PCRE2\n";
+            failed = true;
+            continue;
+        }
+        for ( size_t start = 0; start <= subject.size(); ++start ) {
+            RegexEngine::Found found = pike->search( subject, start, 0, pikeScratch );
+            std::string pikeExpansion, pcreExpansion;
+            if ( found != pcre.search( subject, start, 0, pcreScratch ) ||
+                 ( found == RegexEngine::Found::MATCH &&
+                   ( pikeScratch.matchStart != pcreScratch.matchStart || pikeScratch.matchEnd != pcreScratch.matchEnd ||
+                     pike->expand( subject, "<$0|$1|${2}>", RegexEngine::UNKNOWN_UNSET | RegexEngine::UNSET_EMPTY,
+                                   pikeScratch, pikeExpansion ) !=
+                         pcre.expand( subject, "<$0|$1|${2}>", RegexEngine::UNKNOWN_UNSET | RegexEngine::UNSET_EMPTY,
+                                      pcreScratch, pcreExpansion ) ||
+                     pikeExpansion != pcreExpansion ) ) ) {
+                testLog << INDENT "ERR: " << pattern << " differs from PCRE2 from offset " << start << "\n";
+                failed = true;
+                break;
+            }
+        }
+    }
+
+    // no backtracking, so the row that runs into the match limit on PCRE2 goes through
+    CLIOptions opts;
+    opts.setSeed( "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6" );
+    opts.setMutCount( "2" );
+    opts.setRegexMatchLimit( "10000" );
+    Mutator mutator;
+    std::string mutant = mutator( subject, "/(a+)+ (?:\\w+ )+!/-A\tb\n/(a+)+ (\\w)/-A\t$2\n", &opts );
+    return failed || opts.getWarnings().find( "limit" ) != std::string::npos ||
+           mutant != "abc 123 12345\n]xbc acb cc\n";
+}
+
+static bool testSplitSrcTsvInput() {
+    std::string deliminator( IO_BUFF_SIZE + 10, '=' );  // longer than the old line buffer
+    deliminator += '\n';
+    std::string input = deliminator + "int a;\nx " + deliminator + "int b;\n" + deliminator + "a\tb\n" + deliminator;
+    std::string_view src, tsv;
+    bool failed = !splitSrcTsvInput( input, &src, &tsv );
+    testLog << INDENT << "Got a " << src.size() << " byte source and a " << tsv.size() << " byte TSV\n";
+    failed = failed || src != "int a;\nx " + deliminator + "int b;\n" || tsv != "a\tb\n";
+
+    std::string unterminated = "--\nint a;\n--\na\tb\n";
+    failed = failed || !splitSrcTsvInput( unterminated, &src, &tsv ) || src != "int a;\n" || tsv != "a\tb\n";
+    failed = failed || splitSrcTsvInput( "--\nint a;\n", &src, &tsv ) || splitSrcTsvInput( "", &src, &tsv );
+    return failed;
+}
+
+static bool testRunClassifiesMutants() {
+    char rootName[L_tmpnam] = { 0 };
+    std::filesystem::path root = std::tmpnam( rootName );
+    const std::vector<std::pair<std::string, std::string>> files = {
+        { "project/check.sh",
+          "grep -q slow src/value.txt && sleep 5\n"
+          "grep -q loud src/value.txt && { echo 'FAIL: loud'; sleep 5; }\n"
+          "grep -q good src/value.txt || exit 3\n" },
+        { "project/src/value.txt", "good\n" },
+        { "bad/src/value.txt", "bad\n" },
+        { "same/src/value.txt", "good\n" },
+        { "slow/src/value.txt", "good slow\n" },
+        { "loud/src/value.txt", "good loud\n" } };
+    for ( const auto& [path, contents] : files ) {
+        std::filesystem::create_directories( ( root / path ).parent_path() );
+        std::ofstream( root / path, std::ios::binary ) << contents;
+    }
+    std::vector<std::string> mutantDirs;
+    for ( const char* mutant : { "bad", "same", "slow", "loud" } ) {
+        mutantDirs.push_back( ( root / mutant ).string() );
+    }
+
+    std::vector<MutantResult> results;
+    {
+        MutantRunner runner( root / "project", "sh check.sh", 2, 500000000, "^FAIL" );
+        runner.runBaseline();
+        results = runner.run( mutantDirs );
+    }
+    std::string report = getRunReport( mutantDirs, results );
+    testLog << INDENT << report.substr( report.rfind( '\n' ) + 1 ) << '\n';
+    bool failed = results.size() != 4 || results[0].outcome != MutantOutcome::KILLED || results[0].exitStatus != 3 ||
+                  results[1].outcome != MutantOutcome::SURVIVED || results[2].outcome != MutantOutcome::TIMEOUT ||
+                  results[3].outcome != MutantOutcome::KILLED || results[3].killingLine != "FAIL: loud" ||
+                  results[3].durationNs > 2000000000ull;
+    failed = failed || report.find( "4 mutants: 2 killed, 1 survived, 1 timed out" ) == std::string::npos;
+    // the mutants were laid over copies, the project is left alone
+    std::ifstream value( root / "project/src/value.txt" );
+    std::string line;
+    failed = failed || !std::getline( value, line ) || line != "good";
+    std::filesystem::remove_all( root );
+    return failed;
+}
+
+// The output of the program built from schemata with MUTANT_ID set to id, empty when it does not build
+static std::string runSchemata( const std::filesystem::path& dir, const std::string& schemata, const char* id ) {
+    std::filesystem::path program = dir / "schemata";
+    if ( !std::filesystem::exists( program ) ) {
+        std::ofstream( dir / "schemata.cpp", std::ios::binary ) << schemata;
+        std::string build = "c++ -Wall -Werror -Wno-unused-variable -o " + program.string() + " " +
+                            ( dir / "schemata.cpp" ).string() + " 2>&1";
+        if ( std::system( build.c_str() ) != 0 ) {
+            return "";
+        }
+    }
+    std::string output;
+    std::string command = "MUTANT_ID=" + std::string( id ) + " " + program.string();
+    if ( FILE* pipe = popen( command.c_str(), "r" ) ) {
+        char buffer[64];
+        while ( std::fgets( buffer, sizeof( buffer ), pipe ) ) {
+            output += buffer;
+        }
+        pclose( pipe );
+    }
+    return output;
+}
+
+static bool testSchemataSwitchesMutants() {
+    const char* argv[] = { "./test", "mutate", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+
+    // only the rows on lines 1, 2, 3, 8, 10, 13, 14, 15 and 17 change whole statements or expressions of a function
+    MutationsRetriever retriever(
+        "return x * 2;\treturn 0;\treturn x + 1;\n"
+        "/a < b/-A\ta <= b\n"
+        "+/int y;/-A\ty = 1;\n"
+        "/N 1/-A\tN 2\n"
+        "namespace ns { int limit = 10; }\tnamespace ns { int limit = 11; }\n"
+        "/v = 3/-A\tv = 4\n"
+        "int x = a + 1;\tint x = a - 1;\n"
+        "/a \\+ 1/-A\ta - 1\n"
+        "/int/-A\tlong\n"
+        "/ns::limit/-A\t( ns::limit + 1 )\n"
+        "/ > /-A\t >= \n"
+        "/scale/-A\tscale2\n"
+        "/12/-A\t13\n"
+        "/\\+\\+i/-A\t--i\n"
+        "/s\\.v/-A\ts.v + 1\n"
+        "int total = 0;\tint total = 1;\n"
+        "/total \\+= scale\\( i, N \\);/-A\ttotal -= scale( i, N );\n"
+        "/A = 1/-A\tA = 2\n" );
+    retriever.capturePossibleMutations();
+    retriever.categorizeMutations();
+    retriever.checkNesting();
+    SchemataBuilder builder( &parsedArgs,
+                             "#define N 1\n"
+                             "#include <stdio.h>\n"
+                             "const char* s = \"{\";\n"
+                             "namespace ns { int limit = 10; }\n"
+                             "struct S { int v = 3; };\n"
+                             "enum E { A = 1 };\n"
+                             "static int scale( int a, int b ) {\n"
+                             "    int x = a + 1;\n"
+                             "    if ( x > ns::limit ) {\n"
+                             "        return x * 2;\n"
+                             "    }\n"
+                             "    S s;\n"
+                             "    int y;\n"
+                             "    y = b;\n"
+                             "    return a < b ? x + s.v : y;\n"
+                             "}\n"
+                             "int main() {\n"
+                             "    int total = 0;\n"
+                             "    for ( int i = 0; i < 12; ++i ) {\n"
+                             "        total += scale( i, N );\n"
+                             "    }\n"
+                             "    printf( \"%d\\n\", total );\n"
+                             "    return 0;\n"
+                             "}" );
+    builder.add( retriever.getPossibleMutations() );
+    std::string schemata = builder.build();
+    testLog << INDENT << builder.getMutantCount() << " mutants, expected 10\n";
+
+    const char* expected[] = { "    int x = ( mutateplaceholder_mutant( 5 ) ? ( a - 1 ) : ( a + 1 ) );\n",
+                               "        if ( mutateplaceholder_mutant( 1 ) ) {\n        return 0;\n        }\n"
+                               "        else if ( mutateplaceholder_mutant( 2 ) ) {\n        return x + 1;\n        }\n"
+                               "        else {\n        return x * 2;\n        }\n",
+                               "    int y;\n    if ( mutateplaceholder_mutant( 4 ) ) {\n    y = 1;\n    }\n",
+                               "    return ( mutateplaceholder_mutant( 3 ) ? ( a <= b ) : ( a < b ) ) ? ",
+                               "#define N 1\n", "namespace ns { int limit = 10; }\n", "struct S { int v = 3; };\n" };
+    bool failed = builder.getMutantCount() != 10;
+    for ( const char* part : expected ) {
+        if ( schemata.find( part ) == std::string::npos ) {
+            testLog << INDENT "ERR: missing " << std::quoted( part ) << '\n';
+            failed = true;
+        }
+    }
+    // a preprocessor line, file, namespace, class and enum scope, declarations, a type, an operator on its own and a
+    // function name cannot be switched, the brace in the string notwithstanding
+    failed = failed || parsedArgs.getWarnings().find( "left out of the schemata: { 4, 5, 6, 7, 9, 11, 12, 16, 18 }" ) ==
+                           std::string::npos;
+
+    if ( std::system( "c++ --version > /dev/null 2>&1" ) != 0 ) {
+        testLog << INDENT "No C++ compiler, the schemata were not built\n";
+        return failed;
+    }
+    char rootName[L_tmpnam] = { 0 };
+    std::filesystem::path root = std::tmpnam( rootName );
+    std::filesystem::create_directories( root );
+    // 4 + 9 * 1 + 22 + 24 for the original, with i reaching 12 too 26 more
+    std::string original = runSchemata( root, schemata, "0" );
+    std::string longerLoop = runSchemata( root, schemata, "7" );
+    testLog << INDENT << "the original printed " << std::quoted( original ) << ", mutant 7 "
+            << std::quoted( longerLoop ) << '\n';
+    std::filesystem::remove_all( root );
+    return failed || original != "59\n" || longerLoop != "85\n";
+}
+
+static bool testWorkspacesShareFiles() {
+    char rootName[L_tmpnam] = { 0 };
+    std::filesystem::path root = std::tmpnam( rootName );
+    std::filesystem::create_directories( root / "project/src" );
+    std::ofstream( root / "project/src/value.txt", std::ios::binary ) << "good\n";
+    std::ofstream( root / "project/build.sh", std::ios::binary ) << "true\n";
+    std::filesystem::permissions( root / "project/build.sh", std::filesystem::perms::owner_exec,
+                                  std::filesystem::perm_options::add );
+    auto old = std::filesystem::last_write_time( root / "project/src/value.txt" ) - std::chrono::hours( 24 ) +
+               std::chrono::nanoseconds( 123 );
+    std::filesystem::last_write_time( root / "project/src/value.txt", old );
+
+    WorkspaceBuilder builder( root / "project" );
+    builder.materialize( root / "workspace" );
+    testLog << INDENT << builder.getClonedFiles() << " cloned, " << builder.getLinkedFiles() << " hardlinked, "
+            << builder.getCopiedFiles() << " copied\n";
+    auto contentsOf = []( const std::filesystem::path& path ) {
+        std::ifstream file( path, std::ios::binary );
+        return std::string( std::istreambuf_iterator<char>( file ), std::istreambuf_iterator<char>() );
+    };
+    bool failed = builder.getClonedFiles() + builder.getCopiedFiles() != 2 || builder.getLinkedFiles() ||
+                  contentsOf( root / "workspace/src/value.txt" ) != "good\n" ||
+                  std::filesystem::last_write_time( root / "workspace/src/value.txt" ) != old ||
+                  ( std::filesystem::status( root / "workspace/build.sh" ).permissions() &
+                    std::filesystem::perms::owner_exec ) == std::filesystem::perms::none;
+
+    // a mutant never writes through to the project, and restoring it makes a build redo the file
+    WorkspaceBuilder::replaceFile( root / "workspace/src/value.txt", "bad\n" );
+    failed = failed || contentsOf( root / "workspace/src/value.txt" ) != "bad\n" ||
+             contentsOf( root / "project/src/value.txt" ) != "good\n" ||
+             std::filesystem::last_write_time( root / "project/src/value.txt" ) != old;
+    builder.restore( "src/value.txt", root / "workspace" );
+    failed = failed || contentsOf( root / "workspace/src/value.txt" ) != "good\n" ||
+             std::filesystem::last_write_time( root / "workspace/src/value.txt" ) <= old;
+
+    // hardlinks are only made when asked for, and writing through one is told rather than missed
+    WorkspaceBuilder linker( root / "project", true );
+    linker.materialize( root / "linked" );
+    linker.checkLinkedFiles();
+    std::ofstream( root / "linked/src/value.txt", std::ios::binary | std::ios::app ) << "worse\n";
+    try {
+        linker.checkLinkedFiles();
+        failed = failed || linker.getLinkedFiles();
+    } catch ( const IOErrorException& ) {
+        failed = failed || !linker.getLinkedFiles();
+    }
+    std::filesystem::remove_all( root );
+    return failed;
+}
+
+static bool testWorkspacesStayOnProjectFileSystem() {
+    char rootName[L_tmpnam] = { 0 };
+    std::filesystem::path root = std::tmpnam( rootName );
+    std::filesystem::create_directories( root / "project" );
+    std::filesystem::create_directories( root / "work" );
+    std::ofstream( root / "project/value.txt", std::ios::binary ) << "good\n";
+
+    bool failed = false;
+    {
+        MutantRunner runner( root / "project", "true", 1, 0, "" );
+        testLog << INDENT << "Workspaces made in " << runner.getWorkRoot() << "\n";
+        failed = runner.getWorkRoot().parent_path() != std::filesystem::weakly_canonical( root ) ||
+                 runner.getWorkspaceWarning().size();
+    }
+    {
+        MutantRunner runner( root / "project", "true", 1, 0, "", false, false, root / "work" );
+        failed = failed || runner.getWorkRoot().parent_path() != root / "work" || runner.getWorkspaceWarning().size();
+    }
+    failed = failed || std::distance( std::filesystem::directory_iterator( root ), {} ) != 2;  // removed again
+
+    // the shared memory file system stands in for a temporary directory that is one of its own
+    struct stat projectStat, shmStat;
+    if ( stat( root.c_str(), &projectStat ) == 0 && stat( "/dev/shm", &shmStat ) == 0 &&
+         projectStat.st_dev != shmStat.st_dev && access( "/dev/shm", W_OK ) == 0 ) {
+        MutantRunner runner( root / "project", "true", 1, 0, "", true, false, "/dev/shm" );
+        testLog << INDENT << runner.getWorkspaceWarning() << "\n";
+        failed = failed || runner.getWorkspaceWarning().find( "another file system" ) == std::string::npos;
+    }
+    std::filesystem::remove_all( root );
+    return failed;
+}
+
+static bool testDescriptorsRebuildMutants() {
+    const char* seed = "71E8DC1EC351FAFA40998B1178F7AE00328B4D464172111F6B2AA49D4BC6C1A6";
+    const char* argv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "-s", seed, "-c", "20", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+    std::string src = parsedArgs.getSrcString();
+    std::string tsv = parsedArgs.getTsvString();
+
+    Mutator mutator;
+    std::vector<MutantDescriptor::Mutation> selection;
+    mutator.setSelectionLog( &selection );
+    std::string expected = mutator( src, tsv, &parsedArgs );
+    std::string text =
+        MutantDescriptor( tsv, src, parsedArgs.getLexer(), parsedArgs.getMatchMode(), selection ).toString();
+    testLog << INDENT << selection.size() << " mutations in a descriptor of " << text.size() << " bytes\n";
+
+    // rebuilt from the descriptor alone, with a mutator that never selected anything
+    MutationsRetriever retriever( tsv );
+    retriever.capturePossibleMutations();
+    retriever.categorizeMutations();
+    retriever.checkNesting();
+    MutantDescriptor descriptor = MutantDescriptor::parse( text );
+    SelectedMutVec selected = descriptor.select( tsv, src, retriever.getPossibleMutations() );
+    Mutator replayer;
+    std::string mutant = replayer.removeStrComments( src, parsedArgs.getLexer() );
+    replayer.applyMutations( mutant, selected, &parsedArgs );
+    bool failed = selection.empty() || mutant != expected || descriptor.toString() != text;
+
+    // another TSV or source is turned down rather than mutated differently
+    const std::pair<std::string, std::string> others[] = { { tsv + "\n", src }, { tsv, src + "\n" } };
+    for ( const auto& [otherTsv, otherSrc] : others ) {
+        try {
+            descriptor.select( otherTsv, otherSrc, retriever.getPossibleMutations() );
+            failed = true;
+        } catch ( const InvalidArgumentException& ) {
+        }
+    }
+    return failed;
+}
+
+static bool testDescriptorsKeepLanguageAndMatchMode() {
+    const char* argv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", "-m",
+                           "./ioFiles/rawFiles/cli-options.tsv", "--language", "java", "--match", "tokens", nullptr };
+    parsingBoilerPlate bp( argv );
+    auto& [parsedArgs, nonpositionals, status] = bp;
+    std::string text = MutantDescriptor( parsedArgs.getTsvString(), parsedArgs.getSrcString(), parsedArgs.getLexer(),
+                                         parsedArgs.getMatchMode(), {} )
+                           .toString();
+    MutantDescriptor descriptor = MutantDescriptor::parse( text );
+    testLog << INDENT << text << '\n';
+
+    // replayed without the options, it picks up the ones the mutant was made with
+    const char* bareArgv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", nullptr };
+    parsingBoilerPlate bare( bareArgv );
+    descriptor.applySettings( &bare.parsedArgs );
+    bool failed = std::string( bare.parsedArgs.getLexer().getName() ) != "java" ||
+                  bare.parsedArgs.getMatchMode() != MatchMode::TOKENS;
+
+    // and turns down others rather than stripping or matching differently
+    const char* mismatches[][2] = { { "--language", "cpp" }, { "--match", "text" } };
+    for ( const auto& [option, value] : mismatches ) {
+        const char* otherArgv[] = { "./test", "mutate", "-i", "./ioFiles/rawFiles/cli-options.cpp", option, value,
+                                    nullptr };
+        parsingBoilerPlate other( otherArgv );
+        try {
+            descriptor.applySettings( &other.parsedArgs );
+            failed = true;
+        } catch ( const InvalidArgumentException& ) {
+        }
+    }
+    return failed;
+}
+
 // static bool verifyNegatedSelection(const char* tsvFile) {
 //     patternOperatorsTest(tsvFile, {}, {});
 //     patternOperatorsTest(tsvFile, {}, {});
@@ -622,6 +1606,60 @@ int main( int argc, const char** argv ) {
 
     POOR_MANS_TEST( "Check nesting", checkNesting );
 
+    POOR_MANS_TEST( "Serve requests use warm caches", testServeRequestsUseWarmCaches );
+
+    POOR_MANS_TEST( "Serve streams keep TSVs by id", testServeStreamTsvIds );
+
+    POOR_MANS_TEST( "C API matches the command line", testCApiMatchesCli );
+
+    POOR_MANS_TEST( "--stats counts a mutate run", testStatsCountMutateRun );
+
+    POOR_MANS_TEST( "--trace records spans per thread", testTraceRecordsSpansPerThread );
+
+    POOR_MANS_TEST( "--hw-counters degrade gracefully", testHardwareCountersDegradeGracefully );
+
+    POOR_MANS_TEST( "Allocations are attributed to phases", testAllocationsAttributedToPhases );
+
+    POOR_MANS_TEST( "Comments are stripped in a single pass", testCommentStripping );
+
+    POOR_MANS_TEST( "Lexers tokenize per language", testLexersPerLanguage );
+
+    POOR_MANS_TEST( "Lexing a growing source a piece at a time finds what one pass does",
+                    testLexersResumeOverGrowingSources );
+
+    POOR_MANS_TEST( "Plain patterns match as token sequences", testTokenMatching );
+
+    POOR_MANS_TEST( "--tree mirrors mutants into --output-dir", testTreeModeMirrorsFiles );
+
+    POOR_MANS_TEST( "--file-list only takes paths it can mirror", testFileListStaysInCurrentDirectory );
+
+    POOR_MANS_TEST( "Rows under #paths: only apply to matching files", testPathScopedRows );
+
+    POOR_MANS_TEST( "--stream gives the same mutant whatever the chunk size", testStreamMatchesWholeSource );
+
+    POOR_MANS_TEST( "Split source and TSV read together from stdin", testSplitSrcTsvInput );
+
+    POOR_MANS_TEST( "run tells killed, surviving and timed out mutants apart", testRunClassifiesMutants );
+
+    POOR_MANS_TEST( "--schemata puts every mutant behind a runtime switch that compiles", testSchemataSwitchesMutants );
+
+    POOR_MANS_TEST( "Workspaces share the project's files, keep their modification times and guard hardlinks",
+                    testWorkspacesShareFiles );
+
+    POOR_MANS_TEST( "Run makes its workspaces on the project's file system", testWorkspacesStayOnProjectFileSystem );
+
+    POOR_MANS_TEST( "Descriptors rebuild the mutant without selecting again", testDescriptorsRebuildMutants );
+
+    POOR_MANS_TEST( "Descriptors replay with the language and match mode they were made with",
+                    testDescriptorsKeepLanguageAndMatchMode );
+
+    POOR_MANS_TEST( "Regex rows are skipped when a required literal is missing", testRegexPrefilter );
+
+    POOR_MANS_TEST( "Regex rows replace every match where it was found", testRegexReplacesAtOffsets );
+    POOR_MANS_TEST( "One scan finds the required literals of every regex row", testRequiredLiteralsScan );
+    POOR_MANS_TEST( "Regex rows running into a limit are reported and skipped", testRegexLimits );
+    POOR_MANS_TEST( "Regex rows in the linear time subset match as with PCRE2", testPikeRegexMatchesPcre2 );
+
     // POOR_MANS_TEST("Verify negated selection", verifyNegatedSelection,
     //                "./ioFiles/specialChars/negating/specialChars.tsv");
 